@@ -0,0 +1,398 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+#include <direct.h>
+#define chdir _chdir
+#else
+#include <unistd.h>
+#endif
+#include "OffscreenContext.h"
+#include "CameraPath.h"
+#include "Scene.h"
+#include "RenderState.h"
+#include "ProgramCache.h"
+#include "MeshCache.h"
+#include "ShaderBuildQueue.h"
+#include "AssetLoader.h"
+#include "TextureRegistry.h"
+#include "ObjParser.h"
+#include "ReportUtil.h"
+#include "tiny_obj_loader.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// ヘッドレスベンチマーク
+// ウィンドウも入力も使わずにオフスクリーンでシーンを描画し、
+// CPUフレーム時間・GPUパス時間・ドローコール数をJSONに書き出す
+//
+// 使い方 :
+//   bench [--assets dir] [--path file] [--frames N] [--warmup N] [--out file.json] [--image file.ppm]
+//   bench --obj file.obj [--runs N] [--out file.json]
+//     --assets  Shader/ と mesh/ があるディレクトリ (既定 : カレント)
+//     --path    カメラパスのキーフレームファイル (既定 : 格子の周りを1周する組み込みパス)
+//     --frames  計測するフレーム数 (既定 : 600)
+//     --warmup  計測前に捨てるフレーム数 (既定 : 60)
+//     --out     結果のJSON (既定 : bench_result.json)
+//     --image   最終フレームの画像 (PPM) を保存する
+//     --obj     描画せずにOBJの解析時間を tinyobj と ObjParser で比べる
+//     --runs    --obj の解析回数 (既定 : 5)
+///////////////////////////////////////////////////////////////////////////////////////
+
+// 1パスあたりの合計
+struct PassTotals
+{
+	double drawCalls    = 0.0;
+	double drawCommands = 0.0;
+	double instances    = 0.0;
+	double culled       = 0.0;
+	double triangles    = 0.0;
+	double lodInstances[MeshObj::mLodMax] = {};
+};
+
+// 計測値の統計
+struct SampleStats
+{
+	double average = 0.0;
+	double p50     = 0.0;
+	double p95     = 0.0;
+	double p99     = 0.0;
+	double max     = 0.0;
+};
+
+static SampleStats calcSampleStats(std::vector<double> samples)
+{
+	SampleStats stats;
+	if (samples.empty())
+	{
+		return stats;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double sample : samples)
+	{
+		sum += sample;
+	}
+
+	stats.average = sum / samples.size();
+	stats.p50     = ReportUtil::percentile(samples, 0.50);
+	stats.p95     = ReportUtil::percentile(samples, 0.95);
+	stats.p99     = ReportUtil::percentile(samples, 0.99);
+	stats.max     = samples.back();
+	return stats;
+}
+
+// 格子(8x8, 間隔6)の周りを1周する組み込みパス
+static void makeDefaultPath(CameraPath& path)
+{
+	const Vector3 center(4 * 6, 0, -4 * 6);
+	const int     keyNum = 9;
+	for (int i = 0; i < keyNum; i++)
+	{
+		float angle = Math::TwoPi * i / (keyNum - 1);
+		Vector3 pos = center + Vector3(35.0f * cosf(angle), 8.0f + 4.0f * sinf(angle * 2.0f), 35.0f * sinf(angle));
+		path.addKey(10.0f * i / (keyNum - 1), pos, center);
+	}
+}
+
+static void writeStats(std::ostream& os, const char* name, double average, double p50, double p95, double p99)
+{
+	os << "\"" << ReportUtil::escapeJson(name) << "\":{\"avg\":" << average << ",\"p50\":" << p50 << ",\"p95\":" << p95 << ",\"p99\":" << p99 << "}";
+}
+
+static void writePass(std::ostream& os, const char* name, const PassTotals& totals, unsigned int frameNum)
+{
+	os << "\"" << name << "\":{"
+	   << "\"draw_calls\":" << totals.drawCalls / frameNum
+	   << ",\"draw_commands\":" << totals.drawCommands / frameNum
+	   << ",\"instances\":" << totals.instances / frameNum
+	   << ",\"culled\":" << totals.culled / frameNum
+	   << ",\"triangles\":" << totals.triangles / frameNum
+	   << ",\"lod_instances\":[";
+	for (unsigned int lod = 0; lod < MeshObj::mLodMax; lod++)
+	{
+		os << (lod > 0 ? "," : "") << totals.lodInstances[lod] / frameNum;
+	}
+	os << "]}";
+}
+
+/////////////////////////////////////////////////
+// OBJの解析時間を tinyobj と ObjParser で比べる (GLは使わない)
+// in  : objFile  OBJファイル名
+//       runNum   それぞれの解析回数
+//       outFile  結果のJSON
+// out : 終了コード
+////////////////////////////////////////////////
+static int benchObj(const char* objFile, unsigned int runNum, const char* outFile)
+{
+	std::vector<double> tinyobjTimes, parserTimes;
+	size_t       tinyobjTriangles = 0, parserTriangles = 0;
+	unsigned int threadNum = 0;
+	for (unsigned int run = 0; run < runNum; run++)
+	{
+		{
+			auto start = std::chrono::steady_clock::now();
+			tinyobj::attrib_t attrib;
+			std::vector<tinyobj::shape_t> shapes;
+			std::vector<tinyobj::material_t> materials;
+			std::string warn, err;
+			if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, objFile))
+			{
+				std::cout << "ファイル読み込み失敗 : " << objFile << std::endl << err << std::endl;
+				return 1;
+			}
+			tinyobjTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			tinyobjTriangles = 0;
+			for (const tinyobj::shape_t& shape : shapes)
+			{
+				tinyobjTriangles += shape.mesh.indices.size() / 3;
+			}
+		}
+		{
+			auto start = std::chrono::steady_clock::now();
+			ObjParser parser;
+			if (!parser.parse(objFile))
+			{
+				std::cout << parser.getError() << std::endl;
+				return 1;
+			}
+			parserTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			parserTriangles = parser.getIndices().size() / 3;
+			threadNum       = parser.getThreadNum();
+		}
+	}
+
+	std::ofstream file(outFile);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << outFile << std::endl;
+		return 1;
+	}
+
+	SampleStats tinyobjStats = calcSampleStats(tinyobjTimes);
+	SampleStats parserStats  = calcSampleStats(parserTimes);
+	file << std::fixed << std::setprecision(4);
+	file << "{" << std::endl;
+	file << "\"obj_file\":\"" << ReportUtil::escapeJson(objFile) << "\"," << std::endl;
+	file << "\"runs\":" << runNum << ",\"threads\":" << threadNum << "," << std::endl;
+	file << "\"triangles\":{\"tinyobj\":" << tinyobjTriangles << ",\"obj_parser\":" << parserTriangles << "}," << std::endl;
+	writeStats(file, "tinyobj_ms", tinyobjStats.average, tinyobjStats.p50, tinyobjStats.p95, tinyobjStats.p99);
+	file << "," << std::endl;
+	writeStats(file, "obj_parser_ms", parserStats.average, parserStats.p50, parserStats.p95, parserStats.p99);
+	file << std::endl << "}" << std::endl;
+
+	std::cout << "obj : " << parserTriangles << " triangles, tinyobj " << tinyobjStats.p50 << " ms, ObjParser " << parserStats.p50
+	          << " ms (" << threadNum << " threads) -> " << outFile << std::endl;
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char*  assetDir  = nullptr;
+	const char*  pathFile  = nullptr;
+	const char*  outFile   = "bench_result.json";
+	const char*  imageFile = nullptr;
+	const char*  objFile   = nullptr;
+	unsigned int frameNum  = 600;
+	unsigned int warmupNum = 60;
+	unsigned int runNum    = 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--assets") && hasValue)      { assetDir  = argv[++i]; }
+		else if (!strcmp(argv[i], "--path") && hasValue)   { pathFile  = argv[++i]; }
+		else if (!strcmp(argv[i], "--out") && hasValue)    { outFile   = argv[++i]; }
+		else if (!strcmp(argv[i], "--image") && hasValue)  { imageFile = argv[++i]; }
+		else if (!strcmp(argv[i], "--frames") && hasValue) { frameNum  = static_cast<unsigned int>(atoi(argv[++i])); }
+		else if (!strcmp(argv[i], "--warmup") && hasValue) { warmupNum = static_cast<unsigned int>(atoi(argv[++i])); }
+		else if (!strcmp(argv[i], "--obj") && hasValue)    { objFile   = argv[++i]; }
+		else if (!strcmp(argv[i], "--runs") && hasValue)   { runNum    = static_cast<unsigned int>(atoi(argv[++i])); }
+		else
+		{
+			std::cout << "usage : bench [--assets dir] [--path file] [--frames N] [--warmup N] [--out file.json] [--image file.ppm]" << std::endl;
+			std::cout << "        bench --obj file.obj [--runs N] [--out file.json]" << std::endl;
+			return 1;
+		}
+	}
+	frameNum = std::max(frameNum, 1u);
+
+	if (objFile)
+	{
+		return benchObj(objFile, std::max(runNum, 1u), outFile);
+	}
+
+	// カメラパス (相対パスで指定されたファイルはアセットディレクトリに移る前に読む)
+	CameraPath path;
+	if (pathFile)
+	{
+		if (!path.load(pathFile))
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		makeDefaultPath(path);
+	}
+
+	if (assetDir && chdir(assetDir) != 0)
+	{
+		std::cout << "ディレクトリ移動失敗 : " << assetDir << std::endl;
+		return 1;
+	}
+
+	OffscreenContext offscreen;
+	if (!offscreen.create(Scene::mScreenWidth, Scene::mScreenHeight))
+	{
+		return 1;
+	}
+
+	// シェーダーのビルドとアセットの読み込みが全て終わってから計測する
+	SHADER_BUILD_QUEUE_INSTANCE.initialize(nullptr);
+	ASSET_LOADER_INSTANCE.initialize();
+	Scene* scene = new Scene;
+	SHADER_BUILD_QUEUE_INSTANCE.finish();
+	ASSET_LOADER_INSTANCE.finish();
+	MESH_CACHE_INSTANCE.printReport(std::cout);
+	PROGRAM_CACHE_INSTANCE.printReport(std::cout);
+	SHADER_BUILD_QUEUE_INSTANCE.printReport(std::cout);
+	ASSET_LOADER_INSTANCE.printReport(std::cout);
+	TEXTURE_REGISTRY_INSTANCE.printReport(std::cout);
+	GpuProfiler& gpuProfiler = scene->getGpuProfiler();
+	RenderQueue& renderQueue = scene->getRenderQueue();
+
+	const Matrix4 projMat = Matrix4::CreatePerspectiveFOV(Math::ToRadians(45.0f),
+		static_cast<float>(Scene::mScreenWidth), static_cast<float>(Scene::mScreenHeight), 0.1f, 1000.0f);
+
+	// 固定の時間刻みでパスを進める (計測フレームでパスの始点から終点まで)
+	const float deltaTime = path.getDuration() / std::max(frameNum - 1, 1u);
+
+	std::vector<double> cpuTimes;
+	cpuTimes.reserve(frameNum);
+	PassTotals   passTotals[RenderQueue::RenderPass_Num];
+	double       stateChangeTotal = 0.0;
+	unsigned int firstMeasuredFrame = 0;
+
+	auto benchStart = std::chrono::steady_clock::now();
+	for (unsigned int frame = 0; frame < warmupNum + frameNum; frame++)
+	{
+		const bool measure = frame >= warmupNum;
+		if (frame == warmupNum)
+		{
+			// 計測区間の開始
+			glFinish();
+			gpuProfiler.startCapture();
+			firstMeasuredFrame = gpuProfiler.getFrameNumber();
+			benchStart = std::chrono::steady_clock::now();
+		}
+
+		auto frameStart = std::chrono::steady_clock::now();
+		Shader::resetFrameStats();
+		RENDER_STATE_INSTANCE.resetFrameStats();
+
+		float time = measure ? (frame - warmupNum) * deltaTime : 0.0f;
+		Vector3 pos, target;
+		path.evaluate(time, pos, target);
+		scene->setCamera(Matrix4::CreateLookAt(pos, target, Vector3::UnitY), projMat, pos);
+		scene->update(deltaTime);
+		scene->render(offscreen.getFramebuffer());
+		glFlush();
+
+		auto frameEnd = std::chrono::steady_clock::now();
+		if (!measure)
+		{
+			continue;
+		}
+
+		cpuTimes.emplace_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+		for (int pass = 0; pass < RenderQueue::RenderPass_Num; pass++)
+		{
+			RenderQueue::RenderPassEnum passEnum = static_cast<RenderQueue::RenderPassEnum>(pass);
+			passTotals[pass].drawCalls    += renderQueue.getDrawCount(passEnum);
+			passTotals[pass].drawCommands += renderQueue.getCommandCount(passEnum);
+			passTotals[pass].instances    += renderQueue.getInstanceCount(passEnum);
+			passTotals[pass].culled       += renderQueue.getCulledCount(passEnum);
+			passTotals[pass].triangles    += renderQueue.getTriangleCount(passEnum);
+			for (unsigned int lod = 0; lod < MeshObj::mLodMax; lod++)
+			{
+				passTotals[pass].lodInstances[lod] += renderQueue.getLodInstanceCount(passEnum, lod);
+			}
+		}
+		stateChangeTotal += RENDER_STATE_INSTANCE.getIssuedCount();
+	}
+
+	// 残りのGPU計測結果を回収
+	glFinish();
+	auto benchEnd = std::chrono::steady_clock::now();
+	gpuProfiler.flush();
+	gpuProfiler.stopCapture();
+
+	if (imageFile)
+	{
+		offscreen.writeImage(imageFile);
+	}
+
+	// 結果の書き出し
+	std::ofstream file(outFile);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << outFile << std::endl;
+		return 1;
+	}
+
+	SampleStats cpu = calcSampleStats(cpuTimes);
+	file << std::fixed << std::setprecision(4);
+	file << "{" << std::endl;
+	// 文字列はWindowsのパス (\) やドライバーの文字列をそのまま書くと壊れるのでエスケープする
+	file << "\"backend\":\"" << ReportUtil::escapeJson(offscreen.getBackendName()) << "\"," << std::endl;
+	file << "\"renderer\":\"" << ReportUtil::escapeJson(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << "\"," << std::endl;
+	file << "\"gl_version\":\"" << ReportUtil::escapeJson(reinterpret_cast<const char*>(glGetString(GL_VERSION))) << "\"," << std::endl;
+	file << "\"camera_path\":\"" << ReportUtil::escapeJson(pathFile ? pathFile : "default") << "\"," << std::endl;
+	file << "\"width\":" << Scene::mScreenWidth << ",\"height\":" << Scene::mScreenHeight << "," << std::endl;
+	file << "\"frames\":" << frameNum << ",\"warmup\":" << warmupNum << "," << std::endl;
+	file << "\"wall_ms\":" << std::chrono::duration<double, std::milli>(benchEnd - benchStart).count() << "," << std::endl;
+	file << "\"cpu_frame_ms\":{\"avg\":" << cpu.average << ",\"p50\":" << cpu.p50 << ",\"p95\":" << cpu.p95
+	     << ",\"p99\":" << cpu.p99 << ",\"max\":" << cpu.max << "}," << std::endl;
+
+	file << "\"gpu_ms\":{";
+	bool first = true;
+	for (const std::string& name : gpuProfiler.getScopeNames())
+	{
+		GpuScopeStats stats;
+		if (!gpuProfiler.getCaptureStats(name, firstMeasuredFrame, stats))
+		{
+			continue;
+		}
+		file << (first ? "" : ",") << std::endl;
+		writeStats(file, name.c_str(), stats.average, stats.p50, stats.p95, stats.p99);
+		first = false;
+	}
+	file << std::endl << "}," << std::endl;
+	file << "\"gpu_dropped_frames\":" << gpuProfiler.getDroppedFrameCount() << "," << std::endl;
+
+	file << "\"per_frame\":{" << std::endl;
+	writePass(file, "shadow", passTotals[RenderQueue::RenderPass_Shadow], frameNum);
+	file << "," << std::endl;
+	writePass(file, "opaque", passTotals[RenderQueue::RenderPass_Opaque], frameNum);
+	file << "," << std::endl;
+	file << "\"state_changes\":" << stateChangeTotal / frameNum << std::endl;
+	file << "}" << std::endl;
+	file << "}" << std::endl;
+
+	std::cout << "bench : " << frameNum << " frames, cpu avg " << cpu.average << " ms -> " << outFile << std::endl;
+
+	// シーンの削除 (GLコンテキストを破棄する前に行う)
+	delete scene;
+	TEXTURE_REGISTRY_INSTANCE.releaseAll();
+	ASSET_LOADER_INSTANCE.shutdown();
+	offscreen.destroy();
+
+	return 0;
+}
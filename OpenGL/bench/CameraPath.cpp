@@ -0,0 +1,114 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "CameraPath.h"
+
+// Catmull-Rom スプライン (p1～p2間を t:0～1 で補間)
+static Vector3 catmullRom(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.0f * p1)
+		+ (p2 - p0) * t
+		+ (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+		+ (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+/////////////////////////////////////////////////
+// キーフレームファイルを読み込む
+// in  : fileName  ファイル名
+// out : キーフレームが2つ以上読めたらtrue
+////////////////////////////////////////////////
+bool CameraPath::load(const char* fileName)
+{
+	std::ifstream file(fileName);
+	if (!file)
+	{
+		std::cout << "ファイル読み込み失敗 : " << fileName << std::endl;
+		return false;
+	}
+
+	mKeys.clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		// コメントを除く
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+		{
+			line.erase(comment);
+		}
+
+		std::istringstream ss(line);
+		float time;
+		Vector3 pos, target;
+		if (ss >> time >> pos.x >> pos.y >> pos.z >> target.x >> target.y >> target.z)
+		{
+			addKey(time, pos, target);
+		}
+	}
+
+	if (mKeys.size() < 2)
+	{
+		std::cout << "キーフレームが足りません : " << fileName << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void CameraPath::addKey(float time, const Vector3& pos, const Vector3& target)
+{
+	mKeys.push_back({ time, pos, target });
+}
+
+float CameraPath::getDuration() const
+{
+	if (mKeys.empty())
+	{
+		return 0.0f;
+	}
+	return mKeys.back().time - mKeys.front().time;
+}
+
+/////////////////////////////////////////////////
+// 時刻のカメラ位置と注視点を求める
+// 範囲外の時刻は端のキーフレームに丸める
+// in  : time        パス先頭からの時刻 (秒)
+// out : destPos     カメラ位置
+//       destTarget  注視点
+////////////////////////////////////////////////
+void CameraPath::evaluate(float time, Vector3& destPos, Vector3& destTarget) const
+{
+	if (mKeys.empty())
+	{
+		return;
+	}
+	const float t = mKeys.front().time + Math::Clamp(time, 0.0f, getDuration());
+
+	if (mKeys.size() == 1)
+	{
+		destPos    = mKeys[0].pos;
+		destTarget = mKeys[0].target;
+		return;
+	}
+
+	// tを含む区間 [i, i + 1] を探す
+	size_t i = 0;
+	while (i + 2 < mKeys.size() && mKeys[i + 1].time <= t)
+	{
+		i++;
+	}
+
+	// 端の区間は端点を複製して制御点にする
+	const Key& k0 = mKeys[i > 0 ? i - 1 : i];
+	const Key& k1 = mKeys[i];
+	const Key& k2 = mKeys[i + 1];
+	const Key& k3 = mKeys[i + 2 < mKeys.size() ? i + 2 : i + 1];
+
+	float span = k2.time - k1.time;
+	float f    = span > 0.0f ? Math::Clamp((t - k1.time) / span, 0.0f, 1.0f) : 0.0f;
+
+	destPos    = catmullRom(k0.pos, k1.pos, k2.pos, k3.pos, f);
+	destTarget = catmullRom(k0.target, k1.target, k2.target, k3.target, f);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include "Math.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// キーフレームによるカメラパス
+// キーフレーム間は Catmull-Rom スプラインで補間する
+//
+// ファイル形式 (1行1キーフレーム, '#'以降はコメント, 時刻の昇順)
+//   time  posX posY posZ  targetX targetY targetZ
+///////////////////////////////////////////////////////////////////////////////////////
+class CameraPath
+{
+public:
+	CameraPath() {};
+	~CameraPath() {};
+
+	bool         load(const char* fileName);                             // キーフレームファイルの読み込み
+	void         addKey(float time, const Vector3& pos, const Vector3& target); // キーフレームの追加 (時刻の昇順に追加すること)
+	void         evaluate(float time, Vector3& destPos, Vector3& destTarget) const; // 時刻の位置と注視点
+
+	float        getDuration() const;                                    // パスの長さ (秒)
+	unsigned int getKeyNum() const { return static_cast<unsigned int>(mKeys.size()); }
+
+private:
+	struct Key
+	{
+		float   time;    // 時刻 (秒)
+		Vector3 pos;     // カメラ位置
+		Vector3 target;  // 注視点
+	};
+
+	std::vector<Key> mKeys;
+};
@@ -0,0 +1,316 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include "OffscreenContext.h"
+#include "RenderState.h"
+
+#if defined(_WIN32)
+#include <SDL/SDL.h>
+#elif defined(BENCH_USE_OSMESA)
+#include <GL/osmesa.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+OffscreenContext::OffscreenContext()
+	: mWidth(0)
+	, mHeight(0)
+	, mFBO(0)
+	, mColorRBO(0)
+	, mNativeDisplay(nullptr)
+	, mNativeContext(nullptr)
+	, mOSMesaBuffer(nullptr)
+{
+}
+
+OffscreenContext::~OffscreenContext()
+{
+	destroy();
+}
+
+/////////////////////////////////////////////////
+// コンテキストと描画先FBOを作成する
+// in  : width, height  描画先の解像度
+// out : 成功したらtrue (コンテキストはカレントになっている)
+////////////////////////////////////////////////
+bool OffscreenContext::create(int width, int height)
+{
+	mWidth  = width;
+	mHeight = height;
+
+	if (!createContext(width, height))
+	{
+		return false;
+	}
+
+	// GLADの初期化はcreateContext内で済んでいる
+	std::cout << "GL_RENDERER : " << glGetString(GL_RENDERER) << std::endl;
+	std::cout << "GL_VERSION  : " << glGetString(GL_VERSION) << std::endl;
+
+	// 描画先のFBO (トーンマップの出力先なのでカラーのみ)
+	glGenFramebuffers(1, &mFBO);
+	glGenRenderbuffers(1, &mColorRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, mColorRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	RENDER_STATE_INSTANCE.bindFramebuffer(mFBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColorRBO);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+		return false;
+	}
+	RENDER_STATE_INSTANCE.bindFramebuffer(0);
+
+	return true;
+}
+
+void OffscreenContext::destroy()
+{
+	if (mFBO != 0)
+	{
+		RENDER_STATE_INSTANCE.onDeleteFramebuffer(mFBO);
+		glDeleteFramebuffers(1, &mFBO);
+		glDeleteRenderbuffers(1, &mColorRBO);
+		mFBO = 0;
+		mColorRBO = 0;
+	}
+	destroyContext();
+}
+
+/////////////////////////////////////////////////
+// 描画先FBOの内容をバイナリPPM(P6)で保存する
+// 画像の上下はGLの座標系から反転して書き出す
+////////////////////////////////////////////////
+bool OffscreenContext::writeImage(const char* fileName)
+{
+	std::vector<unsigned char> pixels(mWidth * mHeight * 3);
+	RENDER_STATE_INSTANCE.bindFramebuffer(mFBO);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, mWidth, mHeight, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << fileName << std::endl;
+		return false;
+	}
+
+	file << "P6\n" << mWidth << " " << mHeight << "\n255\n";
+	for (int y = mHeight - 1; y >= 0; y--)
+	{
+		file.write(reinterpret_cast<const char*>(&pixels[y * mWidth * 3]), mWidth * 3);
+	}
+	return true;
+}
+
+#if defined(_WIN32)
+
+const char* OffscreenContext::getBackendName() const
+{
+	return "SDL hidden window";
+}
+
+bool OffscreenContext::createContext(int width, int height)
+{
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+	{
+		printf("SDL初期化失敗 : %s\n", SDL_GetError());
+		return false;
+	}
+
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+
+	SDL_Window* window = SDL_CreateWindow("bench", 0, 0, width, height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	if (!window)
+	{
+		printf("Windowの作成に失敗: %s", SDL_GetError());
+		return false;
+	}
+	mNativeDisplay = window;
+
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context)
+	{
+		printf("GLコンテキストの作成に失敗: %s", SDL_GetError());
+		return false;
+	}
+	mNativeContext = context;
+
+	// 垂直同期で計測が頭打ちにならないようにする
+	SDL_GL_SetSwapInterval(0);
+
+	if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress))
+	{
+		printf("glad初期化失敗！\n");
+		return false;
+	}
+	return true;
+}
+
+void OffscreenContext::destroyContext()
+{
+	if (mNativeContext)
+	{
+		SDL_GL_DeleteContext(static_cast<SDL_GLContext>(mNativeContext));
+		mNativeContext = nullptr;
+	}
+	if (mNativeDisplay)
+	{
+		SDL_DestroyWindow(static_cast<SDL_Window*>(mNativeDisplay));
+		mNativeDisplay = nullptr;
+	}
+}
+
+#elif defined(BENCH_USE_OSMESA)
+
+const char* OffscreenContext::getBackendName() const
+{
+	return "OSMesa";
+}
+
+bool OffscreenContext::createContext(int width, int height)
+{
+	const int attribs[] = {
+		OSMESA_FORMAT,                OSMESA_RGBA,
+		OSMESA_DEPTH_BITS,            24,
+		OSMESA_PROFILE,               OSMESA_CORE_PROFILE,
+		OSMESA_CONTEXT_MAJOR_VERSION, 4,
+		OSMESA_CONTEXT_MINOR_VERSION, 2,
+		0
+	};
+
+	OSMesaContext context = OSMesaCreateContextAttribs(attribs, NULL);
+	if (!context)
+	{
+		printf("OSMesaコンテキストの作成に失敗\n");
+		return false;
+	}
+	mNativeContext = context;
+
+	// OSMesaはカレントにする際に描画バッファが必要 (実際の描画先はFBO)
+	mOSMesaBuffer = new unsigned char[width * height * 4];
+	if (!OSMesaMakeCurrent(context, mOSMesaBuffer, GL_UNSIGNED_BYTE, width, height))
+	{
+		printf("OSMesaMakeCurrent失敗\n");
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)OSMesaGetProcAddress))
+	{
+		printf("glad初期化失敗！\n");
+		return false;
+	}
+	return true;
+}
+
+void OffscreenContext::destroyContext()
+{
+	if (mNativeContext)
+	{
+		OSMesaDestroyContext(static_cast<OSMesaContext>(mNativeContext));
+		mNativeContext = nullptr;
+	}
+	delete[] mOSMesaBuffer;
+	mOSMesaBuffer = nullptr;
+}
+
+#else
+
+const char* OffscreenContext::getBackendName() const
+{
+	return "EGL surfaceless";
+}
+
+bool OffscreenContext::createContext(int /*width*/, int /*height*/) // サーフェスを作らないので大きさは使わない (描画先はFBO)
+{
+	// サーフェスなしのプラットフォームを優先し、なければ既定のディスプレイを使う
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		printf("EGL初期化失敗 : 0x%x\n", eglGetError());
+		return false;
+	}
+	mNativeDisplay = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		printf("eglBindAPI失敗 : 0x%x\n", eglGetError());
+		return false;
+	}
+
+	// EGL_SURFACE_TYPEの既定値はEGL_WINDOW_BITなので、サーフェスなしのプラットフォームでも選べるpbufferを指定
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configNum = 0;
+	if (!eglChooseConfig(display, configAttribs, &config, 1, &configNum) || configNum == 0)
+	{
+		printf("eglChooseConfig失敗 : 0x%x\n", eglGetError());
+		return false;
+	}
+
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION,       4,
+		EGL_CONTEXT_MINOR_VERSION,       2,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT)
+	{
+		printf("eglCreateContext失敗 : 0x%x\n", eglGetError());
+		return false;
+	}
+	mNativeContext = context;
+
+	// EGL_KHR_surfaceless_context : サーフェスなしでカレントにする (描画先はFBO)
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		printf("eglMakeCurrent失敗 : 0x%x\n", eglGetError());
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		printf("glad初期化失敗！\n");
+		return false;
+	}
+	return true;
+}
+
+void OffscreenContext::destroyContext()
+{
+	if (mNativeDisplay)
+	{
+		EGLDisplay display = static_cast<EGLDisplay>(mNativeDisplay);
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (mNativeContext)
+		{
+			eglDestroyContext(display, static_cast<EGLContext>(mNativeContext));
+			mNativeContext = nullptr;
+		}
+		eglTerminate(display);
+		mNativeDisplay = nullptr;
+	}
+}
+
+#endif
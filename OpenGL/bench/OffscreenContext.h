@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// ウィンドウを表示しないGLコンテキスト
+// 描画結果はコンテキストが持つFBO(RGBA8)に書き込む
+//
+// バックエンド
+//   Windows              : 非表示のSDLウィンドウ
+//   BENCH_USE_OSMESA定義 : OSMesa (ソフトウェアラスタライザ)
+//   それ以外             : EGL surfaceless (Mesa llvmpipe でもGPUなしで動く)
+///////////////////////////////////////////////////////////////////////////////////////
+class OffscreenContext
+{
+public:
+	OffscreenContext();
+	~OffscreenContext();
+
+	bool         create(int width, int height);     // GL4.2 coreコンテキストと描画先FBOの作成
+	void         destroy();                         // 破棄
+	bool         writeImage(const char* fileName);  // 描画先FBOの内容をPPMで保存
+
+	GLuint       getFramebuffer() const { return mFBO; }
+	const char*  getBackendName() const;            // バックエンド名
+
+private:
+	bool         createContext(int width, int height); // バックエンドごとのコンテキスト作成
+	void         destroyContext();
+
+	int          mWidth;
+	int          mHeight;
+	GLuint       mFBO;            // 描画先FBO
+	GLuint       mColorRBO;       // 描画先のカラーバッファ
+	void*        mNativeDisplay;  // バックエンドのディスプレイ (EGLDisplay / SDL_Window*)
+	void*        mNativeContext;  // バックエンドのコンテキスト (EGLContext / SDL_GLContext / OSMesaContext)
+	unsigned char* mOSMesaBuffer; // OSMesaの描画バッファ
+};
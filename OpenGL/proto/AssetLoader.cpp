@@ -0,0 +1,741 @@
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+#include <SDL/SDL_image.h>
+#include "AssetLoader.h"
+#include "RenderState.h"
+#include "TextureRegistry.h"
+#include "MipBuilder.h"
+
+// 読み込めなかったテクスチャの色 (テクスチャ0や確保前のテクスチャをサンプルした時と同じ黒)
+static const unsigned char failedColor[4] = { 0, 0, 0, 255 };
+
+AssetLoader::AssetLoader()
+	: mStop(false)
+	, mS3tcSupported(false)
+	, mUploadBudget(16 * 1024 * 1024)
+	, mLoadMilliseconds(0.0f)
+	, mWorkerMilliseconds(0.0f)
+	, mTextureNum(0)
+	, mCompressedNum(0)
+	, mMipBuiltNum(0)
+	, mGpuMipNum(0)
+	, mMeshNum(0)
+	, mFailedNum(0)
+	, mUploadedBytes(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+	// GLコンテキストは既に無いかもしれないので、ここではGLのオブジェクトは破棄しない
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all();
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+	for (Job* job : mLoadQueue)
+	{
+		delete job;
+	}
+	for (Job* job : mCompleted)
+	{
+		delete job;
+	}
+}
+
+/////////////////////////////////////////////////
+// ワーカースレッドを起動する (起動済みなら何もしない)
+// in : workerNum  ワーカー数 (0ならメインスレッドの分を除いたコア数、最低1本)
+////////////////////////////////////////////////
+void AssetLoader::initialize(unsigned int workerNum)
+{
+	if (!mWorkers.empty())
+	{
+		return;
+	}
+
+	// SDL_imageの初期化は遅延で行われ、ワーカーから同時に呼ばれると競合するので先に済ませておく
+	IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+
+	// BC1/BC3はコアの機能ではないので拡張の有無を調べておく (無ければ.ddsがあってもPNGを読む)
+	GLint extensionNum = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionNum);
+	for (GLint i = 0; i < extensionNum; i++)
+	{
+		const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+		if (extension && strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0)
+		{
+			mS3tcSupported = true;
+		}
+	}
+
+	if (workerNum == 0)
+	{
+		workerNum = Math::Max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+	mStop = false;
+	for (unsigned int i = 0; i < workerNum; i++)
+	{
+		mWorkers.emplace_back(&AssetLoader::workerMain, this);
+	}
+}
+
+/////////////////////////////////////////////////
+// ワーカーを止め、読み込み待ちのジョブとステージングバッファを破棄する
+// GLコンテキストを破棄する前に呼ぶこと
+////////////////////////////////////////////////
+void AssetLoader::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mCondition.notify_all();
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+	mWorkers.clear();
+
+	for (Job* job : mLoadQueue)
+	{
+		delete job;
+	}
+	for (Job* job : mCompleted)
+	{
+		delete job;
+	}
+	mLoadQueue.clear();
+	mCompleted.clear();
+
+	for (StagingBuffer& staging : mStagingBuffers)
+	{
+		if (staging.fence)
+		{
+			glDeleteSync(staging.fence);
+		}
+		glDeleteBuffers(1, &staging.buffer);
+	}
+	mStagingBuffers.clear();
+}
+
+/////////////////////////////////////////////////
+// テクスチャの読み込みを要求する
+// テクスチャ名とストレージはTextureRegistryが用意し、読み込みが終わったら全レベルを書き込む
+// in : texture  転送先のテクスチャ名
+//      path     元の画像ファイル名
+//      file     selectTextureFile で選んだファイル名
+//      layer    テクスチャ配列のレイヤー (-1なら2Dテクスチャ)
+////////////////////////////////////////////////
+void AssetLoader::requestTexture(GLuint texture, const std::string& path, const std::string& file, int layer)
+{
+	Job* job = new Job;
+	job->type       = Job::Type_Texture;
+	job->path       = file;
+	job->texture    = texture;
+	job->sourcePath = path;
+	job->layer   = layer;
+	enqueue(job);
+}
+
+/////////////////////////////////////////////////
+// 画像ファイルの代わりに読むファイルを選ぶ
+// 変換ツールで作った.ddsが読めて、転送できる形式で、元の画像の大きさと更新時刻が変わっていなければ.ddsを使う
+// 無ければ前回の読み込みで作った.mip.ddsを同じ条件で使う (古ければ読み込み時に作り直す)
+// メインスレッドで呼ぶのでヘッダーとファイルの情報だけを見る (中身のハッシュはワーカーがloadJobで確かめる)
+// in  : path  画像ファイル名
+// out : info  選んだファイルのヘッダーの情報 (分からなければformatがFormat_None)
+//       読むファイル名
+////////////////////////////////////////////////
+std::string AssetLoader::selectTextureFile(const std::string& path, TextureFile::Info& info) const
+{
+	const std::string compressedPath = TextureFile::getCompressedPath(path);
+	if (TextureFile::readInfo(compressedPath, info) && isFormatSupported(info.format))
+	{
+		if (compressedPath == path || TextureFile::isSourceStampCurrent(info, path))
+		{
+			return compressedPath;
+		}
+		// 元の画像が変換後に書き換えられていたら古い.ddsは使わない
+		std::cout << "変換済みのテクスチャが元の画像より古い : " << compressedPath << std::endl;
+	}
+	const std::string mipCachePath = TextureFile::getMipCachePath(path);
+	if (compressedPath != path && TextureFile::readInfo(mipCachePath, info) && isFormatSupported(info.format) &&
+		TextureFile::isSourceStampCurrent(info, path))
+	{
+		return mipCachePath;
+	}
+	if (!TextureFile::readInfo(path, info))
+	{
+		info.format = TextureFile::Format_None;
+	}
+	return path;
+}
+
+/////////////////////////////////////////////////
+// メッシュの読み込みを要求する
+// in : mesh      読み込み先 (転送が終わるまで描画されない)
+//      path      OBJファイル名
+//      transMat  頂点座標に掛ける変換行列
+//      format    頂点フォーマット
+//      indexType 転送前にCPUで揃えるインデックスの型 (移動先のアリーナの型、GL_NONEなら頂点数で決めた型のまま)
+//      onLoaded  転送後にメインスレッドで呼ぶ処理 (インスタンスバッファの接続・アリーナへの移動など)
+////////////////////////////////////////////////
+void AssetLoader::requestMesh(MeshObj* mesh, const std::string& path, const Matrix4& transMat, MeshObj::VertexFormat format, GLenum indexType,
+	std::function<void(MeshObj&)> onLoaded)
+{
+	Job* job = new Job;
+	job->type     = Job::Type_Mesh;
+	job->path     = path;
+	job->mesh     = mesh;
+	job->transMat = transMat;
+	job->format   = format;
+	job->indexType = indexType;
+	job->onLoaded = onLoaded;
+	enqueue(job);
+}
+
+void AssetLoader::enqueue(Job* job)
+{
+	job->cancelled    = false;
+	job->succeeded    = false;
+	job->mipsBuilt    = false;
+	job->milliseconds = 0.0f;
+	if (job->type == Job::Type_Texture)
+	{
+		job->mesh = nullptr;
+	}
+	else
+	{
+		job->texture = 0;
+		job->layer   = -1;
+	}
+
+	if (isIdle())
+	{
+		mLoadStart = std::chrono::steady_clock::now();
+	}
+	initialize();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mLoadQueue.push_back(job);
+	}
+	mCondition.notify_one();
+}
+
+void AssetLoader::cancel(MeshObj* mesh)
+{
+	cancelJobs([mesh](const Job* job) { return job->mesh == mesh; });
+}
+
+void AssetLoader::cancel(GLuint texture)
+{
+	cancelJobs([texture](const Job* job) { return job->type == Job::Type_Texture && job->texture == texture; });
+	mResidentTextures.erase(std::remove(mResidentTextures.begin(), mResidentTextures.end(), texture), mResidentTextures.end());
+}
+
+/////////////////////////////////////////////////
+// 条件に合うジョブを取り消す
+// 読み込み待ち・転送待ちのものはその場で破棄し、読み込み中のものは読み込み後にワーカーが破棄する
+////////////////////////////////////////////////
+void AssetLoader::cancelJobs(const std::function<bool(const Job*)>& isTarget)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (std::deque<Job*>* jobs : { &mLoadQueue, &mCompleted })
+	{
+		for (auto it = jobs->begin(); it != jobs->end(); )
+		{
+			if (isTarget(*it))
+			{
+				delete *it;
+				it = jobs->erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+	for (Job* job : mLoadingJobs)
+	{
+		job->cancelled = job->cancelled || isTarget(job);
+	}
+}
+
+void AssetLoader::workerMain()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mCondition.wait(lock, [this]() { return mStop || !mLoadQueue.empty(); });
+		if (mStop)
+		{
+			return;
+		}
+
+		Job* job = mLoadQueue.front();
+		mLoadQueue.pop_front();
+		mLoadingJobs.push_back(job);
+
+		// ファイルの読み込み・デコード中はロックを外す
+		lock.unlock();
+		loadJob(job);
+		lock.lock();
+
+		mLoadingJobs.erase(std::find(mLoadingJobs.begin(), mLoadingJobs.end(), job));
+		if (job->cancelled)
+		{
+			delete job;
+		}
+		else
+		{
+			mCompleted.push_back(job);
+		}
+		mCondition.notify_all();
+	}
+}
+
+/////////////////////////////////////////////////
+// ファイルを読み込み、転送できる形にする (ワーカースレッド、GLは使わない)
+// テクスチャは変換済みの.dds (.mip.dds) があればそのまま、無ければ画像をデコードして行の詰め物を除いたRGB/RGBAにし、
+// MipBuilderで全ミップレベルを作って .mip.dds に保存する (保存できなくてもそのまま使う)
+// メッシュはMeshObj::prepareMeshの結果にする
+////////////////////////////////////////////////
+void AssetLoader::loadJob(Job* job) const
+{
+	const auto loadStart = std::chrono::steady_clock::now();
+
+	if (job->type == Job::Type_Texture)
+	{
+		TextureFile& image = job->image;
+		bool decode = TextureFile::getCompressedPath(job->path) != job->path;
+		if (!decode)
+		{
+			job->succeeded = image.loadDDS(job->path) && isFormatSupported(image.getFormat());
+
+			// 選ぶ時には大きさと更新時刻しか比べていないので、元の画像の中身が変わっていないかをここで確かめる
+			if (job->succeeded && job->path != job->sourcePath && !image.isSourceCurrent(job->sourcePath))
+			{
+				if (job->path == TextureFile::getMipCachePath(job->sourcePath))
+				{
+					// 実行時に作ったミップは元の画像から作り直す (形式と大きさは元の画像と同じ)
+					std::cout << "ミップのキャッシュが元の画像より古いので作り直す : " << job->path << std::endl;
+					image.clear();
+					job->succeeded = false;
+					decode = true;
+				}
+				else
+				{
+					// 変換済みの.ddsは形式が違うので確保済みのストレージに合わせてそのまま使う
+					std::cout << "変換済みのテクスチャが元の画像より古い (変換し直すこと) : " << job->path << std::endl;
+				}
+			}
+		}
+		if (decode)
+		{
+			SDL_Surface* surf = IMG_Load(job->sourcePath.c_str());
+			if (surf && surf->format->BytesPerPixel != 3 && surf->format->BytesPerPixel != 4)
+			{
+				// パレット・グレースケールなどはRGBA (リトルエンディアンのABGR8888) に変換する
+				SDL_Surface* converted = SDL_ConvertSurfaceFormat(surf, SDL_PIXELFORMAT_ABGR8888, 0);
+				SDL_FreeSurface(surf);
+				surf = converted;
+			}
+			if (surf)
+			{
+				const int    channels = surf->format->BytesPerPixel;
+				const size_t rowBytes = static_cast<size_t>(surf->w) * channels;
+				image.create(channels == 4 ? TextureFile::Format_RGBA8 : TextureFile::Format_RGB8, surf->w, surf->h, 1);
+				for (int y = 0; y < surf->h; y++)
+				{
+					memcpy(image.getLevelData(0) + rowBytes * y, static_cast<const unsigned char*>(surf->pixels) + static_cast<size_t>(surf->pitch) * y, rowBytes);
+				}
+				SDL_FreeSurface(surf);
+				job->succeeded = true;
+
+				// ワーカー自体が並列なので、ミップの計算は1スレッドで行う
+				TextureFile mips;
+				if (MipBuilder::build(mips, image, MipBuilder::getDefaultMode(job->sourcePath), 1))
+				{
+					mips.saveDDS(TextureFile::getMipCachePath(job->sourcePath), job->sourcePath); // 失敗してもsaveDDSが表示して今回はそのまま使う
+					image = std::move(mips);
+					job->mipsBuilt = true;
+				}
+			}
+		}
+		if (!job->succeeded)
+		{
+			image.clear();
+		}
+	}
+	else
+	{
+		job->succeeded = MeshObj::prepareMesh(job->meshData, job->path.c_str(), job->transMat, job->format);
+		if (job->succeeded && job->indexType != GL_NONE)
+		{
+			// 16bitに収まらなければ変換せずにそのまま転送する (アリーナには入らず専用のバッファで描く)
+			MeshObj::convertIndexType(job->meshData, job->indexType);
+		}
+	}
+
+	job->milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+}
+
+bool AssetLoader::isFormatSupported(TextureFile::Format format) const
+{
+	if (format == TextureFile::Format_BC1 || format == TextureFile::Format_BC3)
+	{
+		return mS3tcSupported;
+	}
+	return format != TextureFile::Format_None;
+}
+
+size_t AssetLoader::getUploadSize(const Job* job)
+{
+	if (!job->succeeded)
+	{
+		return 0;
+	}
+	if (job->type == Job::Type_Texture)
+	{
+		return job->image.getData().size();
+	}
+
+	// インデックスは4byte境界に置く
+	const MeshLoadData& data = job->meshData;
+	const size_t vertexBytes = (static_cast<size_t>(MeshObj::getVertexSize(data.format)) * data.vertexCount + 3) & ~static_cast<size_t>(3);
+	return vertexBytes + static_cast<size_t>(MeshObj::getIndexBytes(data.indexType)) * data.indexCount;
+}
+
+/////////////////////////////////////////////////
+// size バイト以上の空いているステージングバッファを返す
+// GPUが読み終えた(フェンスが通った)バッファを空きとし、足りなければ作るか大きくする
+// in  : size  必要なバイト数
+//       wait  全て使用中ならGPUが読み終えるまで待つか
+// out : ステージングバッファ (待たない場合で全て使用中ならnullptr)
+////////////////////////////////////////////////
+AssetLoader::StagingBuffer* AssetLoader::acquireStagingBuffer(GLsizeiptr size, bool wait)
+{
+	StagingBuffer* found = nullptr;
+	while (!found)
+	{
+		for (StagingBuffer& staging : mStagingBuffers)
+		{
+			if (staging.fence)
+			{
+				GLenum result = glClientWaitSync(staging.fence, 0, 0);
+				if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+				{
+					continue;
+				}
+				glDeleteSync(staging.fence);
+				staging.fence = nullptr;
+			}
+
+			// 空いている中で足りる最小のもの (足りるものが無ければ最大のものを大きくする)
+			if (!found ||
+				(found->size < size && staging.size > found->size) ||
+				(staging.size >= size && staging.size < found->size))
+			{
+				found = &staging;
+			}
+		}
+
+		if (!found || found->size < size)
+		{
+			if (mStagingBuffers.size() < mStagingBufferMax)
+			{
+				mStagingBuffers.push_back({ 0, 0, nullptr });
+				found = &mStagingBuffers.back();
+				glGenBuffers(1, &found->buffer);
+			}
+			else if (!found)
+			{
+				if (!wait)
+				{
+					return nullptr;
+				}
+
+				// 最も古いコピーを待つ (フェンスを作った順に並んでいるとは限らないので先頭から)
+				for (StagingBuffer& staging : mStagingBuffers)
+				{
+					if (staging.fence)
+					{
+						glClientWaitSync(staging.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+						break;
+					}
+				}
+				continue;
+			}
+		}
+	}
+
+	if (found->size < size)
+	{
+		found->size = Math::Max(size, mStagingBufferMinSize);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, found->buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, found->size, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	return found;
+}
+
+/////////////////////////////////////////////////
+// 読み込んだ内容をステージングバッファに書き込み、GPU側のコピーで転送する
+// コピーの後にフェンスを置き、GPUが読み終えるまでそのバッファは使わない
+////////////////////////////////////////////////
+void AssetLoader::uploadJob(Job* job, StagingBuffer& staging)
+{
+	const size_t size = getUploadSize(job);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, staging.buffer);
+	unsigned char* dest = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(size),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+	// マップできなければ読み込んだメモリから直接転送する
+	const GLuint source = dest ? staging.buffer : 0;
+
+	if (job->type == Job::Type_Texture)
+	{
+		const TextureFile& image = job->image;
+		if (dest)
+		{
+			memcpy(dest, image.getData().data(), size);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		// ヘッダーから確保済みのストレージと食い違えば (読み込み中にファイルが書き換わったなど) 転送しない
+		const TextureFile::Format format = image.getFormat();
+		const TextureFile::Info   info   = { format, image.getWidth(), image.getHeight(), image.getLevelNum(), 0, 0, 0 };
+		GLenum       internalFormat = GL_NONE;
+		unsigned int levelNum       = 0;
+		if (!TextureRegistry::getStorageFormat(info, internalFormat, levelNum) ||
+			!TEXTURE_REGISTRY_INSTANCE.allocateStorage(job->texture, internalFormat, info.width, info.height, levelNum))
+		{
+			std::cout << "テクスチャの大きさ・形式が確保済みのストレージと違う : " << job->path << std::endl;
+			fillFailedTexture(job);
+			mFailedNum++;
+		}
+		else
+		{
+			// 同じテクスチャ名 (テクスチャ配列ならそのレイヤー) の全レベルを書き込む
+			const bool   layered = job->layer >= 0;
+			const GLenum target  = layered ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+			RENDER_STATE_INSTANCE.bindTexture(0, target, job->texture);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, source);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			for (unsigned int i = 0; i < image.getLevelNum(); i++)
+			{
+				// ステージングバッファからはバッファ先頭からのオフセットで指定する
+				const TextureLevel& level  = image.getLevel(i);
+				const void*         pixels = source ? reinterpret_cast<const void*>(level.offset) : image.getLevelData(i);
+				const GLsizei       size   = static_cast<GLsizei>(level.size);
+				const GLenum        pixelFormat = TextureFile::getPixelFormat(format);
+				if (layered && TextureFile::isCompressed(format))
+				{
+					glCompressedTexSubImage3D(target, i, 0, 0, job->layer, level.width, level.height, 1, internalFormat, size, pixels);
+				}
+				else if (layered)
+				{
+					glTexSubImage3D(target, i, 0, 0, job->layer, level.width, level.height, 1, pixelFormat, GL_UNSIGNED_BYTE, pixels);
+				}
+				else if (TextureFile::isCompressed(format))
+				{
+					glCompressedTexSubImage2D(target, i, 0, 0, level.width, level.height, internalFormat, size, pixels);
+				}
+				else
+				{
+					glTexSubImage2D(target, i, 0, 0, level.width, level.height, pixelFormat, GL_UNSIGNED_BYTE, pixels);
+				}
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			// 2Dは仮の色の最小レベルから描くのをやめる (テクスチャ配列はレイヤーごとに全レベルを埋めてあるので変えない)
+			if (!layered)
+			{
+				glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+				glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levelNum - 1));
+			}
+
+			// ミップレベルが揃っていなければ残りをGPUで作る (テクスチャ配列は全レイヤーを作り直す)
+			if (image.getLevelNum() < levelNum)
+			{
+				glGenerateMipmap(target);
+				mGpuMipNum++;
+			}
+			if (job->mipsBuilt)
+			{
+				mMipBuiltNum++;
+			}
+			if (TextureFile::isCompressed(format))
+			{
+				mCompressedNum++;
+			}
+		}
+	}
+	else
+	{
+		const MeshLoadData& data = job->meshData;
+		const size_t vertexBytes = static_cast<size_t>(MeshObj::getVertexSize(data.format)) * data.vertexCount;
+		const size_t indexOffset = (vertexBytes + 3) & ~static_cast<size_t>(3);
+		if (dest)
+		{
+			memcpy(dest, data.vertices, vertexBytes);
+			memcpy(dest + indexOffset, data.indices, size - indexOffset);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		job->mesh->uploadMesh(data, source, 0, static_cast<GLintptr>(indexOffset));
+	}
+
+	staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mUploadedBytes += size;
+}
+
+void AssetLoader::fillFailedTexture(const Job* job)
+{
+	if (job->layer >= 0)
+	{
+		TEXTURE_REGISTRY_INSTANCE.fillLayer(job->texture, static_cast<unsigned int>(job->layer), failedColor);
+	}
+	else
+	{
+		TEXTURE_REGISTRY_INSTANCE.fillPlaceholder(job->texture, failedColor);
+	}
+}
+
+/////////////////////////////////////////////////
+// 読み込み済みのジョブを転送する (メインスレッド)
+// in  : wait  trueならステージングバッファが空くのを待ち、予算も無視して全て転送する
+// out : 読み込み済みのジョブを全て転送したらtrue
+////////////////////////////////////////////////
+bool AssetLoader::uploadCompleted(bool wait)
+{
+	size_t uploaded = 0;
+	while (true)
+	{
+		// 取り出すのはメインスレッドだけなので、先頭を見てから転送先を用意しても入れ替わらない
+		Job* job;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mCompleted.empty())
+			{
+				return true;
+			}
+			job = mCompleted.front();
+		}
+
+		const size_t size = getUploadSize(job);
+		if (!wait && uploaded > 0 && uploaded + size > mUploadBudget)
+		{
+			return false;
+		}
+		StagingBuffer* staging = nullptr;
+		if (size > 0)
+		{
+			staging = acquireStagingBuffer(static_cast<GLsizeiptr>(size), wait);
+			if (!staging)
+			{
+				return false;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mCompleted.pop_front();
+		}
+		mWorkerMilliseconds += job->milliseconds;
+
+		if (job->type == Job::Type_Texture)
+		{
+			if (staging)
+			{
+				uploadJob(job, *staging);
+			}
+			else
+			{
+				std::cout << "ファイル読み込みに失敗 : " << job->path << std::endl;
+				fillFailedTexture(job);
+				mFailedNum++;
+			}
+			mResidentTextures.push_back(job->texture);
+			mTextureNum++;
+		}
+		else
+		{
+			if (staging)
+			{
+				uploadJob(job, *staging);
+				if (job->onLoaded)
+				{
+					job->onLoaded(*job->mesh);
+				}
+				mMeshNum++;
+			}
+			else
+			{
+				mFailedNum++;
+			}
+		}
+
+		uploaded += size;
+		delete job;
+	}
+}
+
+void AssetLoader::update()
+{
+	if (isIdle())
+	{
+		return;
+	}
+
+	uploadCompleted(false);
+
+	if (isIdle())
+	{
+		mLoadMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mLoadStart).count();
+	}
+}
+
+void AssetLoader::finish()
+{
+	while (!isIdle())
+	{
+		{
+			// ワーカーの読み込みが終わるか、転送できるジョブが出るまで待つ
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return !mCompleted.empty() || (mLoadQueue.empty() && mLoadingJobs.empty()); });
+		}
+		uploadCompleted(true);
+	}
+	mLoadMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mLoadStart).count();
+}
+
+bool AssetLoader::isIdle() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mLoadQueue.empty() && mLoadingJobs.empty() && mCompleted.empty();
+}
+
+bool AssetLoader::isResident(GLuint texture) const
+{
+	return std::find(mResidentTextures.begin(), mResidentTextures.end(), texture) != mResidentTextures.end();
+}
+
+void AssetLoader::printReport(std::ostream& os) const
+{
+	os << "asset loader : " << mTextureNum << " textures (" << mCompressedNum << " block-compressed, " << mMipBuiltNum << " mip-built, " << mGpuMipNum << " gpu-mipmapped), " << mMeshNum << " meshes (" << mFailedNum << " failed), "
+	   << std::fixed << std::setprecision(2) << mUploadedBytes / (1024.0 * 1024.0) << " MB uploaded, "
+	   << mLoadMilliseconds << " ms until all resident (" << mWorkerMilliseconds << " ms of loading on "
+	   << mWorkers.size() << " workers)" << std::endl;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <ostream>
+#include "Math.h"
+#include "MeshObj.h"
+#include "TextureFile.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// アセットの非同期読み込み
+// テクスチャ・メッシュの要求を受け取り、
+//   1. ワーカースレッド(コア数-1本)でファイルの読み込みとデコード(PNGの展開・OBJの解析と最適化)を行う
+//      テクスチャは変換ツールで作った同じ名前の.dds (ブロック圧縮・ミップ済み) があればそちらを読み、
+//      デコードとミップマップの生成を省く
+//      .ddsが無いPNGはデコード後にMipBuilderでミップを作り、元の画像の隣に .mip.dds で保存する
+//      (次回からはそれを読む。glGenerateMipmapはミップを作れなかった時の予備)
+//   2. メインスレッド(update)で完了した物をステージングバッファ(PBO)に書き込み、
+//      GPU側のコピー(glTexSubImage2D / glCopyBufferSubData)で転送する
+//   3. ステージングバッファはフェンスでGPUが読み終えたのを確認してから再利用する
+// テクスチャ名とストレージはTextureRegistryが用意し、転送時に同じテクスチャ名の全レベルを書き込む
+// (テクスチャ配列はレイヤーを指定して、そのレイヤーの全レベルを書き込む)
+// (ヘッダーから確保できなかった物は転送時にTextureRegistryで確保する)
+// メッシュは転送が終わるまで描画されず、転送後に onLoaded を呼ぶ (アリーナへの移動など)
+//
+// 使い方 :
+//   initialize() → TextureRegistry::acquire / requestMesh … → 毎フレーム update()
+//   全て揃うまで待つ場合は finish()
+///////////////////////////////////////////////////////////////////////////////////////
+class AssetLoader
+{
+public:
+	static AssetLoader& AssetLoaderInstance()        // インスタンス
+	{
+		static AssetLoader AssetLoaderInstance;
+		return AssetLoaderInstance;
+	}
+
+	~AssetLoader();
+
+	void         initialize(unsigned int workerNum = 0);          // ワーカーの起動 (0ならコア数-1、最低1本)
+	void         shutdown();                                      // ワーカーの停止とステージングバッファの破棄 (GLコンテキストの破棄前)
+	void         requestTexture(GLuint texture, const std::string& path, const std::string& file, int layer = -1); // テクスチャの読み込み要求 (layer : テクスチャ配列のレイヤー、-1なら2D)
+	std::string  selectTextureFile(const std::string& path, TextureFile::Info& info) const; // 実際に読むファイル (使える.dds・.mip.ddsがあればそちら) とその情報
+	void         requestMesh(MeshObj* mesh, const std::string& path, const Matrix4& transMat, MeshObj::VertexFormat format, GLenum indexType,
+	                         std::function<void(MeshObj&)> onLoaded = nullptr);                      // メッシュの読み込み要求
+	void         cancel(MeshObj* mesh);                           // 読み込み待ちから外す (MeshObjの破棄時)
+	void         cancel(GLuint texture);                          // 読み込み待ちから外す (テクスチャの削除前)
+	void         update();                                        // 完了した物の転送 (メインスレッド、1回の転送量はmUploadBudgetまで)
+	void         finish();                                        // 全ての転送が終わるまで待つ
+
+	bool         isIdle() const;                                  // 読み込み・転送待ちが無いか
+	bool         isResident(GLuint texture) const;                // 読み込んだ内容が転送済みか
+	void         setUploadBudget(size_t bytes) { mUploadBudget = bytes; }
+	void         printReport(std::ostream& os) const;
+
+private:
+	AssetLoader(); // シングルトン
+
+	static const unsigned int mStagingBufferMax = 4;                 // ステージングバッファの最大数
+	static const GLsizeiptr   mStagingBufferMinSize = 4 * 1024 * 1024; // ステージングバッファの最小サイズ
+
+	// 読み込みジョブ
+	struct Job
+	{
+		enum Type
+		{
+			Type_Texture,
+			Type_Mesh
+		};
+
+		Type          type;
+		std::string   path;
+		bool          cancelled;
+		bool          succeeded;
+		float         milliseconds;   // ワーカーでの読み込み時間
+
+		// テクスチャ
+		GLuint        texture;
+		std::string   sourcePath;     // 元の画像ファイル名 (.ddsを読む時にハッシュを確かめる)
+		int           layer;          // テクスチャ配列のレイヤー (-1なら2Dテクスチャ)
+		TextureFile   image;          // 全ミップレベル (ミップを作れなかった場合はレベル0のみ)
+		bool          mipsBuilt;      // PNGからミップを作ったか
+
+		// メッシュ
+		MeshObj*      mesh;
+		Matrix4       transMat;
+		MeshObj::VertexFormat format;
+		GLenum        indexType;      // 転送前に揃えるインデックスの型 (GL_NONEならprepareMeshが決めた型のまま)
+		MeshLoadData  meshData;
+		std::function<void(MeshObj&)> onLoaded;
+	};
+
+	// GPUが読み終えるまで再利用しないステージングバッファ
+	struct StagingBuffer
+	{
+		GLuint      buffer;
+		GLsizeiptr  size;
+		GLsync      fence;            // 最後に使ったコピーの完了 (nullptrなら空き)
+	};
+
+	void           enqueue(Job* job);
+	void           cancelJobs(const std::function<bool(const Job*)>& isTarget); // 条件に合うジョブの取り消し
+	void           workerMain();                                  // ワーカースレッドの処理
+	void           loadJob(Job* job) const;                       // ファイルの読み込みとデコード (GLは使わない)
+	bool           isFormatSupported(TextureFile::Format format) const; // 転送できるテクスチャの形式か
+	static size_t  getUploadSize(const Job* job);                 // ステージングバッファに書き込むバイト数
+	StagingBuffer* acquireStagingBuffer(GLsizeiptr size, bool wait); // 空いているステージングバッファ (無ければnullptr)
+	void           uploadJob(Job* job, StagingBuffer& staging);   // ステージングバッファ経由の転送
+	static void    fillFailedTexture(const Job* job);             // 読み込めなかったテクスチャ (レイヤー) を黒で埋める
+	bool           uploadCompleted(bool wait);                    // 完了したジョブを転送 (予算を使い切ったらfalse)
+
+	std::vector<std::thread> mWorkers;                            // 読み込みスレッド
+	mutable std::mutex      mMutex;                               // 以下のジョブ一覧を保護
+	std::condition_variable mCondition;
+	std::deque<Job*>        mLoadQueue;                           // 読み込み待ち
+	std::vector<Job*>       mLoadingJobs;                         // ワーカーが読み込み中
+	std::deque<Job*>        mCompleted;                           // 読み込み済み (転送待ち)
+	bool                    mStop;                                // ワーカーの終了要求
+
+	std::vector<StagingBuffer> mStagingBuffers;                   // メインスレッドのみ
+	std::vector<GLuint>     mResidentTextures;                    // 転送済みのテクスチャ
+	bool                    mS3tcSupported;                       // BC1/BC3を使えるか (initializeで調べる)
+	size_t                  mUploadBudget;                        // 1回のupdateで転送するバイト数の上限 (最低1つは転送する)
+
+	// レポート用
+	std::chrono::steady_clock::time_point mLoadStart;             // アイドルから最初に要求した時刻
+	float                   mLoadMilliseconds;                    // 最後にアイドルになるまでの時間
+	float                   mWorkerMilliseconds;                  // ワーカーでの読み込み時間の合計
+	unsigned int            mTextureNum;                          // 転送したテクスチャ数
+	unsigned int            mCompressedNum;                       // そのうちブロック圧縮の数
+	unsigned int            mMipBuiltNum;                         // そのうちPNGからCPUでミップを作った数
+	unsigned int            mGpuMipNum;                           // そのうちglGenerateMipmapでミップを作った数
+	unsigned int            mMeshNum;                             // 転送したメッシュ数
+	unsigned int            mFailedNum;                           // 読み込めなかった数
+	size_t                  mUploadedBytes;                       // 転送したバイト数
+};
+
+#define ASSET_LOADER_INSTANCE AssetLoader::AssetLoaderInstance()
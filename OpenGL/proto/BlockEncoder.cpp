@@ -0,0 +1,377 @@
+#include <thread>
+#include <vector>
+#include <cstring>
+#include "BlockEncoder.h"
+#include "Math.h"
+
+static const unsigned int refineIterationNum = 2; // BC1の端点の当てはめ直しの回数
+
+// 8bitの色をRGB565に丸める
+static unsigned short packColor565(const float* color)
+{
+	const int r = Math::Clamp(static_cast<int>(color[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	const int g = Math::Clamp(static_cast<int>(color[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+	const int b = Math::Clamp(static_cast<int>(color[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+	return static_cast<unsigned short>((r << 11) | (g << 5) | b);
+}
+
+// RGB565をデコーダーと同じ方法で8bitに戻す
+static void unpackColor565(unsigned short packed, float* color)
+{
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+	color[0] = static_cast<float>((r << 3) | (r >> 2));
+	color[1] = static_cast<float>((g << 2) | (g >> 4));
+	color[2] = static_cast<float>((b << 3) | (b >> 2));
+}
+
+static float distanceSq(const float* a, const float* b)
+{
+	const float dr = a[0] - b[0];
+	const float dg = a[1] - b[1];
+	const float db = a[2] - b[2];
+	return dr * dr + dg * dg + db * db;
+}
+
+// 端点 (c0 > c1 の4色モード) から各画素のインデックスを選ぶ
+// out : 誤差の合計
+static float selectIndices(const float (*pixels)[3], unsigned short color0, unsigned short color1, unsigned int* indices)
+{
+	float palette[4][3];
+	unpackColor565(color0, palette[0]);
+	unpackColor565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+		palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+	}
+
+	float error = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		unsigned int best = 0;
+		float bestDistance = distanceSq(pixels[i], palette[0]);
+		for (unsigned int p = 1; p < 4; p++)
+		{
+			const float distance = distanceSq(pixels[i], palette[p]);
+			if (distance < bestDistance)
+			{
+				best = p;
+				bestDistance = distance;
+			}
+		}
+		indices[i] = best;
+		error += bestDistance;
+	}
+	return error;
+}
+
+// インデックスを固定して、誤差が最小になる端点を最小二乗法で求める
+// out : 求められたらtrue (全画素が同じインデックスなら解けない)
+static bool fitEndpoints(const float (*pixels)[3], const unsigned int* indices, float* end0, float* end1)
+{
+	// インデックスごとの end0 の重み (色 = w * end0 + (1 - w) * end1)
+	static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ap[3] = { 0.0f, 0.0f, 0.0f };
+	float bp[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+	{
+		const float a = weights[indices[i]];
+		const float b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < 3; c++)
+		{
+			ap[c] += a * pixels[i][c];
+			bp[c] += b * pixels[i][c];
+		}
+	}
+
+	const float det = aa * bb - ab * ab;
+	if (Math::Abs(det) < 1.0e-6f)
+	{
+		return false;
+	}
+	const float invDet = 1.0f / det;
+	for (int c = 0; c < 3; c++)
+	{
+		end0[c] = Math::Clamp((ap[c] * bb - bp[c] * ab) * invDet, 0.0f, 255.0f);
+		end1[c] = Math::Clamp((bp[c] * aa - ap[c] * ab) * invDet, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+// 端点を4色モードの順 (color0 > color1) にして書き込む
+static void writeBC1(unsigned char* dest, unsigned short color0, unsigned short color1, const unsigned int* indices)
+{
+	// 入れ替えると 0<->1, 2<->3 が入れ替わる
+	const bool swap = color0 < color1;
+	if (swap)
+	{
+		const unsigned short temp = color0;
+		color0 = color1;
+		color1 = temp;
+	}
+
+	unsigned int bits = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			bits |= (swap ? indices[i] ^ 1u : indices[i]) << (i * 2);
+		}
+	}
+	dest[0] = static_cast<unsigned char>(color0);
+	dest[1] = static_cast<unsigned char>(color0 >> 8);
+	dest[2] = static_cast<unsigned char>(color1);
+	dest[3] = static_cast<unsigned char>(color1 >> 8);
+	dest[4] = static_cast<unsigned char>(bits);
+	dest[5] = static_cast<unsigned char>(bits >> 8);
+	dest[6] = static_cast<unsigned char>(bits >> 16);
+	dest[7] = static_cast<unsigned char>(bits >> 24);
+}
+
+/////////////////////////////////////////////////
+// 画像1枚をブロック圧縮する
+// out : dest       圧縮したブロック (TextureFile::getLevelSize() バイト)
+// in  : rgba       RGBA8の画像
+//       width      幅
+//       height     高さ
+//       format     BC1 / BC3 / BC4 / BC5
+//       threadNum  スレッド数 (0ならコア数、ブロック行が少なければ減らす)
+// out : 対応している形式ならtrue
+////////////////////////////////////////////////
+bool BlockEncoder::encode(unsigned char* dest, const unsigned char* rgba, int width, int height, TextureFile::Format format, unsigned int threadNum)
+{
+	if (format != TextureFile::Format_BC1 && format != TextureFile::Format_BC3 &&
+		format != TextureFile::Format_BC4 && format != TextureFile::Format_BC5)
+	{
+		return false;
+	}
+
+	const int blockRows = (height + 3) / 4;
+	if (threadNum == 0)
+	{
+		threadNum = Math::Max(std::thread::hardware_concurrency(), 1u);
+	}
+	threadNum = Math::Max(Math::Min(threadNum, static_cast<unsigned int>(blockRows / mParallelBlockRowNum)), 1u);
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < threadNum; i++)
+	{
+		threads.emplace_back(&BlockEncoder::encodeRows, dest, rgba, width, height, format,
+			static_cast<int>(static_cast<long long>(blockRows) * i / threadNum),
+			static_cast<int>(static_cast<long long>(blockRows) * (i + 1) / threadNum));
+	}
+	encodeRows(dest, rgba, width, height, format, 0, blockRows / static_cast<int>(threadNum));
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	return true;
+}
+
+/////////////////////////////////////////////////
+// ブロック行 [firstBlockRow, lastBlockRow) を圧縮する
+////////////////////////////////////////////////
+void BlockEncoder::encodeRows(unsigned char* dest, const unsigned char* rgba, int width, int height, TextureFile::Format format,
+	int firstBlockRow, int lastBlockRow)
+{
+	const int    blocksX    = (width + 3) / 4;
+	const size_t blockBytes = TextureFile::getBlockBytes(format);
+
+	unsigned char block[16 * 4];
+	for (int by = firstBlockRow; by < lastBlockRow; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			// 画像の外は端の画素を繰り返す
+			for (int y = 0; y < 4; y++)
+			{
+				const int sy = Math::Min(by * 4 + y, height - 1);
+				for (int x = 0; x < 4; x++)
+				{
+					const int sx = Math::Min(bx * 4 + x, width - 1);
+					memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+				}
+			}
+
+			unsigned char* out = dest + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+			switch (format)
+			{
+			case TextureFile::Format_BC1:
+				encodeBC1(out, block);
+				break;
+			case TextureFile::Format_BC3:
+				encodeBC4(out, block, 3);
+				encodeBC1(out + 8, block);
+				break;
+			case TextureFile::Format_BC4:
+				encodeBC4(out, block, 0);
+				break;
+			default:
+				encodeBC4(out, block, 0);
+				encodeBC4(out + 8, block, 1);
+				break;
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// 4x4のRGBAをBC1 (4色モード、アルファ無し) に圧縮する
+// out : dest   8バイト
+// in  : block  16画素のRGBA
+////////////////////////////////////////////////
+void BlockEncoder::encodeBC1(unsigned char* dest, const unsigned char* block)
+{
+	float pixels[16][3];
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			pixels[i][c] = block[i * 4 + c];
+			mean[c] += pixels[i][c];
+		}
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		mean[c] /= 16.0f;
+	}
+
+	// 共分散行列の主成分 (べき乗法)
+	float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; // rr rg rb gg gb bb
+	for (int i = 0; i < 16; i++)
+	{
+		const float r = pixels[i][0] - mean[0];
+		const float g = pixels[i][1] - mean[1];
+		const float b = pixels[i][2] - mean[2];
+		cov[0] += r * r;
+		cov[1] += r * g;
+		cov[2] += r * b;
+		cov[3] += g * g;
+		cov[4] += g * b;
+		cov[5] += b * b;
+	}
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		const float length = Math::Max(Math::Abs(x), Math::Max(Math::Abs(y), Math::Abs(z)));
+		if (length < 1.0e-6f)
+		{
+			break; // 単色のブロック
+		}
+		axis[0] = x / length;
+		axis[1] = y / length;
+		axis[2] = z / length;
+	}
+
+	// 軸に投影して両端の画素を端点の初期値にする
+	int minIndex = 0, maxIndex = 0;
+	float minDot = 1.0e30f, maxDot = -1.0e30f;
+	for (int i = 0; i < 16; i++)
+	{
+		const float dot = pixels[i][0] * axis[0] + pixels[i][1] * axis[1] + pixels[i][2] * axis[2];
+		if (dot < minDot)
+		{
+			minDot = dot;
+			minIndex = i;
+		}
+		if (dot > maxDot)
+		{
+			maxDot = dot;
+			maxIndex = i;
+		}
+	}
+
+	unsigned short color0 = packColor565(pixels[maxIndex]);
+	unsigned short color1 = packColor565(pixels[minIndex]);
+	unsigned int   indices[16];
+	float          error = selectIndices(pixels, color0, color1, indices);
+
+	// インデックスを固定して端点を当てはめ直し、誤差が減ったら採用する
+	for (unsigned int iteration = 0; iteration < refineIterationNum && error > 0.0f; iteration++)
+	{
+		float end0[3], end1[3];
+		if (!fitEndpoints(pixels, indices, end0, end1))
+		{
+			break;
+		}
+		const unsigned short newColor0 = packColor565(end0);
+		const unsigned short newColor1 = packColor565(end1);
+		unsigned int newIndices[16];
+		const float newError = selectIndices(pixels, newColor0, newColor1, newIndices);
+		if (newError >= error)
+		{
+			break;
+		}
+		color0 = newColor0;
+		color1 = newColor1;
+		memcpy(indices, newIndices, sizeof(indices));
+		error = newError;
+	}
+
+	writeBC1(dest, color0, color1, indices);
+}
+
+/////////////////////////////////////////////////
+// 4x4のRGBAの1チャンネルをBC4 (8段階の補間) に圧縮する
+// out : dest     8バイト
+// in  : block    16画素のRGBA
+//       channel  0:R 1:G 2:B 3:A
+////////////////////////////////////////////////
+void BlockEncoder::encodeBC4(unsigned char* dest, const unsigned char* block, unsigned int channel)
+{
+	int minValue = 255, maxValue = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		const int value = block[i * 4 + channel];
+		minValue = Math::Min(minValue, value);
+		maxValue = Math::Max(maxValue, value);
+	}
+
+	dest[0] = static_cast<unsigned char>(maxValue);
+	dest[1] = static_cast<unsigned char>(minValue);
+
+	// a0 > a1 の8段階モード : 0:a0 1:a1 2～7:a0からa1への補間
+	unsigned long long bits = 0;
+	if (maxValue != minValue)
+	{
+		int palette[8];
+		palette[0] = maxValue;
+		palette[1] = minValue;
+		for (int i = 2; i < 8; i++)
+		{
+			palette[i] = ((8 - i) * maxValue + (i - 1) * minValue) / 7;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			const int value = block[i * 4 + channel];
+			unsigned long long best = 0;
+			int bestDistance = 256;
+			for (int p = 0; p < 8; p++)
+			{
+				const int distance = value > palette[p] ? value - palette[p] : palette[p] - value;
+				if (distance < bestDistance)
+				{
+					best = static_cast<unsigned long long>(p);
+					bestDistance = distance;
+				}
+			}
+			bits |= best << (i * 3);
+		}
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		dest[2 + i] = static_cast<unsigned char>(bits >> (i * 8));
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "TextureFile.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// CPUでのブロック圧縮 (BC1 / BC3 / BC4 / BC5)
+// 画像を4x4のブロックに分け、ブロック行の範囲をスレッドに分けて圧縮する
+//
+// BC1 : 色の主成分の軸の両端を端点の初期値にし、インデックスの割り当てと
+//       端点の最小二乗法による当てはめを交互に繰り返して誤差の小さい方を使う
+// BC4 : ブロック内の最小値・最大値を端点にした8段階の補間 (BC3のアルファ、BC5のR・Gも同じ)
+// 入力はRGBA8 (1画素4バイト)、画像の端で4に満たないブロックは端の画素を繰り返す
+///////////////////////////////////////////////////////////////////////////////////////
+class BlockEncoder
+{
+public:
+	static const unsigned int mParallelBlockRowNum = 16; // これ以上のブロック行があれば複数スレッドで圧縮
+
+	static bool encode(unsigned char* dest, const unsigned char* rgba, int width, int height, TextureFile::Format format,
+	                   unsigned int threadNum = 0);       // 画像1枚を圧縮する (threadNum 0ならコア数)
+	static void encodeBC1(unsigned char* dest, const unsigned char* block);                       // 4x4のRGBAから8バイト
+	static void encodeBC4(unsigned char* dest, const unsigned char* block, unsigned int channel); // 4x4のRGBAの1チャンネルから8バイト
+
+private:
+	BlockEncoder() = delete;
+
+	static void encodeRows(unsigned char* dest, const unsigned char* rgba, int width, int height, TextureFile::Format format,
+	                       int firstBlockRow, int lastBlockRow);
+};
@@ -1,15 +1,15 @@
 #include "FlyCamera.h"
 
-const float initZoomDegree  =  45.0f ; // Y[p(degree)
-const float initMoveSpeed   =   5.5f ; // ړx ( / secP)
-const float initSensitibity =  0.25f ; // zC[XN[x( / frame )
-const float initYawDegree   = -90.0f ; // ]ʒu (x-90xړ zΑ)
+const float initZoomDegree  =  45.0f ; // 初期ズーム画角(degree)
+const float initMoveSpeed   =   5.5f ; // 初期移動速度 ( / sec単位)
+const float initSensitibity =  0.25f ; // 初期ホイールスクロール感度( / frame )
+const float initYawDegree   = -90.0f ; // 初期回転位置 (x軸から-90度移動 z軸反対側)
 
-const float pitchMaxDegree  =  89.0f ; // Jsb`ōpx(degree)
-const float pitchMinDegree  = -89.0f ; // Jsb`Œpx(degree)
+const float pitchMaxDegree  =  89.0f ; // カメラピッチ最高角度(degree)
+const float pitchMinDegree  = -89.0f ; // カメラピッチ最低角度(degree)
 
-const float zoomMaxDegree   =  90.0f ; // Y[pőpx(Y[AEg)
-const float zoomMinDegree   =   1.0f ; // Y[pŏpx(Y[C)
+const float zoomMaxDegree   =  90.0f ; // ズーム画角最大角度(ズームアウト)
+const float zoomMinDegree   =   1.0f ; // ズーム画角最小角度(ズームイン)
 
 
 FlyCamera::FlyCamera(Vector3& cameraPos)
@@ -30,21 +30,21 @@ FlyCamera::FlyCamera(Vector3& cameraPos)
 }
 
 
-// J̍XV
+// カメラの更新処理
 void FlyCamera::UpdateCamera(float frameDeltaTime)
 {
-	UpdateMouse(frameDeltaTime); // [sb`EY[̕ύX
-	UpdateKey(frameDeltaTime);   // Jʒu
+	UpdateMouse(frameDeltaTime); // ヨーピッチ・ズームの変更
+	UpdateKey(frameDeltaTime);   // カメラ位置
 
 	mProjectionMatrix = Matrix4::CreatePerspectiveFOV(mZoom, mScreenWidth, mScreenHeight, 0.1f, 1000.0f);
     mViewMatrix       = Matrix4::CreateLookAt(mCameraPos, mCameraPos + mCameraFront, mCameraUp);
 
 }
 
-// [sb`EY[x̕ύX
+// ヨーピッチ・ズームレベルの変更
 void FlyCamera::UpdateMouse(float frameDeltaTime)
 {
-	// J̃[sb`ύX
+	// カメラのヨーピッチを変更
 	Vector2 mouse = MOUSE_INSTANCE.GetPosition();
 	static float sensitivity = 0.2f;
 	float xoffset = mouse.x * sensitivity * frameDeltaTime;
@@ -62,21 +62,21 @@ void FlyCamera::UpdateMouse(float frameDeltaTime)
 		mPitch = Math::ToRadians(pitchMinDegree);
 	}
 
-	// J̃[sb`J̑OxNg߂
+	// カメラのヨーピッチからカメラの前方ベクトルを求める
 	Vector3 direction;
 	direction.x = cosf(mYaw) * cos(mPitch);
 	direction.y = sinf(mPitch);
 	direction.z = sinf(mYaw) * cosf(mPitch);
 	direction.Normalize();
 
-	// JOxNg
+	// カメラ前方ベクトル
 	mCameraFront = direction;
 
-	// ZoomW
+	// Zoom係数
 	Vector2 wheel = MOUSE_INSTANCE.GetWheel();
 	mZoom += wheel.y * frameDeltaTime;
 
-	// őEŏY[pɃNv
+	// 最大・最小ズーム角にクランプする
 	if (Math::ToDegrees(mZoom) < zoomMinDegree)
 	{
 		mZoom = Math::ToRadians(zoomMinDegree);
@@ -87,14 +87,14 @@ void FlyCamera::UpdateMouse(float frameDeltaTime)
 	}
 }
 
-// L[{[h쏈
+// キーボード操作処理
 void FlyCamera::UpdateKey(float frameDeltaTime)
 {
-	// J̑OړxƉExNg̎擾
+	// カメラの前方移動速度と右方向ベクトルの取得
 	const float cameraSpeed = mCameraMoveSpeed * frameDeltaTime;
 	Vector3 cameraRightVec = Vector3::Cross(mCameraUp, mCameraFront);
 
-	// L[͂J̈ʒǔvZ
+	// キー入力からカメラの位置の計算する
 	if (INPUT_INSTANCE.GetInput(SDL_SCANCODE_W) == Input::KEY_STATE_PRESSED)
 	{
 		mCameraPos += cameraSpeed * mCameraFront;
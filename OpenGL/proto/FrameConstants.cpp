@@ -0,0 +1,58 @@
+#include "FrameConstants.h"
+
+const char* FrameConstantBuffer::mBlockName = "FrameConstants";
+
+namespace
+{
+	void copyVec3(float* dst, const Vector3& vec)
+	{
+		dst[0] = vec.x;
+		dst[1] = vec.y;
+		dst[2] = vec.z;
+	}
+}
+
+FrameConstantBuffer::FrameConstantBuffer()
+	: mUBO(0)
+{
+	memset(&mConstants, 0, sizeof(mConstants));
+	mConstants.exposure = 1.0f;
+
+	glGenBuffers(1, &mUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameConstantBuffer::~FrameConstantBuffer()
+{
+	glDeleteBuffers(1, &mUBO);
+}
+
+void FrameConstantBuffer::setCamera(const Matrix4& view, const Matrix4& projection, const Vector3& viewPos)
+{
+	memcpy(mConstants.view, view.GetAsFloatPtr(), sizeof(mConstants.view));
+	memcpy(mConstants.projection, projection.GetAsFloatPtr(), sizeof(mConstants.projection));
+	copyVec3(mConstants.viewPos, viewPos);
+}
+
+void FrameConstantBuffer::setLight(const Vector3& direction, const Vector3& ambient, const Vector3& diffuse, const Vector3& specular)
+{
+	copyVec3(mConstants.lightDirection, direction);
+	copyVec3(mConstants.lightAmbient, ambient);
+	copyVec3(mConstants.lightDiffuse, diffuse);
+	copyVec3(mConstants.lightSpecular, specular);
+}
+
+void FrameConstantBuffer::setLightSpaceMatrix(const Matrix4& lightSpaceMatrix)
+{
+	memcpy(mConstants.lightSpaceMatrix, lightSpaceMatrix.GetAsFloatPtr(), sizeof(mConstants.lightSpaceMatrix));
+}
+
+void FrameConstantBuffer::upload()
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &mConstants);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, mBindingPoint, mUBO);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "Math.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// フレーム共通定数
+// GLSL側の "FrameConstants" uniformブロック(std140)と同じメモリレイアウトにすること
+// vec3はstd140では16byteアラインなので、後ろにfloatを詰めるかパディングを入れる
+///////////////////////////////////////////////////////////////////////////////////////
+struct FrameConstants
+{
+	float view[16];             // ビュー行列
+	float projection[16];       // プロジェクション行列
+	float lightSpaceMatrix[16]; // ライト空間行列
+	float viewPos[3];           // 視点
+	float exposure;             // 露出 (viewPosのパディング位置に詰める)
+	float lightDirection[4];    // ライト方向 (xyzのみ使用)
+	float lightAmbient[4];      // ライトアンビエント
+	float lightDiffuse[4];      // ライトディフューズ
+	float lightSpecular[4];     // ライトスペキュラー
+};
+static_assert(sizeof(FrameConstants) == 272, "FrameConstants must match the std140 layout of the GLSL block");
+
+///////////////////////////////////////////////////////////////////////////////////////
+// フレーム共通定数のuniformバッファ
+// 1フレームに1回だけ転送し、固定のバインディングポイントに接続する
+// Shaderはリンク時に FrameConstants ブロックをこのバインディングポイントに割り当てる
+///////////////////////////////////////////////////////////////////////////////////////
+class FrameConstantBuffer
+{
+public:
+	static const GLuint mBindingPoint = 0;                 // uniformブロックのバインディングポイント
+	static const char*  mBlockName;                        // GLSL側のuniformブロック名
+
+	FrameConstantBuffer();
+	~FrameConstantBuffer();
+
+	void                  setCamera(const Matrix4& view, const Matrix4& projection, const Vector3& viewPos);
+	void                  setLight(const Vector3& direction, const Vector3& ambient, const Vector3& diffuse, const Vector3& specular);
+	void                  setLightSpaceMatrix(const Matrix4& lightSpaceMatrix);
+	void                  setExposure(float exposure) { mConstants.exposure = exposure; }
+	void                  upload();                        // GPUへ転送してバインディングポイントに接続
+
+	const FrameConstants& getConstants() const { return mConstants; }
+
+private:
+	FrameConstants mConstants;  // CPU側の定数
+	GLuint         mUBO;        // uniformバッファオブジェクト
+};
@@ -0,0 +1,126 @@
+#include "FrameTimeOverlay.h"
+#include "FrameTimer.h"
+#include "RenderState.h"
+
+const float FrameTimeOverlay::mPixelPerMillisecond = 4.0f;
+const float FrameTimeOverlay::mMaxMilliseconds     = 50.0f;
+const float FrameTimeOverlay::mMargin              = 16.0f;
+
+FrameTimeOverlay::FrameTimeOverlay()
+	: mLineShader("Shader/Line.vert", "Shader/Line.frag", Shader::BuildMode_Async)
+	, mVAO(0)
+	, mVBO(0)
+	, mVBOCapacity(0)
+{
+	glGenVertexArrays(1, &mVAO);
+	glGenBuffers(1, &mVBO);
+	RENDER_STATE_INSTANCE.bindVertexArray(mVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+}
+
+FrameTimeOverlay::~FrameTimeOverlay()
+{
+	RENDER_STATE_INSTANCE.onDeleteVertexArray(mVAO);
+	glDeleteVertexArrays(1, &mVAO);
+	glDeleteBuffers(1, &mVBO);
+}
+
+void FrameTimeOverlay::addLine(float x0, float y0, float x1, float y1)
+{
+	mVertices.insert(mVertices.end(), { x0, y0, 0.0f, x1, y1, 0.0f });
+}
+
+/////////////////////////////////////////////////
+// 溜めた線分を1色で描画して空にする
+// 頂点バッファは足りなくなったときだけ確保し直し、以降は部分更新する
+////////////////////////////////////////////////
+void FrameTimeOverlay::flushLines(const Vector3& color)
+{
+	if (mVertices.empty())
+	{
+		return;
+	}
+
+	GLsizeiptr size = static_cast<GLsizeiptr>(mVertices.size() * sizeof(float));
+	RENDER_STATE_INSTANCE.bindVertexArray(mVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+	if (size > mVBOCapacity)
+	{
+		mVBOCapacity = size * 2;
+		glBufferData(GL_ARRAY_BUFFER, mVBOCapacity, nullptr, GL_STREAM_DRAW);
+	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, mVertices.data());
+
+	mLineShader.setVec3(mColorHandle, color);
+	glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(mVertices.size() / 3));
+	mVertices.clear();
+}
+
+/////////////////////////////////////////////////
+// フレーム時間グラフを描画する
+// in : timer         描画する履歴
+//      screenWidth   描画先の解像度 (ピクセル)
+//      screenHeight
+////////////////////////////////////////////////
+void FrameTimeOverlay::draw(const FrameTimer& timer, int screenWidth, int screenHeight)
+{
+	const unsigned int historyCount = timer.getHistoryCount();
+	if (historyCount < 2 || !mLineShader.isReady())
+	{
+		return;
+	}
+
+	// uniformハンドルはビルドが終わってから取得する
+	if (!mViewProjHandle.isValid())
+	{
+		mViewProjHandle = mLineShader.getUniformHandle("uViewProj");
+		mColorHandle    = mLineShader.getUniformHandle("uColor");
+	}
+
+	// 画面中心が原点のピクセル座標 → 左下を原点にずらす
+	const float left   = -0.5f * screenWidth + mMargin;
+	const float bottom = -0.5f * screenHeight + mMargin;
+	const float right  = left + FrameTimer::mHistoryNum;
+	auto toY = [bottom](float milliseconds)
+	{
+		return bottom + Math::Min(milliseconds, mMaxMilliseconds) * mPixelPerMillisecond;
+	};
+
+	Matrix4 viewProj = Matrix4::CreateSimpleViewProj(static_cast<float>(screenWidth), static_cast<float>(screenHeight));
+	mLineShader.use();
+	mLineShader.setMatrix(mViewProjHandle, viewProj.GetAsFloatPtr());
+	RENDER_STATE_INSTANCE.setDepthTest(false);
+
+	// 目盛り
+	const unsigned int targetFps = timer.getTargetFrameRate() != 0 ? timer.getTargetFrameRate() : 60;
+	addLine(left, toY(1000.0f / 30), right, toY(1000.0f / 30));
+	flushLines(Vector3(0.4f, 0.4f, 0.4f));
+	addLine(left, toY(1000.0f / targetFps), right, toY(1000.0f / targetFps));
+	flushLines(Vector3(1.0f, 0.9f, 0.2f));
+
+	// 区間合計
+	for (unsigned int i = 1; i < historyCount; i++)
+	{
+		addLine(left + i - 1, toY(timer.getHistoryWorkTime(i - 1)), left + i, toY(timer.getHistoryWorkTime(i)));
+	}
+	flushLines(Vector3(0.2f, 0.9f, 0.3f));
+
+	// フレーム間隔
+	for (unsigned int i = 1; i < historyCount; i++)
+	{
+		addLine(left + i - 1, toY(timer.getHistoryFrameTime(i - 1)), left + i, toY(timer.getHistoryFrameTime(i)));
+	}
+	flushLines(Vector3(1.0f, 1.0f, 1.0f));
+
+	// ヒッチは縦線で強調
+	for (unsigned int i = 0; i < historyCount; i++)
+	{
+		if (timer.isHistoryHitch(i))
+		{
+			addLine(left + i, bottom, left + i, toY(timer.getHistoryFrameTime(i)));
+		}
+	}
+	flushLines(Vector3(1.0f, 0.2f, 0.2f));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include "Math.h"
+#include "Shader.h"
+
+class FrameTimer;
+
+///////////////////////////////////////////////////////////////////////////////////////
+// フレーム時間グラフのオーバーレイ
+// FrameTimerの履歴を画面左下に折れ線で描く (1フレーム = 1ピクセル幅)
+//   白 : フレーム間隔   緑 : 区間合計(CPU処理時間)   赤 : ヒッチ
+//   黄 : 目標フレーム時間 (リミッタ無効時は60fps)   灰 : 33.3ms
+// 文字は描かないので、数値はウィンドウタイトルやコンソールに出す
+///////////////////////////////////////////////////////////////////////////////////////
+class FrameTimeOverlay
+{
+public:
+	static const float mPixelPerMillisecond;     // 縦軸の拡大率
+	static const float mMaxMilliseconds;         // 縦軸の上限 (超える値は頭打ち)
+	static const float mMargin;                  // 画面端からの余白 (ピクセル)
+
+	FrameTimeOverlay();
+	~FrameTimeOverlay();
+
+	void         draw(const FrameTimer& timer, int screenWidth, int screenHeight); // 現在のフレームバッファに描画
+
+private:
+	void         addLine(float x0, float y0, float x1, float y1);     // 線分を頂点列に追加
+	void         flushLines(const Vector3& color);                    // 溜めた線分を描画
+
+	Shader             mLineShader;
+	UniformHandle      mViewProjHandle;
+	UniformHandle      mColorHandle;
+	GLuint             mVAO;
+	GLuint             mVBO;
+	GLsizeiptr         mVBOCapacity;             // 頂点バッファの確保サイズ (byte)
+	std::vector<float> mVertices;                // 線分の頂点 (xyz)
+};
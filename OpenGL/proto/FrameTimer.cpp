@@ -0,0 +1,312 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include "FrameTimer.h"
+#include "ReportUtil.h"
+
+const float FrameTimer::mHitchRatio   = 2.0f;
+const float FrameTimer::mMaxDeltaTime = 0.25f;
+
+// ヒッチ判定を始めるのに必要な履歴数 (起動直後の揺れを数えない)
+static const unsigned int hitchMinHistory = 30;
+
+// スリープの精度が足りない分をスピンで待つ時間 (ミリ秒)
+static const float limiterSpinMargin = 2.0f;
+
+static const char* phaseNames[FramePhase_Num] =
+{
+	"Input",
+	"Camera",
+	"ShadowSubmit",
+	"MainSubmit",
+	"Post",
+	"Swap",
+};
+
+FrameTimer::FrameTimer()
+	: mFrequency(SDL_GetPerformanceFrequency())
+	, mFrameStart(0)
+	, mPhaseStart(0)
+	, mOpenPhase(-1)
+	, mInFrame(false)
+	, mPending(false)
+	, mCurrent()
+	, mHistory()
+	, mNext(0)
+	, mFrameCount(0)
+	, mHitchCount(0)
+	, mFrameTimeSum(0.0)
+	, mTargetFrameRate(0)
+	, mNextFrameCounter(0)
+{
+}
+
+float FrameTimer::toMilliseconds(Uint64 counter) const
+{
+	return static_cast<float>(counter * 1000.0 / mFrequency);
+}
+
+/////////////////////////////////////////////////
+// フレームを開始する
+// 前フレームの間隔をここで確定して履歴に入れる
+// out : 前フレーム開始からの経過時間 (秒, mMaxDeltaTimeで頭打ち)
+////////////////////////////////////////////////
+float FrameTimer::beginFrame()
+{
+	const Uint64 now = SDL_GetPerformanceCounter();
+	const float  deltaTime = mFrameStart != 0 ? toMilliseconds(now - mFrameStart) * 0.001f : 0.0f;
+
+	if (mPending)
+	{
+		mCurrent.frameTime = deltaTime * 1000.0f;
+
+		// 直近平均との比較でヒッチを判定
+		const unsigned int historyCount = getHistoryCount();
+		mCurrent.hitch = historyCount >= hitchMinHistory &&
+			mCurrent.frameTime > mHitchRatio * static_cast<float>(mFrameTimeSum / historyCount);
+		if (mCurrent.hitch)
+		{
+			mHitchCount++;
+		}
+
+		// リングに書き込む (あふれた分は合計から引く)
+		if (historyCount == mHistoryNum)
+		{
+			mFrameTimeSum -= mHistory[mNext].frameTime;
+		}
+		mFrameTimeSum += mCurrent.frameTime;
+		mHistory[mNext] = mCurrent;
+		mNext = (mNext + 1) % mHistoryNum;
+		mFrameCount++;
+		mPending = false;
+	}
+
+	mCurrent = FrameRecord();
+	mCurrent.frameNumber = mFrameCount;
+	mFrameStart = now;
+	mOpenPhase  = -1;
+	mInFrame    = true;
+
+	return std::min(deltaTime, mMaxDeltaTime);
+}
+
+void FrameTimer::beginPhase(FramePhaseEnum phase)
+{
+	if (!mInFrame)
+	{
+		return;
+	}
+	endPhase();
+	mOpenPhase  = phase;
+	mPhaseStart = SDL_GetPerformanceCounter();
+}
+
+void FrameTimer::endPhase()
+{
+	if (mOpenPhase < 0)
+	{
+		return;
+	}
+	// 同じ区間を複数回開いた場合は合計する
+	mCurrent.phaseTimes[mOpenPhase] += toMilliseconds(SDL_GetPerformanceCounter() - mPhaseStart);
+	mOpenPhase = -1;
+}
+
+void FrameTimer::endFrame()
+{
+	if (!mInFrame)
+	{
+		return;
+	}
+	endPhase();
+	mInFrame = false;
+	mPending = true;
+}
+
+void FrameTimer::setTargetFrameRate(unsigned int fps)
+{
+	mTargetFrameRate  = fps;
+	mNextFrameCounter = 0;
+}
+
+/////////////////////////////////////////////////
+// 目標フレーム間隔になるまで待つ
+// 大半はSDL_Delayで眠り、スリープの誤差が出る最後のlimiterSpinMargin分はスピンする
+// 目標より1フレーム以上遅れていたら、追いつこうとせず現在時刻から数え直す
+////////////////////////////////////////////////
+void FrameTimer::waitForNextFrame()
+{
+	if (mTargetFrameRate == 0)
+	{
+		return;
+	}
+
+	const Uint64 period = mFrequency / mTargetFrameRate;
+	const Uint64 start  = SDL_GetPerformanceCounter();
+	if (mNextFrameCounter == 0 || start > mNextFrameCounter + period)
+	{
+		// 初回、または大きく遅れている場合は待たずに数え直す
+		mNextFrameCounter = start;
+	}
+
+	Uint64 now = start;
+	while (now < mNextFrameCounter)
+	{
+		float remaining = toMilliseconds(mNextFrameCounter - now);
+		if (remaining > limiterSpinMargin)
+		{
+			SDL_Delay(static_cast<Uint32>(remaining - limiterSpinMargin));
+		}
+		now = SDL_GetPerformanceCounter();
+	}
+	mNextFrameCounter += period;
+
+	if (mPending)
+	{
+		mCurrent.waitTime += toMilliseconds(now - start);
+	}
+}
+
+unsigned int FrameTimer::getHistoryCount() const
+{
+	return std::min(mFrameCount, mHistoryNum);
+}
+
+const FrameTimer::FrameRecord& FrameTimer::getHistory(unsigned int index) const
+{
+	const unsigned int historyCount = getHistoryCount();
+	return mHistory[(mNext + mHistoryNum - historyCount + index) % mHistoryNum];
+}
+
+float FrameTimer::getHistoryFrameTime(unsigned int index) const
+{
+	return getHistory(index).frameTime;
+}
+
+float FrameTimer::getHistoryWorkTime(unsigned int index) const
+{
+	const FrameRecord& record = getHistory(index);
+	float sum = 0.0f;
+	for (float phaseTime : record.phaseTimes)
+	{
+		sum += phaseTime;
+	}
+	return sum;
+}
+
+bool FrameTimer::isHistoryHitch(unsigned int index) const
+{
+	return getHistory(index).hitch;
+}
+
+unsigned int FrameTimer::getRecentHitchCount() const
+{
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < getHistoryCount(); i++)
+	{
+		count += getHistory(i).hitch ? 1 : 0;
+	}
+	return count;
+}
+
+const char* FrameTimer::getPhaseName(FramePhaseEnum phase)
+{
+	return phaseNames[phase];
+}
+
+bool FrameTimer::getFrameStats(FrameTimeStats& destStats) const
+{
+	return calcStats(-1, destStats);
+}
+
+bool FrameTimer::getPhaseStats(FramePhaseEnum phase, FrameTimeStats& destStats) const
+{
+	return calcStats(phase, destStats);
+}
+
+/////////////////////////////////////////////////
+// 履歴から統計を求める
+// in  : phase  区間 (負ならフレーム間隔)
+// out : 履歴が1フレーム以上あればtrue
+////////////////////////////////////////////////
+bool FrameTimer::calcStats(int phase, FrameTimeStats& destStats) const
+{
+	const unsigned int historyCount = getHistoryCount();
+	if (historyCount == 0)
+	{
+		return false;
+	}
+
+	std::vector<float> samples(historyCount);
+	float sum = 0.0f;
+	for (unsigned int i = 0; i < historyCount; i++)
+	{
+		const FrameRecord& record = getHistory(i);
+		samples[i] = phase < 0 ? record.frameTime : record.phaseTimes[phase];
+		sum += samples[i];
+	}
+	std::sort(samples.begin(), samples.end());
+
+	destStats.average = sum / historyCount;
+	destStats.p50     = ReportUtil::percentile(samples, 0.50);
+	destStats.p95     = ReportUtil::percentile(samples, 0.95);
+	destStats.p99     = ReportUtil::percentile(samples, 0.99);
+	destStats.max     = samples.back();
+	destStats.samples = historyCount;
+	return true;
+}
+
+void FrameTimer::printStats(std::ostream& os) const
+{
+	FrameTimeStats stats;
+	if (!getFrameStats(stats))
+	{
+		return;
+	}
+
+	os << "CPU frame time (ms)   avg / p50 / p95 / p99 / max" << std::endl;
+	os << "  Frame : " << stats.average << " / " << stats.p50 << " / " << stats.p95 << " / " << stats.p99 << " / " << stats.max << std::endl;
+	for (int phase = 0; phase < FramePhase_Num; phase++)
+	{
+		getPhaseStats(static_cast<FramePhaseEnum>(phase), stats);
+		os << "    " << phaseNames[phase] << " : "
+		   << stats.average << " / " << stats.p50 << " / " << stats.p95 << " / " << stats.p99 << " / " << stats.max << std::endl;
+	}
+	os << "  hitches (recent / total) : " << getRecentHitchCount() << " / " << mHitchCount << std::endl;
+	if (mTargetFrameRate != 0)
+	{
+		os << "  frame limiter : " << mTargetFrameRate << " fps" << std::endl;
+	}
+}
+
+bool FrameTimer::writeCSV(const char* fileName) const
+{
+	std::ofstream file(fileName);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << fileName << std::endl;
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(4);
+	file << "frame,frame_ms";
+	for (const char* name : phaseNames)
+	{
+		file << "," << name << "_ms";
+	}
+	file << ",wait_ms,hitch" << std::endl;
+
+	for (unsigned int i = 0; i < getHistoryCount(); i++)
+	{
+		const FrameRecord& record = getHistory(i);
+		file << record.frameNumber << "," << record.frameTime;
+		for (float phaseTime : record.phaseTimes)
+		{
+			file << "," << phaseTime;
+		}
+		file << "," << record.waitTime << "," << (record.hitch ? 1 : 0) << std::endl;
+	}
+	return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <SDL/SDL.h>
+#include <ostream>
+
+// フレーム内のCPU区間
+enum FramePhaseEnum
+{
+	FramePhase_Input = 0,       // 入力・イベント処理
+	FramePhase_Camera,          // カメラ・シーンの更新
+	FramePhase_ShadowSubmit,    // シャドウパスの発行
+	FramePhase_MainSubmit,      // 描画パスの発行
+	FramePhase_Post,            // トーンマップ・オーバーレイ
+	FramePhase_Swap,            // SwapWindow
+	FramePhase_Num
+};
+
+// フレーム時間の統計 (ミリ秒)
+struct FrameTimeStats
+{
+	float        average = 0.0f;  // 平均
+	float        p50     = 0.0f;  // 中央値
+	float        p95     = 0.0f;  // 95パーセンタイル
+	float        p99     = 0.0f;  // 99パーセンタイル
+	float        max     = 0.0f;  // 最大
+	unsigned int samples = 0;     // 集計したフレーム数
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 高分解能フレームタイマー
+// SDL_GetPerformanceCounter でフレーム間隔と区間ごとのCPU時間を計り、
+// 直近mHistoryNumフレームをリングバッファに保持する
+// フレーム間隔は次のbeginFrameで確定するので、履歴への記録は1フレーム遅れる
+// フレーム間隔が直近平均のmHitchRatio倍を超えたフレームをヒッチとして数える
+//
+// 使い方 :
+//   deltaTime = beginFrame() → beginPhase(区間) … → endFrame() → waitForNextFrame()
+//   beginPhaseは直前の区間を閉じてから次の区間を開く
+///////////////////////////////////////////////////////////////////////////////////////
+class FrameTimer
+{
+public:
+	static const unsigned int mHistoryNum = 240;   // 統計に使う直近フレーム数
+	static const float        mHitchRatio;         // ヒッチとみなす直近平均に対する倍率
+	static const float        mMaxDeltaTime;       // beginFrameが返す経過時間の上限 (秒)
+
+	static FrameTimer& FrameTimerInstance()        // インスタンス
+	{
+		static FrameTimer FrameTimerInstance;
+		return FrameTimerInstance;
+	}
+
+	~FrameTimer() {};
+
+	float        beginFrame();                      // フレーム開始 (前フレーム開始からの経過時間(秒)を返す)
+	void         beginPhase(FramePhaseEnum phase);  // 区間の開始 (開いている区間は閉じる)
+	void         endPhase();                        // 開いている区間の終了
+	void         endFrame();                        // フレーム終了 (履歴に記録)
+
+	// フレームリミッタ (0で無効)
+	void         setTargetFrameRate(unsigned int fps);
+	unsigned int getTargetFrameRate() const { return mTargetFrameRate; }
+	void         waitForNextFrame();                // 目標フレーム間隔までスリープ＋スピンで待つ
+
+	// 統計
+	bool         getFrameStats(FrameTimeStats& destStats) const;                        // フレーム間隔
+	bool         getPhaseStats(FramePhaseEnum phase, FrameTimeStats& destStats) const;  // 区間のCPU時間
+	unsigned int getRecentHitchCount() const;                                           // 履歴内のヒッチ数
+	unsigned int getHitchCount() const { return mHitchCount; }                          // 累計ヒッチ数
+	unsigned int getFrameCount() const { return mFrameCount; }                          // 記録したフレーム数
+	unsigned int getHistoryCount() const;                                               // 履歴に入っているフレーム数
+	float        getHistoryFrameTime(unsigned int index) const;                         // 古い順index番目のフレーム間隔 (ミリ秒)
+	float        getHistoryWorkTime(unsigned int index) const;                          // 古い順index番目の区間合計 (ミリ秒)
+	bool         isHistoryHitch(unsigned int index) const;                              // 古い順index番目がヒッチか
+	static const char* getPhaseName(FramePhaseEnum phase);
+
+	void         printStats(std::ostream& os) const;        // 統計をコンソールに出力
+	bool         writeCSV(const char* fileName) const;      // 履歴をCSVに書き出す
+
+private:
+	FrameTimer(); // シングルトン
+
+	// 1フレームの記録
+	struct FrameRecord
+	{
+		float        frameTime;                    // 前フレーム開始からの間隔 (ミリ秒)
+		float        phaseTimes[FramePhase_Num];   // 区間ごとのCPU時間 (ミリ秒)
+		float        waitTime;                     // リミッタの待ち時間 (ミリ秒)
+		unsigned int frameNumber;                  // フレーム番号
+		bool         hitch;                        // ヒッチか
+	};
+
+	float        toMilliseconds(Uint64 counter) const;
+	const FrameRecord& getHistory(unsigned int index) const; // 古い順index番目の記録
+	bool         calcStats(int phase, FrameTimeStats& destStats) const;   // 統計 (phaseが負ならフレーム間隔)
+
+	Uint64       mFrequency;                       // カウンタの周波数
+	Uint64       mFrameStart;                      // 現在のフレームの開始カウンタ
+	Uint64       mPhaseStart;                      // 開いている区間の開始カウンタ
+	int          mOpenPhase;                       // 開いている区間 (-1:なし)
+	bool         mInFrame;                         // beginFrame～endFrameの間
+	bool         mPending;                         // 間隔の確定待ち (次のbeginFrameで履歴に入れる)
+	FrameRecord  mCurrent;                         // 記録中のフレーム
+
+	FrameRecord  mHistory[mHistoryNum];            // 履歴のリングバッファ
+	unsigned int mNext;                            // 次に書き込む位置
+	unsigned int mFrameCount;                      // 記録したフレーム数
+	unsigned int mHitchCount;                      // 累計ヒッチ数
+	double       mFrameTimeSum;                    // 履歴のフレーム間隔の合計 (直近平均用)
+
+	unsigned int mTargetFrameRate;                 // リミッタの目標フレームレート
+	Uint64       mNextFrameCounter;                // 次のフレームを始める目標カウンタ
+};
+
+#define FRAME_TIMER_INSTANCE FrameTimer::FrameTimerInstance()
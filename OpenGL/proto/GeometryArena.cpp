@@ -0,0 +1,150 @@
+#include "GeometryArena.h"
+#include "InstanceBatch.h"
+#include "RenderState.h"
+
+GeometryArena::GeometryArena(MeshObj::VertexFormat format, unsigned int vertexCapacity, unsigned int indexCapacity, GLenum indexType)
+	: mVFormat(format)
+	, mIndexType(indexType)
+	, mVAO(0)
+	, mVBO(0)
+	, mEBO(0)
+	, mVertexCapacity(0)
+	, mIndexCapacity(0)
+	, mVertexCount(0)
+	, mIndexCount(0)
+	, mInstanceBatch(nullptr)
+{
+	glGenVertexArrays(1, &mVAO);
+	reserve(vertexCapacity, indexCapacity);
+}
+
+GeometryArena::~GeometryArena()
+{
+	RENDER_STATE_INSTANCE.onDeleteVertexArray(mVAO);
+	glDeleteVertexArrays(1, &mVAO);
+	glDeleteBuffers(1, &mVBO);
+	glDeleteBuffers(1, &mEBO);
+}
+
+bool GeometryArena::canAllocate(unsigned int vertexCount, GLenum indexType) const
+{
+	return indexType == mIndexType && (mIndexType == GL_UNSIGNED_INT || vertexCount <= 65536);
+}
+
+/////////////////////////////////////////////////
+// メッシュのVBO/EBOの内容をアリーナの末尾にコピーする
+// コピーはGPU上で行い、CPUへの読み戻しはしない
+// out : destRange            アリーナ内の範囲
+// in  : srcVBO, vertexCount  コピー元の頂点バッファと頂点数 (頂点フォーマットはアリーナと同じであること)
+//       srcEBO, indexCount   コピー元のインデックスバッファとインデックス数
+//       srcIndexType         コピー元のインデックスの型 (アリーナと同じであること)
+// out : 格納できたらtrue (インデックスの型が違う・16bitに収まらない場合は何もしない)
+////////////////////////////////////////////////
+bool GeometryArena::allocate(GeometryRange& destRange, GLuint srcVBO, unsigned int vertexCount, GLuint srcEBO, unsigned int indexCount, GLenum srcIndexType)
+{
+	if (!canAllocate(vertexCount, srcIndexType))
+	{
+		return false;
+	}
+
+	// 足りなければ倍々で拡張
+	unsigned int newVertexCapacity = mVertexCapacity;
+	unsigned int newIndexCapacity  = mIndexCapacity;
+	while (mVertexCount + vertexCount > newVertexCapacity)
+	{
+		newVertexCapacity = Math::Max(newVertexCapacity * 2, 1024u);
+	}
+	while (mIndexCount + indexCount > newIndexCapacity)
+	{
+		newIndexCapacity = Math::Max(newIndexCapacity * 2, 1024u);
+	}
+	if (newVertexCapacity != mVertexCapacity || newIndexCapacity != mIndexCapacity)
+	{
+		reserve(newVertexCapacity, newIndexCapacity);
+	}
+
+	const GLsizeiptr vertexSize = MeshObj::getVertexSize(mVFormat);
+	const GLsizeiptr indexSize  = MeshObj::getIndexBytes(mIndexType);
+
+	destRange.firstIndex  = mIndexCount;
+	destRange.indexCount  = indexCount;
+	destRange.baseVertex  = static_cast<GLint>(mVertexCount);
+	destRange.vertexCount = vertexCount;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, srcVBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mVBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, vertexSize * mVertexCount, vertexSize * vertexCount);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, srcEBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mEBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, indexSize * mIndexCount, indexSize * indexCount);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	mVertexCount += vertexCount;
+	mIndexCount  += indexCount;
+	return true;
+}
+
+void GeometryArena::setInstanceBatch(const InstanceBatch* batch)
+{
+	mInstanceBatch = batch;
+	if (mInstanceBatch)
+	{
+		mInstanceBatch->bindToVertexArray(mVAO);
+	}
+}
+
+/////////////////////////////////////////////////
+// VBO/EBOを指定容量で作り直す
+// 使用中の範囲は新しいバッファへGPU上でコピーし、共有VAOの頂点属性を張り直す
+////////////////////////////////////////////////
+void GeometryArena::reserve(unsigned int vertexCapacity, unsigned int indexCapacity)
+{
+	const GLsizeiptr vertexSize = MeshObj::getVertexSize(mVFormat);
+	const GLsizeiptr indexSize  = MeshObj::getIndexBytes(mIndexType);
+
+	GLuint newVBO, newEBO;
+	glGenBuffers(1, &newVBO);
+	glGenBuffers(1, &newEBO);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertexSize * vertexCapacity, NULL, GL_STATIC_DRAW);
+	if (mVBO != 0 && mVertexCount > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, mVBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, vertexSize * mVertexCount);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newEBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, indexSize * indexCapacity, NULL, GL_STATIC_DRAW);
+	if (mEBO != 0 && mIndexCount > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, mEBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, indexSize * mIndexCount);
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &mVBO);
+	glDeleteBuffers(1, &mEBO);
+	mVBO = newVBO;
+	mEBO = newEBO;
+	mVertexCapacity = vertexCapacity;
+	mIndexCapacity  = indexCapacity;
+
+	setupVertexArray();
+}
+
+void GeometryArena::setupVertexArray()
+{
+	RENDER_STATE_INSTANCE.bindVertexArray(mVAO);
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+		MeshObj::setupVertexAttributes(mVFormat);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "MeshObj.h"
+
+class InstanceBatch;
+
+// glMultiDrawElementsIndirect / GL_DRAW_INDIRECT_BUFFER のコマンド形式
+struct DrawElementsIndirectCommand
+{
+	GLuint count;          // インデックス数
+	GLuint instanceCount;  // インスタンス数
+	GLuint firstIndex;     // 先頭インデックス (要素単位)
+	GLint  baseVertex;     // インデックスに加算する頂点オフセット
+	GLuint baseInstance;   // インスタンス属性の開始位置
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must be tightly packed");
+
+// アリーナ内に確保したメッシュの範囲
+struct GeometryRange
+{
+	GLuint firstIndex  = 0;  // EBO内の先頭インデックス
+	GLuint indexCount  = 0;  // インデックス数
+	GLint  baseVertex  = 0;  // VBO内の先頭頂点
+	GLuint vertexCount = 0;  // 頂点数
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 静的メッシュ用のジオメトリアリーナ
+// 同じ頂点フォーマットのメッシュを大きなVBO/EBOにまとめ、1つのVAOを共有させる
+// インデックスはメッシュ内のローカル値のまま格納し、描画時にbaseVertexで補正する
+// (ローカル値なので、メッシュごとの頂点数が65536以下なら16bitインデックスで足りる)
+// インデックスの型はアリーナと同じであること (型の変換は転送前にCPUで MeshObj::convertIndexType で行う)
+// 静的メッシュ専用のため、確保した範囲の個別解放はしない
+///////////////////////////////////////////////////////////////////////////////////////
+class GeometryArena
+{
+public:
+	GeometryArena(MeshObj::VertexFormat format, unsigned int vertexCapacity, unsigned int indexCapacity, GLenum indexType = GL_UNSIGNED_INT);
+	~GeometryArena();
+
+	bool                  canAllocate(unsigned int vertexCount, GLenum indexType) const; // メッシュを格納できるか (インデックスの型が同じで16bitの範囲)
+	bool                  allocate(GeometryRange& destRange, GLuint srcVBO, unsigned int vertexCount, GLuint srcEBO, unsigned int indexCount,
+	                               GLenum srcIndexType);                     // メッシュのバッファをアリーナにコピー (格納できなければfalse)
+	void                  setInstanceBatch(const InstanceBatch* batch);    // 共有VAOにインスタンスバッファを接続
+
+	MeshObj::VertexFormat getFormat() const { return mVFormat; }
+	GLenum                getIndexType() const { return mIndexType; }      // インデックスの型 (GL_UNSIGNED_SHORT / GL_UNSIGNED_INT)
+	GLuint                getVAO() const { return mVAO; }
+	unsigned int          getVertexCount() const { return mVertexCount; }  // 使用中の頂点数
+	unsigned int          getIndexCount() const { return mIndexCount; }    // 使用中のインデックス数
+
+private:
+	void                  reserve(unsigned int vertexCapacity, unsigned int indexCapacity); // 容量の拡張 (既存データはGPU上でコピー)
+	void                  setupVertexArray();                               // 共有VAOに頂点属性を設定
+
+	MeshObj::VertexFormat mVFormat;         // 頂点フォーマット
+	GLenum                mIndexType;       // インデックスの型
+	GLuint                mVAO;             // 共有VAO
+	GLuint                mVBO;             // 共有VBO
+	GLuint                mEBO;             // 共有EBO
+	unsigned int          mVertexCapacity;  // VBOの確保済み頂点数
+	unsigned int          mIndexCapacity;   // EBOの確保済みインデックス数
+	unsigned int          mVertexCount;     // 使用中の頂点数
+	unsigned int          mIndexCount;      // 使用中のインデックス数
+	const InstanceBatch*  mInstanceBatch;   // 接続中のインスタンスバッファ
+};
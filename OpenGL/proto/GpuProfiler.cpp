@@ -0,0 +1,334 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include "GpuProfiler.h"
+#include "ReportUtil.h"
+
+GpuProfiler::GpuProfiler()
+	: mFrameNumber(0)
+	, mInFrame(false)
+	, mCapturing(false)
+	, mDroppedFrameCount(0)
+{
+	for (FrameSlot& slot : mSlots)
+	{
+		slot.usedQueryNum = 0;
+		slot.frameNumber  = 0;
+		slot.pending      = false;
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	for (FrameSlot& slot : mSlots)
+	{
+		if (!slot.queries.empty())
+		{
+			glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// フレーム開始
+// これから使うリングのスロットにmFrameLatencyフレーム前の結果が残っていれば回収する
+////////////////////////////////////////////////
+void GpuProfiler::beginFrame()
+{
+	FrameSlot& slot = mSlots[mFrameNumber % mFrameLatency];
+	if (slot.pending)
+	{
+		resolveFrame(slot);
+	}
+
+	slot.usedQueryNum = 0;
+	slot.scopes.clear();
+	slot.frameNumber  = mFrameNumber;
+	slot.pending      = false;
+	mScopeStack.clear();
+	mInFrame = true;
+}
+
+void GpuProfiler::endFrame()
+{
+	if (!mInFrame)
+	{
+		return;
+	}
+
+	// 閉じ忘れの区間はここで閉じる
+	while (!mScopeStack.empty())
+	{
+		std::cout << "GpuProfiler : scope not closed : " << mSlots[mFrameNumber % mFrameLatency].scopes[mScopeStack.back()].name << std::endl;
+		endScope();
+	}
+
+	mSlots[mFrameNumber % mFrameLatency].pending = true;
+	mFrameNumber++;
+	mInFrame = false;
+}
+
+void GpuProfiler::beginScope(const char* name)
+{
+	if (!mInFrame)
+	{
+		return;
+	}
+
+	FrameSlot& slot = mSlots[mFrameNumber % mFrameLatency];
+	ScopeRecord scope;
+	scope.name       = name;
+	scope.depth      = static_cast<unsigned int>(mScopeStack.size());
+	scope.beginQuery = issueTimestamp();
+	scope.endQuery   = scope.beginQuery;
+
+	mScopeStack.emplace_back(static_cast<unsigned int>(slot.scopes.size()));
+	slot.scopes.emplace_back(scope);
+}
+
+void GpuProfiler::endScope()
+{
+	if (!mInFrame || mScopeStack.empty())
+	{
+		return;
+	}
+
+	FrameSlot& slot = mSlots[mFrameNumber % mFrameLatency];
+	slot.scopes[mScopeStack.back()].endQuery = issueTimestamp();
+	mScopeStack.pop_back();
+}
+
+/////////////////////////////////////////////////
+// 回収待ちのフレームを古い順に全て回収する
+// glFinish()後に呼べば、直近mFrameLatencyフレームの結果も取りこぼさない
+////////////////////////////////////////////////
+void GpuProfiler::flush()
+{
+	for (unsigned int i = 0; i < mFrameLatency; i++)
+	{
+		FrameSlot& slot = mSlots[(mFrameNumber + i) % mFrameLatency];
+		if (slot.pending)
+		{
+			resolveFrame(slot);
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// 現在のフレームのクエリを1つ使ってタイムスタンプを記録する
+// クエリオブジェクトは足りない分だけ作り、以降のフレームで使い回す
+////////////////////////////////////////////////
+unsigned int GpuProfiler::issueTimestamp()
+{
+	FrameSlot& slot = mSlots[mFrameNumber % mFrameLatency];
+	if (slot.usedQueryNum >= slot.queries.size())
+	{
+		GLuint query;
+		glGenQueries(1, &query);
+		slot.queries.emplace_back(query);
+	}
+
+	unsigned int index = slot.usedQueryNum++;
+	glQueryCounter(slot.queries[index], GL_TIMESTAMP);
+	return index;
+}
+
+/////////////////////////////////////////////////
+// フレームの計測結果を回収する
+// 最後のクエリの結果が出ていなければ待たずにそのフレームを破棄する
+////////////////////////////////////////////////
+void GpuProfiler::resolveFrame(FrameSlot& slot)
+{
+	slot.pending = false;
+	if (slot.usedQueryNum == 0)
+	{
+		return;
+	}
+
+	GLint available = 0;
+	glGetQueryObjectiv(slot.queries[slot.usedQueryNum - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+	{
+		mDroppedFrameCount++;
+		return;
+	}
+
+	// 最後のクエリが出ていれば、それ以前のクエリも全て出ている
+	std::vector<GLuint64> timestamps(slot.usedQueryNum);
+	for (unsigned int i = 0; i < slot.usedQueryNum; i++)
+	{
+		glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+	}
+
+	for (const ScopeRecord& scope : slot.scopes)
+	{
+		GLuint64 begin = timestamps[scope.beginQuery];
+		GLuint64 end   = timestamps[scope.endQuery];
+		addSample(scope, static_cast<float>(end - begin) * 1.0e-6f);
+
+		if (mCapturing)
+		{
+			mCaptured.push_back({ scope.name, slot.frameNumber, scope.depth, begin, end });
+		}
+	}
+}
+
+void GpuProfiler::addSample(const ScopeRecord& scope, float milliseconds)
+{
+	auto it = mHistories.find(scope.name);
+	if (it == mHistories.end())
+	{
+		ScopeHistory history;
+		history.depth = scope.depth;
+		history.next  = 0;
+		history.samples.reserve(mHistoryNum);
+		it = mHistories.emplace(scope.name, history).first;
+		mScopeOrder.emplace_back(scope.name);
+	}
+
+	ScopeHistory& history = it->second;
+	if (history.samples.size() < mHistoryNum)
+	{
+		history.samples.emplace_back(milliseconds);
+	}
+	else
+	{
+		history.samples[history.next] = milliseconds;
+	}
+	history.next = (history.next + 1) % mHistoryNum;
+}
+
+/////////////////////////////////////////////////
+// 区間の直近mHistoryNumフレームの統計を計算する
+// in  : name       区間名
+// out : destStats  統計 (ミリ秒)
+// 区間がまだ計測されていなければfalse
+////////////////////////////////////////////////
+bool GpuProfiler::getStats(const std::string& name, GpuScopeStats& destStats) const
+{
+	auto it = mHistories.find(name);
+	if (it == mHistories.end() || it->second.samples.empty())
+	{
+		return false;
+	}
+
+	std::vector<float> samples = it->second.samples;
+	return calcStats(samples, destStats);
+}
+
+/////////////////////////////////////////////////
+// キャプチャした区間のうち、firstFrame以降のフレームの統計を計算する
+// 履歴(mHistoryNumフレーム)より長い区間をまとめて集計したい場合に使う
+////////////////////////////////////////////////
+bool GpuProfiler::getCaptureStats(const std::string& name, unsigned int firstFrame, GpuScopeStats& destStats) const
+{
+	std::vector<float> samples;
+	for (const CapturedScope& scope : mCaptured)
+	{
+		if (scope.frameNumber >= firstFrame && scope.name == name)
+		{
+			samples.emplace_back(static_cast<float>(scope.end - scope.begin) * 1.0e-6f);
+		}
+	}
+	return calcStats(samples, destStats);
+}
+
+bool GpuProfiler::calcStats(std::vector<float>& samples, GpuScopeStats& destStats)
+{
+	if (samples.empty())
+	{
+		return false;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	float sum = 0.0f;
+	for (float sample : samples)
+	{
+		sum += sample;
+	}
+
+	destStats.average = sum / samples.size();
+	destStats.p50     = ReportUtil::percentile(samples, 0.50);
+	destStats.p95     = ReportUtil::percentile(samples, 0.95);
+	destStats.p99     = ReportUtil::percentile(samples, 0.99);
+	destStats.samples = static_cast<unsigned int>(samples.size());
+	return true;
+}
+
+void GpuProfiler::printStats(std::ostream& os) const
+{
+	os << "GPU time (ms)   avg / p50 / p95 / p99" << std::endl;
+	for (const std::string& name : mScopeOrder)
+	{
+		GpuScopeStats stats;
+		if (!getStats(name, stats))
+		{
+			continue;
+		}
+		os << "  " << std::string(mHistories.at(name).depth * 2, ' ') << name << " : "
+		   << stats.average << " / " << stats.p50 << " / " << stats.p95 << " / " << stats.p99 << std::endl;
+	}
+	os << "  dropped frames : " << mDroppedFrameCount << std::endl;
+}
+
+void GpuProfiler::startCapture()
+{
+	mCaptured.clear();
+	mCapturing = true;
+}
+
+void GpuProfiler::stopCapture()
+{
+	mCapturing = false;
+}
+
+bool GpuProfiler::writeCSV(const char* fileName) const
+{
+	std::ofstream file(fileName);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << fileName << std::endl;
+		return false;
+	}
+
+	// 開始時刻はキャプチャ先頭のフレームを0とする
+	const GLuint64 origin = mCaptured.empty() ? 0 : mCaptured.front().begin;
+
+	file << std::fixed << std::setprecision(4);
+	file << "frame,scope,depth,start_ms,duration_ms" << std::endl;
+	for (const CapturedScope& scope : mCaptured)
+	{
+		file << scope.frameNumber << "," << scope.name << "," << scope.depth << ","
+		     << (scope.begin - origin) * 1.0e-6 << "," << (scope.end - scope.begin) * 1.0e-6 << std::endl;
+	}
+	return true;
+}
+
+bool GpuProfiler::writeChromeTrace(const char* fileName) const
+{
+	std::ofstream file(fileName);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << fileName << std::endl;
+		return false;
+	}
+
+	const GLuint64 origin = mCaptured.empty() ? 0 : mCaptured.front().begin;
+
+	// 完了イベント("ph":"X")として出力。時刻の単位はマイクロ秒
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[" << std::endl;
+	for (size_t i = 0; i < mCaptured.size(); i++)
+	{
+		const CapturedScope& scope = mCaptured[i];
+		file << "{\"name\":\"" << ReportUtil::escapeJson(scope.name) << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+		     << ",\"ts\":" << (scope.begin - origin) * 1.0e-3
+		     << ",\"dur\":" << (scope.end - scope.begin) * 1.0e-3
+		     << ",\"args\":{\"frame\":" << scope.frameNumber << "}}"
+		     << (i + 1 < mCaptured.size() ? "," : "") << std::endl;
+	}
+	file << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+	return true;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+
+// 計測区間の統計 (ミリ秒)
+struct GpuScopeStats
+{
+	float        average = 0.0f;  // 平均
+	float        p50     = 0.0f;  // 中央値
+	float        p95     = 0.0f;  // 95パーセンタイル
+	float        p99     = 0.0f;  // 99パーセンタイル
+	unsigned int samples = 0;     // 集計したフレーム数
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// GPUタイマークエリによるプロファイラ
+// 区間の開始・終了で glQueryCounter(GL_TIMESTAMP) を発行し、入れ子の区間も計測できる
+// クエリはフレームごとのリングで持ち、mFrameLatencyフレーム後に結果を回収するので
+// パイプラインを止めない (その時点で結果が出ていないフレームは破棄する)
+//
+// 使い方 :
+//   beginFrame() → GpuProfileScope / beginScope()～endScope() で区間を囲む → endFrame()
+///////////////////////////////////////////////////////////////////////////////////////
+class GpuProfiler
+{
+public:
+	static const unsigned int mFrameLatency = 3;     // 結果を回収するまでのフレーム数 (リングの段数)
+	static const unsigned int mHistoryNum   = 120;   // 統計に使う直近フレーム数
+
+	GpuProfiler();
+	~GpuProfiler();
+
+	void         beginFrame();                        // フレーム開始 (mFrameLatencyフレーム前の結果を回収)
+	void         endFrame();                          // フレーム終了
+	void         beginScope(const char* name);        // 区間の開始
+	void         endScope();                          // 直近に開始した区間の終了
+	void         flush();                             // 回収待ちのフレームを全て回収 (glFinish後に呼ぶ)
+
+	bool         getStats(const std::string& name, GpuScopeStats& destStats) const; // 区間の統計を取得
+	void         printStats(std::ostream& os) const;  // 全区間の統計を入れ子順に出力
+	const std::vector<std::string>& getScopeNames() const { return mScopeOrder; } // 計測した区間名 (初出順)
+
+	// キャプチャ (回収したフレームの全区間を記録してファイルに書き出す)
+	void         startCapture();                      // 記録開始 (以前の記録は破棄)
+	void         stopCapture();                       // 記録終了
+	bool         isCapturing() const { return mCapturing; }
+	bool         getCaptureStats(const std::string& name, unsigned int firstFrame, GpuScopeStats& destStats) const; // キャプチャ中のfirstFrame以降の統計
+	bool         writeCSV(const char* fileName) const;         // frame,scope,depth,start_ms,duration_ms のCSV
+	bool         writeChromeTrace(const char* fileName) const; // chrome://tracing 形式 (trace_event) のJSON
+
+	unsigned int getFrameNumber() const { return mFrameNumber; }             // 現在のフレーム番号
+	unsigned int getDroppedFrameCount() const { return mDroppedFrameCount; } // 結果が間に合わず破棄したフレーム数
+
+private:
+	// 1区間の記録
+	struct ScopeRecord
+	{
+		std::string  name;         // 区間名
+		unsigned int depth;        // 入れ子の深さ
+		unsigned int beginQuery;   // 開始タイムスタンプのクエリ番号
+		unsigned int endQuery;     // 終了タイムスタンプのクエリ番号
+	};
+
+	// リングの1フレーム分
+	struct FrameSlot
+	{
+		std::vector<GLuint>      queries;        // タイムスタンプクエリ (使い回す)
+		unsigned int             usedQueryNum;   // このフレームで使用したクエリ数
+		std::vector<ScopeRecord> scopes;         // このフレームの区間
+		unsigned int             frameNumber;    // フレーム番号
+		bool                     pending;        // 結果の回収待ち
+	};
+
+	// 区間ごとの履歴
+	struct ScopeHistory
+	{
+		unsigned int       depth;    // 入れ子の深さ (表示用)
+		std::vector<float> samples;  // 直近の計測値 (リングバッファ, ミリ秒)
+		unsigned int       next;     // 次に書き込む位置
+	};
+
+	// キャプチャした区間
+	struct CapturedScope
+	{
+		std::string  name;
+		unsigned int frameNumber;
+		unsigned int depth;
+		GLuint64     begin;        // 開始タイムスタンプ (ns)
+		GLuint64     end;          // 終了タイムスタンプ (ns)
+	};
+
+	unsigned int issueTimestamp();                    // 現在のフレームにタイムスタンプクエリを発行
+	void         resolveFrame(FrameSlot& slot);       // フレームの結果を回収 (出ていなければ破棄)
+	void         addSample(const ScopeRecord& scope, float milliseconds);
+	static bool  calcStats(std::vector<float>& samples, GpuScopeStats& destStats); // 計測値の統計 (samplesはソートされる)
+
+	FrameSlot                                     mSlots[mFrameLatency];   // フレームのリング
+	unsigned int                                  mFrameNumber;            // 現在のフレーム番号
+	bool                                          mInFrame;                // beginFrame～endFrameの間
+	std::vector<unsigned int>                     mScopeStack;             // 開いている区間 (現在のフレームのscopesのインデックス)
+	std::vector<std::string>                      mScopeOrder;             // 区間名 (初出順)
+	std::unordered_map<std::string, ScopeHistory> mHistories;              // 区間名 → 履歴
+	bool                                          mCapturing;              // キャプチャ中
+	std::vector<CapturedScope>                    mCaptured;               // キャプチャした区間
+	unsigned int                                  mDroppedFrameCount;      // 破棄したフレーム数
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// スコープの間だけGPU区間を計測する
+///////////////////////////////////////////////////////////////////////////////////////
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler& profiler, const char* name)
+		: mProfiler(profiler)
+	{
+		mProfiler.beginScope(name);
+	}
+	~GpuProfileScope()
+	{
+		mProfiler.endScope();
+	}
+
+private:
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+	GpuProfiler& mProfiler;
+};
@@ -16,11 +16,11 @@ Input::Input()
 
 void Input::Update()
 {
-	// ݂̃L[1ÕL[̏Ԃւ  0PɁA10
+	// 現在のキーと1つ前のキーの状態を入れ替える  0を１に、1を0に
 	mNowKey ^= 1;
 	mPrevKey = mNowKey ^ 1;
 
-	//L[Ԏ擾
+	//キー状態取得
 	const Uint8* keys = SDL_GetKeyboardState(NULL);
 	memcpy(mKeyState[mNowKey], keys, sizeof(char) * 256);
 
@@ -29,21 +29,21 @@ void Input::Update()
 		char nowInput  = mKeyState[mNowKey][i];
 		char prevInput = mKeyState[mPrevKey][i];
 
-		if (nowInput) //݉Ă
+		if (nowInput) //現在押されている
 		{
-			//Õt[ĂH
+			//前のフレームも押されていた？
 			if (prevInput)
 			{
-				mKey[i] = KEY_STATE_PRESSED; // ςȂ
+				mKey[i] = KEY_STATE_PRESSED; // 押されっぱなし
 			}
 			else {
-				mKey[i] = KEY_STATE_PUSHDOWN;// ꂽ
+				mKey[i] = KEY_STATE_PUSHDOWN;// 今押された
 			}
 
 		}
-		else // ݃L[͉ĂȂ
+		else // 現在キーは押されていない
 		{
-			// Õt[ŉĂH
+			// 前のフレームで押されていた？
 			if (prevInput)
 			{
 				mKey[i] = KEY_STATE_PULLUP;
@@ -0,0 +1,273 @@
+#include <cstring>
+#include <cstddef>
+#include "InstanceBatch.h"
+#include "MeshObj.h"
+#include "LodSelector.h"
+#include "RenderState.h"
+
+InstanceBatch::InstanceBatch()
+	: mRigid(true)
+	, mVBO(0)
+	, mCapacity(0)
+{
+}
+
+InstanceBatch::~InstanceBatch()
+{
+	glDeleteBuffers(1, &mVBO);
+}
+
+void InstanceBatch::clear()
+{
+	mInstances.clear();
+	mVisibleInstances.clear();
+	mPendingNormals.clear();
+	mRigid = true;
+}
+
+/////////////////////////////////////////////////
+// インスタンスを追加する
+// in : modelMat  モデル行列
+//      rigid     回転と平行移動だけの行列ならtrue (法線行列にモデル行列の3x3をそのまま使う)
+////////////////////////////////////////////////
+void InstanceBatch::addInstance(const Matrix4& modelMat, bool rigid)
+{
+	InstanceData instance;
+	instance.model = modelMat;
+	for (int i = 0; i < 3; i++)
+	{
+		instance.normal[i][0] = modelMat.mat[i][0];
+		instance.normal[i][1] = modelMat.mat[i][1];
+		instance.normal[i][2] = modelMat.mat[i][2];
+		instance.normal[i][3] = 0.0f;
+	}
+	if (!rigid)
+	{
+		// 逆転置はupload/カリング前にまとめて計算する
+		mPendingNormals.emplace_back(getCount());
+		mRigid = false;
+	}
+	mInstances.emplace_back(instance);
+}
+
+/////////////////////////////////////////////////
+// XZ平面上に numX × numZ 個の格子状にインスタンスを並べる
+// in : numX, numZ  X方向・Z方向の個数
+//      spacing     格子の間隔
+////////////////////////////////////////////////
+void InstanceBatch::addGrid(int numX, int numZ, float spacing)
+{
+	mInstances.reserve(mInstances.size() + numX * numZ);
+	for (int i = 0; i < numX; i++)
+	{
+		for (int j = 0; j < numZ; j++)
+		{
+			Vector3 pos(i * spacing, 0.0f, -j * spacing);
+			addInstance(Matrix4::CreateTranslation(pos), true);
+		}
+	}
+}
+
+Vector3 InstanceBatch::getCenter() const
+{
+	Vector3 center = Vector3::Zero;
+	if (mInstances.empty())
+	{
+		return center;
+	}
+	for (const InstanceData& instance : mInstances)
+	{
+		center += instance.model.GetTranslation();
+	}
+	return center * (1.0f / mInstances.size());
+}
+
+/////////////////////////////////////////////////
+// 剛体変換でないインスタンスの法線行列をまとめて計算する
+// Matrix4::InvertTransposeBatch で4行列ずつSIMDで処理する
+////////////////////////////////////////////////
+void InstanceBatch::updateNormalMatrices()
+{
+	if (mPendingNormals.empty())
+	{
+		return;
+	}
+
+	std::vector<Matrix4> matrices(mPendingNormals.size());
+	for (size_t i = 0; i < mPendingNormals.size(); i++)
+	{
+		matrices[i] = mInstances[mPendingNormals[i]].model;
+	}
+	Matrix4::InvertTransposeBatch(matrices.data(), matrices.data(), matrices.size());
+	for (size_t i = 0; i < mPendingNormals.size(); i++)
+	{
+		InstanceData& instance = mInstances[mPendingNormals[i]];
+		memcpy(instance.normal, matrices[i].mat, sizeof(InstanceData::normal));
+		instance.normal[0][3] = 0.0f;   // 4列目は逆転置の平行移動の成分が入るので、レイヤー番号0に戻す
+	}
+	mPendingNormals.clear();
+}
+
+void InstanceBatch::upload()
+{
+	if (mVBO == 0)
+	{
+		glGenBuffers(1, &mVBO);
+	}
+
+	updateNormalMatrices();
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+
+	// 容量が足りない場合のみ再確保し、それ以外は部分更新
+	const unsigned int count = getCount();
+	const unsigned int visibleCount = static_cast<unsigned int>(mVisibleInstances.size());
+	if (count + visibleCount > mCapacity)
+	{
+		mCapacity = count + visibleCount;
+		glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceData) * mCapacity, NULL, GL_DYNAMIC_DRAW);
+	}
+	if (count > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(InstanceData) * count, mInstances.data());
+	}
+	if (visibleCount > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(InstanceData) * count, sizeof(InstanceData) * visibleCount, mVisibleInstances.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBatch::beginCulling()
+{
+	updateNormalMatrices();
+	mVisibleInstances.clear();
+}
+
+/////////////////////////////////////////////////
+// 視錐台と交差するインスタンスだけを可視リストに追記する
+// 境界球で粗く判定し、残ったものをAABBで判定する
+// in  : frustum        判定する視錐台
+//       localBox       メッシュのローカルAABB
+//       localSphere    メッシュのローカル境界球
+//       materialLayer  可視リストに書き込むマテリアルのレイヤー番号
+// out : 可視リスト内の描画範囲 (upload()後に描画に使う)
+////////////////////////////////////////////////
+InstanceRange InstanceBatch::cull(const Frustum& frustum, const AABB& localBox, const BoundingSphere& localSphere, float materialLayer)
+{
+	InstanceRange range;
+	range.base = getCount() + static_cast<unsigned int>(mVisibleInstances.size());
+
+	for (const InstanceData& instance : mInstances)
+	{
+		if (!frustum.Intersects(BoundingSphere::Transform(localSphere, instance.model)))
+		{
+			continue;
+		}
+		if (!frustum.Intersects(AABB::Transform(localBox, instance.model)))
+		{
+			continue;
+		}
+		mVisibleInstances.emplace_back(instance);
+		mVisibleInstances.back().normal[0][3] = materialLayer;
+	}
+
+	range.count = getCount() + static_cast<unsigned int>(mVisibleInstances.size()) - range.base;
+	return range;
+}
+
+/////////////////////////////////////////////////
+// 視錐台と交差するインスタンスのLODを選び、LODごとに連続させて可視リストに追記する
+// out : destRanges     LODごとの描画範囲 (MeshObj::mLodMax個、使わないLODはcount 0)
+//       戻り値         可視インスタンス数
+// in  : frustum        判定する視錐台
+//       mesh           描画するメッシュ (境界ボリュームとLOD表を使う)
+//       lodSelector    メッシュ・パスごとのLOD選択
+//       materialLayer  可視リストに書き込むマテリアルのレイヤー番号
+////////////////////////////////////////////////
+unsigned int InstanceBatch::cull(const Frustum& frustum, const MeshObj& mesh, LodSelector& lodSelector, InstanceRange* destRanges,
+	float materialLayer)
+{
+	const AABB&           localBox    = mesh.getBoundingBox();
+	const BoundingSphere& localSphere = mesh.getBoundingSphere();
+
+	mCulledInstances.clear();
+	mCulledLods.clear();
+	unsigned int lodCounts[MeshObj::mLodMax] = {};
+	for (unsigned int i = 0; i < getCount(); i++)
+	{
+		const Matrix4& model = mInstances[i].model;
+		const BoundingSphere worldSphere = BoundingSphere::Transform(localSphere, model);
+		if (!frustum.Intersects(worldSphere) || !frustum.Intersects(AABB::Transform(localBox, model)))
+		{
+			continue;
+		}
+		const float  scale = localSphere.mRadius > 0.0f ? worldSphere.mRadius / localSphere.mRadius : 1.0f;
+		unsigned int lod   = lodSelector.select(mesh, i, worldSphere, scale);
+		mCulledInstances.emplace_back(i);
+		mCulledLods.emplace_back(lod);
+		lodCounts[lod]++;
+	}
+
+	// LODごとの範囲を確保してから振り分ける
+	unsigned int base = getCount() + static_cast<unsigned int>(mVisibleInstances.size());
+	unsigned int writePos[MeshObj::mLodMax];
+	for (unsigned int lod = 0; lod < MeshObj::mLodMax; lod++)
+	{
+		destRanges[lod].base  = base;
+		destRanges[lod].count = lodCounts[lod];
+		writePos[lod] = base - getCount();
+		base += lodCounts[lod];
+	}
+	mVisibleInstances.resize(base - getCount());
+	for (size_t i = 0; i < mCulledInstances.size(); i++)
+	{
+		InstanceData& dest = mVisibleInstances[writePos[mCulledLods[i]]++];
+		dest = mInstances[mCulledInstances[i]];
+		dest.normal[0][3] = materialLayer;
+	}
+	return static_cast<unsigned int>(mCulledInstances.size());
+}
+
+InstanceRange InstanceBatch::getFullRange() const
+{
+	InstanceRange range;
+	range.base  = 0;
+	range.count = getCount();
+	return range;
+}
+
+/////////////////////////////////////////////////
+// VAOにモデル行列と法線行列をインスタンス属性として接続する
+// Matrix4の各行がGLSLのmat4の各列に対応するので、uniformでmodelを渡す場合と同じ並びになる
+// (法線行列も同様に3行をmat3の3列として読む。1行目の4列目はマテリアルのレイヤー番号として読む)
+// in : vao  接続先の頂点配列オブジェクト
+////////////////////////////////////////////////
+void InstanceBatch::bindToVertexArray(GLuint vao) const
+{
+	if (vao == 0 || mVBO == 0)
+	{
+		return;
+	}
+
+	RENDER_STATE_INSTANCE.bindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+	for (GLuint i = 0; i < 4; i++)
+	{
+		GLuint location = mInstanceAttribLocation + i;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(i * 4 * sizeof(float)));
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+	for (GLuint i = 0; i < 3; i++)
+	{
+		GLuint location = mNormalAttribLocation + i;
+		glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, normal) + i * 4 * sizeof(float)));
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+	glVertexAttribPointer(mMaterialAttribLocation, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, normal) + 3 * sizeof(float)));
+	glEnableVertexAttribArray(mMaterialAttribLocation);
+	glVertexAttribDivisor(mMaterialAttribLocation, 1);
+	RENDER_STATE_INSTANCE.bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
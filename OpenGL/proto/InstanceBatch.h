@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include "Math.h"
+
+class MeshObj;
+class LodSelector;
+
+// インスタンスバッファ内の描画範囲 (baseInstance, instanceCount)
+struct InstanceRange
+{
+	unsigned int base  = 0;
+	unsigned int count = 0;
+};
+
+// GPUに転送するインスタンス1つ分のデータ
+struct InstanceData
+{
+	Matrix4 model;           // モデル行列
+	float   normal[3][4];    // 法線行列 (モデル行列の左上3x3の逆転置、normal[0][3]はマテリアルのレイヤー番号、残りの4列目は未使用)
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// インスタンス描画用のモデル行列バッファ
+// インスタンスごとのモデル行列と法線行列をGPUバッファに保持し、MeshObjのVAOに
+// インスタンス属性(モデル行列 location 4～7 / 法線行列 location 8～10 / マテリアルのレイヤー番号 location 13, divisor 1)として接続する
+// 法線行列は追加時にまとめてCPUで計算するので、頂点シェーダーで逆行列を求める必要はない
+// (剛体変換のインスタンスは左上3x3をそのまま使い、逆行列の計算も省く)
+//
+// バッファの並び : [登録した全インスタンス][カリング結果の可視リスト...]
+// 可視リストはメッシュ・パスごとに追記し、baseInstanceで描画範囲を指定する
+// LODを選ぶ場合は同じLODのインスタンスが連続するように並べ、LODごとの描画範囲を返す
+// 可視リストには描画するメッシュのマテリアルのレイヤー番号を書き込むので、テクスチャ配列を使うマテリアルは
+// 同じインスタンスを別のマテリアルで描いても同じドローにまとめられる (登録したインスタンスは0)
+///////////////////////////////////////////////////////////////////////////////////////
+class InstanceBatch
+{
+public:
+	static const GLuint  mInstanceAttribLocation = 4;                         // モデル行列の先頭attribute location (mat4で4つ使用)
+	static const GLuint  mNormalAttribLocation   = 8;                         // 法線行列の先頭attribute location (vec4を3つ使用)
+	static const GLuint  mMaterialAttribLocation = 13;                        // マテリアルのレイヤー番号のattribute location (float)
+
+	InstanceBatch();
+	~InstanceBatch();
+
+	void                 clear();                                             // 登録インスタンスのクリア
+	void                 addInstance(const Matrix4& modelMat, bool rigid = false); // インスタンスのモデル行列を追加 (rigid : 回転と平行移動のみ)
+	void                 addGrid(int numX, int numZ, float spacing);          // XZ平面上に格子状にインスタンスを追加
+	void                 upload();                                            // モデル行列(全インスタンス + 可視リスト)をGPUバッファに転送
+	void                 bindToVertexArray(GLuint vao) const;                 // VAOにインスタンス属性として接続
+
+	// カリング
+	void                 beginCulling();                                      // 可視リストのクリア (毎フレーム先頭で呼ぶ)
+	InstanceRange        cull(const Frustum& frustum, const AABB& localBox, const BoundingSphere& localSphere, float materialLayer = 0.0f); // 可視インスタンスを可視リストに追記
+	unsigned int         cull(const Frustum& frustum, const MeshObj& mesh, LodSelector& lodSelector, InstanceRange* destRanges,
+	                          float materialLayer = 0.0f);                   // LODごとに可視リストに追記
+	InstanceRange        getFullRange() const;                                // 全インスタンスの描画範囲
+
+	unsigned int         getCount() const { return static_cast<unsigned int>(mInstances.size()); }
+	const Matrix4&       getModelMatrix(unsigned int index) const { return mInstances[index].model; }
+	Vector3              getCenter() const;                                   // 全インスタンスの平行移動成分の平均
+	bool                 isRigid() const { return mRigid; }                   // 全インスタンスが剛体変換か (法線行列 = モデル行列の3x3)
+
+private:
+	void                 updateNormalMatrices();                              // 追加されたインスタンスの法線行列を計算
+
+	std::vector<InstanceData> mInstances;        // インスタンスごとのモデル行列と法線行列
+	std::vector<InstanceData> mVisibleInstances; // カリング結果の可視リスト (全インスタンスの後ろに配置)
+	std::vector<unsigned int> mPendingNormals;   // 法線行列の計算待ちのインスタンス (剛体変換でないもの)
+	std::vector<unsigned int> mCulledInstances;  // LOD選択時の作業領域 (可視インスタンスの番号)
+	std::vector<unsigned int> mCulledLods;       // LOD選択時の作業領域 (可視インスタンスのLOD)
+	bool                      mRigid;            // 全インスタンスが剛体変換か
+	GLuint                    mVBO;              // インスタンスバッファオブジェクト
+	unsigned int              mCapacity;         // GPUバッファに確保済みのインスタンス数
+};
@@ -0,0 +1,69 @@
+#include "LodSelector.h"
+
+LodSelector::LodSelector()
+	: mPixelError(1.0f)
+	, mHysteresis(0.25f)
+	, mLodBias(0)
+	, mViewPos(Vector3::Zero)
+	, mPixelsPerUnit(1.0f)
+{
+}
+
+void LodSelector::setPolicy(float pixelError, float hysteresis, unsigned int lodBias)
+{
+	mPixelError = Math::Max(pixelError, 0.0f);
+	mHysteresis = Math::Clamp(hysteresis, 0.0f, 1.0f);
+	mLodBias    = lodBias;
+}
+
+void LodSelector::setView(const Vector3& viewPos, float pixelsPerUnit)
+{
+	mViewPos       = viewPos;
+	mPixelsPerUnit = pixelsPerUnit;
+}
+
+/////////////////////////////////////////////////
+// インスタンスのLODを選ぶ
+// 前フレームのLODの誤差が許容誤差を超えていれば細かくし、
+// 次のLODの誤差が許容誤差 × (1 - hysteresis) に収まれば粗くする
+// in  : mesh         描画するメッシュ (LOD表を使う)
+//       instance     インスタンス番号 (前フレームのLODを覚えておく)
+//       worldSphere  ワールド座標の境界球
+//       scale        ローカル座標からワールド座標への拡大率
+// out : 描画するLOD (バイアス込み、メッシュのLOD数未満)
+////////////////////////////////////////////////
+unsigned int LodSelector::select(const MeshObj& mesh, unsigned int instance, const BoundingSphere& worldSphere, float scale)
+{
+	const std::vector<MeshLod>& lods = mesh.getLods();
+	if (lods.size() <= 1)
+	{
+		return 0;
+	}
+	if (instance >= mCurrentLods.size())
+	{
+		mCurrentLods.resize(instance + 1, 0);
+	}
+
+	// 誤差1単位が画面上で何ピクセルになるか (境界球の内側にいるときは最も細かいLOD)
+	const float distance = (worldSphere.mCenter - mViewPos).Length() - worldSphere.mRadius;
+	if (distance <= 0.0f)
+	{
+		mCurrentLods[instance] = 0;
+		return Math::Min<unsigned int>(mLodBias, static_cast<unsigned int>(lods.size()) - 1);
+	}
+	const float pixelsPerError = scale * mPixelsPerUnit / distance;
+
+	const unsigned int lodMax = static_cast<unsigned int>(lods.size()) - 1;
+	unsigned int lod = Math::Min<unsigned int>(mCurrentLods[instance], lodMax);
+	while (lod > 0 && lods[lod].error * pixelsPerError > mPixelError)
+	{
+		lod--;
+	}
+	while (lod < lodMax && lods[lod + 1].error * pixelsPerError <= mPixelError * (1.0f - mHysteresis))
+	{
+		lod++;
+	}
+	mCurrentLods[instance] = static_cast<unsigned char>(lod);
+
+	return Math::Min(lod + mLodBias, lodMax);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include "Math.h"
+#include "MeshObj.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// インスタンスごとのLOD選択
+// LODの誤差(ローカル座標の距離)を画面上のピクセル数に投影し、許容誤差に収まる最も粗いLODを選ぶ
+// 投影した誤差は 誤差 / 境界球の半径 × 画面上の境界球の半径(ピクセル) なので、画面上の大きさに比例する
+// インスタンスごとに前フレームのLODを覚えておき、粗くするときは許容誤差を (1 - hysteresis) 倍に
+// 狭めて判定する (境目の距離でLODが毎フレーム切り替わってポップしないように)
+// メッシュ・パスごとに1つ使い、シャドウパスはlodBiasで描画パスより粗いLODにできる
+///////////////////////////////////////////////////////////////////////////////////////
+class LodSelector
+{
+public:
+	LodSelector();
+
+	void         setPolicy(float pixelError, float hysteresis, unsigned int lodBias); // 許容誤差(ピクセル)・ヒステリシス・LODのバイアス
+	void         setView(const Vector3& viewPos, float pixelsPerUnit);                 // 視点と投影 (距離1で1単位が何ピクセルか)
+	unsigned int select(const MeshObj& mesh, unsigned int instance, const BoundingSphere& worldSphere, float scale); // LODの選択
+
+private:
+	float                      mPixelError;     // 許容する画面上の誤差 (ピクセル)
+	float                      mHysteresis;     // 粗くするときに許容誤差を狭める割合
+	unsigned int               mLodBias;        // 選んだLODに足す段数 (シャドウなど)
+	Vector3                    mViewPos;        // 視点
+	float                      mPixelsPerUnit;  // 距離1での1単位のピクセル数
+	std::vector<unsigned char> mCurrentLods;    // インスタンスごとの前フレームのLOD (バイアスを足す前)
+};
@@ -0,0 +1,123 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "MappedFile.h"
+
+MappedFile::MappedFile()
+	: mData(nullptr)
+	, mSize(0)
+#ifdef _WIN32
+	, mFile(INVALID_HANDLE_VALUE)
+	, mMapping(nullptr)
+#else
+	, mFile(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+/////////////////////////////////////////////////
+// ファイルを読み込み専用でマップする
+// in  : path  ファイル名
+// out : マップできたらtrue
+////////////////////////////////////////////////
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMapping)
+	{
+		close();
+		return false;
+	}
+
+	mData = static_cast<const unsigned char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!mData)
+	{
+		close();
+		return false;
+	}
+	mSize = static_cast<size_t>(size.QuadPart);
+#else
+	mFile = ::open(path.c_str(), O_RDONLY);
+	if (mFile < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(mFile, &status) != 0 || status.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	mData = static_cast<const unsigned char*>(data);
+	mSize = static_cast<size_t>(status.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+	}
+	mMapping = nullptr;
+	mFile    = INVALID_HANDLE_VALUE;
+#else
+	if (mData)
+	{
+		munmap(const_cast<unsigned char*>(mData), mSize);
+	}
+	if (mFile >= 0)
+	{
+		::close(mFile);
+	}
+	mFile = -1;
+#endif
+	mData = nullptr;
+	mSize = 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 読み込み専用のメモリマップトファイル
+// ファイル全体をアドレス空間にマップし、読み込み・コピーなしで内容を参照する
+// (ページはアクセスした時にOSが読み込む)
+///////////////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool                 open(const std::string& path);   // ファイルをマップする (空のファイルは失敗)
+	void                 close();                         // マップを解除する
+
+	bool                 isOpen() const { return mData != nullptr; }
+	const unsigned char* getData() const { return mData; }
+	size_t               getSize() const { return mSize; }
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* mData;      // マップした先頭アドレス
+	size_t               mSize;      // ファイルサイズ
+#ifdef _WIN32
+	void*                mFile;      // ファイルハンドル
+	void*                mMapping;   // ファイルマッピングハンドル
+#else
+	int                  mFile;      // ファイルディスクリプタ
+#endif
+};
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include "MaterialLibrary.h"
+#include "TextureRegistry.h"
+#include "AssetLoader.h"
+#include "ShaderPermutation.h"
+#include "RenderState.h"
+
+// マップのテクスチャユニット (lit.frag のサンプラーと同じ)
+const unsigned int MaterialLibrary::mMapUnits[Map_Num] = { 0, 1, 3 };
+
+// マップの読み込み中の色 (ディフューズは灰色、スペキュラーは黒、法線は面の向きそのまま)
+const unsigned char MaterialLibrary::mPlaceholders[Map_Num][4] =
+{
+	{ 128, 128, 128, 255 },
+	{   0,   0,   0, 255 },
+	{ 128, 128, 255, 255 },
+};
+
+MaterialLibrary::MaterialLibrary(unsigned int layerMax)
+	: mLayerMax(std::max(layerMax, 1u))
+{
+}
+
+MaterialLibrary::~MaterialLibrary()
+{
+	for (GLuint texture : mTextures)
+	{
+		TEXTURE_REGISTRY_INSTANCE.release(texture);
+	}
+	for (TextureSet* set : mTextureSets)
+	{
+		delete set;
+	}
+}
+
+void MaterialLibrary::setSharedTexture(unsigned int unit, GLuint texture)
+{
+	mSharedTextures.emplace_back(unit, texture);
+	TEXTURE_REGISTRY_INSTANCE.addRef(texture);
+	mTextures.push_back(texture);
+}
+
+/////////////////////////////////////////////////
+// マテリアルを追加する
+// マップのファイルのヘッダーだけを読み、テクスチャ配列に入れられるかを決める
+// in  : diffusePath, specularPath, normalPath  各マップの画像ファイル名 (使わないマップは空文字列)
+// out : マテリアル番号
+////////////////////////////////////////////////
+unsigned int MaterialLibrary::addMaterial(const std::string& diffusePath, const std::string& specularPath, const std::string& normalPath)
+{
+	MaterialEntry entry;
+	entry.paths[Map_Diffuse]  = diffusePath;
+	entry.paths[Map_Specular] = specularPath;
+	entry.paths[Map_Normal]   = normalPath;
+	entry.layered             = true;
+	entry.material            = { nullptr, 0.0f, 0 };
+
+	for (int map = 0; map < Map_Num; map++)
+	{
+		MapFormat& format = entry.formats[map];
+		format = { GL_NONE, 0, 0, 0 };
+		if (entry.paths[map].empty())
+		{
+			continue;
+		}
+
+		// BC7は仮の色を圧縮できないので、2Dテクスチャで読み込みが終わるまで待つ
+		TextureFile::Info info;
+		entry.files[map] = ASSET_LOADER_INSTANCE.selectTextureFile(entry.paths[map], info);
+		if (info.format == TextureFile::Format_BC7 ||
+			!TextureRegistry::getStorageFormat(info, format.internalFormat, format.levelNum))
+		{
+			format.internalFormat = GL_NONE;
+			entry.layered = false;
+			continue;
+		}
+		format.width  = info.width;
+		format.height = info.height;
+	}
+
+	mMaterials.push_back(entry);
+	return static_cast<unsigned int>(mMaterials.size() - 1);
+}
+
+/////////////////////////////////////////////////
+// テクスチャセットを作る
+// テクスチャ配列に入れられるマテリアルは、全マップの形式が同じでレイヤーに空きのあるテクスチャセットに入れる
+// (不変ストレージはレイヤー数を後から増やせないので、全マテリアルを追加してから作る)
+////////////////////////////////////////////////
+void MaterialLibrary::build()
+{
+	for (unsigned int i = 0; i < mMaterials.size(); i++)
+	{
+		MaterialEntry& entry = mMaterials[i];
+		TextureSet*    found = nullptr;
+		for (TextureSet* set : mTextureSets)
+		{
+			if (!entry.layered || !set->layered || set->materials.size() >= mLayerMax)
+			{
+				continue;
+			}
+			bool same = true;
+			for (int map = 0; map < Map_Num && same; map++)
+			{
+				same = isSameFormat(set->formats[map], entry.formats[map]);
+			}
+			if (same)
+			{
+				found = set;
+				break;
+			}
+		}
+		if (!found)
+		{
+			found = new TextureSet;
+			found->layered = entry.layered;
+			std::copy(entry.formats, entry.formats + Map_Num, found->formats);
+			mTextureSets.push_back(found);
+		}
+		found->materials.push_back(i);
+	}
+
+	for (unsigned int i = 0; i < mTextureSets.size(); i++)
+	{
+		buildTextureSet(*mTextureSets[i], i);
+	}
+}
+
+/////////////////////////////////////////////////
+// テクスチャセット1つ分のテクスチャを作り、読み込みを要求する
+// in : set       作るテクスチャセット
+//      setIndex  テクスチャセットの番号 (レポートに出す名前用)
+////////////////////////////////////////////////
+void MaterialLibrary::buildTextureSet(TextureSet& set, unsigned int setIndex)
+{
+	static const char* mapNames[Map_Num] = { "diffuse", "specular", "normal" };
+
+	unsigned int unitNum = 0;
+	for (int map = 0; map < Map_Num; map++)
+	{
+		unitNum = std::max(unitNum, mMapUnits[map] + 1);
+	}
+	for (const auto& shared : mSharedTextures)
+	{
+		unitNum = std::max(unitNum, shared.first + 1);
+	}
+	// ターゲットはここで決めておき、描画時にはTextureRegistryを引かない
+	set.bindings.textures.assign(unitNum, 0);
+	set.bindings.targets.assign(unitNum, GL_TEXTURE_2D);
+	for (const auto& shared : mSharedTextures)
+	{
+		set.bindings.textures[shared.first] = shared.second;
+		set.bindings.targets[shared.first]  = TEXTURE_REGISTRY_INSTANCE.getTarget(shared.second);
+	}
+
+	const unsigned int layerNum = static_cast<unsigned int>(set.materials.size());
+	for (int map = 0; map < Map_Num; map++)
+	{
+		if (!set.layered)
+		{
+			// テクスチャ配列に入れられないマテリアルは、そのマテリアルだけの2Dテクスチャ
+			const MaterialEntry& entry = mMaterials[set.materials[0]];
+			if (!entry.paths[map].empty())
+			{
+				GLuint texture = TEXTURE_REGISTRY_INSTANCE.acquire(entry.paths[map], mPlaceholders[map]);
+				set.bindings.textures[mMapUnits[map]] = texture;
+				mTextures.push_back(texture);
+			}
+			continue;
+		}
+
+		const MapFormat& format = set.formats[map];
+		if (format.internalFormat == GL_NONE)
+		{
+			continue;
+		}
+		const std::string name = "material set " + std::to_string(setIndex) + " " + mapNames[map];
+		GLuint texture = TEXTURE_REGISTRY_INSTANCE.createTextureArray(name, format.internalFormat, format.width, format.height, format.levelNum, layerNum);
+		RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // 各レイヤーは全レベルを埋めるのでミップを使える
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		set.bindings.textures[mMapUnits[map]] = texture;
+		set.bindings.targets[mMapUnits[map]]  = GL_TEXTURE_2D_ARRAY;
+		mTextures.push_back(texture);
+
+		// 読み込みが終わるまでは各レイヤーを仮の色で埋めておく
+		for (unsigned int layer = 0; layer < layerNum; layer++)
+		{
+			const MaterialEntry& entry = mMaterials[set.materials[layer]];
+			TEXTURE_REGISTRY_INSTANCE.fillLayer(texture, layer, mPlaceholders[map]);
+			ASSET_LOADER_INSTANCE.requestTexture(texture, entry.paths[map], entry.files[map], static_cast<int>(layer));
+		}
+	}
+
+	for (unsigned int layer = 0; layer < layerNum; layer++)
+	{
+		Material& material = mMaterials[set.materials[layer]].material;
+		material.textures = &set.bindings;
+		material.layer    = static_cast<float>(layer);
+		material.features = set.layered ? ShaderFeature_TextureArray : 0;
+	}
+}
+
+bool MaterialLibrary::isSameFormat(const MapFormat& a, const MapFormat& b)
+{
+	return a.internalFormat == b.internalFormat && a.width == b.width && a.height == b.height && a.levelNum == b.levelNum;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include "RenderQueue.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// マテリアルのテクスチャ配列
+// マテリアルのマップ(ディフューズ・スペキュラー・法線)を大きさと形式が同じもの同士で
+// GL_TEXTURE_2D_ARRAY にまとめ、マテリアルにはレイヤー番号を割り当てる
+// 同じテクスチャ配列に入ったマテリアルはテクスチャセットが共通になるので、レイヤー番号を
+// インスタンス属性で渡せば、別のマテリアルのメッシュも1つのマルチドローで描ける
+//
+// 全マップの大きさと形式の組が同じマテリアルが同じテクスチャセットに入る
+// 大きさはレベル0で比べるので、解像度の違うマップ (2048x2048と1024x1024など) を持つマテリアル同士は別のテクスチャセットになる
+// ヘッダーから大きさ・形式が分からないマップを持つマテリアルはテクスチャ配列に入れず、
+// TextureRegistryの2Dテクスチャで1つのテクスチャセットを作る (TEXTURE_ARRAYを付けないバリアントで描く)
+// マップのテクスチャユニットは lit.frag と同じ (ディフューズ 0 / スペキュラー 1 / 法線 3)
+//
+// 使い方 :
+//   setSharedTexture (シャドウマップなど) → addMaterial … → build() → getMaterial
+///////////////////////////////////////////////////////////////////////////////////////
+class MaterialLibrary
+{
+public:
+	enum MapEnum
+	{
+		Map_Diffuse,
+		Map_Specular,
+		Map_Normal,
+		Map_Num
+	};
+
+	// 描画に使うマテリアルの情報
+	struct Material
+	{
+		const TextureBindings*           textures;   // テクスチャセット (ユニット順、DrawItemに渡す)
+		float                            layer;      // テクスチャ配列のレイヤー番号 (インスタンス属性に書く)
+		unsigned int                     features;   // 必要なシェーダー機能 (テクスチャ配列ならShaderFeature_TextureArray)
+	};
+
+	MaterialLibrary(unsigned int layerMax = 64);
+	~MaterialLibrary();
+
+	void            setSharedTexture(unsigned int unit, GLuint texture);  // 全テクスチャセットに入れるテクスチャ (build前)
+	unsigned int    addMaterial(const std::string& diffusePath, const std::string& specularPath,
+	                            const std::string& normalPath = "");       // マテリアルの追加 (使わないマップは空文字列)
+	void            build();                                               // テクスチャセットを作り、各マップの読み込みを要求する
+	const Material& getMaterial(unsigned int material) const { return mMaterials[material].material; } // build後に使う
+	unsigned int    getTextureSetNum() const { return static_cast<unsigned int>(mTextureSets.size()); }
+
+private:
+	MaterialLibrary(const MaterialLibrary&) = delete;
+	MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+
+	// マップを入れる不変ストレージの形式 (全マップで同じならテクスチャ配列を共有できる)
+	struct MapFormat
+	{
+		GLenum       internalFormat;   // マップ無しはGL_NONE
+		int          width;
+		int          height;
+		unsigned int levelNum;
+	};
+
+	struct MaterialEntry
+	{
+		std::string  paths[Map_Num];   // 要求されたファイル名 (マップ無しは空)
+		std::string  files[Map_Num];   // 実際に読むファイル名 (使える.ddsがあればそちら)
+		MapFormat    formats[Map_Num];
+		bool         layered;          // テクスチャ配列に入れられるか
+		Material     material;
+	};
+
+	struct TextureSet
+	{
+		bool                      layered;    // テクスチャ配列か (falseならマテリアル1つ分の2D)
+		MapFormat                 formats[Map_Num];
+		std::vector<unsigned int> materials;  // レイヤー順のマテリアル
+		TextureBindings           bindings;   // ユニット順のテクスチャ名とターゲット
+	};
+
+	static bool     isSameFormat(const MapFormat& a, const MapFormat& b);
+	void            buildTextureSet(TextureSet& set, unsigned int setIndex);
+
+	static const unsigned int  mMapUnits[Map_Num];           // マップのテクスチャユニット
+	static const unsigned char mPlaceholders[Map_Num][4];    // マップの読み込み中の色
+
+	std::vector<MaterialEntry>  mMaterials;
+	std::vector<TextureSet*>    mTextureSets;                 // Material::textures が bindings を指すのでポインタで持つ
+	std::vector<std::pair<unsigned int, GLuint>> mSharedTextures; // ユニットとテクスチャ名
+	std::vector<GLuint>         mTextures;                    // 解放するテクスチャ (参照を持っている物)
+	unsigned int                mLayerMax;                    // 1つのテクスチャ配列のレイヤー数の上限
+};
@@ -8,6 +8,11 @@
 
 #include "Math.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define MATH_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
 const Vector2 Vector2::Zero(0.0f, 0.0f);
 const Vector2 Vector2::UnitX(1.0f, 0.0f);
 const Vector2 Vector2::UnitY(0.0f, 1.0f);
@@ -211,6 +216,109 @@ void Matrix4::Invert()
 	}
 }
 
+// Normal matrix of a single matrix (scalar path)
+static void InvertTransposeUpper3x3(const Matrix4& src, Matrix4& dest)
+{
+	const float (*m)[4] = src.mat;
+
+	// The inverse transpose of a 3x3 is its cofactor matrix divided by the determinant,
+	// and the cofactor rows are the cross products of the source rows
+	float c[3][3];
+	c[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+	c[0][1] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+	c[0][2] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+	c[1][0] = m[2][1] * m[0][2] - m[2][2] * m[0][1];
+	c[1][1] = m[2][2] * m[0][0] - m[2][0] * m[0][2];
+	c[1][2] = m[2][0] * m[0][1] - m[2][1] * m[0][0];
+	c[2][0] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+	c[2][1] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+	c[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+	float det = m[0][0] * c[0][0] + m[0][1] * c[0][1] + m[0][2] * c[0][2];
+	float invDet = (det != 0.0f) ? 1.0f / det : 0.0f;
+
+	for (int i = 0; i < 3; i++)
+	{
+		dest.mat[i][0] = c[i][0] * invDet;
+		dest.mat[i][1] = c[i][1] * invDet;
+		dest.mat[i][2] = c[i][2] * invDet;
+		dest.mat[i][3] = 0.0f;
+	}
+	dest.mat[3][0] = 0.0f;
+	dest.mat[3][1] = 0.0f;
+	dest.mat[3][2] = 0.0f;
+	dest.mat[3][3] = 1.0f;
+}
+
+void Matrix4::InvertTransposeBatch(const Matrix4* src, Matrix4* dest, size_t count)
+{
+	size_t i = 0;
+#ifdef MATH_USE_SSE
+	// Four matrices at a time in structure-of-arrays form:
+	// after the transposes, x0 holds mat[0][0] of all four matrices, y0 holds mat[0][1], ...
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x0 = _mm_loadu_ps(src[i + 0].mat[0]);
+		__m128 y0 = _mm_loadu_ps(src[i + 1].mat[0]);
+		__m128 z0 = _mm_loadu_ps(src[i + 2].mat[0]);
+		__m128 w0 = _mm_loadu_ps(src[i + 3].mat[0]);
+		_MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+
+		__m128 x1 = _mm_loadu_ps(src[i + 0].mat[1]);
+		__m128 y1 = _mm_loadu_ps(src[i + 1].mat[1]);
+		__m128 z1 = _mm_loadu_ps(src[i + 2].mat[1]);
+		__m128 w1 = _mm_loadu_ps(src[i + 3].mat[1]);
+		_MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+
+		__m128 x2 = _mm_loadu_ps(src[i + 0].mat[2]);
+		__m128 y2 = _mm_loadu_ps(src[i + 1].mat[2]);
+		__m128 z2 = _mm_loadu_ps(src[i + 2].mat[2]);
+		__m128 w2 = _mm_loadu_ps(src[i + 3].mat[2]);
+		_MM_TRANSPOSE4_PS(x2, y2, z2, w2);
+
+		// Cofactor rows: row1 x row2, row2 x row0, row0 x row1
+		__m128 cx0 = _mm_sub_ps(_mm_mul_ps(y1, z2), _mm_mul_ps(z1, y2));
+		__m128 cy0 = _mm_sub_ps(_mm_mul_ps(z1, x2), _mm_mul_ps(x1, z2));
+		__m128 cz0 = _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(y1, x2));
+		__m128 cx1 = _mm_sub_ps(_mm_mul_ps(y2, z0), _mm_mul_ps(z2, y0));
+		__m128 cy1 = _mm_sub_ps(_mm_mul_ps(z2, x0), _mm_mul_ps(x2, z0));
+		__m128 cz1 = _mm_sub_ps(_mm_mul_ps(x2, y0), _mm_mul_ps(y2, x0));
+		__m128 cx2 = _mm_sub_ps(_mm_mul_ps(y0, z1), _mm_mul_ps(z0, y1));
+		__m128 cy2 = _mm_sub_ps(_mm_mul_ps(z0, x1), _mm_mul_ps(x0, z1));
+		__m128 cz2 = _mm_sub_ps(_mm_mul_ps(x0, y1), _mm_mul_ps(y0, x1));
+
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, cx0), _mm_mul_ps(y0, cy0)), _mm_mul_ps(z0, cz0));
+		__m128 invDet = _mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_div_ps(_mm_set1_ps(1.0f), det));
+
+		cx0 = _mm_mul_ps(cx0, invDet); cy0 = _mm_mul_ps(cy0, invDet); cz0 = _mm_mul_ps(cz0, invDet);
+		cx1 = _mm_mul_ps(cx1, invDet); cy1 = _mm_mul_ps(cy1, invDet); cz1 = _mm_mul_ps(cz1, invDet);
+		cx2 = _mm_mul_ps(cx2, invDet); cy2 = _mm_mul_ps(cy2, invDet); cz2 = _mm_mul_ps(cz2, invDet);
+
+		// Back to one row per matrix (the 4th column becomes zero)
+		__m128 cw0 = zero, cw1 = zero, cw2 = zero;
+		_MM_TRANSPOSE4_PS(cx0, cy0, cz0, cw0);
+		_MM_TRANSPOSE4_PS(cx1, cy1, cz1, cw1);
+		_MM_TRANSPOSE4_PS(cx2, cy2, cz2, cw2);
+
+		const __m128 row3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+		__m128 rows[3][4] = { { cx0, cy0, cz0, cw0 }, { cx1, cy1, cz1, cw1 }, { cx2, cy2, cz2, cw2 } };
+		for (int k = 0; k < 4; k++)
+		{
+			_mm_storeu_ps(dest[i + k].mat[0], rows[0][k]);
+			_mm_storeu_ps(dest[i + k].mat[1], rows[1][k]);
+			_mm_storeu_ps(dest[i + k].mat[2], rows[2][k]);
+			_mm_storeu_ps(dest[i + k].mat[3], row3);
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		InvertTransposeUpper3x3(src[i], dest[i]);
+	}
+}
+
 Matrix4 Matrix4::CreateFromQuaternion(const class Quaternion& q)
 {
 	float mat[4][4];
@@ -237,3 +345,64 @@ Matrix4 Matrix4::CreateFromQuaternion(const class Quaternion& q)
 
 	return Matrix4(mat);
 }
+
+AABB AABB::Transform(const AABB& box, const Matrix4& mat)
+{
+	// Transform the center, then project the extents onto each world axis
+	Vector3 center = Vector3::Transform(box.GetCenter(), mat);
+	Vector3 extents = box.GetExtents();
+	Vector3 newExtents;
+	newExtents.x = Math::Abs(mat.mat[0][0]) * extents.x + Math::Abs(mat.mat[1][0]) * extents.y + Math::Abs(mat.mat[2][0]) * extents.z;
+	newExtents.y = Math::Abs(mat.mat[0][1]) * extents.x + Math::Abs(mat.mat[1][1]) * extents.y + Math::Abs(mat.mat[2][1]) * extents.z;
+	newExtents.z = Math::Abs(mat.mat[0][2]) * extents.x + Math::Abs(mat.mat[1][2]) * extents.y + Math::Abs(mat.mat[2][2]) * extents.z;
+	return AABB(center - newExtents, center + newExtents);
+}
+
+BoundingSphere BoundingSphere::Transform(const BoundingSphere& sphere, const Matrix4& mat)
+{
+	Vector3 scale = mat.GetScale();
+	float maxScale = Math::Max(scale.x, Math::Max(scale.y, scale.z));
+	return BoundingSphere(Vector3::Transform(sphere.mCenter, mat), sphere.mRadius * maxScale);
+}
+
+Frustum::Frustum(const Matrix4& viewProj)
+{
+	// clip = v * M, so each clip component is a dot product with a column of M.
+	// Uses the -w <= z <= w range, which is conservative for [0, w] depth too.
+	const float (*m)[4] = viewProj.mat;
+	mPlanes[PLANE_LEFT]   = Plane(m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0], m[3][3] + m[3][0]);
+	mPlanes[PLANE_RIGHT]  = Plane(m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0], m[3][3] - m[3][0]);
+	mPlanes[PLANE_BOTTOM] = Plane(m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1], m[3][3] + m[3][1]);
+	mPlanes[PLANE_TOP]    = Plane(m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1], m[3][3] - m[3][1]);
+	mPlanes[PLANE_NEAR]   = Plane(m[0][3] + m[0][2], m[1][3] + m[1][2], m[2][3] + m[2][2], m[3][3] + m[3][2]);
+	mPlanes[PLANE_FAR]    = Plane(m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2]);
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const
+{
+	for (int i = 0; i < PLANE_NUM; i++)
+	{
+		if (mPlanes[i].SignedDist(sphere.mCenter) < -sphere.mRadius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+	for (int i = 0; i < PLANE_NUM; i++)
+	{
+		// Test the corner furthest along the plane normal
+		const Vector3& n = mPlanes[i].mNormal;
+		Vector3 positive(n.x >= 0.0f ? box.mMax.x : box.mMin.x,
+			n.y >= 0.0f ? box.mMax.y : box.mMin.y,
+			n.z >= 0.0f ? box.mMax.z : box.mMin.z);
+		if (mPlanes[i].SignedDist(positive) < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -11,6 +11,7 @@
 #include <cmath>
 #include <memory.h>
 #include <limits>
+#include <cstddef>
 
 namespace Math
 {
@@ -684,6 +685,12 @@ public:
 	// Invert the matrix - super slow
 	void Invert();
 
+	// Compute the inverse transpose of the upper 3x3 of each matrix (the normal matrix).
+	// The 4th row and column of each result are set to identity; singular matrices give zero.
+	// Four matrices are processed per iteration with SSE when available.
+	// src and dest may be the same array.
+	static void InvertTransposeBatch(const Matrix4* src, Matrix4* dest, size_t count);
+
 	// Get the translation component of the matrix
 	Vector3 GetTranslation() const
 	{
@@ -1018,6 +1025,129 @@ public:
 	static const Quaternion Identity;
 };
 
+// Axis-aligned bounding box
+class AABB
+{
+public:
+	Vector3 mMin;
+	Vector3 mMax;
+
+	// Starts out empty (min = +inf, max = -inf)
+	AABB()
+		:mMin(Vector3::Infinity)
+		,mMax(Vector3::NegInfinity)
+	{}
+
+	AABB(const Vector3& min, const Vector3& max)
+		:mMin(min)
+		,mMax(max)
+	{}
+
+	// Grow the box to contain the point
+	void UpdateMinMax(const Vector3& point)
+	{
+		mMin.x = Math::Min(mMin.x, point.x);
+		mMin.y = Math::Min(mMin.y, point.y);
+		mMin.z = Math::Min(mMin.z, point.z);
+		mMax.x = Math::Max(mMax.x, point.x);
+		mMax.y = Math::Max(mMax.y, point.y);
+		mMax.z = Math::Max(mMax.z, point.z);
+	}
+
+	bool IsEmpty() const
+	{
+		return mMin.x > mMax.x || mMin.y > mMax.y || mMin.z > mMax.z;
+	}
+
+	Vector3 GetCenter() const
+	{
+		return (mMin + mMax) * 0.5f;
+	}
+
+	Vector3 GetExtents() const
+	{
+		return (mMax - mMin) * 0.5f;
+	}
+
+	// Transform the box by mat and return the box enclosing the result
+	static AABB Transform(const AABB& box, const class Matrix4& mat);
+};
+
+// Bounding sphere
+class BoundingSphere
+{
+public:
+	Vector3 mCenter;
+	float mRadius;
+
+	BoundingSphere()
+		:mRadius(0.0f)
+	{}
+
+	BoundingSphere(const Vector3& center, float radius)
+		:mCenter(center)
+		,mRadius(radius)
+	{}
+
+	// Transform the sphere by mat (radius is scaled by the largest axis scale)
+	static BoundingSphere Transform(const BoundingSphere& sphere, const class Matrix4& mat);
+};
+
+// Plane (dot(mNormal, p) + mD = 0, normal points to the inside)
+class Plane
+{
+public:
+	Vector3 mNormal;
+	float mD;
+
+	Plane()
+		:mD(0.0f)
+	{}
+
+	Plane(float a, float b, float c, float d)
+	{
+		// Normalize so that SignedDist returns a real distance
+		float invLength = 1.0f / Math::Sqrt(a * a + b * b + c * c);
+		mNormal = Vector3(a * invLength, b * invLength, c * invLength);
+		mD = d * invLength;
+	}
+
+	// Signed distance from the plane (positive on the inside)
+	float SignedDist(const Vector3& point) const
+	{
+		return Vector3::Dot(point, mNormal) + mD;
+	}
+};
+
+// View frustum made of six inward facing planes
+class Frustum
+{
+public:
+	enum
+	{
+		PLANE_LEFT,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_NUM
+	};
+
+	Plane mPlanes[PLANE_NUM];
+
+	Frustum() {}
+
+	// Extract the planes from a view-projection matrix (row vector convention, v * M)
+	explicit Frustum(const class Matrix4& viewProj);
+
+	// Returns false if the sphere is completely outside
+	bool Intersects(const BoundingSphere& sphere) const;
+
+	// Returns false if the box is completely outside
+	bool Intersects(const AABB& box) const;
+};
+
 namespace Color
 {
 	static const Vector3 Black(0.0f, 0.0f, 0.0f);
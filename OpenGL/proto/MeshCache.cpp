@@ -0,0 +1,266 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "MeshCache.h"
+
+static const char         meshMagic[4] = { 'M', 'B', 'I', 'N' };
+static const unsigned int meshVersion  = 4;
+static const size_t       sectionAlign = 16;
+
+// FNV-1a 64bit (8バイト単位で混ぜ、端数は1バイトずつ)
+static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		unsigned long long word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash ^= word;
+		hash *= 1099511628211ull;
+	}
+	for (; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static void makeDirectory(const std::string& directory)
+{
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+}
+
+static size_t alignSection(size_t offset)
+{
+	return (offset + sectionAlign - 1) & ~(sectionAlign - 1);
+}
+
+MeshCache::MeshCache()
+	: mDirectory("mesh_cache")
+	, mEnable(true)
+{
+}
+
+// キャッシュファイル名は読み込み元のパスと変換行列から作る (同じOBJを別の変換で読んでも上書きし合わない)
+std::string MeshCache::getFilePath(const std::string& objPath, const Matrix4& transMat) const
+{
+	unsigned long long key = 14695981039346656037ull;
+	key = hashBytes(key, objPath.data(), objPath.size());
+	key = hashBytes(key, transMat.mat, sizeof(transMat.mat));
+
+	std::ostringstream ss;
+	ss << mDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".mbin";
+	return ss.str();
+}
+
+/////////////////////////////////////////////////
+// 元のOBJファイルの内容・変換行列・オーバードロー最適化とLODの設定のハッシュ
+// OBJはマップして読むだけで解析はしない
+////////////////////////////////////////////////
+bool MeshCache::getSourceHash(const std::string& objPath, const Matrix4& transMat, float overdrawThreshold, const std::vector<float>& lodRatios,
+	unsigned long long& destHash) const
+{
+	MappedFile source;
+	if (!source.open(objPath))
+	{
+		return false;
+	}
+
+	unsigned long long hash = 14695981039346656037ull;
+	hash = hashBytes(hash, source.getData(), source.getSize());
+	hash = hashBytes(hash, transMat.mat, sizeof(transMat.mat));
+	hash = hashBytes(hash, &overdrawThreshold, sizeof(overdrawThreshold));
+	hash = hashBytes(hash, lodRatios.data(), sizeof(float) * lodRatios.size());
+	destHash = hash;
+	return true;
+}
+
+/////////////////////////////////////////////////
+// キャッシュファイルをマップする
+// in  : objPath            元のOBJファイル名
+//       transMat           読み込み時の変換行列
+//       overdrawThreshold  読み込み時のオーバードロー最適化の設定
+//       lodRatios          読み込み時のLODの設定
+//       format             読み込む頂点フォーマット (キャッシュと違えば読み込み直す)
+// out : dest      マップしたファイルと各データの先頭
+//       有効なキャッシュがあればtrue (無い・古い・壊れている場合はfalse)
+////////////////////////////////////////////////
+bool MeshCache::load(const std::string& objPath, const Matrix4& transMat, float overdrawThreshold, const std::vector<float>& lodRatios,
+	MeshObj::VertexFormat format, MeshCacheView& dest)
+{
+	if (!mEnable)
+	{
+		return false;
+	}
+
+	unsigned long long sourceHash;
+	if (!getSourceHash(objPath, transMat, overdrawThreshold, lodRatios, sourceHash) || !dest.file.open(getFilePath(objPath, transMat)))
+	{
+		return false;
+	}
+
+	const unsigned char*   data   = dest.file.getData();
+	const size_t           size   = dest.file.getSize();
+	const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(data);
+	if (size < sizeof(MeshCacheHeader) ||
+		memcmp(header->magic, meshMagic, sizeof(meshMagic)) != 0 ||
+		header->version != meshVersion || header->sourceHash != sourceHash ||
+		header->vertexFormat != static_cast<unsigned int>(format) || header->vertexStride != MeshObj::getVertexSize(format) ||
+		(header->indexBytes != 2 && header->indexBytes != 4) || header->lodCount == 0 || header->lodCount > MeshObj::mLodMax)
+	{
+		dest.file.close();
+		return false;
+	}
+
+	// 各データがファイル内に収まっているか (書き込み途中のファイル対策)
+	const unsigned long long vertexEnd  = header->vertexOffset + static_cast<unsigned long long>(header->vertexStride) * header->vertexCount;
+	const unsigned long long indexEnd   = header->indexOffset + static_cast<unsigned long long>(header->indexBytes) * header->indexCount;
+	const unsigned long long submeshEnd = header->submeshOffset + sizeof(MeshSubmesh) * static_cast<unsigned long long>(header->submeshCount);
+	const unsigned long long lodEnd     = header->lodOffset + sizeof(MeshLod) * static_cast<unsigned long long>(header->lodCount);
+	if (vertexEnd > size || indexEnd > size || submeshEnd > size || lodEnd > size)
+	{
+		dest.file.close();
+		return false;
+	}
+
+	dest.header    = header;
+	dest.vertices  = data + header->vertexOffset;
+	dest.indices   = data + header->indexOffset;
+	dest.submeshes = reinterpret_cast<const MeshSubmesh*>(data + header->submeshOffset);
+	dest.lods      = reinterpret_cast<const MeshLod*>(data + header->lodOffset);
+	return true;
+}
+
+/////////////////////////////////////////////////
+// OBJの読み込み結果を保存する
+// in : objPath, transMat          元のOBJファイル名と変換行列 (ファイル名とハッシュに使う)
+//      overdrawThreshold          オーバードロー最適化の設定 (ハッシュに使う)
+//      lodRatios                  LODの設定 (ハッシュに使う)
+//      format                     頂点フォーマット
+//      vertices, vertexCount      インターリーブ済みの頂点データ (formatの形式)
+//      indices, indexCount        インデックス (全LOD分)
+//      indexType                  GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+//      submeshes                  サブメッシュ表
+//      lods                       LOD表
+//      box, sphere                境界ボリューム
+//      statsBefore, statsAfter    三角形の並べ替え前後の頂点キャッシュ効率 (次回のレポート用)
+//      coldMilliseconds           OBJの読み込みにかかった時間 (次回のレポート用)
+////////////////////////////////////////////////
+void MeshCache::store(const std::string& objPath, const Matrix4& transMat, float overdrawThreshold, const std::vector<float>& lodRatios,
+	MeshObj::VertexFormat format,
+	const void* vertices, unsigned int vertexCount, const void* indices, unsigned int indexCount, GLenum indexType,
+	const std::vector<MeshSubmesh>& submeshes, const std::vector<MeshLod>& lods, const AABB& box, const BoundingSphere& sphere,
+	const VertexCacheStats& statsBefore, const VertexCacheStats& statsAfter, float coldMilliseconds)
+{
+	unsigned long long sourceHash;
+	if (!mEnable || !getSourceHash(objPath, transMat, overdrawThreshold, lodRatios, sourceHash))
+	{
+		return;
+	}
+
+	MeshCacheHeader header = {};
+	memcpy(header.magic, meshMagic, sizeof(meshMagic));
+	header.version          = meshVersion;
+	header.sourceHash       = sourceHash;
+	header.vertexFormat     = format;
+	header.vertexStride     = MeshObj::getVertexSize(format);
+	header.vertexCount      = vertexCount;
+	header.indexBytes       = indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+	header.indexCount       = indexCount;
+	header.submeshCount     = static_cast<unsigned int>(submeshes.size());
+	header.lodCount         = static_cast<unsigned int>(lods.size());
+	header.boundsMin[0]     = box.mMin.x;
+	header.boundsMin[1]     = box.mMin.y;
+	header.boundsMin[2]     = box.mMin.z;
+	header.boundsMax[0]     = box.mMax.x;
+	header.boundsMax[1]     = box.mMax.y;
+	header.boundsMax[2]     = box.mMax.z;
+	header.sphereCenter[0]  = sphere.mCenter.x;
+	header.sphereCenter[1]  = sphere.mCenter.y;
+	header.sphereCenter[2]  = sphere.mCenter.z;
+	header.sphereRadius     = sphere.mRadius;
+	header.coldMilliseconds = coldMilliseconds;
+	header.acmrBefore       = statsBefore.acmr;
+	header.acmrAfter        = statsAfter.acmr;
+	header.atvrBefore       = statsBefore.atvr;
+	header.atvrAfter        = statsAfter.atvr;
+
+	const size_t vertexBytes  = static_cast<size_t>(header.vertexStride) * vertexCount;
+	const size_t indexBytes   = static_cast<size_t>(header.indexBytes) * indexCount;
+	const size_t submeshBytes = sizeof(MeshSubmesh) * submeshes.size();
+	const size_t lodBytes     = sizeof(MeshLod) * lods.size();
+	header.vertexOffset  = alignSection(sizeof(MeshCacheHeader));
+	header.indexOffset   = alignSection(header.vertexOffset + vertexBytes);
+	header.submeshOffset = alignSection(header.indexOffset + indexBytes);
+	header.lodOffset     = alignSection(header.submeshOffset + submeshBytes);
+
+	makeDirectory(mDirectory);
+	const std::string filePath = getFilePath(objPath, transMat);
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << filePath << std::endl;
+		return;
+	}
+
+	// 各セクションの前を0で埋めて境界をそろえる
+	const char zeros[sectionAlign] = {};
+	auto writeSection = [&file, &zeros](unsigned long long offset, const void* data, size_t bytes)
+	{
+		file.write(zeros, static_cast<std::streamsize>(offset - static_cast<unsigned long long>(file.tellp())));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+	};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeSection(header.vertexOffset, vertices, vertexBytes);
+	writeSection(header.indexOffset, indices, indexBytes);
+	writeSection(header.submeshOffset, submeshes.data(), submeshBytes);
+	writeSection(header.lodOffset, lods.data(), lodBytes);
+}
+
+void MeshCache::addRecord(const std::string& name, bool cacheHit, float milliseconds, float coldMilliseconds,
+	const VertexCacheStats& statsBefore, const VertexCacheStats& statsAfter)
+{
+	mRecords.push_back({ name, cacheHit, milliseconds, coldMilliseconds, statsBefore, statsAfter });
+}
+
+void MeshCache::printReport(std::ostream& os) const
+{
+	float total = 0.0f, coldTotal = 0.0f;
+	unsigned int hitNum = 0;
+
+	os << "mesh load (ms)   cold / this launch" << std::endl;
+	for (const LoadRecord& record : mRecords)
+	{
+		os << "  " << std::left << std::setw(56) << record.name << std::right << std::fixed << std::setprecision(2)
+		   << std::setw(8) << record.coldMilliseconds << " / " << std::setw(8) << record.milliseconds
+		   << (record.cacheHit ? "  (cache)" : "  (obj)") << std::endl;
+		total     += record.milliseconds;
+		coldTotal += record.coldMilliseconds;
+		hitNum    += record.cacheHit ? 1 : 0;
+	}
+	os << "  total : " << coldTotal << " / " << total << "  cache hits " << hitNum << " / " << mRecords.size() << std::endl;
+
+	// 頂点シェーダーの実行回数 (FIFOキャッシュのシミュレーション)
+	os << "vertex cache (" << MeshOptimizer::mCacheSize << " entries)   ACMR before -> after   ATVR before -> after" << std::endl;
+	for (const LoadRecord& record : mRecords)
+	{
+		os << "  " << std::left << std::setw(56) << record.name << std::right << std::setprecision(3)
+		   << std::setw(8) << record.statsBefore.acmr << " -> " << std::setw(6) << record.statsAfter.acmr
+		   << std::setw(9) << record.statsBefore.atvr << " -> " << std::setw(6) << record.statsAfter.atvr << std::endl;
+	}
+	os.unsetf(std::ios::fixed);
+	os << std::setprecision(6);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "Math.h"
+#include "MeshObj.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+
+// キャッシュファイルの先頭
+// 続けて 頂点データ(インターリーブ、float版か圧縮版) / インデックス(16bit or 32bit、全LOD分) / サブメッシュ表 / LOD表
+// を16byte境界に並べる
+struct MeshCacheHeader
+{
+	char               magic[4];          // "MBIN"
+	unsigned int       version;           // ファイル形式のバージョン
+	unsigned long long sourceHash;        // 元のOBJファイルの内容・変換行列・最適化とLODの設定のハッシュ
+	unsigned int       vertexFormat;      // MeshObj::VertexFormat
+	unsigned int       vertexStride;      // 1頂点のバイト数
+	unsigned int       vertexCount;       // 頂点数
+	unsigned int       indexBytes;        // インデックス1つのバイト数 (2 or 4)
+	unsigned int       indexCount;        // インデックス数
+	unsigned int       submeshCount;      // サブメッシュ数
+	float              boundsMin[3];      // AABB
+	float              boundsMax[3];
+	float              sphereCenter[3];   // 境界球
+	float              sphereRadius;
+	float              coldMilliseconds;  // OBJの読み込みにかかった時間
+	float              acmrBefore;        // 最適化前後の頂点キャッシュ効率 (レポート用)
+	float              acmrAfter;
+	float              atvrBefore;
+	float              atvrAfter;
+	unsigned int       lodCount;          // LOD数 (LOD0を含む)
+	unsigned long long vertexOffset;      // 頂点データのファイル先頭からの位置
+	unsigned long long indexOffset;       // インデックスの位置
+	unsigned long long submeshOffset;     // サブメッシュ表の位置
+	unsigned long long lodOffset;         // LOD表の位置
+};
+static_assert(sizeof(MeshCacheHeader) == 136, "MeshCacheHeader must not contain implicit padding");
+
+// キャッシュから読み込んだメッシュ
+// ファイルをマップしたまま頂点・インデックスを直接指すので、GPUへの転送が終わるまで破棄しないこと
+struct MeshCacheView
+{
+	MappedFile             file;
+	const MeshCacheHeader* header    = nullptr;
+	const void*            vertices  = nullptr;
+	const void*            indices   = nullptr;
+	const MeshSubmesh*     submeshes = nullptr;
+	const MeshLod*         lods      = nullptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// メッシュのバイナリキャッシュ
+// OBJを読み込んだ結果(頂点・インデックス・境界ボリューム・サブメッシュ・LOD)を
+// mDirectory/<パスと変換行列のキー>.mbin に保存し、次回はファイルをマップして
+// 頂点とインデックスの範囲をそのままglBufferDataに渡す (テキストの解析と中間コピーなし)
+// OBJの内容が変わるとハッシュが一致しなくなり、読み込み直して上書きする
+//
+// キャッシュのヒット/ミスとメッシュごとの読み込み時間を記録し、起動時のレポートに使う
+///////////////////////////////////////////////////////////////////////////////////////
+class MeshCache
+{
+public:
+	static MeshCache& MeshCacheInstance()             // インスタンス
+	{
+		static MeshCache MeshCacheInstance;
+		return MeshCacheInstance;
+	}
+
+	~MeshCache() {};
+
+	void         setDirectory(const std::string& directory) { mDirectory = directory; } // キャッシュの保存先
+	void         setEnable(bool enable) { mEnable = enable; }                            // 無効にすると常にOBJを読む
+
+	bool         load(const std::string& objPath, const Matrix4& transMat, float overdrawThreshold, const std::vector<float>& lodRatios,
+	                  MeshObj::VertexFormat format, MeshCacheView& dest); // キャッシュをマップする
+	void         store(const std::string& objPath, const Matrix4& transMat, float overdrawThreshold, const std::vector<float>& lodRatios,
+	                   MeshObj::VertexFormat format,
+	                   const void* vertices, unsigned int vertexCount, const void* indices, unsigned int indexCount, GLenum indexType,
+	                   const std::vector<MeshSubmesh>& submeshes, const std::vector<MeshLod>& lods, const AABB& box, const BoundingSphere& sphere,
+	                   const VertexCacheStats& statsBefore, const VertexCacheStats& statsAfter, float coldMilliseconds); // 読み込み結果を保存
+
+	// 起動時間のレポート
+	void         addRecord(const std::string& name, bool cacheHit, float milliseconds, float coldMilliseconds,
+	                       const VertexCacheStats& statsBefore, const VertexCacheStats& statsAfter);
+	void         printReport(std::ostream& os) const; // メッシュごとのコールド/ウォーム読み込み時間と頂点キャッシュ効率
+
+private:
+	MeshCache(); // シングルトン
+
+	std::string  getFilePath(const std::string& objPath, const Matrix4& transMat) const;
+	bool         getSourceHash(const std::string& objPath, const Matrix4& transMat, float overdrawThreshold, const std::vector<float>& lodRatios,
+	                           unsigned long long& destHash) const;
+
+	// メッシュ1つ分の読み込み記録
+	struct LoadRecord
+	{
+		std::string name;              // OBJファイル名
+		bool        cacheHit;          // キャッシュから読めたか
+		float       milliseconds;      // 今回の読み込み時間
+		float       coldMilliseconds;  // OBJ読み込み時の時間 (ヒット時はキャッシュに記録された値)
+		VertexCacheStats statsBefore;  // 三角形の並べ替え前の頂点キャッシュ効率
+		VertexCacheStats statsAfter;   // 並べ替え後
+	};
+
+	std::string             mDirectory;       // 保存先ディレクトリ
+	bool                    mEnable;          // キャッシュを使うか
+	std::vector<LoadRecord> mRecords;         // 読み込み記録
+};
+
+#define MESH_CACHE_INSTANCE MeshCache::MeshCacheInstance()
@@ -1,17 +1,36 @@
 #include <iostream>
+#include <chrono>
+#include <cstddef>
 #include "MeshObj.h"
-#include "tiny_obj_loader.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "VertexPacker.h"
+#include "TangentGenerator.h"
+#include "InstanceBatch.h"
+#include "GeometryArena.h"
+#include "RenderState.h"
+#include "ObjParser.h"
+#include "AssetLoader.h"
 
 
+float              MeshObj::mOverdrawThreshold = 1.05f;
+std::vector<float> MeshObj::mLodRatios = { 0.5f, 0.25f, 0.125f };
+
 MeshObj::MeshObj()
 	: mReady(false)
 	, mVAO(0)
 	, mVBO(0)
 	, mEBO(0)
 	, mIndexSize(0)
-	, mVBOSize(0)
+	, mIndexType(GL_UNSIGNED_INT)
+	, mVertexCount(0)
 	, mVFormat(VertexFormatEnum_PosNormalTex)
 	, mTexturesNum(0)
+	, mInstanceBatch(nullptr)
+	, mArena(nullptr)
+	, mFirstIndex(0)
+	, mBaseVertex(0)
 {
 	for (int i = 0; i < 8; i++)
 	{
@@ -21,343 +40,548 @@ MeshObj::MeshObj()
 
 MeshObj::~MeshObj()
 {
-	glDeleteVertexArrays(1, &mVAO);
+	// 読み込み中なら転送先から外す
+	ASSET_LOADER_INSTANCE.cancel(this);
+
+	// アリーナに移したメッシュのVAOはアリーナの持ち物
+	if (!mArena)
+	{
+		RENDER_STATE_INSTANCE.onDeleteVertexArray(mVAO);
+		glDeleteVertexArrays(1, &mVAO);
+	}
 	glDeleteBuffers(1, &mVBO);
 	glDeleteBuffers(1, &mEBO);
 }
 
+MeshLoadData::MeshLoadData()
+	: format(MeshObj::VertexFormatEnum_PosNormalTex)
+	, vertices(nullptr)
+	, vertexCount(0)
+	, indices(nullptr)
+	, indexCount(0)
+	, indexType(GL_UNSIGNED_INT)
+	, cacheHit(false)
+	, milliseconds(0.0f)
+	, coldMilliseconds(0.0f)
+	, statsBefore{}
+	, statsAfter{}
+	, cache(nullptr)
+{
+}
+
+MeshLoadData::~MeshLoadData()
+{
+	delete cache;
+}
+
 void MeshObj::loadMesh(const char* fileName)
 {
 	Matrix4 identity;
 	loadMesh(fileName, identity);
 }
 
-void MeshObj::loadMesh(const char* fileName, Matrix4& transMat)
+/////////////////////////////////////////////////
+// メッシュを読み込む (読み込みと転送を続けて行う)
+// in : fileName  OBJファイル名
+//      transMat  頂点座標に掛ける変換行列
+//      format    頂点フォーマット
+////////////////////////////////////////////////
+void MeshObj::loadMesh(const char* fileName, Matrix4& transMat, VertexFormat format)
 {
-	// f̃[h
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
+	MeshLoadData data;
+	if (prepareMesh(data, fileName, transMat, format))
+	{
+		uploadMesh(data);
+	}
+}
 
-	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, fileName))
+/////////////////////////////////////////////////
+// メッシュを読み込み、GPUに転送できる状態まで進める (GLを使わないのでワーカースレッドから呼べる)
+// バイナリキャッシュが有効ならファイルをマップして頂点・インデックスをそのまま指し、
+// 無ければOBJを解析してからキャッシュを書き出す
+// LODは頂点を共有したまま簡略化したインデックスをLOD0の後ろに並べる
+// out : dest      読み込んだメッシュ
+// in  : fileName  OBJファイル名
+//       transMat  頂点座標に掛ける変換行列
+//       format    頂点フォーマット (タンジェント付きならタンジェントも読み込み時にCPUで求める)
+// out : 読み込めたらtrue
+////////////////////////////////////////////////
+bool MeshObj::prepareMesh(MeshLoadData& dest, const char* fileName, const Matrix4& transMat, VertexFormat format)
+{
+	const auto loadStart = std::chrono::steady_clock::now();
+	dest.fileName = fileName;
+	dest.format   = format;
+
+	// バイナリキャッシュ (解析も中間コピーも無し)
+	dest.cache = new MeshCacheView;
+	if (MESH_CACHE_INSTANCE.load(fileName, transMat, mOverdrawThreshold, mLodRatios, format, *dest.cache))
 	{
-		std::cout << "t@Cǂݍݎs : " << fileName << std::endl;
-		std::cout << err << std::endl;
-		return;
+		const MeshCacheView&   cache  = *dest.cache;
+		const MeshCacheHeader& header = *cache.header;
+		dest.vertices    = cache.vertices;
+		dest.vertexCount = header.vertexCount;
+		dest.indices     = cache.indices;
+		dest.indexCount  = header.indexCount;
+		dest.indexType   = header.indexBytes == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+		dest.boundingBox.mMin = Vector3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		dest.boundingBox.mMax = Vector3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+		dest.boundingSphere   = BoundingSphere(Vector3(header.sphereCenter[0], header.sphereCenter[1], header.sphereCenter[2]), header.sphereRadius);
+		dest.submeshes.assign(cache.submeshes, cache.submeshes + header.submeshCount);
+		dest.lods.assign(cache.lods, cache.lods + header.lodCount);
+
+		dest.cacheHit         = true;
+		dest.milliseconds     = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+		dest.coldMilliseconds = header.coldMilliseconds;
+		dest.statsBefore      = VertexCacheStats{ header.acmrBefore, header.atvrBefore };
+		dest.statsAfter       = VertexCacheStats{ header.acmrAfter, header.atvrAfter };
+		return true;
 	}
+	delete dest.cache;
+	dest.cache = nullptr;
 
-	const int attribVertexNum = 3; // _W     x,y,z     : 3   
-	const int attribNormalNum = 3; // @vector  nx, ny, nz : 3
-	const int attribTexCoordNum = 2; // textureW u, v       : 2
+	// モデルのロード (メモリマップしたOBJを複数スレッドで解析)
+	ObjParser parser;
+	if (!parser.parse(fileName))
+	{
+		std::cout << "ファイル読み込み失敗 : " << fileName << std::endl;
+		std::cout << parser.getError() << std::endl;
+		return false;
+	}
+	const std::vector<float>& positions = parser.getPositions();
+	const std::vector<float>& normals   = parser.getNormals();
+	const std::vector<float>& texcoords = parser.getTexcoords();
+	const std::vector<ObjIndex>& objIndices = parser.getIndices();
+
+	const int attribVertexNum = 3; // 頂点座標個数     x,y,z     : 3個   
+	const int attribNormalNum = 3; // 法線vector個数  nx, ny, nz : 3個
+	const int attribTexCoordNum = 2; // texture座標個数 u, v       : 2個
 	const int attribStride = attribVertexNum + attribNormalNum + attribTexCoordNum;
 
-	int vertexNum = attrib.vertices.size() / attribVertexNum; //_
-
-	// CfbNXobt@̎擾
-	std::vector<int> indices;
-	for (const auto& shape : shapes)
+	// 面のコーナーごとに頂点を展開する (位置・法線・UVの組が異なるコーナーは別の頂点になる)
+	// シェイプごとのインデックス範囲をサブメッシュとして記録
+	std::vector<float> corners;
+	corners.reserve(objIndices.size() * attribStride);
+	dest.submeshes.clear();
+	for (const ObjShape& shape : parser.getShapes())
 	{
-		for (const auto& index : shape.mesh.indices)
+		MeshSubmesh submesh;
+		submesh.firstIndex = static_cast<unsigned int>(corners.size() / attribStride);
+		submesh.indexCount = static_cast<unsigned int>(shape.indexCount);
+		dest.submeshes.emplace_back(submesh);
+		for (size_t i = shape.firstIndex; i < shape.firstIndex + shape.indexCount; i++)
 		{
-			indices.push_back(index.vertex_index);
+			const ObjIndex& idx = objIndices[i];
+			Vector3 position = Vector3(positions[3 * idx.vertex + 0],
+				positions[3 * idx.vertex + 1],
+				positions[3 * idx.vertex + 2]);
+			position = Vector3::Transform(position, transMat);
+
+			// 法線・UVを持たないコーナーは0にする
+			float corner[attribStride] = { position.x, position.y, position.z, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+			if (idx.normal >= 0)
+			{
+				corner[3] = normals[3 * idx.normal + 0];
+				corner[4] = normals[3 * idx.normal + 1];
+				corner[5] = normals[3 * idx.normal + 2];
+			}
+			if (idx.texcoord >= 0)
+			{
+				corner[6] = texcoords[2 * idx.texcoord + 0];
+				corner[7] = 1.0f - texcoords[2 * idx.texcoord + 1];
+			}
+			corners.insert(corners.end(), corner, corner + attribStride);
 		}
 	}
 
-	// _f[^m _~1̒_f[^ɕKvȗvf(x,y,z,nx,ny,nz,u,v)@1_8float
-	std::vector<float> vertexVec(vertexNum * attribStride);
+	// 同じ頂点をまとめる
+	std::vector<float> vertexVec;
+	std::vector<unsigned int> indices;
+	unsigned int weldedNum = MeshOptimizer::weldVertices(vertexVec, indices, corners.data(), corners.size() / attribStride, attribStride);
 
-	// `󃋁[v
-	for (const auto& shape : shapes)
+	// サブメッシュごとに頂点キャッシュ(とオーバードロー)向けに三角形を並べ替え、頂点を参照順に並べる
+	const VertexCacheStats statsBefore = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), weldedNum);
+	std::vector<unsigned int> clusters;
+	for (const MeshSubmesh& submesh : dest.submeshes)
 	{
-		size_t indexOffset = 0;
-		// ̖ʁiOp`orlp`j̃[v
-		for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++)
+		unsigned int* submeshIndices = indices.data() + submesh.firstIndex;
+		MeshOptimizer::optimizeVertexCache(submeshIndices, submesh.indexCount, weldedNum, mOverdrawThreshold > 0.0f ? &clusters : nullptr);
+		if (mOverdrawThreshold > 0.0f)
 		{
-			size_t num_vertices = shape.mesh.num_face_vertices[f];
-			// _[v
-			for (size_t v = 0; v < num_vertices; v++)
-			{
-				// ʂ\CfbNX擾
-				tinyobj::index_t idx = shape.mesh.indices[indexOffset + v];
-
-				Vector3 position = Vector3(attrib.vertices[3 * idx.vertex_index + 0],
-					attrib.vertices[3 * idx.vertex_index + 1],
-					attrib.vertices[3 * idx.vertex_index + 2]);
-				position = Vector3::Transform(position, transMat);
-
-				// _WvertexVecɃRs[
-				vertexVec[idx.vertex_index * attribStride + 0] = position.x;
-				vertexVec[idx.vertex_index * attribStride + 1] = position.y;
-				vertexVec[idx.vertex_index * attribStride + 2] = position.z;
-
-				// @f[^vertexVecɃRs[
-				vertexVec[idx.vertex_index * attribStride + 3] = attrib.normals[3 * idx.normal_index + 0];
-				vertexVec[idx.vertex_index * attribStride + 4] = attrib.normals[3 * idx.normal_index + 1];
-				vertexVec[idx.vertex_index * attribStride + 5] = attrib.normals[3 * idx.normal_index + 2];
-
-				// uvf[^vertexVec
-				vertexVec[idx.vertex_index * attribStride + 6] = attrib.texcoords[2 * idx.texcoord_index + 0];
-				vertexVec[idx.vertex_index * attribStride + 7] = 1.0f - attrib.texcoords[2 * idx.texcoord_index + 1];
-			}
-			indexOffset += num_vertices;
+			MeshOptimizer::optimizeOverdraw(submeshIndices, submesh.indexCount, vertexVec.data(), attribStride, clusters, mOverdrawThreshold);
 		}
 	}
+	MeshOptimizer::optimizeVertexFetch(vertexVec, indices.data(), indices.size(), attribStride);
 
-	// GPUɓ]
-	glGenVertexArrays(1, &mVAO);
-	glGenBuffers(1, &mVBO);
-	glGenBuffers(1, &mEBO);
+	int vertexNum = static_cast<int>(vertexVec.size() / attribStride); //頂点数
+	const VertexCacheStats statsAfter = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertexNum);
 
-	glBindVertexArray(mVAO);
+	// LODの作成 (1つ前のLODを目標の三角形数まで簡略化し、頂点キャッシュ向けに並べてからインデックスの後ろに追加)
+	// 誤差は各段の誤差の和 (元のメッシュからの距離の上限の目安)
+	const unsigned int lod0IndexNum = static_cast<unsigned int>(indices.size());
+	dest.lods.assign(1, MeshLod{ 0, lod0IndexNum, 0.0f });
+	std::vector<unsigned int> lodIndices(lod0IndexNum);
+	for (float ratio : mLodRatios)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertexNum * attribStride, vertexVec.data(), GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+		const MeshLod prevLod = dest.lods.back();
+		const size_t  target  = static_cast<size_t>(lod0IndexNum * ratio) / 3 * 3;
+		if (dest.lods.size() >= mLodMax || target >= prevLod.indexCount)
+		{
+			continue;
+		}
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, attribStride * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(0);
+		float error = 0.0f;
+		size_t lodIndexNum = MeshSimplifier::simplify(lodIndices.data(), indices.data() + prevLod.firstIndex, prevLod.indexCount,
+			vertexVec.data(), vertexNum, attribStride, target, &error);
+		if (lodIndexNum == 0 || lodIndexNum > prevLod.indexCount * 9 / 10)
+		{
+			break; // ほとんど減らせなければそれ以上のLODは作らない
+		}
+		MeshOptimizer::optimizeVertexCache(lodIndices.data(), lodIndexNum, vertexNum);
+		dest.lods.push_back({ static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(lodIndexNum), prevLod.error + error });
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.begin() + lodIndexNum);
+	}
 
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, attribStride * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
+	// タンジェント付きなら転送前にタンジェントを求めて頂点に加える (x,y,z, nx,ny,nz, u,v, tx,ty,tz,w)
+	int vertexStride = attribStride;
+	if (hasTangent(format))
+	{
+		std::vector<float> tangentVertices(static_cast<size_t>(vertexNum) * 12);
+		TangentGenerator::generate(tangentVertices.data(), vertexVec.data(), vertexNum, indices.data(), lod0IndexNum);
+		vertexVec.swap(tangentVertices);
+		vertexStride = 12;
+	}
 
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, attribStride * sizeof(float), (void*)(6 * sizeof(float)));
-		glEnableVertexAttribArray(2);
+	// 圧縮形式なら圧縮し、境界ボリュームは展開し直した値(GPUが読む値)で求める
+	std::vector<unsigned char> packedVertices;
+	if (isPackedFormat(format))
+	{
+		packedVertices.resize(static_cast<size_t>(vertexNum) * getVertexSize(format));
+		VertexPacker::packVertices(packedVertices.data(), format, vertexVec.data(), vertexNum);
+		VertexPacker::unpackVertices(vertexVec.data(), format, packedVertices.data(), vertexNum);
 	}
 
-	mReady = true;
-	mVBOSize = vertexVec.size();
-	mIndexSize = indices.size();
-	mVFormat = VertexFormatEnum_PosNormalTex;
-}
+	// 境界ボリュームの計算（AABBの中心から最も遠い頂点までを境界球の半径とする）
+	dest.boundingBox = AABB();
+	for (int i = 0; i < vertexNum; i++)
+	{
+		dest.boundingBox.UpdateMinMax(Vector3(vertexVec[i * vertexStride + 0], vertexVec[i * vertexStride + 1], vertexVec[i * vertexStride + 2]));
+	}
+	float radiusSq = 0.0f;
+	Vector3 center = dest.boundingBox.GetCenter();
+	for (int i = 0; i < vertexNum; i++)
+	{
+		Vector3 pos(vertexVec[i * vertexStride + 0], vertexVec[i * vertexStride + 1], vertexVec[i * vertexStride + 2]);
+		radiusSq = Math::Max(radiusSq, (pos - center).LengthSq());
+	}
+	dest.boundingSphere = BoundingSphere(center, Math::Sqrt(radiusSq));
 
-void MeshObj::draw() const
-{
-	if (!mReady)
+	// 頂点数が16bitに収まればインデックスを16bitにする (インデックス帯域とメモリが半分)
+	dest.vertexCount = vertexNum;
+	dest.indexCount  = static_cast<unsigned int>(indices.size());
+	if (vertexNum <= 65536)
 	{
-		return;
+		dest.shortIndices.assign(indices.begin(), indices.end());
+		dest.indices   = dest.shortIndices.data();
+		dest.indexType = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		dest.intIndices.swap(indices);
+		dest.indices   = dest.intIndices.data();
+		dest.indexType = GL_UNSIGNED_INT;
+	}
+	if (isPackedFormat(format))
+	{
+		dest.packedVertices.swap(packedVertices);
+		dest.vertices = dest.packedVertices.data();
+	}
+	else
+	{
+		dest.floatVertices.swap(vertexVec);
+		dest.vertices = dest.floatVertices.data();
 	}
 
-	glBindVertexArray(mVAO);
-	glDrawElements(GL_TRIANGLES, mIndexSize, GL_UNSIGNED_INT, 0);
+	dest.cacheHit         = false;
+	dest.milliseconds     = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	dest.coldMilliseconds = dest.milliseconds;
+	dest.statsBefore      = statsBefore;
+	dest.statsAfter       = statsAfter;
 
+	// 次回からはキャッシュを使う
+	MESH_CACHE_INSTANCE.store(fileName, transMat, mOverdrawThreshold, mLodRatios, format, dest.vertices, dest.vertexCount, dest.indices, dest.indexCount,
+		dest.indexType, dest.submeshes, dest.lods, dest.boundingBox, dest.boundingSphere, statsBefore, statsAfter, dest.milliseconds);
+	return true;
 }
 
-bool MeshObj::convertTangentMesh()
+/////////////////////////////////////////////////
+// 読み込んだメッシュのインデックスを指定の型に詰め直す
+// 転送先のジオメトリアリーナとインデックスの型を揃えるのに使う (転送後にGPUから読み戻して変換しないで済む)
+// in  : data       prepareMeshで読み込んだメッシュ (キャッシュを指していれば自前の配列にコピーする)
+//       indexType  GL_UNSIGNED_SHORT / GL_UNSIGNED_INT
+// out : 変換できたら (か同じ型なら) true、頂点数が16bitに収まらなければ何もせずfalse
+////////////////////////////////////////////////
+bool MeshObj::convertIndexType(MeshLoadData& data, GLenum indexType)
 {
-
-	if (mVFormat != VertexFormatEnum_PosNormalTex)
+	if (data.indexType == indexType)
 	{
-		return false;
+		return true;
 	}
-	const int tangentStride = 11;
-	const int oldStride = 8;
-	const int insertPoint = 8;
-	const int vertexNum = mVBOSize / oldStride;
-
-	float* vboptr;
-	float* vertexsrc = new float[mVBOSize];
-	int* eboptr;
-	int* indexBuffer = new int[mIndexSize];
-
-	// GPUVBÕf[^vertexSrcɃRs[
-	glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-	vboptr = static_cast<float*>(glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY));
-	if (!vboptr)
+	if (indexType == GL_UNSIGNED_INT)
 	{
-		return false;
+		const unsigned short* src = static_cast<const unsigned short*>(data.indices);
+		data.intIndices.assign(src, src + data.indexCount);
+		data.shortIndices.clear();
+		data.indices = data.intIndices.data();
 	}
-	memcpy(vertexsrc, vboptr, mVBOSize * sizeof(float));
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-
-	// GPUEBÕf[^indexBufferɃRs[
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-	eboptr = static_cast<int*>(glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY));
-	if (!eboptr)
+	else
 	{
-		return false;
+		if (data.vertexCount > 65536)
+		{
+			return false;
+		}
+		const unsigned int* src = static_cast<const unsigned int*>(data.indices);
+		data.shortIndices.assign(src, src + data.indexCount);
+		data.intIndices.clear();
+		data.indices = data.shortIndices.data();
 	}
-	memcpy(indexBuffer, eboptr, mIndexSize * sizeof(int));
-	glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-
-	// V_tH[}bg̃m
-	float* newTangentArray = new float[vertexNum * tangentStride];
+	data.indexType = indexType;
+	return true;
+}
 
-	// V_tH[}bgɃRs[
-	for (int i = 0; i < vertexNum; i++)
+/////////////////////////////////////////////////
+// 読み込んだメッシュをGPUに転送し、描画できる状態にする (GLスレッド)
+// in : data           prepareMeshで読み込んだメッシュ
+//      stagingBuffer  0ならdataの頂点・インデックスを直接転送する
+//                     0以外なら頂点・インデックスを書き込み済みのステージングバッファからGPU内でコピーする
+//      vertexOffset   ステージングバッファ内の頂点の位置
+//      indexOffset    ステージングバッファ内のインデックスの位置
+////////////////////////////////////////////////
+void MeshObj::uploadMesh(const MeshLoadData& data, GLuint stagingBuffer, GLintptr vertexOffset, GLintptr indexOffset)
+{
+	const auto uploadStart = std::chrono::steady_clock::now();
+	if (stagingBuffer)
 	{
-		copyPointNormalUVtoTangentArray(newTangentArray, i, tangentStride, vertexsrc);
+		createBuffers(data.format, nullptr, data.vertexCount, nullptr, data.indexCount, data.indexType);
+		glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, mVBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, vertexOffset, 0, static_cast<GLsizeiptr>(getVertexSize(data.format)) * data.vertexCount);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, mEBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, indexOffset, 0, static_cast<GLsizeiptr>(getIndexBytes(data.indexType)) * data.indexCount);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 	}
-
-	// Op`ʂNUVlA^WFgvZ
-		// 1ڂ̎Op`
-	Vector3 pos[3], tangent;
-	Vector2 uv[3];
-	for (unsigned int i = 0; i < mIndexSize / 3; i++)
-	{	
-		getPosVec(pos[0], vertexsrc, indexBuffer[i * 3 + 0]);
-		getPosVec(pos[1], vertexsrc, indexBuffer[i * 3 + 1]);
-		getPosVec(pos[2], vertexsrc, indexBuffer[i * 3 + 2]);
-
-		getUVVec(uv[0], vertexsrc, indexBuffer[i * 3 + 0]);
-		getUVVec(uv[1], vertexsrc, indexBuffer[i * 3 + 1]);
-		getUVVec(uv[2], vertexsrc, indexBuffer[i * 3 + 2]);
-
-		calcTangent(tangent, pos[0], pos[1], pos[2], uv[0], uv[1], uv[2]);
-		insertVec(newTangentArray, indexBuffer[i * 3 + 0], tangentStride, insertPoint, tangent);
-		insertVec(newTangentArray, indexBuffer[i * 3 + 1], tangentStride, insertPoint, tangent);
-		insertVec(newTangentArray, indexBuffer[i * 3 + 2], tangentStride, insertPoint, tangent);
+	else
+	{
+		createBuffers(data.format, data.vertices, data.vertexCount, data.indices, data.indexCount, data.indexType);
 	}
 
-	//debug
-	//for (int i = 0; i < vertexNum; i++)
-	//{
-	//	for (int j = 0; j < tangentStride; j++)
-	//	{
-	//		printf("% .3f ", newTangentArray[i * tangentStride + j]);
-	//	}
-	//	printf("\n");
-	//}
+	mBoundingBox    = data.boundingBox;
+	mBoundingSphere = data.boundingSphere;
+	mSubmeshes      = data.submeshes;
+	mLods           = data.lods;
 
-	// VAO폜
-	glDeleteVertexArrays(1, &mVAO);
-	glDeleteBuffers(1, &mVBO);
-	glDeleteBuffers(1, &mEBO);
-	mVAO = 0;
-	mVBO = 0;
-	mEBO = 0;
+	float milliseconds = data.milliseconds + std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+	MESH_CACHE_INSTANCE.addRecord(data.fileName, data.cacheHit, milliseconds, data.cacheHit ? data.coldMilliseconds : milliseconds,
+		data.statsBefore, data.statsAfter);
+}
 
-	// VKVAO쐬
+/////////////////////////////////////////////////
+// VAO/VBO/EBOを作成して頂点・インデックスを転送する
+// in : format                 頂点フォーマット
+//      vertices, vertexCount  インターリーブ済みの頂点データ
+//      indices, indexCount    インデックス
+//      indexType              GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+////////////////////////////////////////////////
+void MeshObj::createBuffers(VertexFormat format, const void* vertices, unsigned int vertexCount, const void* indices, unsigned int indexCount, GLenum indexType)
+{
 	glGenVertexArrays(1, &mVAO);
 	glGenBuffers(1, &mVBO);
 	glGenBuffers(1, &mEBO);
 
-	glBindVertexArray(mVAO);
+	RENDER_STATE_INSTANCE.bindVertexArray(mVAO);
 	{
 		glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertexNum * tangentStride, newTangentArray, GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(getVertexSize(format)) * vertexCount, vertices, GL_STATIC_DRAW);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * mIndexSize, indexBuffer, GL_STATIC_DRAW);
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, tangentStride * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(0);
-
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, tangentStride * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
-
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, tangentStride * sizeof(float), (void*)(6 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, tangentStride * sizeof(float), (void*)(8 * sizeof(float)));
-		glEnableVertexAttribArray(3);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(getIndexBytes(indexType)) * indexCount, indices, GL_STATIC_DRAW);
+		setupVertexAttributes(format);
 	}
 
-	// GPUɓ]̂Ōf[^폜
-	delete[] newTangentArray;
-	delete[] indexBuffer;
-	delete[] vertexsrc;
-
-	mVFormat = VertexFormatEnum_PosNormalTexTangent;
-
-	return true;
+	mReady = true;
+	mVertexCount = vertexCount;
+	mIndexSize = indexCount;
+	mIndexType = indexType;
+	mVFormat = format;
 }
 
-void MeshObj::setTexture(GLuint textureID, int textureStageNum)
+unsigned int MeshObj::getVertexSize(VertexFormat format)
 {
-	if (textureStageNum < mTextureNumMax && textureStageNum >= 0)
+	switch (format)
 	{
-		mTextures[textureStageNum] = textureID;
-		mTexturesNum++;
+	case VertexFormatEnum_PosNormalTex:
+		return 8 * sizeof(float);   // x,y,z, nx,ny,nz, u,v
+	case VertexFormatEnum_PosNormalTexTangent:
+		return 12 * sizeof(float);  // x,y,z, nx,ny,nz, u,v, tx,ty,tz,w
+	case VertexFormatEnum_PackedPosNormalTex:
+		return sizeof(PackedVertex);
+	case VertexFormatEnum_PackedPosNormalTexTangent:
+		return sizeof(PackedTangentVertex);
 	}
+	return 0;
 }
 
-GLuint MeshObj::getTextureID(int textureStageNum) const
+/////////////////////////////////////////////////
+// バインド中のVAOに、バインド中のVBOの頂点属性を設定する
+// location 0:位置 1:法線 2:UV 3:タンジェント
+// 圧縮形式の位置・UVはhalfのままvec3/vec2として読め、法線・タンジェントは八面体エンコードのvec2になる
+// 従法線の向きはfloat版ならタンジェントのw、圧縮形式なら位置のwに入っている
+// in : format  頂点フォーマット
+////////////////////////////////////////////////
+void MeshObj::setupVertexAttributes(VertexFormat format)
 {
-	if (textureStageNum < mTextureNumMax && textureStageNum >= 0)
+	const GLsizei stride = getVertexSize(format);
+
+	if (isPackedFormat(format))
 	{
-		return mTextures[textureStageNum];
+		glVertexAttribPointer(0, hasTangent(format) ? 4 : 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedTangentVertex, position));
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedTangentVertex, normal));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedTangentVertex, texCoord));
+		if (format == VertexFormatEnum_PackedPosNormalTexTangent)
+		{
+			glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedTangentVertex, tangent));
+		}
+	}
+	else
+	{
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+		if (format == VertexFormatEnum_PosNormalTexTangent)
+		{
+			glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+		}
 	}
-	// w肳ꂽeNX`Xe[W͖
-	return 0;
-}
 
-float* MeshObj::calcInsertPoint(float* dst, int vertexIndex, int stride, int insertPoint)
-{
-	// _obt@zstrideɍ킹K؂ȑ}|C^̌vZ
-	return dst + vertexIndex * stride + insertPoint;
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	if (hasTangent(format))
+	{
+		glEnableVertexAttribArray(3);
+	}
 }
 
-// _z̓K؂ȈʒuvecRs[
-void MeshObj::insertVec(float* dst, int vertexIndex, int stride, int insertPoint, const Vector3& vec)
+void MeshObj::draw() const
 {
-	float* ins = calcInsertPoint(dst, vertexIndex, stride, insertPoint);
-	ins[0] = vec.x;
-	ins[1] = vec.y;
-	ins[2] = vec.z;
+	if (!mReady)
+	{
+		return;
+	}
+
+	RENDER_STATE_INSTANCE.bindVertexArray(mVAO);
+	glDrawElementsBaseVertex(GL_TRIANGLES, mLods[0].indexCount, mIndexType, (void*)(static_cast<size_t>(getIndexBytes(mIndexType)) * mFirstIndex), mBaseVertex);
+
 }
 
-// _tH[}bgPosNormalUV  ^WFgtɕϊ
-void MeshObj::copyPointNormalUVtoTangentArray(float* dst, int vertexIndex, int stride, float* srcPNUVArray)
+void MeshObj::drawInstanced(unsigned int instanceCount, unsigned int baseInstance) const
 {
-	const int PNUVStride = 8; // PointNormalUVz̃XgCh
-	float* ins = calcInsertPoint(dst, vertexIndex, stride, 0);              // }
-	float* src = calcInsertPoint(srcPNUVArray, vertexIndex, PNUVStride, 0); // Rs[
-
-	// TangenttzɃRs[
-	for (int i = 0; i < PNUVStride; i++)
+	if (!mReady || !mInstanceBatch || instanceCount == 0)
 	{
-		ins[i] = src[i];
+		return;
 	}
+
+	RENDER_STATE_INSTANCE.bindVertexArray(mVAO);
+	glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mLods[0].indexCount, mIndexType, (void*)(static_cast<size_t>(getIndexBytes(mIndexType)) * mFirstIndex), instanceCount, mBaseVertex, baseInstance);
 }
 
-///////////////////////////////////////////////////////////////////////////////////////
-// ^WFgxNgvZ
-// Op`ʂpos1`pos3 ,uv0`uv2 gTangentxNg destTangentɕԂ
-//
-// inout destTangent Tangenti[ϐ
-// in : pos0, pos1, pos2 Op`ʂ̒_
-// in : uv0, uv1, uv2    Op`ʂ̒_ɑΉUVW
-///////////////////////////////////////////////////////////////////////////////////////
-void MeshObj::calcTangent(Vector3& destTangent, const Vector3& pos1, const Vector3& pos2, const Vector3& pos3, const Vector2& uv1, const Vector2& uv2, const Vector2& uv3)
+/////////////////////////////////////////////////
+// 頂点・インデックスをジオメトリアリーナにコピーし、専用のVAO/VBO/EBOを破棄する
+// 以降の描画はアリーナの共有VAOとbaseVertex/firstIndexで行う
+// タンジェントはprepareMeshが頂点フォーマットに合わせて生成済みなので、アリーナは同じフォーマットのものを渡すこと
+////////////////////////////////////////////////
+bool MeshObj::moveToArena(GeometryArena& arena)
 {
-	Vector3 edge1, edge2;
-	edge1 = pos2 - pos1;
-	edge2 = pos3 - pos1;
-
-	Vector2 deltaUV1 = uv2 - uv1;
-	Vector2 deltaUV2 = uv3 - uv1;
+	if (!mReady || mArena || arena.getFormat() != mVFormat || !arena.canAllocate(mVertexCount, mIndexType))
+	{
+		return false;
+	}
 
-	float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+	GeometryRange range;
+	if (!arena.allocate(range, mVBO, mVertexCount, mEBO, mIndexSize, mIndexType))
+	{
+		return false;
+	}
 
-	destTangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-	destTangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-	destTangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
+	RENDER_STATE_INSTANCE.onDeleteVertexArray(mVAO);
+	glDeleteVertexArrays(1, &mVAO);
+	glDeleteBuffers(1, &mVBO);
+	glDeleteBuffers(1, &mEBO);
+	mVBO = 0;
+	mEBO = 0;
 
-	destTangent.Normalize();
+	mArena      = &arena;
+	mVAO        = arena.getVAO();
+	mFirstIndex = range.firstIndex;
+	mBaseVertex = range.baseVertex;
+	mIndexType  = arena.getIndexType();
 
+	// 共有VAOにインスタンス属性を接続
+	if (mInstanceBatch)
+	{
+		mInstanceBatch->bindToVertexArray(mVAO);
+	}
+	return true;
 }
+
 /////////////////////////////////////////////////
-// _璸_Wlo
-// inout : destUV  _UVWi[ϐ
-// in    : fv      _&UVf[^z̐擪AhXi[ꂽ|C^
-//         index   _&UVf[^z̃CfbNXl
+// このメッシュを描画する間接描画コマンドを作成する
+// out : destCommand    作成したコマンド
+// in  : instanceCount  インスタンス数
+//       baseInstance   インスタンスバッファ内の開始位置
+//       lod            描画するLOD (無いLODなら最も粗いLOD)
+// 描画できない状態(未ロード・インスタンスバッファ未接続)ならfalse
 ////////////////////////////////////////////////
-void MeshObj::getPosVec(Vector3& destPos, const float* fv, int index)
+bool MeshObj::getDrawCommand(DrawElementsIndirectCommand& destCommand, unsigned int instanceCount, unsigned int baseInstance, unsigned int lod) const
 {
-	destPos.x = fv[index * 8 + 0];
-	destPos.y = fv[index * 8 + 1];
-	destPos.z = fv[index * 8 + 2];
+	if (!mReady || !mInstanceBatch)
+	{
+		return false;
+	}
+
+	const MeshLod& meshLod = mLods[Math::Min(lod, static_cast<unsigned int>(mLods.size()) - 1)];
+	destCommand.count         = meshLod.indexCount;
+	destCommand.instanceCount = instanceCount;
+	destCommand.firstIndex    = mFirstIndex + meshLod.firstIndex;
+	destCommand.baseVertex    = mBaseVertex;
+	destCommand.baseInstance  = baseInstance;
+	return true;
 }
-/////////////////////////////////////////////////
-// _UVlo
-// inout : destUV  _UVWi[ϐ
-// in    : fv      _&UVf[^z̐擪AhXi[ꂽ|C^
-//         index   _&UVf[^z̃CfbNXl
-////////////////////////////////////////////////
-void MeshObj::getUVVec(Vector2& destUV, const float* fv, int index)
+
+void MeshObj::setInstanceBatch(const InstanceBatch* batch)
 {
-	destUV.x = fv[index * 8 + 6 + 0];
-	destUV.y = fv[index * 8 + 6 + 1];
+	mInstanceBatch = batch;
+	if (mInstanceBatch)
+	{
+		mInstanceBatch->bindToVertexArray(mVAO);
+	}
+}
+
+void MeshObj::setTexture(GLuint textureID, int textureStageNum)
+{
+	if (textureStageNum < mTextureNumMax && textureStageNum >= 0)
+	{
+		mTextures[textureStageNum] = textureID;
+		mTexturesNum++;
+	}
 }
 
+GLuint MeshObj::getTextureID(int textureStageNum) const
+{
+	if (textureStageNum < mTextureNumMax && textureStageNum >= 0)
+	{
+		return mTextures[textureStageNum];
+	}
+	// 指定されたテクスチャステージは無効
+	return 0;
+}
@@ -2,47 +2,142 @@
 
 #include <glad/glad.h>
 #include <vector>
+#include <string>
 #include "Math.h"
+#include "MeshOptimizer.h"
+
+class InstanceBatch;
+class GeometryArena;
+struct DrawElementsIndirectCommand;
+struct MeshCacheView;
+struct MeshLoadData;
+
+// サブメッシュ (OBJのシェイプ) のインデックス範囲
+struct MeshSubmesh
+{
+	unsigned int firstIndex;  // 先頭インデックス
+	unsigned int indexCount;  // インデックス数
+};
+
+// LODのインデックス範囲 (全LODが同じ頂点を参照し、インデックスだけをEBOの後ろに並べる)
+struct MeshLod
+{
+	unsigned int firstIndex;  // 先頭インデックス
+	unsigned int indexCount;  // インデックス数
+	float        error;       // 元のメッシュからの誤差 (ローカル座標での距離)
+};
 
 class MeshObj
 {
 public:
+	static const unsigned int mLodMax = 4; // LOD0を含むLODの最大数
+
 	enum VertexFormat
 	{
-		VertexFormatEnum_PosNormalTex,
-		VertexFormatEnum_PosNormalTexTangent
+		VertexFormatEnum_PosNormalTex,              // float 位置・法線・UV (32byte)
+		VertexFormatEnum_PosNormalTexTangent,       // float 位置・法線・UV・タンジェントと従法線の向き (48byte)
+		VertexFormatEnum_PackedPosNormalTex,        // half位置・八面体法線・half UV (16byte)
+		VertexFormatEnum_PackedPosNormalTexTangent  // half位置(wに従法線の向き)・八面体法線・half UV・八面体タンジェント (20byte)
 	};
 
 	MeshObj();
 	~MeshObj();
-	void                  loadMesh(const char* fileName);                         // bṼ[h
-	void                  loadMesh(const char* fileName, Matrix4& transMat);      // bVϊă[h
-	void                  draw() const;                                           // `
-	MeshObj::VertexFormat getFormat() const { return MeshObj::mVFormat; }         // _tH[}bg̎擾
-
-	bool                  convertTangentMesh();                                   // @}bvpɃ^WFgxNgt_tH[}bgɕϊ
-	void                  setTexture(GLuint textureID, int textureStageNum);      // eNX`IDeNX`Xe[WɃZbg
-	GLuint                getTextureID(int textureStageNum) const;                // eNX`Xe[WɃZbgĂeNX`IDԂ
+	void                  loadMesh(const char* fileName);                         // メッシュのロード
+	void                  loadMesh(const char* fileName, Matrix4& transMat, VertexFormat format = VertexFormatEnum_PosNormalTex); // メッシュを変換してロード
+	static bool           prepareMesh(MeshLoadData& dest, const char* fileName, const Matrix4& transMat, VertexFormat format); // 転送前までの読み込み (GLを使わない)
+	static bool           convertIndexType(MeshLoadData& data, GLenum indexType); // 転送前にインデックスの型を変える (GLを使わない、16bitに収まらなければfalse)
+	void                  uploadMesh(const MeshLoadData& data, GLuint stagingBuffer = 0, GLintptr vertexOffset = 0, GLintptr indexOffset = 0); // 読み込んだメッシュの転送
+	bool                  isReady() const { return mReady; }                      // 転送済みで描画できるか
+	void                  draw() const;                                           // 描画
+	void                  drawInstanced(unsigned int instanceCount, unsigned int baseInstance = 0) const; // インスタンス描画
+	void                  setInstanceBatch(const InstanceBatch* batch);           // インスタンスバッファをVAOに接続
+	MeshObj::VertexFormat getFormat() const { return MeshObj::mVFormat; }         // 頂点フォーマットの取得
+	GLenum                getIndexType() const { return mIndexType; }             // インデックスの型 (GL_UNSIGNED_SHORT / GL_UNSIGNED_INT)
+	const std::vector<MeshSubmesh>& getSubmeshes() const { return mSubmeshes; }  // サブメッシュ表 (LOD0)
+	const std::vector<MeshLod>&     getLods() const { return mLods; }            // LOD表 (0が元のメッシュ)
+	static unsigned int   getIndexBytes(GLenum indexType) { return indexType == GL_UNSIGNED_SHORT ? 2 : 4; } // インデックス1つのバイト数
+	static unsigned int   getVertexSize(VertexFormat format);                     // 1頂点のバイト数
+	static bool           isPackedFormat(VertexFormat format) { return format == VertexFormatEnum_PackedPosNormalTex || format == VertexFormatEnum_PackedPosNormalTexTangent; }
+	static bool           hasTangent(VertexFormat format) { return format == VertexFormatEnum_PosNormalTexTangent || format == VertexFormatEnum_PackedPosNormalTexTangent; }
+	static void           setupVertexAttributes(VertexFormat format);             // バインド中のVAO/VBOに頂点属性を設定
+	static void           setOverdrawThreshold(float threshold) { mOverdrawThreshold = threshold; } // 読み込み時のオーバードロー最適化 (ACMRの許容悪化率、0で無効)
+	static void           setLodRatios(const std::vector<float>& ratios) { mLodRatios = ratios; }   // 読み込み時に作るLODの三角形数の比率 (LOD0に対する比、空ならLODなし)
+	static const std::vector<float>& getLodRatios() { return mLodRatios; }
+
+	bool                  moveToArena(GeometryArena& arena);                      // 頂点・インデックスをジオメトリアリーナに移す (以降はアリーナのVAOを共有)
+	bool                  getDrawCommand(DrawElementsIndirectCommand& destCommand, unsigned int instanceCount, unsigned int baseInstance,
+	                                     unsigned int lod = 0) const;             // 間接描画コマンドの作成
+	void                  setTexture(GLuint textureID, int textureStageNum);      // テクスチャIDをテクスチャステージにセット
+	GLuint                getTextureID(int textureStageNum) const;                // テクスチャステージにセットされているテクスチャIDを返す
 	unsigned int          getTextureNum() const { return mTexturesNum; }
+	GLuint                getVAO() const { return mVAO; }                         // 頂点配列オブジェクトの取得
+	const AABB&           getBoundingBox() const { return mBoundingBox; }         // ローカル座標のAABB
+	const BoundingSphere& getBoundingSphere() const { return mBoundingSphere; }   // ローカル座標の境界球
 
 private:
-	float*                calcInsertPoint(float* dst, int vertexIndex, int stride, int insertPoint);
-	void                  insertVec(float* dst, int vertexIndex,int stride, int insertPoint, const Vector3& vec);
-	void                  copyPointNormalUVtoTangentArray(float* dst, int vertexIndex, int stride, float* srcPNUVArray);
-	void                  calcTangent(Vector3& destTangent, const Vector3& pos1, const Vector3& pos2, const Vector3& pos3, const Vector2& uv1, const Vector2& uv2, const Vector2& uv3);
-	void                  getPosVec(Vector3& destPos, const float* fv, int index);
-	void                  getUVVec(Vector2& destUV, const float* fv, int index);
-
-	bool         mReady;                // `tO
-	unsigned int mVAO;                  // _zIuWFNg
-	unsigned int mVBO;                  // _obt@IuWFNg
-	unsigned int mEBO;                  // Ggobt@IuWFNgiCfbNXobt@j
-	unsigned int mIndexSize;			// CfbNXobt@̌
-	unsigned int mVBOSize;				// VBOɊi[Ă
-	const int    mTextureNumMax = 8;	// eNX`Xe[Wő吔
-	GLuint       mTextures[8];			// eNX`Xe[Wɓo^eNX`
-	unsigned int mTexturesNum;          // o^eNX`        
-	VertexFormat mVFormat;				// _tH[}bg
+	void                  createBuffers(VertexFormat format, const void* vertices, unsigned int vertexCount, const void* indices, unsigned int indexCount, GLenum indexType); // VAO/VBO/EBOの作成と転送
+
+	bool         mReady;                // 描画フラグ
+	unsigned int mVAO;                  // 頂点配列オブジェクト
+	unsigned int mVBO;                  // 頂点バッファオブジェクト
+	unsigned int mEBO;                  // エレメントバッファオブジェクト（インデックスバッファ）
+	unsigned int mIndexSize;			// インデックスバッファの個数 (全LODの合計)
+	GLenum       mIndexType;            // インデックスの型 (頂点数が65536以下なら16bit)
+	unsigned int mVertexCount;          // VBOに格納されている頂点数
+	const int    mTextureNumMax = 8;	// テクスチャステージ最大数
+	GLuint       mTextures[8];			// テクスチャステージに登録するテクスチャ
+	unsigned int mTexturesNum;          // 登録テクスチャ枚数        
+	VertexFormat mVFormat;				// 頂点フォーマット
+	const InstanceBatch* mInstanceBatch; // 接続中のインスタンスバッファ
+	GeometryArena* mArena;               // 格納先のジオメトリアリーナ (nullptrなら専用のVAO/VBO/EBO)
+	unsigned int   mFirstIndex;          // アリーナ内の先頭インデックス
+	int            mBaseVertex;          // アリーナ内の先頭頂点
+	AABB           mBoundingBox;         // ローカル座標のAABB
+	BoundingSphere mBoundingSphere;      // ローカル座標の境界球
+	std::vector<MeshSubmesh> mSubmeshes; // サブメッシュ表
+	std::vector<MeshLod>     mLods;      // LOD表
+
+	static float   mOverdrawThreshold;   // オーバードロー最適化でクラスタを分けてよいACMRの悪化率 (0なら頂点キャッシュ最適化のみ)
+	static std::vector<float> mLodRatios; // LODごとの三角形数の比率
 };
 
+/////////////////////////////////////////////////
+// 読み込んだメッシュ (GPUへの転送前)
+// MeshObj::prepareMesh はGLを使わないのでワーカースレッドで作り、GLスレッドで uploadMesh に渡せる
+// キャッシュから読んだ場合はファイルをマップしたまま頂点・インデックスを指すので、転送が終わるまで破棄しないこと
+////////////////////////////////////////////////
+struct MeshLoadData
+{
+	MeshLoadData();
+	~MeshLoadData();
+
+	std::string                 fileName;
+	MeshObj::VertexFormat       format;
+	const void*                 vertices;        // 転送する頂点 (cacheか下の配列のどれかを指す)
+	unsigned int                vertexCount;
+	const void*                 indices;         // 転送するインデックス (全LOD分)
+	unsigned int                indexCount;
+	GLenum                      indexType;
+	AABB                        boundingBox;
+	BoundingSphere              boundingSphere;
+	std::vector<MeshSubmesh>    submeshes;
+	std::vector<MeshLod>        lods;
 
+	// 読み込み記録 (MeshCache::addRecordに渡す)
+	bool                        cacheHit;
+	float                       milliseconds;
+	float                       coldMilliseconds;
+	VertexCacheStats            statsBefore;
+	VertexCacheStats            statsAfter;
+
+	// 頂点・インデックスの持ち主
+	MeshCacheView*              cache;           // キャッシュをマップしたもの
+	std::vector<float>          floatVertices;
+	std::vector<unsigned char>  packedVertices;
+	std::vector<unsigned int>   intIndices;
+	std::vector<unsigned short> shortIndices;
+
+private:
+	MeshLoadData(const MeshLoadData&) = delete;
+	MeshLoadData& operator=(const MeshLoadData&) = delete;
+};
@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <cstring>
+#include "MeshOptimizer.h"
+#include "Math.h"
+
+static const unsigned int invalidIndex = 0xffffffff;
+
+// 頂点1つ分のハッシュ (FNV-1a を32bit単位で)
+static unsigned int hashVertex(const float* vertex, unsigned int stride)
+{
+	unsigned int hash = 2166136261u;
+	for (unsigned int i = 0; i < stride; i++)
+	{
+		unsigned int word;
+		memcpy(&word, vertex + i, sizeof(word));
+		hash ^= word;
+		hash *= 16777619u;
+	}
+	return hash ^ (hash >> 16);
+}
+
+// FIFOキャッシュに三角形1つを通してミス数を返す
+// cacheTime[v] は頂点vがキャッシュに入った時刻、timeStamp - cacheTime[v] > mCacheSize なら追い出し済み
+static unsigned int simulateTriangle(const unsigned int* triangle, std::vector<unsigned int>& cacheTime, unsigned int& timeStamp)
+{
+	unsigned int misses = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const unsigned int v = triangle[i];
+		if (timeStamp - cacheTime[v] > MeshOptimizer::mCacheSize)
+		{
+			cacheTime[v] = timeStamp++;
+			misses++;
+		}
+	}
+	return misses;
+}
+
+// キャッシュを空にする (全エントリの時刻を期限切れにする)
+static void flushCache(unsigned int& timeStamp)
+{
+	timeStamp += MeshOptimizer::mCacheSize + 1;
+}
+
+static unsigned int getVertexCount(const unsigned int* indices, size_t indexCount)
+{
+	unsigned int vertexCount = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		vertexCount = std::max(vertexCount, indices[i] + 1);
+	}
+	return vertexCount;
+}
+
+/////////////////////////////////////////////////
+// 位置・法線・UVが完全に一致する頂点をまとめる
+// out : destVertices  重複を除いた頂点
+//       destIndices   各コーナーの頂点番号
+// in  : corners       三角形のコーナーごとに展開した頂点 (cornerCount × stride個のfloat)
+//       cornerCount   コーナー数 (= インデックス数)
+//       stride        1頂点のfloat数
+// 戻り値 : 重複を除いた頂点数
+////////////////////////////////////////////////
+unsigned int MeshOptimizer::weldVertices(std::vector<float>& destVertices, std::vector<unsigned int>& destIndices,
+	const float* corners, size_t cornerCount, unsigned int stride)
+{
+	// 開番地法のハッシュ表 (頂点番号を格納、比較はdestVerticesとのビット一致)
+	size_t tableSize = 1;
+	while (tableSize < cornerCount * 2)
+	{
+		tableSize <<= 1;
+	}
+	std::vector<unsigned int> table(tableSize, invalidIndex);
+
+	destVertices.clear();
+	destVertices.reserve(cornerCount * stride);
+	destIndices.resize(cornerCount);
+
+	unsigned int vertexCount = 0;
+	for (size_t c = 0; c < cornerCount; c++)
+	{
+		const float* corner = corners + c * stride;
+		size_t slot = hashVertex(corner, stride) & (tableSize - 1);
+		for (;;)
+		{
+			const unsigned int id = table[slot];
+			if (id == invalidIndex)
+			{
+				table[slot] = vertexCount;
+				destVertices.insert(destVertices.end(), corner, corner + stride);
+				destIndices[c] = vertexCount++;
+				break;
+			}
+			if (memcmp(&destVertices[static_cast<size_t>(id) * stride], corner, sizeof(float) * stride) == 0)
+			{
+				destIndices[c] = id;
+				break;
+			}
+			slot = (slot + 1) & (tableSize - 1);
+		}
+	}
+	return vertexCount;
+}
+
+/////////////////////////////////////////////////
+// 頂点キャッシュ向けに三角形を並べ替える (Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" の Tipsify)
+// 頂点を1つ選び、その頂点を使う未出力の三角形をまとめて出力(ファン)し、
+// 次はキャッシュに残っていて、かつ残りの三角形を出してもキャッシュから溢れない頂点に移る
+// in/out : indices        三角形リストのインデックス (並べ替える)
+// in     : indexCount     インデックス数
+//          vertexCount    頂点数 (インデックスの最大値+1以上)
+// out    : destClusters   キャッシュが途切れた位置 (各クラスタの先頭三角形番号)、不要ならnullptr
+////////////////////////////////////////////////
+void MeshOptimizer::optimizeVertexCache(unsigned int* indices, size_t indexCount, unsigned int vertexCount,
+	std::vector<unsigned int>* destClusters)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (destClusters)
+	{
+		destClusters->clear();
+	}
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// 頂点 → 三角形の隣接表
+	std::vector<unsigned int> liveCount(vertexCount, 0); // 未出力の三角形数
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		liveCount[indices[i]]++;
+	}
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] = offsets[v] + liveCount[v];
+	}
+	{
+		std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+	}
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	unsigned int              timeStamp = mCacheSize + 1;
+	std::vector<char>         emitted(triangleCount, 0);
+	std::vector<unsigned int> deadEnd;     // 最近使った頂点 (行き止まりになったら戻る先)
+	std::vector<unsigned int> candidates;  // 直前のファンで使った頂点
+	std::vector<unsigned int> output;
+	deadEnd.reserve(triangleCount * 3);
+	output.reserve(triangleCount * 3);
+
+	unsigned int scanCursor = 0; // 行き止まりの時に未出力の頂点を探す位置
+	unsigned int fanning    = indices[0];
+	if (destClusters)
+	{
+		destClusters->push_back(0);
+	}
+
+	while (fanning != invalidIndex)
+	{
+		// fanningを使う未出力の三角形を全て出力
+		candidates.clear();
+		for (unsigned int k = offsets[fanning]; k < offsets[fanning + 1]; k++)
+		{
+			const unsigned int t = adjacency[k];
+			if (emitted[t])
+			{
+				continue;
+			}
+			for (int j = 0; j < 3; j++)
+			{
+				const unsigned int v = indices[t * 3 + j];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+				if (timeStamp - cacheTime[v] > mCacheSize)
+				{
+					cacheTime[v] = timeStamp++;
+				}
+			}
+			emitted[t] = 1;
+		}
+
+		// 次の頂点 : キャッシュに残っている中で一番古いもの (残りのファンで溢れない場合に限る)
+		unsigned int next         = invalidIndex;
+		int          bestPriority = -1;
+		for (unsigned int v : candidates)
+		{
+			if (liveCount[v] == 0)
+			{
+				continue;
+			}
+			int priority = 0;
+			if (timeStamp - cacheTime[v] + 2 * liveCount[v] <= mCacheSize)
+			{
+				priority = static_cast<int>(timeStamp - cacheTime[v]);
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next         = v;
+			}
+		}
+
+		// 行き止まり : 最近使った頂点に戻り、それも無ければ未出力の頂点を先頭から探す
+		if (next == invalidIndex)
+		{
+			while (!deadEnd.empty() && next == invalidIndex)
+			{
+				const unsigned int v = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveCount[v] > 0)
+				{
+					next = v;
+				}
+			}
+			while (next == invalidIndex && scanCursor < vertexCount)
+			{
+				if (liveCount[scanCursor] > 0)
+				{
+					next = scanCursor;
+				}
+				scanCursor++;
+			}
+			if (destClusters && next != invalidIndex)
+			{
+				destClusters->push_back(static_cast<unsigned int>(output.size() / 3));
+			}
+		}
+		fanning = next;
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+/////////////////////////////////////////////////
+// オーバードローを減らすようにクラスタの描画順を並べ替える
+// optimizeVertexCacheのクラスタを、キャッシュ効率がthreshold倍まで落ちない範囲でさらに細かく分け、
+// メッシュの中心から外を向いているクラスタほど先に描く (手前の面が先にデプスを埋める)
+// in/out : indices     三角形リストのインデックス (optimizeVertexCache済み)
+// in     : indexCount  インデックス数
+//          vertices    頂点 (先頭3要素が位置)
+//          stride      1頂点のfloat数
+//          clusters    optimizeVertexCacheが返したクラスタの先頭三角形番号
+//          threshold   クラスタを分けてよいACMRの悪化率 (1.05なら5%まで)
+////////////////////////////////////////////////
+void MeshOptimizer::optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* vertices, unsigned int stride,
+	const std::vector<unsigned int>& clusters, float threshold)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || clusters.empty())
+	{
+		return;
+	}
+
+	// クラスタの細分化 : クラスタ内でキャッシュを空から始めて、累積ACMRがクラスタ全体のACMR×threshold以下になった所で切る
+	std::vector<unsigned int> cacheTime(getVertexCount(indices, indexCount), 0);
+	unsigned int              timeStamp = mCacheSize + 1;
+	std::vector<unsigned int> softClusters;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const unsigned int start = clusters[c];
+		const unsigned int end   = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<unsigned int>(triangleCount);
+
+		flushCache(timeStamp);
+		unsigned int clusterMisses = 0;
+		for (unsigned int t = start; t < end; t++)
+		{
+			clusterMisses += simulateTriangle(indices + t * 3, cacheTime, timeStamp);
+		}
+		const float clusterThreshold = threshold * clusterMisses / (end - start);
+
+		flushCache(timeStamp);
+		softClusters.push_back(start);
+		unsigned int misses = 0, triangles = 0;
+		for (unsigned int t = start; t < end; t++)
+		{
+			misses += simulateTriangle(indices + t * 3, cacheTime, timeStamp);
+			triangles++;
+			if (t + 1 < end && static_cast<float>(misses) / triangles <= clusterThreshold)
+			{
+				softClusters.push_back(t + 1);
+				flushCache(timeStamp);
+				misses    = 0;
+				triangles = 0;
+			}
+		}
+	}
+
+	// クラスタごとの面積で重み付けした中心と法線
+	struct Cluster
+	{
+		unsigned int start;
+		unsigned int end;
+		Vector3      centroid;
+		Vector3      normal;
+		float        area;
+		float        sortKey;
+	};
+	std::vector<Cluster> sortClusters(softClusters.size());
+	Vector3 meshCentroid(0.0f, 0.0f, 0.0f);
+	float   meshArea = 0.0f;
+	for (size_t c = 0; c < softClusters.size(); c++)
+	{
+		Cluster& cluster = sortClusters[c];
+		cluster.start    = softClusters[c];
+		cluster.end      = c + 1 < softClusters.size() ? softClusters[c + 1] : static_cast<unsigned int>(triangleCount);
+		cluster.centroid = Vector3(0.0f, 0.0f, 0.0f);
+		cluster.normal   = Vector3(0.0f, 0.0f, 0.0f);
+		cluster.area     = 0.0f;
+		for (unsigned int t = cluster.start; t < cluster.end; t++)
+		{
+			const float* p0 = vertices + static_cast<size_t>(indices[t * 3 + 0]) * stride;
+			const float* p1 = vertices + static_cast<size_t>(indices[t * 3 + 1]) * stride;
+			const float* p2 = vertices + static_cast<size_t>(indices[t * 3 + 2]) * stride;
+			const Vector3 a(p0[0], p0[1], p0[2]), b(p1[0], p1[1], p1[2]), c2(p2[0], p2[1], p2[2]);
+			const Vector3 cross = Vector3::Cross(b - a, c2 - a);
+			const float   area  = cross.Length();
+			cluster.centroid += (a + b + c2) * (area / 3.0f);
+			cluster.normal   += cross;
+			cluster.area     += area;
+		}
+		meshCentroid += cluster.centroid;
+		meshArea     += cluster.area;
+		if (cluster.area > 0.0f)
+		{
+			cluster.centroid *= 1.0f / cluster.area;
+		}
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCentroid *= 1.0f / meshArea;
+	}
+
+	for (Cluster& cluster : sortClusters)
+	{
+		const float normalLength = cluster.normal.Length();
+		cluster.sortKey = normalLength > 0.0f ? Vector3::Dot(cluster.centroid - meshCentroid, cluster.normal) / normalLength : 0.0f;
+	}
+	std::stable_sort(sortClusters.begin(), sortClusters.end(),
+		[](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+	for (const Cluster& cluster : sortClusters)
+	{
+		output.insert(output.end(), indices + cluster.start * 3, indices + cluster.end * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+/////////////////////////////////////////////////
+// 頂点をインデックスで最初に参照される順に並べ替える (参照されない頂点は削除)
+// in/out : vertices    頂点
+//          indices     インデックス (新しい頂点番号に書き換える)
+// in     : indexCount  インデックス数
+//          stride      1頂点のfloat数
+////////////////////////////////////////////////
+void MeshOptimizer::optimizeVertexFetch(std::vector<float>& vertices, unsigned int* indices, size_t indexCount, unsigned int stride)
+{
+	const size_t vertexCount = vertices.size() / stride;
+	std::vector<unsigned int> remap(vertexCount, invalidIndex);
+	std::vector<float>        output;
+	output.reserve(vertices.size());
+
+	unsigned int next = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		const unsigned int v = indices[i];
+		if (remap[v] == invalidIndex)
+		{
+			remap[v] = next++;
+			output.insert(output.end(), vertices.begin() + v * stride, vertices.begin() + (v + 1) * stride);
+		}
+		indices[i] = remap[v];
+	}
+	vertices.swap(output);
+}
+
+/////////////////////////////////////////////////
+// FIFO頂点キャッシュ(mCacheSizeエントリ)をシミュレートする
+// in  : indices, indexCount  三角形リストのインデックス
+//       vertexCount          頂点数
+// out : ACMR (ミス数/三角形数) と ATVR (ミス数/参照される頂点数)
+////////////////////////////////////////////////
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const unsigned int* indices, size_t indexCount, unsigned int vertexCount)
+{
+	VertexCacheStats stats;
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return stats;
+	}
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<char>         used(vertexCount, 0);
+	unsigned int              timeStamp = mCacheSize + 1;
+	unsigned int              misses = 0, usedCount = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		misses += simulateTriangle(indices + t * 3, cacheTime, timeStamp);
+		for (int j = 0; j < 3; j++)
+		{
+			const unsigned int v = indices[t * 3 + j];
+			usedCount += used[v] ? 0 : 1;
+			used[v] = 1;
+		}
+	}
+	stats.acmr = static_cast<float>(misses) / triangleCount;
+	stats.atvr = static_cast<float>(misses) / usedCount;
+	return stats;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// 頂点キャッシュの効率
+struct VertexCacheStats
+{
+	float acmr = 0.0f;  // 三角形1つあたりの頂点シェーダー実行数 (Average Cache Miss Ratio, 理想は0.5付近)
+	float atvr = 0.0f;  // 頂点1つあたりの頂点シェーダー実行数 (Average Transformed Vertex Ratio, 理想は1.0)
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// メッシュの前処理
+//   weldVertices        : 位置・法線・UVが完全に一致する頂点を1つにまとめる
+//   optimizeVertexCache : 頂点キャッシュにヒットしやすい順に三角形を並べ替える (Tipsify)
+//   optimizeOverdraw    : Tipsifyのクラスタを外向きのものから描く順に並べ替え、オーバードローを減らす
+//   optimizeVertexFetch : 頂点をインデックスで最初に参照される順に並べ、頂点フェッチを連続させる
+//   analyzeVertexCache  : FIFOキャッシュをシミュレートしてACMR/ATVRを求める
+// 頂点はfloatのインターリーブ配列 (先頭3要素が位置) として扱う
+///////////////////////////////////////////////////////////////////////////////////////
+class MeshOptimizer
+{
+public:
+	static const unsigned int mCacheSize = 16; // 想定する頂点キャッシュのエントリ数
+
+	static unsigned int     weldVertices(std::vector<float>& destVertices, std::vector<unsigned int>& destIndices,
+	                                     const float* corners, size_t cornerCount, unsigned int stride);
+	static void             optimizeVertexCache(unsigned int* indices, size_t indexCount, unsigned int vertexCount,
+	                                            std::vector<unsigned int>* destClusters = nullptr);
+	static void             optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* vertices, unsigned int stride,
+	                                         const std::vector<unsigned int>& clusters, float threshold);
+	static void             optimizeVertexFetch(std::vector<float>& vertices, unsigned int* indices, size_t indexCount, unsigned int stride);
+	static VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, unsigned int vertexCount);
+
+private:
+	MeshOptimizer() = delete;
+};
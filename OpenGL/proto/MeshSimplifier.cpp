@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <cstdint>
+#include "MeshSimplifier.h"
+#include "Math.h"
+
+// 二次誤差 (Garland-Heckbert)
+// 平面 dot(n, p) + d = 0 ごとに A = n n^T, b = d n, c = d^2 を面積で重み付けして足し合わせたもの
+// 点pの誤差 p^T A p + 2 b^T p + c を重みの合計で割ると、平面までの距離の2乗の平均になる
+struct Quadric
+{
+	double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+	double weight = 0.0;
+};
+
+// 縮約の候補 (from を to の位置に寄せる)
+struct Collapse
+{
+	unsigned int from;
+	unsigned int to;
+	double       cost;
+};
+
+static void addQuadric(Quadric& dest, const Quadric& src)
+{
+	dest.a00 += src.a00; dest.a11 += src.a11; dest.a22 += src.a22;
+	dest.a01 += src.a01; dest.a02 += src.a02; dest.a12 += src.a12;
+	dest.b0  += src.b0;  dest.b1  += src.b1;  dest.b2  += src.b2;
+	dest.c   += src.c;
+	dest.weight += src.weight;
+}
+
+static void addPlane(Quadric& dest, const Vector3& normal, float d, float weight)
+{
+	const double x = normal.x, y = normal.y, z = normal.z;
+	dest.a00 += weight * x * x; dest.a11 += weight * y * y; dest.a22 += weight * z * z;
+	dest.a01 += weight * x * y; dest.a02 += weight * x * z; dest.a12 += weight * y * z;
+	dest.b0  += weight * d * x; dest.b1  += weight * d * y; dest.b2  += weight * d * z;
+	dest.c   += weight * d * d;
+	dest.weight += weight;
+}
+
+// 点positionでの平均の距離の2乗
+static double evaluateQuadric(const Quadric& q, const float* position)
+{
+	if (q.weight <= 0.0)
+	{
+		return 0.0;
+	}
+	const double x = position[0], y = position[1], z = position[2];
+	const double error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+	                   + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+	                   + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+	return Math::Max(error, 0.0) / q.weight;
+}
+
+// 三角形の法線 (正規化しない、長さは面積の2倍)
+static Vector3 getTriangleNormal(const float* p0, const float* p1, const float* p2)
+{
+	const Vector3 edge1(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]);
+	const Vector3 edge2(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]);
+	return Vector3::Cross(edge1, edge2);
+}
+
+static bool containsVertex(const unsigned int* triangle, unsigned int vertex)
+{
+	return triangle[0] == vertex || triangle[1] == vertex || triangle[2] == vertex;
+}
+
+/////////////////////////////////////////////////
+// 三角形数を目標まで減らす
+// 縮約の候補を誤差の小さい順に並べ、互いの周囲の三角形が重ならないものをまとめて適用する、を繰り返す
+// 面が裏返る縮約と、位相が変わる(辺の両端の共通の隣接頂点が増える)縮約はしない
+// out : destIndices       簡略化したインデックス (indexCount個分の領域が必要)
+//       destError         縮約した頂点の誤差の最大値 (平面までの距離、省略可)
+//       戻り値            簡略化したインデックス数 (目標まで減らせないこともある)
+// in  : indices           三角形リストのインデックス
+//       indexCount        インデックス数
+//       vertices          頂点 (vertexCount × stride個のfloat)
+//       vertexCount       頂点数
+//       stride            1頂点のfloatの個数
+//       targetIndexCount  目標のインデックス数
+////////////////////////////////////////////////
+size_t MeshSimplifier::simplify(unsigned int* destIndices, const unsigned int* indices, size_t indexCount,
+	const float* vertices, unsigned int vertexCount, unsigned int stride,
+	size_t targetIndexCount, float* destError)
+{
+	auto getPosition = [vertices, stride](unsigned int vertex) { return vertices + static_cast<size_t>(vertex) * stride; };
+
+	// 使われている頂点のうち同じ位置のものをまとめる (代表は最小の頂点番号)
+	std::vector<unsigned int> positionRemap(vertexCount);
+	std::vector<unsigned int> usedVertices;
+	{
+		std::vector<unsigned char> used(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			used[indices[i]] = 1;
+		}
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			positionRemap[v] = v;
+			if (used[v])
+			{
+				usedVertices.emplace_back(v);
+			}
+		}
+	}
+	std::sort(usedVertices.begin(), usedVertices.end(), [&getPosition](unsigned int a, unsigned int b)
+	{
+		const float* pa = getPosition(a);
+		const float* pb = getPosition(b);
+		if (pa[0] != pb[0]) return pa[0] < pb[0];
+		if (pa[1] != pb[1]) return pa[1] < pb[1];
+		if (pa[2] != pb[2]) return pa[2] < pb[2];
+		return a < b;
+	});
+
+	// 継ぎ目(同じ位置に複数の頂点)は動かさない
+	std::vector<unsigned char> locked(vertexCount, 0);
+	for (size_t i = 0; i < usedVertices.size();)
+	{
+		const float* position = getPosition(usedVertices[i]);
+		size_t end = i + 1;
+		while (end < usedVertices.size())
+		{
+			const float* other = getPosition(usedVertices[end]);
+			if (other[0] != position[0] || other[1] != position[1] || other[2] != position[2])
+			{
+				break;
+			}
+			positionRemap[usedVertices[end]] = usedVertices[i];
+			end++;
+		}
+		if (end - i > 1)
+		{
+			locked[usedVertices[i]] = 1;
+		}
+		i = end;
+	}
+
+	// 開いた境界・非多様体の辺の頂点も動かさない (逆向きの辺がちょうど1つでない辺)
+	{
+		std::vector<uint64_t> edges;
+		edges.reserve(indexCount);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				const uint64_t a = positionRemap[indices[i + e]];
+				const uint64_t b = positionRemap[indices[i + (e + 1) % 3]];
+				edges.emplace_back((a << 32) | b);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		for (uint64_t edge : edges)
+		{
+			const uint64_t a = edge >> 32, b = edge & 0xffffffff;
+			const auto forward = std::equal_range(edges.begin(), edges.end(), edge);
+			const auto reverse = std::equal_range(edges.begin(), edges.end(), (b << 32) | a);
+			if (forward.second - forward.first != 1 || reverse.second - reverse.first != 1)
+			{
+				locked[a] = 1;
+				locked[b] = 1;
+			}
+		}
+	}
+
+	// 各頂点(の位置)に周囲の三角形の平面を面積で重み付けして集める
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		const float* p0 = getPosition(indices[i + 0]);
+		Vector3 normal = getTriangleNormal(p0, getPosition(indices[i + 1]), getPosition(indices[i + 2]));
+		const float area2 = normal.Length();
+		if (area2 <= 0.0f)
+		{
+			continue;
+		}
+		normal *= 1.0f / area2;
+		const float d = -(normal.x * p0[0] + normal.y * p0[1] + normal.z * p0[2]);
+		for (int k = 0; k < 3; k++)
+		{
+			addPlane(quadrics[positionRemap[indices[i + k]]], normal, d, area2 * 0.5f);
+		}
+	}
+
+	std::vector<unsigned int>  result(indices, indices + indexCount);
+	std::vector<unsigned int>  collapseRemap(vertexCount);
+	std::vector<unsigned char> touched(vertexCount);
+	std::vector<unsigned int>  triangleOffsets(vertexCount + 1);
+	std::vector<unsigned int>  vertexTriangles;
+	std::vector<unsigned int>  neighbors0, neighbors1;
+	std::vector<Collapse>      collapses;
+	double                     maxError = 0.0;
+
+	while (result.size() > targetIndexCount)
+	{
+		const size_t triangleCount = result.size() / 3;
+
+		// 頂点 → 周囲の三角形
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (unsigned int index : result)
+		{
+			triangleOffsets[index + 1]++;
+		}
+		std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+		vertexTriangles.resize(result.size());
+		{
+			std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					vertexTriangles[fill[result[t * 3 + k]]++] = static_cast<unsigned int>(t);
+				}
+			}
+		}
+
+		// 辺ごとに両方向の縮約の誤差を求める
+		collapses.clear();
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				const unsigned int ends[2] = { result[t * 3 + e], result[t * 3 + (e + 1) % 3] };
+				for (int k = 0; k < 2; k++)
+				{
+					const unsigned int from = ends[k], to = ends[1 - k];
+					if (locked[positionRemap[from]])
+					{
+						continue;
+					}
+					Quadric quadric = quadrics[from];
+					addQuadric(quadric, quadrics[positionRemap[to]]);
+					collapses.push_back({ from, to, evaluateQuadric(quadric, getPosition(to)) });
+				}
+			}
+		}
+		if (collapses.empty())
+		{
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		// 縮約できるか (周囲の三角形が裏返らず、辺の両端の共通の隣接頂点が辺を共有する三角形の頂点だけ)
+		auto canCollapse = [&](unsigned int from, unsigned int to)
+		{
+			const float* target = getPosition(to);
+			unsigned int sharedNum = 0;
+			neighbors0.clear();
+			for (unsigned int i = triangleOffsets[from]; i < triangleOffsets[from + 1]; i++)
+			{
+				const unsigned int* triangle = &result[vertexTriangles[i] * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					if (touched[triangle[k]])
+					{
+						return false;
+					}
+					if (triangle[k] != from)
+					{
+						neighbors0.emplace_back(triangle[k]);
+					}
+				}
+				if (containsVertex(triangle, to))
+				{
+					sharedNum++;
+					continue;
+				}
+
+				const float* p[3];
+				const float* moved[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k]     = getPosition(triangle[k]);
+					moved[k] = triangle[k] == from ? target : p[k];
+				}
+				const Vector3 before = getTriangleNormal(p[0], p[1], p[2]);
+				const Vector3 after  = getTriangleNormal(moved[0], moved[1], moved[2]);
+				if (Vector3::Dot(before, after) <= 0.25f * before.Length() * after.Length())
+				{
+					return false;
+				}
+			}
+
+			neighbors1.clear();
+			for (unsigned int i = triangleOffsets[to]; i < triangleOffsets[to + 1]; i++)
+			{
+				const unsigned int* triangle = &result[vertexTriangles[i] * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					if (triangle[k] != to && triangle[k] != from)
+					{
+						neighbors1.emplace_back(triangle[k]);
+					}
+				}
+			}
+			std::sort(neighbors0.begin(), neighbors0.end());
+			neighbors0.erase(std::unique(neighbors0.begin(), neighbors0.end()), neighbors0.end());
+			std::sort(neighbors1.begin(), neighbors1.end());
+			neighbors1.erase(std::unique(neighbors1.begin(), neighbors1.end()), neighbors1.end());
+			unsigned int commonNum = 0;
+			for (unsigned int neighbor : neighbors1)
+			{
+				commonNum += std::binary_search(neighbors0.begin(), neighbors0.end(), neighbor) ? 1 : 0;
+			}
+			return sharedNum > 0 && commonNum == sharedNum;
+		};
+
+		// 誤差の小さい順に、周囲が重ならない縮約をまとめて適用する
+		std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+		std::fill(touched.begin(), touched.end(), 0);
+		const size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+		size_t       removed = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (removed >= trianglesToRemove)
+			{
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to] || !canCollapse(collapse.from, collapse.to))
+			{
+				continue;
+			}
+
+			for (unsigned int i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1]; i++)
+			{
+				const unsigned int* triangle = &result[vertexTriangles[i] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+				removed += containsVertex(triangle, collapse.to) ? 1 : 0;
+			}
+			touched[collapse.to] = 1;
+			collapseRemap[collapse.from] = collapse.to;
+			addQuadric(quadrics[positionRemap[collapse.to]], quadrics[collapse.from]);
+			maxError = Math::Max(maxError, collapse.cost);
+		}
+		if (removed == 0)
+		{
+			break;
+		}
+
+		// 縮約を反映し、潰れた三角形を除く
+		size_t writeIndex = 0;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			const unsigned int a = collapseRemap[result[t * 3 + 0]];
+			const unsigned int b = collapseRemap[result[t * 3 + 1]];
+			const unsigned int c = collapseRemap[result[t * 3 + 2]];
+			if (a == b || b == c || c == a)
+			{
+				continue;
+			}
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+	}
+
+	std::copy(result.begin(), result.end(), destIndices);
+	if (destError)
+	{
+		*destError = static_cast<float>(Math::Sqrt(static_cast<float>(maxError)));
+	}
+	return result.size();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// メッシュの簡略化 (LOD生成)
+// Garland-Heckbert の二次誤差(QEM)の小さい辺から縮約し、三角形数を目標まで減らす
+// 縮約は辺の片方の頂点をもう片方に寄せるだけで新しい頂点は作らないので、簡略化した
+// インデックスは元の頂点配列をそのまま参照できる (LOD間で頂点バッファを共有できる)
+// 同じ位置に複数の頂点がある頂点(法線・UVの継ぎ目)と開いた境界上の頂点は動かさない
+// 頂点はfloatのインターリーブ配列 (先頭3要素が位置) として扱う
+///////////////////////////////////////////////////////////////////////////////////////
+class MeshSimplifier
+{
+public:
+	static size_t simplify(unsigned int* destIndices, const unsigned int* indices, size_t indexCount,
+	                       const float* vertices, unsigned int vertexCount, unsigned int stride,
+	                       size_t targetIndexCount, float* destError = nullptr);
+
+private:
+	MeshSimplifier() = delete;
+};
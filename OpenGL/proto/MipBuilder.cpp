@@ -0,0 +1,380 @@
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "MipBuilder.h"
+#include "Math.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define MIP_BUILDER_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+static const float kaiserAlpha = 4.0f; // カイザー窓の形 (大きいほど側波帯が小さく、ぼやける)
+
+// 0次の第1種変形ベッセル関数 (カイザー窓用、級数展開)
+static float besselI0(float x)
+{
+	float sum  = 1.0f;
+	float term = 1.0f;
+	const float halfSq = x * x * 0.25f;
+	for (int k = 1; k < 32 && term > sum * 1e-7f; k++)
+	{
+		term *= halfSq / static_cast<float>(k * k);
+		sum  += term;
+	}
+	return sum;
+}
+
+// sRGBの8bit値 → 線形 の表
+static const float* getSrgbToLinearTable()
+{
+	static const std::vector<float> table = []()
+	{
+		std::vector<float> values(256);
+		for (int i = 0; i < 256; i++)
+		{
+			const float c = i / 255.0f;
+			values[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return values;
+	}();
+	return table.data();
+}
+
+// 線形 → sRGBの8bit値
+static unsigned char linearToSrgb(float c)
+{
+	c = Math::Clamp(c, 0.0f, 1.0f);
+	c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+	return static_cast<unsigned char>(c * 255.0f + 0.5f);
+}
+
+static unsigned char toUnorm8(float c)
+{
+	return static_cast<unsigned char>(Math::Clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+/////////////////////////////////////////////////
+// ミップマップの全レベルを作る
+// out : dest       sourceと同じ形式で1x1までの全レベル (レベル0はsourceのコピー)
+// in  : source     元の画像 (RGB8 / RGBA8、レベル0だけを使う。destと同じものは渡せない)
+//       mode       画素の値の意味 (平均の取り方)
+//       threadNum  スレッド数 (0ならコア数、行が少なければ減らす)
+// out : 対応している形式ならtrue
+////////////////////////////////////////////////
+bool MipBuilder::build(TextureFile& dest, const TextureFile& source, Mode mode, unsigned int threadNum)
+{
+	const TextureFile::Format format = source.getFormat();
+	if (source.getLevelNum() == 0 || (format != TextureFile::Format_RGB8 && format != TextureFile::Format_RGBA8))
+	{
+		return false;
+	}
+
+	const unsigned int channels = TextureFile::getBlockBytes(format);
+	const int          width    = source.getWidth();
+	const int          height   = source.getHeight();
+	dest.create(format, width, height, TextureFile::getFullLevelNum(width, height));
+	memcpy(dest.getLevelData(0), source.getLevelData(0), source.getLevel(0).size);
+
+	// 各レベルは1つ前のレベルを8bitに丸める前の値から作る
+	std::vector<float> level(static_cast<size_t>(width) * height * 4);
+	std::vector<float> rows;
+	std::vector<float> next;
+	runParallel(height, threadNum, [&](int firstRow, int lastRow)
+	{
+		const size_t offset = static_cast<size_t>(firstRow) * width;
+		decode(level.data() + offset * 4, source.getLevelData(0) + offset * channels, static_cast<size_t>(lastRow - firstRow) * width, channels, mode);
+	});
+
+	for (unsigned int i = 1; i < dest.getLevelNum(); i++)
+	{
+		const TextureLevel& sourceLevel = dest.getLevel(i - 1);
+		const TextureLevel& destLevel   = dest.getLevel(i);
+		Kernel kernelX;
+		Kernel kernelY;
+		makeKernel(kernelX, sourceLevel.width, destLevel.width);
+		makeKernel(kernelY, sourceLevel.height, destLevel.height);
+
+		// 横に縮小 (元の高さのまま) → 縦に縮小して8bitに戻す
+		rows.resize(static_cast<size_t>(destLevel.width) * sourceLevel.height * 4);
+		runParallel(sourceLevel.height, threadNum, [&](int firstRow, int lastRow)
+		{
+			filterRows(rows.data(), level.data(), sourceLevel.width, destLevel.width, kernelX, firstRow, lastRow);
+		});
+
+		next.resize(static_cast<size_t>(destLevel.width) * destLevel.height * 4);
+		unsigned char* pixels = dest.getLevelData(i);
+		runParallel(destLevel.height, threadNum, [&](int firstRow, int lastRow)
+		{
+			filterColumns(next.data(), rows.data(), destLevel.width, kernelY, firstRow, lastRow);
+			const size_t offset = static_cast<size_t>(firstRow) * destLevel.width;
+			encode(pixels + offset * channels, next.data() + offset * 4, static_cast<size_t>(lastRow - firstRow) * destLevel.width, channels, mode);
+		});
+		level.swap(next);
+	}
+	return true;
+}
+
+/////////////////////////////////////////////////
+// ファイル名から画素の値の意味を推測する
+// in  : path  画像ファイル名
+// out : 法線マップ (normal / _n / _nrm) ならMode_Normal、
+//       スペキュラー・ラフネスなどのデータ (specular / rough / metal / gloss / height / mask / _s / _r / _m / _ao) ならMode_Linear、
+//       それ以外はMode_Color
+////////////////////////////////////////////////
+MipBuilder::Mode MipBuilder::getDefaultMode(const std::string& path)
+{
+	const size_t slash = path.find_last_of("/\\");
+	std::string  name  = path.substr(slash == std::string::npos ? 0 : slash + 1);
+	const size_t dot   = name.find_last_of('.');
+	if (dot != std::string::npos)
+	{
+		name.resize(dot);
+	}
+	std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+
+	auto contains = [&name](const char* word) { return name.find(word) != std::string::npos; };
+	auto endsWith = [&name](const std::string& suffix)
+	{
+		return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+	};
+
+	if (contains("normal") || endsWith("_n") || endsWith("_nrm"))
+	{
+		return Mode_Normal;
+	}
+	if (contains("specular") || contains("rough") || contains("metal") || contains("gloss") || contains("height") || contains("mask") ||
+		endsWith("_s") || endsWith("_r") || endsWith("_m") || endsWith("_ao"))
+	{
+		return Mode_Linear;
+	}
+	return Mode_Color;
+}
+
+const char* MipBuilder::getModeName(Mode mode)
+{
+	switch (mode)
+	{
+	case Mode_Color:  return "color";
+	case Mode_Linear: return "linear";
+	case Mode_Normal: return "normal";
+	}
+	return "unknown";
+}
+
+/////////////////////////////////////////////////
+// 1方向の縮小の重みを作る
+// 縮小後の画素の中心を元の座標に置き、元の画素の間隔を縮小率で割った距離でフィルターを引く
+// out : kernel      重み
+// in  : sourceSize  元の画素数
+//       destSize    縮小後の画素数
+////////////////////////////////////////////////
+void MipBuilder::makeKernel(Kernel& kernel, int sourceSize, int destSize)
+{
+	const float scale   = static_cast<float>(sourceSize) / static_cast<float>(destSize);
+	const float support = mFilterRadius * scale;
+	kernel.tapNum = sourceSize == destSize ? 1 : static_cast<int>(ceilf(support * 2.0f)) + 1;
+	kernel.indices.resize(static_cast<size_t>(destSize) * kernel.tapNum);
+	kernel.weights.resize(static_cast<size_t>(destSize) * kernel.tapNum);
+
+	for (int d = 0; d < destSize; d++)
+	{
+		int*   indices = kernel.indices.data() + static_cast<size_t>(d) * kernel.tapNum;
+		float* weights = kernel.weights.data() + static_cast<size_t>(d) * kernel.tapNum;
+		if (kernel.tapNum == 1)
+		{
+			// 縮小しない方向 (1画素の辺) はそのまま
+			indices[0] = d;
+			weights[0] = 1.0f;
+			continue;
+		}
+
+		const float center = (d + 0.5f) * scale - 0.5f;
+		const int   first  = static_cast<int>(ceilf(center - support));
+		float       sum    = 0.0f;
+		for (int k = 0; k < kernel.tapNum; k++)
+		{
+			// GL_REPEATと同じく反対側に回り込む (小さいレベルでは何周もする)
+			const int x = first + k;
+			indices[k] = ((x % sourceSize) + sourceSize) % sourceSize;
+			weights[k] = getFilterWeight((x - center) / scale);
+			sum       += weights[k];
+		}
+		for (int k = 0; k < kernel.tapNum; k++)
+		{
+			weights[k] /= sum;
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// カイザー窓を掛けたsinc
+// in  : x  縮小後の画素単位の距離
+// out : 重み (正規化前、半径の外は0)
+////////////////////////////////////////////////
+float MipBuilder::getFilterWeight(float x)
+{
+	const float t = x / mFilterRadius;
+	if (t <= -1.0f || t >= 1.0f)
+	{
+		return 0.0f;
+	}
+	const float window = besselI0(kaiserAlpha * sqrtf(1.0f - t * t)) / besselI0(kaiserAlpha);
+	const float px     = Math::Pi * x;
+	const float sinc   = Math::NearZero(px) ? 1.0f : sinf(px) / px;
+	return sinc * window;
+}
+
+/////////////////////////////////////////////////
+// 行 [firstRow, lastRow) を横に縮小する
+// out : dest         縮小後 (width x 元の高さ、1画素float4つ)
+// in  : source       元の画像 (sourceWidth x 元の高さ)
+////////////////////////////////////////////////
+void MipBuilder::filterRows(float* dest, const float* source, int sourceWidth, int width, const Kernel& kernel, int firstRow, int lastRow)
+{
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		const float* row = source + static_cast<size_t>(y) * sourceWidth * 4;
+		float*       out = dest + static_cast<size_t>(y) * width * 4;
+		for (int x = 0; x < width; x++, out += 4)
+		{
+			const int*   indices = kernel.indices.data() + static_cast<size_t>(x) * kernel.tapNum;
+			const float* weights = kernel.weights.data() + static_cast<size_t>(x) * kernel.tapNum;
+#ifdef MIP_BUILDER_USE_SSE
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k < kernel.tapNum; k++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(row + indices[k] * 4)));
+			}
+			_mm_storeu_ps(out, sum);
+#else
+			out[0] = out[1] = out[2] = out[3] = 0.0f;
+			for (int k = 0; k < kernel.tapNum; k++)
+			{
+				const float* pixel = row + indices[k] * 4;
+				for (int c = 0; c < 4; c++)
+				{
+					out[c] += weights[k] * pixel[c];
+				}
+			}
+#endif
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// 縮小後の行 [firstRow, lastRow) を縦に縮小する
+// 入力の行ごとに行全体へ重みを足し込む (行を連続して読む)
+// out : dest          縮小後 (width x 縮小後の高さ)
+// in  : source        横に縮小した画像 (width x 元の高さ)
+////////////////////////////////////////////////
+void MipBuilder::filterColumns(float* dest, const float* source, int width, const Kernel& kernel, int firstRow, int lastRow)
+{
+	const size_t rowFloats = static_cast<size_t>(width) * 4;
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		const int*   indices = kernel.indices.data() + static_cast<size_t>(y) * kernel.tapNum;
+		const float* weights = kernel.weights.data() + static_cast<size_t>(y) * kernel.tapNum;
+		float*       out     = dest + static_cast<size_t>(y) * rowFloats;
+		std::fill(out, out + rowFloats, 0.0f);
+		for (int k = 0; k < kernel.tapNum; k++)
+		{
+			const float* row = source + static_cast<size_t>(indices[k]) * rowFloats;
+#ifdef MIP_BUILDER_USE_SSE
+			const __m128 weight = _mm_set1_ps(weights[k]);
+			for (size_t i = 0; i < rowFloats; i += 4)
+			{
+				_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(weight, _mm_loadu_ps(row + i))));
+			}
+#else
+			for (size_t i = 0; i < rowFloats; i++)
+			{
+				out[i] += weights[k] * row[i];
+			}
+#endif
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// 行 [0, rowNum) を範囲に分けて複数スレッドで処理する (最初の範囲は呼び出したスレッド)
+// in : rowNum     行数
+//      threadNum  スレッド数 (0ならコア数、行が少なければ減らす)
+//      func       行 [firstRow, lastRow) を処理する関数
+////////////////////////////////////////////////
+void MipBuilder::runParallel(int rowNum, unsigned int threadNum, const std::function<void(int, int)>& func)
+{
+	if (threadNum == 0)
+	{
+		threadNum = Math::Max(std::thread::hardware_concurrency(), 1u);
+	}
+	threadNum = Math::Max(Math::Min(threadNum, static_cast<unsigned int>(rowNum) / mParallelRowNum), 1u);
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < threadNum; i++)
+	{
+		threads.emplace_back(func,
+			static_cast<int>(static_cast<long long>(rowNum) * i / threadNum),
+			static_cast<int>(static_cast<long long>(rowNum) * (i + 1) / threadNum));
+	}
+	func(0, rowNum / static_cast<int>(threadNum));
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+/////////////////////////////////////////////////
+// 8bitの画素をフィルターを掛ける値 (1画素float4つ) に直す
+// in : channels  1画素のバイト数 (3ならアルファは1)
+////////////////////////////////////////////////
+void MipBuilder::decode(float* dest, const unsigned char* source, size_t pixelNum, unsigned int channels, Mode mode)
+{
+	const float* srgbToLinear = getSrgbToLinearTable();
+	for (size_t i = 0; i < pixelNum; i++, dest += 4, source += channels)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			switch (mode)
+			{
+			case Mode_Color:  dest[c] = srgbToLinear[source[c]]; break;
+			case Mode_Linear: dest[c] = source[c] / 255.0f; break;
+			case Mode_Normal: dest[c] = source[c] / 255.0f * 2.0f - 1.0f; break;
+			}
+		}
+		dest[3] = channels == 4 ? source[3] / 255.0f : 1.0f;
+	}
+}
+
+/////////////////////////////////////////////////
+// フィルターを掛けた値を8bitの画素に戻す
+// sincの負の重みで範囲を少しはみ出すので丸める。法線は長さを1に戻す
+// in : channels  1画素のバイト数 (3ならアルファは書かない)
+////////////////////////////////////////////////
+void MipBuilder::encode(unsigned char* dest, const float* source, size_t pixelNum, unsigned int channels, Mode mode)
+{
+	for (size_t i = 0; i < pixelNum; i++, dest += channels, source += 4)
+	{
+		if (mode == Mode_Normal)
+		{
+			// 向きがばらばらで打ち消し合った所は面の向きそのまま
+			Vector3 normal(source[0], source[1], source[2]);
+			normal = normal.LengthSq() > 1e-8f ? Vector3::Normalize(normal) : Vector3::UnitZ;
+			dest[0] = toUnorm8(normal.x * 0.5f + 0.5f);
+			dest[1] = toUnorm8(normal.y * 0.5f + 0.5f);
+			dest[2] = toUnorm8(normal.z * 0.5f + 0.5f);
+		}
+		else
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				dest[c] = mode == Mode_Color ? linearToSrgb(source[c]) : toUnorm8(source[c]);
+			}
+		}
+		if (channels == 4)
+		{
+			dest[3] = toUnorm8(source[3]);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "TextureFile.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// CPUでのミップマップ生成
+// 1段ずつ幅・高さを半分にし (奇数は切り捨て、最小1)、各段は1つ前の段を浮動小数点のまま縮小して作る
+// 縮小はカイザー窓を掛けたsinc (半径3画素、alpha 4) を横・縦の順に掛ける分離フィルター
+// テクスチャはGL_REPEATで貼るので、画像の端は反対側に回り込んで読む
+//
+// Mode_Color  : sRGBの色 (ディフューズ)。線形に直してから平均してsRGBに戻す (2x2の平均のように暗くならない)
+// Mode_Linear : 値のまま平均する (スペキュラーなどのデータ)
+// Mode_Normal : 法線マップ。[-1,1]に直して平均し、長さを1に正規化してから戻す
+// アルファはどのモードでも値のまま平均する
+// 行の範囲をスレッドに分け、1画素のRGBAはSSEの4要素でまとめて計算する
+///////////////////////////////////////////////////////////////////////////////////////
+class MipBuilder
+{
+public:
+	enum Mode
+	{
+		Mode_Color,
+		Mode_Linear,
+		Mode_Normal,
+	};
+
+	static const int          mFilterRadius  = 3;   // フィルターの半径 (縮小後の画素単位)
+	static const unsigned int mParallelRowNum = 32; // これ以上の行があれば複数スレッドで計算
+
+	static bool        build(TextureFile& dest, const TextureFile& source, Mode mode,
+	                         unsigned int threadNum = 0);      // sourceのレベル0から1x1までの全レベルを作る (RGB8 / RGBA8、threadNum 0ならコア数)
+	static Mode        getDefaultMode(const std::string& path); // ファイル名から決める (normal・_n → 法線、specular・rough・_s など → データ、他は色)
+	static const char* getModeName(Mode mode);
+
+private:
+	MipBuilder() = delete;
+
+	// 縮小1方向分の重み (縮小後の1画素ごとに tapNum 個の入力画素と重み)
+	struct Kernel
+	{
+		int                tapNum;
+		std::vector<int>   indices;   // 入力画素の番号 (回り込み済み)
+		std::vector<float> weights;   // 合計が1になるように正規化済み
+	};
+
+	static void  makeKernel(Kernel& kernel, int sourceSize, int destSize);
+	static float getFilterWeight(float x);
+	static void  filterRows(float* dest, const float* source, int sourceWidth, int width, const Kernel& kernel, int firstRow, int lastRow);
+	static void  filterColumns(float* dest, const float* source, int width, const Kernel& kernel, int firstRow, int lastRow);
+	static void  runParallel(int rowNum, unsigned int threadNum, const std::function<void(int, int)>& func); // 行 [0, rowNum) をスレッドに分ける
+	static void  decode(float* dest, const unsigned char* source, size_t pixelNum, unsigned int channels, Mode mode);
+	static void  encode(unsigned char* dest, const float* source, size_t pixelNum, unsigned int channels, Mode mode);
+};
@@ -48,7 +48,7 @@ void Mouse::OnMouseWheelEvent(SDL_Event& event)
 	}
 }
 
-// ͏̍XVB_O[v̐擪1񂾂ĂԂ悤ɂ
+// 入力処理の更新。レンダリングループの先頭で1回だけ呼ぶようにする
 void Mouse::Update()
 {
 	mPrevButtons = mCurrentButtons;
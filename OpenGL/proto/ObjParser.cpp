@@ -0,0 +1,488 @@
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Math.h"
+
+// 範囲内で解決した負のインデックスは「範囲の先頭からの番号 - relativeBias」として持ち、連結時に直す
+// (-1 は指定無し、0以上は絶対インデックス)
+static const int relativeBias = 1 << 30;
+
+// 10の累乗 (仮数が15桁程度・指数が22以内ならdoubleで正しく丸められる)
+static const double powersOf10[] =
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// 行の途中で切れないように分けたファイルの範囲と、その解析結果
+struct ObjParser::Chunk
+{
+	const char*           begin = nullptr;
+	const char*           end   = nullptr;
+
+	std::vector<float>    positions;
+	std::vector<float>    normals;
+	std::vector<float>    texcoords;
+	std::vector<ObjIndex> indices;
+	std::vector<std::pair<size_t, std::string>> groups;   // g / o の位置 (範囲内のインデックス番号) と名前
+	size_t                lineNum   = 0;                   // 解析した行数
+	size_t                errorLine = 0;                   // エラーのあった行 (範囲内で1始まり、0ならエラー無し)
+	std::string           error;
+
+	// 連結先 (範囲の先頭までの個数)
+	size_t                firstPosition = 0;
+	size_t                firstNormal   = 0;
+	size_t                firstTexcoord = 0;
+	size_t                firstIndex    = 0;
+};
+
+static inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline void skipSpace(const char*& p, const char* end)
+{
+	while (p < end && isSpace(*p))
+	{
+		p++;
+	}
+}
+
+/////////////////////////////////////////////////
+// 10進の実数を読む (符号・小数点・指数)
+// in  : p      読み始める位置 (読み終わった位置に進める)
+//       end    行の終わり
+// out : value  読んだ値
+//       数字が無ければfalse
+////////////////////////////////////////////////
+static bool parseFloat(const char*& p, const char* end, float& value)
+{
+	const char* s = p;
+	bool negative = false;
+	if (s < end && (*s == '-' || *s == '+'))
+	{
+		negative = *s == '-';
+		s++;
+	}
+
+	// 仮数は18桁まで整数で持ち、それ以降の桁は指数に回す
+	unsigned long long mantissa = 0;
+	int  exponent = 0;
+	bool hasDigit = false;
+	for (; s < end && isDigit(*s); s++)
+	{
+		if (mantissa < 100000000000000000ULL)
+		{
+			mantissa = mantissa * 10 + (*s - '0');
+		}
+		else
+		{
+			exponent++;
+		}
+		hasDigit = true;
+	}
+	if (s < end && *s == '.')
+	{
+		for (s++; s < end && isDigit(*s); s++)
+		{
+			if (mantissa < 100000000000000000ULL)
+			{
+				mantissa = mantissa * 10 + (*s - '0');
+				exponent--;
+			}
+			hasDigit = true;
+		}
+	}
+	if (!hasDigit)
+	{
+		return false;
+	}
+	if (s < end && (*s == 'e' || *s == 'E'))
+	{
+		const char* e = s + 1;
+		bool negativeExponent = false;
+		if (e < end && (*e == '-' || *e == '+'))
+		{
+			negativeExponent = *e == '-';
+			e++;
+		}
+		if (e < end && isDigit(*e))
+		{
+			int exponentValue = 0;
+			for (; e < end && isDigit(*e); e++)
+			{
+				exponentValue = Math::Min(exponentValue * 10 + (*e - '0'), 9999);
+			}
+			exponent += negativeExponent ? -exponentValue : exponentValue;
+			s = e;
+		}
+	}
+
+	double result = static_cast<double>(mantissa);
+	if (mantissa != 0 && exponent != 0)
+	{
+		const int absExponent = exponent < 0 ? -exponent : exponent;
+		const double scale = absExponent <= 22 ? powersOf10[absExponent] : std::pow(10.0, absExponent);
+		result = exponent < 0 ? result / scale : result * scale;
+	}
+	value = static_cast<float>(negative ? -result : result);
+	p = s;
+	return true;
+}
+
+/////////////////////////////////////////////////
+// 面のインデックスを1つ読む (1始まり、負なら直前に定義した要素からの相対)
+// in  : p           読み始める位置 (読み終わった位置に進める)
+//       end         行の終わり
+//       localCount  範囲内でこれまでに定義した要素数
+// out : dest        0始まりの絶対インデックス、または相対インデックス (relativeBias参照)
+//       数字が無い・0・大きすぎる場合はfalse
+////////////////////////////////////////////////
+static bool parseIndex(const char*& p, const char* end, size_t localCount, int& dest)
+{
+	const char* s = p;
+	bool negative = false;
+	if (s < end && *s == '-')
+	{
+		negative = true;
+		s++;
+	}
+	if (s >= end || !isDigit(*s))
+	{
+		return false;
+	}
+	long long value = 0;
+	for (; s < end && isDigit(*s); s++)
+	{
+		value = value * 10 + (*s - '0');
+		if (value >= relativeBias)
+		{
+			return false;
+		}
+	}
+	if (value == 0)
+	{
+		return false;
+	}
+
+	dest = negative ? static_cast<int>(static_cast<long long>(localCount) - value - relativeBias) : static_cast<int>(value - 1);
+	p = s;
+	return true;
+}
+
+// 数値を count 個読む (足りない分は0)
+static bool parseFloats(const char*& p, const char* end, unsigned int count, std::vector<float>& dest)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		skipSpace(p, end);
+		float value = 0.0f;
+		if (p < end && !parseFloat(p, end, value))
+		{
+			return false;
+		}
+		dest.push_back(value);
+	}
+	return true;
+}
+
+ObjParser::ObjParser()
+	: mThreadNum(0)
+{
+}
+
+void ObjParser::clear()
+{
+	mPositions.clear();
+	mNormals.clear();
+	mTexcoords.clear();
+	mIndices.clear();
+	mShapes.clear();
+	mError.clear();
+}
+
+/////////////////////////////////////////////////
+// OBJファイルを解析する
+// ファイルを行単位の範囲に分けてスレッドごとに解析し、範囲の順に連結する
+// in  : fileName  OBJファイル名
+// out : 解析できたらtrue
+////////////////////////////////////////////////
+bool ObjParser::parse(const char* fileName)
+{
+	clear();
+
+	MappedFile file;
+	if (!file.open(fileName))
+	{
+		mError = std::string("ファイルを開けない : ") + fileName;
+		return false;
+	}
+	const char*  data = reinterpret_cast<const char*>(file.getData());
+	const size_t size = file.getSize();
+
+	// 範囲の境界は次の改行の直後までずらす
+	const unsigned int hardwareNum = Math::Max(std::thread::hardware_concurrency(), 1u);
+	mThreadNum = static_cast<unsigned int>(Math::Clamp<size_t>(size / mChunkBytesMin, 1, hardwareNum));
+	std::vector<Chunk> chunks(mThreadNum);
+	const char* begin = data;
+	for (unsigned int i = 0; i < mThreadNum; i++)
+	{
+		const char* end = data + size;
+		if (i + 1 < mThreadNum)
+		{
+			end = std::max(begin, data + size * (i + 1) / mThreadNum);
+			const void* newLine = memchr(end, '\n', static_cast<size_t>(data + size - end));
+			end = newLine ? static_cast<const char*>(newLine) + 1 : data + size;
+		}
+		chunks[i].begin = begin;
+		chunks[i].end   = end;
+		begin = end;
+	}
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < mThreadNum; i++)
+	{
+		threads.emplace_back(&ObjParser::parseChunk, &chunks[i]);
+	}
+	parseChunk(&chunks[0]);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	threads.clear();
+
+	// 最初のエラーを報告する (行番号は前の範囲の行数を足してファイル先頭からにする)
+	size_t lineNum = 0;
+	for (const Chunk& chunk : chunks)
+	{
+		if (chunk.errorLine)
+		{
+			mError = std::string(fileName) + "(" + std::to_string(lineNum + chunk.errorLine) + ") : " + chunk.error;
+			return false;
+		}
+		lineNum += chunk.lineNum;
+	}
+
+	// 連結先を決め、範囲ごとにコピーとインデックスの修正を並列に行う
+	size_t positionNum = 0, normalNum = 0, texcoordNum = 0, indexNum = 0;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.firstPosition = positionNum;
+		chunk.firstNormal   = normalNum;
+		chunk.firstTexcoord = texcoordNum;
+		chunk.firstIndex    = indexNum;
+		positionNum += chunk.positions.size();
+		normalNum   += chunk.normals.size();
+		texcoordNum += chunk.texcoords.size();
+		indexNum    += chunk.indices.size();
+	}
+	mPositions.resize(positionNum);
+	mNormals.resize(normalNum);
+	mTexcoords.resize(texcoordNum);
+	mIndices.resize(indexNum);
+
+	for (unsigned int i = 1; i < mThreadNum; i++)
+	{
+		threads.emplace_back(&ObjParser::mergeChunk, this, &chunks[i]);
+	}
+	mergeChunk(this, &chunks[0]);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	for (const Chunk& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			clear();
+			mError = std::string(fileName) + " : " + chunk.error;
+			return false;
+		}
+	}
+
+	// g / o で区切ってシェイプにする (面の無いシェイプは作らない)
+	std::string name;
+	size_t firstIndex = 0;
+	for (const Chunk& chunk : chunks)
+	{
+		for (const auto& group : chunk.groups)
+		{
+			const size_t groupIndex = chunk.firstIndex + group.first;
+			if (groupIndex > firstIndex)
+			{
+				mShapes.push_back({ name, firstIndex, groupIndex - firstIndex });
+			}
+			name       = group.second;
+			firstIndex = groupIndex;
+		}
+	}
+	if (mIndices.size() > firstIndex)
+	{
+		mShapes.push_back({ name, firstIndex, mIndices.size() - firstIndex });
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////
+// 範囲内の行を解析する (スレッドから呼ばれる)
+////////////////////////////////////////////////
+void ObjParser::parseChunk(Chunk* chunk)
+{
+	std::vector<ObjIndex> face;
+	const char* line = chunk->begin;
+	while (line < chunk->end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(chunk->end - line)));
+		const char* next    = lineEnd ? lineEnd + 1 : chunk->end;
+		if (!lineEnd)
+		{
+			lineEnd = chunk->end;
+		}
+		chunk->lineNum++;
+
+		const char* p = line;
+		line = next;
+		skipSpace(p, lineEnd);
+		if (lineEnd - p < 2)
+		{
+			continue;
+		}
+
+		const char* error = nullptr;
+		if (p[0] == 'v' && isSpace(p[1]))
+		{
+			p += 2;
+			if (!parseFloats(p, lineEnd, 3, chunk->positions))
+			{
+				error = "頂点座標が不正";
+			}
+		}
+		else if (p[0] == 'v' && p[1] == 'n' && p + 2 < lineEnd && isSpace(p[2]))
+		{
+			p += 3;
+			if (!parseFloats(p, lineEnd, 3, chunk->normals))
+			{
+				error = "法線が不正";
+			}
+		}
+		else if (p[0] == 'v' && p[1] == 't' && p + 2 < lineEnd && isSpace(p[2]))
+		{
+			p += 3;
+			if (!parseFloats(p, lineEnd, 2, chunk->texcoords))
+			{
+				error = "テクスチャ座標が不正";
+			}
+		}
+		else if (p[0] == 'f' && isSpace(p[1]))
+		{
+			// v, v/vt, v//vn, v/vt/vn
+			face.clear();
+			for (p += 2, skipSpace(p, lineEnd); p < lineEnd && !error; skipSpace(p, lineEnd))
+			{
+				ObjIndex corner = { -1, -1, -1 };
+				if (!parseIndex(p, lineEnd, chunk->positions.size() / 3, corner.vertex))
+				{
+					error = "面の頂点番号が不正";
+					break;
+				}
+				if (p < lineEnd && *p == '/')
+				{
+					p++;
+					if (p < lineEnd && *p != '/' && !parseIndex(p, lineEnd, chunk->texcoords.size() / 2, corner.texcoord))
+					{
+						error = "面のテクスチャ座標番号が不正";
+					}
+					if (p < lineEnd && *p == '/')
+					{
+						p++;
+						if (!parseIndex(p, lineEnd, chunk->normals.size() / 3, corner.normal))
+						{
+							error = "面の法線番号が不正";
+						}
+					}
+				}
+				if (p < lineEnd && !isSpace(*p))
+				{
+					error = "面の書式が不正";
+				}
+				face.push_back(corner);
+			}
+
+			// 扇状に三角形に分割 (3頂点未満の面は捨てる)
+			for (size_t i = 2; i < face.size() && !error; i++)
+			{
+				chunk->indices.push_back(face[0]);
+				chunk->indices.push_back(face[i - 1]);
+				chunk->indices.push_back(face[i]);
+			}
+		}
+		else if ((p[0] == 'g' || p[0] == 'o') && isSpace(p[1]))
+		{
+			const char* nameBegin = p + 2;
+			const char* nameEnd   = lineEnd;
+			skipSpace(nameBegin, nameEnd);
+			while (nameEnd > nameBegin && isSpace(nameEnd[-1]))
+			{
+				nameEnd--;
+			}
+			chunk->groups.emplace_back(chunk->indices.size(), std::string(nameBegin, nameEnd));
+		}
+
+		if (error)
+		{
+			chunk->error     = error;
+			chunk->errorLine = chunk->lineNum;
+			return;
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// 範囲の解析結果を連結先にコピーし、相対インデックスを絶対インデックスに直す (スレッドから呼ばれる)
+// 範囲外を参照するインデックスがあれば chunk->error に理由を入れる
+////////////////////////////////////////////////
+void ObjParser::mergeChunk(ObjParser* parser, Chunk* chunk)
+{
+	std::copy(chunk->positions.begin(), chunk->positions.end(), parser->mPositions.begin() + chunk->firstPosition);
+	std::copy(chunk->normals.begin(), chunk->normals.end(), parser->mNormals.begin() + chunk->firstNormal);
+	std::copy(chunk->texcoords.begin(), chunk->texcoords.end(), parser->mTexcoords.begin() + chunk->firstTexcoord);
+
+	const long long positionBase = static_cast<long long>(chunk->firstPosition / 3);
+	const long long normalBase   = static_cast<long long>(chunk->firstNormal / 3);
+	const long long texcoordBase = static_cast<long long>(chunk->firstTexcoord / 2);
+	const long long positionNum  = static_cast<long long>(parser->mPositions.size() / 3);
+	const long long normalNum    = static_cast<long long>(parser->mNormals.size() / 3);
+	const long long texcoordNum  = static_cast<long long>(parser->mTexcoords.size() / 2);
+
+	bool outOfRange = false;
+	ObjIndex* dest = parser->mIndices.data() + chunk->firstIndex;
+	for (const ObjIndex& src : chunk->indices)
+	{
+		long long vertex   = src.vertex < -1 ? positionBase + src.vertex + relativeBias : src.vertex;
+		long long normal   = src.normal < -1 ? normalBase + src.normal + relativeBias : src.normal;
+		long long texcoord = src.texcoord < -1 ? texcoordBase + src.texcoord + relativeBias : src.texcoord;
+
+		// 範囲内では省略だけが-1 (相対インデックスは-1より小さく持つ) なので、省略かどうかは直す前の値で見る
+		// 指定された番号は直した結果が-1 (先頭より前を指す相対インデックス) でも範囲外にする
+		const bool hasNormal   = src.normal != -1;
+		const bool hasTexcoord = src.texcoord != -1;
+		outOfRange |= vertex < 0 || vertex >= positionNum;
+		outOfRange |= hasNormal && (normal < 0 || normal >= normalNum);
+		outOfRange |= hasTexcoord && (texcoord < 0 || texcoord >= texcoordNum);
+		*dest++ = { static_cast<int>(vertex), static_cast<int>(normal), static_cast<int>(texcoord) };
+	}
+	if (outOfRange)
+	{
+		chunk->error = "面のインデックスが範囲外";
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// 面のコーナーが参照する位置・法線・UVの番号 (0始まり、指定が無ければ-1)
+struct ObjIndex
+{
+	int vertex;
+	int normal;
+	int texcoord;
+};
+
+// g / o で区切られた面のまとまり (面の無いまとまりは作らない)
+struct ObjShape
+{
+	std::string name;
+	size_t      firstIndex;   // getIndices() の先頭
+	size_t      indexCount;   // インデックス数 (三角形数 × 3)
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// OBJファイルの高速な読み込み
+// ファイルをメモリマップし、行の途中で切れないように分けた範囲をスレッドごとに解析する
+// (v / vn / vt / f / g / o のみ。マテリアル・線・点などその他の行は読み飛ばす)
+// 範囲ごとの結果は最後に連結し、範囲の先頭までの頂点数で負の(相対)インデックスを直す
+// 多角形の面は最初の頂点を中心に扇状に三角形に分割する
+///////////////////////////////////////////////////////////////////////////////////////
+class ObjParser
+{
+public:
+	static const size_t mChunkBytesMin = 1 << 20; // 1スレッドに割り当てる最小のバイト数
+
+	ObjParser();
+
+	bool                         parse(const char* fileName);   // ファイルを解析する (失敗したらgetError()に理由)
+	void                         clear();
+
+	const std::vector<float>&    getPositions() const { return mPositions; }  // x,y,z
+	const std::vector<float>&    getNormals() const { return mNormals; }      // nx,ny,nz
+	const std::vector<float>&    getTexcoords() const { return mTexcoords; }  // u,v
+	const std::vector<ObjIndex>& getIndices() const { return mIndices; }      // 三角形リスト
+	const std::vector<ObjShape>& getShapes() const { return mShapes; }
+	const std::string&           getError() const { return mError; }
+	unsigned int                 getThreadNum() const { return mThreadNum; }  // 直前の解析で使ったスレッド数
+
+private:
+	struct Chunk;
+
+	ObjParser(const ObjParser&) = delete;
+	ObjParser& operator=(const ObjParser&) = delete;
+
+	static void parseChunk(Chunk* chunk);
+	static void mergeChunk(ObjParser* parser, Chunk* chunk);
+
+	std::vector<float>    mPositions;
+	std::vector<float>    mNormals;
+	std::vector<float>    mTexcoords;
+	std::vector<ObjIndex> mIndices;
+	std::vector<ObjShape> mShapes;
+	std::string           mError;
+	unsigned int          mThreadNum;
+};
@@ -0,0 +1,215 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "ProgramCache.h"
+
+// キャッシュファイルの先頭
+struct ProgramBinaryHeader
+{
+	char               magic[4];          // "PBIN"
+	unsigned int       version;           // ファイル形式のバージョン
+	unsigned long long key;               // キャッシュキー (ファイル名と一致すること)
+	unsigned int       binaryFormat;      // glGetProgramBinaryの形式
+	unsigned int       binaryLength;      // バイナリのバイト数
+	float              coldMilliseconds;  // コンパイルにかかった時間
+	unsigned int       padding;
+};
+
+static const char         binaryMagic[4] = { 'P', 'B', 'I', 'N' };
+static const unsigned int binaryVersion  = 1;
+
+// FNV-1a 64bit
+static unsigned long long hashString(unsigned long long hash, const std::string& str)
+{
+	for (unsigned char c : str)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	// 連結の境界を区別する
+	hash ^= 0xff;
+	hash *= 1099511628211ull;
+	return hash;
+}
+
+static void makeDirectory(const std::string& directory)
+{
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+}
+
+ProgramCache::ProgramCache()
+	: mDirectory("shader_cache")
+	, mEnable(true)
+	, mSupported(-1)
+{
+}
+
+bool ProgramCache::isSupported()
+{
+	if (mSupported < 0)
+	{
+		GLint formatNum = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatNum);
+		mSupported = formatNum > 0 ? 1 : 0;
+		if (!mSupported)
+		{
+			std::cout << "ProgramCache : プログラムバイナリ非対応のドライバなのでキャッシュしません" << std::endl;
+		}
+	}
+	return mEnable && mSupported == 1;
+}
+
+std::string ProgramCache::getFilePath(unsigned long long key) const
+{
+	std::ostringstream ss;
+	ss << mDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+	return ss.str();
+}
+
+/////////////////////////////////////////////////
+// キャッシュキーを作る
+// ソースが同じでもドライバやGPUが変わればバイナリは使えないので、GL_RENDERER と GL_VERSION も含める
+////////////////////////////////////////////////
+unsigned long long ProgramCache::makeKey(const std::string& vertexCode, const std::string& fragmentCode)
+{
+	if (mDriverId.empty())
+	{
+		const GLubyte* renderer = glGetString(GL_RENDERER);
+		const GLubyte* version  = glGetString(GL_VERSION);
+		mDriverId = std::string(renderer ? reinterpret_cast<const char*>(renderer) : "") + "|" +
+		            std::string(version ? reinterpret_cast<const char*>(version) : "");
+	}
+
+	unsigned long long hash = 14695981039346656037ull;
+	hash = hashString(hash, vertexCode);
+	hash = hashString(hash, fragmentCode);
+	hash = hashString(hash, mDriverId);
+	return hash;
+}
+
+/////////////////////////////////////////////////
+// キャッシュからプログラムを読み込む
+// in  : key      makeKeyで作ったキー
+//       program  読み込み先 (glCreateProgram済み、シェーダー未アタッチ)
+// out : リンク済みになればtrue
+//       destColdMilliseconds  キャッシュ作成時のコンパイル時間
+////////////////////////////////////////////////
+bool ProgramCache::load(unsigned long long key, GLuint program, float& destColdMilliseconds)
+{
+	if (!isSupported())
+	{
+		return false;
+	}
+
+	std::ifstream file(getFilePath(key), std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	ProgramBinaryHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0 ||
+		header.version != binaryVersion || header.key != key)
+	{
+		return false;
+	}
+
+	std::vector<char> binary(header.binaryLength);
+	if (!file.read(binary.data(), binary.size()))
+	{
+		return false;
+	}
+
+	// ドライバが受け付けなければリンク失敗になる (エラーは出さずにコンパイルに戻る)
+	glProgramBinary(program, header.binaryFormat, binary.data(), header.binaryLength);
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		return false;
+	}
+
+	destColdMilliseconds = header.coldMilliseconds;
+	return true;
+}
+
+/////////////////////////////////////////////////
+// リンク済みプログラムのバイナリを保存する
+// リンク前に GL_PROGRAM_BINARY_RETRIEVABLE_HINT を設定しておくこと
+// in : key               makeKeyで作ったキー
+//      program           リンク済みのプログラム
+//      coldMilliseconds  コンパイル～リンクにかかった時間 (次回のレポート用)
+////////////////////////////////////////////////
+void ProgramCache::store(unsigned long long key, GLuint program, float coldMilliseconds)
+{
+	if (!isSupported())
+	{
+		return;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	ProgramBinaryHeader header = {};
+	memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+	header.version          = binaryVersion;
+	header.key              = key;
+	header.binaryFormat     = format;
+	header.binaryLength     = static_cast<unsigned int>(length);
+	header.coldMilliseconds = coldMilliseconds;
+
+	makeDirectory(mDirectory);
+	std::ofstream file(getFilePath(key), std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << getFilePath(key) << std::endl;
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(binary.data(), length);
+}
+
+void ProgramCache::addRecord(const std::string& name, bool cacheHit, float milliseconds, float coldMilliseconds)
+{
+	mRecords.push_back({ name, cacheHit, milliseconds, coldMilliseconds });
+}
+
+void ProgramCache::printReport(std::ostream& os) const
+{
+	float total = 0.0f, coldTotal = 0.0f;
+	unsigned int hitNum = 0;
+
+	os << "shader program load (ms)   cold / this launch" << std::endl;
+	for (const LoadRecord& record : mRecords)
+	{
+		os << "  " << std::left << std::setw(56) << record.name << std::right << std::fixed << std::setprecision(2)
+		   << std::setw(8) << record.coldMilliseconds << " / " << std::setw(8) << record.milliseconds
+		   << (record.cacheHit ? "  (cache)" : "  (compiled)") << std::endl;
+		total     += record.milliseconds;
+		coldTotal += record.coldMilliseconds;
+		hitNum    += record.cacheHit ? 1 : 0;
+	}
+	os << "  total : " << coldTotal << " / " << total << "  cache hits " << hitNum << " / " << mRecords.size() << std::endl;
+	os.unsetf(std::ios::fixed);
+	os << std::setprecision(6);
+}
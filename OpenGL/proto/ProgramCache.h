@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <ostream>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// プログラムバイナリのディスクキャッシュ
+// 頂点/フラグメントのソースと GL_RENDERER / GL_VERSION からキーを作り、
+// glGetProgramBinary の結果を mDirectory/<キー>.bin に保存する
+// 次回起動時は glProgramBinary で読み込み、ドライバに拒否されたらコンパイルに戻る
+// (ドライバ更新などでバイナリが使えなくなった場合も、コンパイル後に上書きされる)
+//
+// キャッシュのヒット/ミスとプログラムごとの読み込み時間を記録し、起動時のレポートに使う
+///////////////////////////////////////////////////////////////////////////////////////
+class ProgramCache
+{
+public:
+	static ProgramCache& ProgramCacheInstance()       // インスタンス
+	{
+		static ProgramCache ProgramCacheInstance;
+		return ProgramCacheInstance;
+	}
+
+	~ProgramCache() {};
+
+	void         setDirectory(const std::string& directory) { mDirectory = directory; } // キャッシュの保存先
+	void         setEnable(bool enable) { mEnable = enable; }                            // 無効にすると常にコンパイル
+
+	// キャッシュの読み書き (GLコンテキストがカレントであること)
+	unsigned long long makeKey(const std::string& vertexCode, const std::string& fragmentCode); // キャッシュキー
+	bool         load(unsigned long long key, GLuint program, float& destColdMilliseconds);   // バイナリを読み込みリンク済みにする
+	void         store(unsigned long long key, GLuint program, float coldMilliseconds);       // リンク済みプログラムのバイナリを保存
+
+	// 起動時間のレポート
+	void         addRecord(const std::string& name, bool cacheHit, float milliseconds, float coldMilliseconds);
+	void         printReport(std::ostream& os) const; // プログラムごとのコールド/ウォーム読み込み時間
+
+private:
+	ProgramCache(); // シングルトン
+
+	bool         isSupported();                      // バイナリ形式が1つ以上あるか (初回に問い合わせる)
+	std::string  getFilePath(unsigned long long key) const;
+
+	// プログラム1つ分の読み込み記録
+	struct LoadRecord
+	{
+		std::string name;              // シェーダーファイル名
+		bool        cacheHit;          // キャッシュから読めたか
+		float       milliseconds;      // 今回の読み込み時間
+		float       coldMilliseconds;  // コンパイル時の読み込み時間 (ヒット時はキャッシュに記録された値)
+	};
+
+	std::string             mDirectory;       // 保存先ディレクトリ
+	bool                    mEnable;          // キャッシュを使うか
+	int                     mSupported;       // バイナリ対応 (-1:未確認 0:なし 1:あり)
+	std::string             mDriverId;        // GL_RENDERER + GL_VERSION (キーに含める)
+	std::vector<LoadRecord> mRecords;         // 読み込み記録
+};
+
+#define PROGRAM_CACHE_INSTANCE ProgramCache::ProgramCacheInstance()
@@ -0,0 +1,298 @@
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "MeshObj.h"
+#include "InstanceBatch.h"
+#include "RenderState.h"
+
+// キーの各フィールドのビット幅とシフト量
+static const int      depthBits        = 24;
+static const int      meshBits         = 12;
+static const int      textureSetBits   = 12;
+static const int      programBits      = 8;
+static const int      meshShift        = depthBits;
+static const int      textureSetShift  = meshShift + meshBits;
+static const int      programShift     = textureSetShift + textureSetBits;
+
+static uint64_t maskBits(uint64_t value, int bits)
+{
+	return value & ((uint64_t(1) << bits) - 1);
+}
+
+RenderQueue::RenderQueue()
+	: mIndirectBuffer(0)
+	, mIndirectCapacity(0)
+	, mMaxDepth(1000.0f)
+{
+	for (int i = 0; i < RenderPass_Num; i++)
+	{
+		mDrawCount[i]     = 0;
+		mCommandCount[i]  = 0;
+		mInstanceCount[i] = 0;
+		mCulledCount[i]   = 0;
+		mTriangleCount[i] = 0;
+		for (unsigned int lod = 0; lod < MeshObj::mLodMax; lod++)
+		{
+			mLodInstanceCount[i][lod] = 0;
+		}
+	}
+}
+
+RenderQueue::~RenderQueue()
+{
+	glDeleteBuffers(1, &mIndirectBuffer);
+}
+
+void RenderQueue::clear()
+{
+	for (int i = 0; i < RenderPass_Num; i++)
+	{
+		mItems[i].clear();
+		mEntries[i].clear();
+		mCulledCount[i] = 0;
+	}
+	mTextureSetIDs.clear();
+}
+
+void RenderQueue::enqueue(RenderPassEnum pass, const DrawItem& item)
+{
+	if (!item.shader || !item.mesh || !item.instances || item.instanceCount == 0)
+	{
+		return;
+	}
+
+	SortEntry entry;
+	entry.key   = makeKey(item);
+	entry.index = static_cast<uint32_t>(mItems[pass].size());
+	mItems[pass].emplace_back(item);
+	mEntries[pass].emplace_back(entry);
+}
+
+/////////////////////////////////////////////////
+// 描画アイテムからソートキーを作成
+// 深度は [0, mMaxDepth] を24bitに量子化し、手前ほど小さい値にする
+////////////////////////////////////////////////
+uint64_t RenderQueue::makeKey(const DrawItem& item)
+{
+	float depth = Math::Clamp(item.depth / mMaxDepth, 0.0f, 1.0f);
+	uint64_t depthKey = static_cast<uint64_t>(depth * ((1 << depthBits) - 1));
+
+	uint64_t key = 0;
+	key |= maskBits(item.shader->GetID(), programBits) << programShift;
+	key |= maskBits(getTextureSetID(item.textures), textureSetBits) << textureSetShift;
+	key |= maskBits(item.mesh->getVAO(), meshBits) << meshShift;
+	key |= maskBits(depthKey, depthBits);
+	return key;
+}
+
+uint32_t RenderQueue::getTextureSetID(const TextureBindings* textures)
+{
+	if (!textures)
+	{
+		return 0;
+	}
+
+	// 同じテクスチャセットは同じ番号になるよう、フレーム内で初出順に番号を振る
+	auto it = mTextureSetIDs.find(textures);
+	if (it != mTextureSetIDs.end())
+	{
+		return it->second;
+	}
+	uint32_t id = static_cast<uint32_t>(mTextureSetIDs.size()) + 1;
+	mTextureSetIDs[textures] = id;
+	return id;
+}
+
+/////////////////////////////////////////////////
+// 64bitキーのLSD基数ソート (8bitずつ8パス)
+// 全要素で同じ値になる桁はスキップする
+////////////////////////////////////////////////
+void RenderQueue::radixSort(std::vector<SortEntry>& entries)
+{
+	const size_t num = entries.size();
+	if (num < 2)
+	{
+		return;
+	}
+	mSortWork.resize(num);
+
+	std::vector<SortEntry>* src = &entries;
+	std::vector<SortEntry>* dst = &mSortWork;
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		uint32_t count[256] = { 0 };
+		for (size_t i = 0; i < num; i++)
+		{
+			count[((*src)[i].key >> shift) & 0xFF]++;
+		}
+
+		// 全要素が同じバケットならこの桁は並び替え不要
+		if (count[((*src)[0].key >> shift) & 0xFF] == num)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			uint32_t c = count[b];
+			count[b] = offset;
+			offset += c;
+		}
+		for (size_t i = 0; i < num; i++)
+		{
+			const SortEntry& e = (*src)[i];
+			(*dst)[count[(e.key >> shift) & 0xFF]++] = e;
+		}
+		std::swap(src, dst);
+	}
+
+	if (src != &entries)
+	{
+		entries.swap(mSortWork);
+	}
+}
+
+/////////////////////////////////////////////////
+// パスの描画アイテムをソートして発行する
+// FBO・ビューポート等のパス単位の設定は呼び出し側で済ませておくこと
+////////////////////////////////////////////////
+void RenderQueue::submit(RenderPassEnum pass)
+{
+	std::vector<SortEntry>& entries = mEntries[pass];
+	std::vector<DrawItem>&  items   = mItems[pass];
+	radixSort(entries);
+
+	// ソート順に描画コマンドを作成 (ビルドが終わっていないシェーダーのアイテムは飛ばす)
+	mCommands.clear();
+	mCommandItems.clear();
+	for (const SortEntry& entry : entries)
+	{
+		const DrawItem& item = items[entry.index];
+		if (!item.shader->isReady())
+		{
+			continue;
+		}
+		DrawElementsIndirectCommand command;
+		if (item.mesh->getDrawCommand(command, item.instanceCount, item.baseInstance, item.lod))
+		{
+			mCommands.emplace_back(command);
+			mCommandItems.emplace_back(entry.index);
+		}
+	}
+
+	const bool useIndirect = GLAD_GL_VERSION_4_3 != 0;
+	if (useIndirect)
+	{
+		uploadCommands();
+	}
+
+	const Shader*                    lastShader   = nullptr;
+	const TextureBindings*           lastTextures = nullptr;
+	mDrawCount[pass]     = 0;
+	mCommandCount[pass]  = 0;
+	mInstanceCount[pass] = 0;
+	mTriangleCount[pass] = 0;
+	for (unsigned int lod = 0; lod < MeshObj::mLodMax; lod++)
+	{
+		mLodInstanceCount[pass][lod] = 0;
+	}
+
+	size_t first = 0;
+	while (first < mCommands.size())
+	{
+		const DrawItem& item = items[mCommandItems[first]];
+
+		// シェーダー・テクスチャセット・VAOが同じ区間を探す
+		size_t last = first + 1;
+		while (last < mCommands.size())
+		{
+			const DrawItem& next = items[mCommandItems[last]];
+			if (next.shader != item.shader || next.textures != item.textures || next.mesh->getVAO() != item.mesh->getVAO())
+			{
+				break;
+			}
+			last++;
+		}
+
+		if (item.shader != lastShader)
+		{
+			item.shader->use();
+			lastShader = item.shader;
+		}
+		if (item.textures && item.textures != lastTextures)
+		{
+			// マテリアルのテクスチャ配列は GL_TEXTURE_2D_ARRAY にバインドする
+			const TextureBindings& bindings = *item.textures;
+			for (unsigned int i = 0; i < bindings.textures.size(); i++)
+			{
+				RENDER_STATE_INSTANCE.bindTexture(i, bindings.targets[i], bindings.textures[i]);
+			}
+			lastTextures = item.textures;
+		}
+		RENDER_STATE_INSTANCE.bindVertexArray(item.mesh->getVAO());
+
+		drawCommands(first, last - first, item.mesh->getIndexType(), useIndirect);
+		mDrawCount[pass] += useIndirect ? 1 : static_cast<unsigned int>(last - first);
+		mCommandCount[pass] += static_cast<unsigned int>(last - first);
+		for (size_t i = first; i < last; i++)
+		{
+			mInstanceCount[pass] += mCommands[i].instanceCount;
+			mTriangleCount[pass] += mCommands[i].count / 3 * mCommands[i].instanceCount;
+			mLodInstanceCount[pass][Math::Min(items[mCommandItems[i]].lod, MeshObj::mLodMax - 1)] += mCommands[i].instanceCount;
+		}
+
+		first = last;
+	}
+
+	if (useIndirect)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
+
+/////////////////////////////////////////////////
+// パスの描画コマンドをまとめて間接描画バッファに転送する
+// 毎フレーム書き換えるので、前フレームの内容は再確保で切り離してから書き込む
+////////////////////////////////////////////////
+void RenderQueue::uploadCommands()
+{
+	if (mIndirectBuffer == 0)
+	{
+		glGenBuffers(1, &mIndirectBuffer);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mIndirectBuffer);
+
+	const unsigned int count = static_cast<unsigned int>(mCommands.size());
+	if (count > mIndirectCapacity)
+	{
+		mIndirectCapacity = count;
+	}
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * mIndirectCapacity, NULL, GL_STREAM_DRAW);
+	if (count > 0)
+	{
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * count, mCommands.data());
+	}
+}
+
+/////////////////////////////////////////////////
+// 描画コマンドの区間 [first, first + count) を発行する
+// VAOはバインド済みであること
+////////////////////////////////////////////////
+void RenderQueue::drawCommands(size_t first, size_t count, GLenum indexType, bool useIndirect)
+{
+	if (useIndirect)
+	{
+		glMultiDrawElementsIndirect(GL_TRIANGLES, indexType,
+			(void*)(sizeof(DrawElementsIndirectCommand) * first), static_cast<GLsizei>(count), 0);
+		return;
+	}
+
+	// GL4.3未満 : コマンドを1つずつbaseVertex/baseInstance付きで発行
+	for (size_t i = first; i < first + count; i++)
+	{
+		const DrawElementsIndirectCommand& command = mCommands[i];
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, indexType,
+			(void*)(static_cast<size_t>(MeshObj::getIndexBytes(indexType)) * command.firstIndex), command.instanceCount, command.baseVertex, command.baseInstance);
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "GeometryArena.h"
+
+class Shader;
+class MeshObj;
+class InstanceBatch;
+
+// テクスチャセット (ユニット0から順にバインドするテクスチャ名とターゲット)
+// ターゲットは作る側が決めておき、描画時にTextureRegistryを引かないで済むようにする
+struct TextureBindings
+{
+	std::vector<GLuint> textures;   // ユニット順のテクスチャ名 (0なら何もバインドしない)
+	std::vector<GLenum> targets;    // 同じユニットのターゲット (GL_TEXTURE_2D / GL_TEXTURE_2D_ARRAY)
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 描画アイテム
+// 1回のドローコールに必要な情報（プログラム・テクスチャセット・メッシュ・インスタンス・深度）
+///////////////////////////////////////////////////////////////////////////////////////
+struct DrawItem
+{
+	Shader*                          shader    = nullptr;  // 描画に使うシェーダー
+	const TextureBindings*           textures  = nullptr;  // テクスチャセット (ユニット0から順にバインド / nullptrならバインドしない)
+	const MeshObj*                   mesh      = nullptr;  // メッシュ
+	const InstanceBatch*             instances = nullptr;  // インスタンスバッファ
+	float                            depth     = 0.0f;     // カメラからの距離 (ソート用)
+	unsigned int                     baseInstance  = 0;    // インスタンスバッファ内の開始位置
+	unsigned int                     instanceCount = 0;    // 描画するインスタンス数 (0なら描画しない)
+	unsigned int                     lod           = 0;    // 描画するメッシュのLOD
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// ソートキー付き描画キュー
+// 各パスのバケットに描画アイテムを積み、64bitキーを基数ソートしてから発行する
+//
+// キーのビット割り当て (上位から)
+//   63-56 : 予約 (レイヤー)
+//   55-48 : プログラム
+//   47-36 : テクスチャセット
+//   35-24 : メッシュ
+//   23- 0 : 深度 (手前から奥へ昇順)
+// ステート切り替えの少ない順に並べ、同一ステート内は手前から描画して早期深度テストを効かせる
+//
+// ソート後、シェーダー・テクスチャセット・VAOが同じ連続区間を1回のマルチドローにまとめる
+// (ジオメトリアリーナのメッシュはVAOを共有するので1区間になる)
+// GL4.3以上なら間接描画バッファ + glMultiDrawElementsIndirect、
+// それ未満ならコマンドごとに glDrawElementsInstancedBaseVertexBaseInstance で発行する
+///////////////////////////////////////////////////////////////////////////////////////
+class RenderQueue
+{
+public:
+	enum RenderPassEnum
+	{
+		RenderPass_Shadow,      // シャドウマップパス
+		RenderPass_Opaque,      // 不透明パス
+		RenderPass_Num
+	};
+
+	RenderQueue();
+	~RenderQueue();
+
+	void         clear();                                          // 全パスのバケットをクリア (毎フレーム先頭で呼ぶ)
+	void         setDepthRange(float maxDepth) { mMaxDepth = maxDepth; } // 深度キーの正規化範囲
+	void         enqueue(RenderPassEnum pass, const DrawItem& item); // 描画アイテムを積む
+	void         submit(RenderPassEnum pass);                      // ソートして描画発行
+
+	// パスごとの統計
+	void         addCulledCount(RenderPassEnum pass, unsigned int culled) { mCulledCount[pass] += culled; } // カリングされたインスタンス数を加算
+	unsigned int getDrawCount(RenderPassEnum pass) const { return mDrawCount[pass]; }         // 直近のsubmitで発行したドローコール数 (マルチドローは1回)
+	unsigned int getCommandCount(RenderPassEnum pass) const { return mCommandCount[pass]; }   // 直近のsubmitで発行した描画コマンド数
+	unsigned int getInstanceCount(RenderPassEnum pass) const { return mInstanceCount[pass]; } // 直近のsubmitで描画したインスタンス数
+	unsigned int getLodInstanceCount(RenderPassEnum pass, unsigned int lod) const { return mLodInstanceCount[pass][lod]; } // 直近のsubmitでそのLODで描画したインスタンス数
+	unsigned int getTriangleCount(RenderPassEnum pass) const { return mTriangleCount[pass]; } // 直近のsubmitで描画した三角形数
+	unsigned int getCulledCount(RenderPassEnum pass) const { return mCulledCount[pass]; }     // このフレームでカリングされたインスタンス数
+
+private:
+	struct SortEntry
+	{
+		uint64_t key;    // ソートキー
+		uint32_t index;  // バケット内の描画アイテムのインデックス
+	};
+
+	uint64_t     makeKey(const DrawItem& item);                    // ソートキーの作成
+	uint32_t     getTextureSetID(const TextureBindings* textures); // テクスチャセットの通し番号
+	void         radixSort(std::vector<SortEntry>& entries);       // キーの基数ソート(LSD 8bit x 8)
+	void         uploadCommands();                                 // 描画コマンドを間接描画バッファに転送
+	void         drawCommands(size_t first, size_t count, GLenum indexType, bool useIndirect); // 描画コマンドの区間を発行 (VAOが同じ区間なのでインデックスの型も同じ)
+
+	std::vector<DrawItem>                           mItems[RenderPass_Num];   // パスごとのバケット
+	std::vector<SortEntry>                          mEntries[RenderPass_Num]; // パスごとのソートキー
+	std::vector<SortEntry>                          mSortWork;                // 基数ソート用作業領域
+	std::unordered_map<const void*, uint32_t>       mTextureSetIDs;           // テクスチャセット → 通し番号
+	std::vector<DrawElementsIndirectCommand>        mCommands;                // ソート順の描画コマンド
+	std::vector<uint32_t>                           mCommandItems;            // 描画コマンドに対応する描画アイテムのインデックス
+	GLuint                                          mIndirectBuffer;          // 間接描画バッファ
+	unsigned int                                    mIndirectCapacity;        // 間接描画バッファの確保済みコマンド数
+	unsigned int                                    mDrawCount[RenderPass_Num];
+	unsigned int                                    mCommandCount[RenderPass_Num];
+	unsigned int                                    mInstanceCount[RenderPass_Num];
+	unsigned int                                    mLodInstanceCount[RenderPass_Num][MeshObj::mLodMax];
+	unsigned int                                    mTriangleCount[RenderPass_Num];
+	unsigned int                                    mCulledCount[RenderPass_Num];
+	float                                           mMaxDepth;                // 深度キーの最大距離
+};
@@ -0,0 +1,160 @@
+#include "RenderState.h"
+
+// 不明な状態を表すID（どのGLオブジェクトとも一致しない値）
+static const GLuint unknownID = 0xFFFFFFFF;
+
+RenderState::RenderState()
+	: mIssuedCount(0)
+	, mElidedCount(0)
+{
+	invalidate();
+}
+
+void RenderState::invalidate()
+{
+	mProgram    = unknownID;
+	mVAO        = unknownID;
+	mFBO        = unknownID;
+	mActiveUnit = unknownID;
+	for (unsigned int i = 0; i < mMaxTextureUnitNum; i++)
+	{
+		mTextures[i]       = unknownID;
+		mTextureTargets[i] = 0;
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		mViewport[i] = -1;
+	}
+	mDepthTest = -1;
+	mBlend     = -1;
+}
+
+bool RenderState::isCached(bool same)
+{
+	if (same)
+	{
+		mElidedCount++;
+		return true;
+	}
+	mIssuedCount++;
+	return false;
+}
+
+void RenderState::useProgram(GLuint program)
+{
+	if (isCached(mProgram == program))
+	{
+		return;
+	}
+	glUseProgram(program);
+	mProgram = program;
+}
+
+void RenderState::bindVertexArray(GLuint vao)
+{
+	if (isCached(mVAO == vao))
+	{
+		return;
+	}
+	glBindVertexArray(vao);
+	mVAO = vao;
+}
+
+/////////////////////////////////////////////////
+// テクスチャユニットにテクスチャをバインドする
+// 既に同じテクスチャがバインドされていればアクティブユニットの切り替えも行わない
+////////////////////////////////////////////////
+void RenderState::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	if (unit >= mMaxTextureUnitNum)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		mActiveUnit = unit;
+		mIssuedCount++;
+		return;
+	}
+
+	if (isCached(mTextures[unit] == texture && mTextureTargets[unit] == target))
+	{
+		return;
+	}
+	if (mActiveUnit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		mActiveUnit = unit;
+	}
+	glBindTexture(target, texture);
+	mTextures[unit]       = texture;
+	mTextureTargets[unit] = target;
+}
+
+void RenderState::bindFramebuffer(GLuint fbo)
+{
+	if (isCached(mFBO == fbo))
+	{
+		return;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	mFBO = fbo;
+}
+
+void RenderState::setViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (isCached(mViewport[0] == x && mViewport[1] == y && mViewport[2] == width && mViewport[3] == height))
+	{
+		return;
+	}
+	glViewport(x, y, width, height);
+	mViewport[0] = x;
+	mViewport[1] = y;
+	mViewport[2] = width;
+	mViewport[3] = height;
+}
+
+void RenderState::setDepthTest(bool enable)
+{
+	if (isCached(mDepthTest == (enable ? 1 : 0)))
+	{
+		return;
+	}
+	enable ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+	mDepthTest = enable ? 1 : 0;
+}
+
+void RenderState::setBlend(bool enable)
+{
+	if (isCached(mBlend == (enable ? 1 : 0)))
+	{
+		return;
+	}
+	enable ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	mBlend = enable ? 1 : 0;
+}
+
+void RenderState::onDeleteVertexArray(GLuint vao)
+{
+	if (mVAO == vao)
+	{
+		mVAO = 0;
+	}
+}
+
+void RenderState::onDeleteTexture(GLuint texture)
+{
+	for (unsigned int i = 0; i < mMaxTextureUnitNum; i++)
+	{
+		if (mTextures[i] == texture)
+		{
+			mTextures[i] = 0;
+		}
+	}
+}
+
+void RenderState::onDeleteFramebuffer(GLuint fbo)
+{
+	if (mFBO == fbo)
+	{
+		mFBO = 0;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <glad/glad.h>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// GLステートキャッシュ
+// 現在のプログラム・VAO・テクスチャユニットごとのバインド・FBO・ビューポート・
+// デプス/ブレンドの有効状態を記録し、同じ値の再設定はドライバに渡さず破棄する
+// GLの状態を変更するコードは必ずこのクラスを経由すること
+///////////////////////////////////////////////////////////////////////////////////////
+class RenderState
+{
+public:
+	static const unsigned int mMaxTextureUnitNum = 16;           // 管理するテクスチャユニット数
+
+	static RenderState& RenderStateInstance()                   // インスタンス
+	{
+		static RenderState RenderStateInstance;
+		return RenderStateInstance;
+	}
+
+	~RenderState() {};
+
+	void useProgram(GLuint program);                             // glUseProgram
+	void bindVertexArray(GLuint vao);                            // glBindVertexArray
+	void bindTexture(GLuint unit, GLenum target, GLuint texture);// glActiveTexture + glBindTexture
+	void bindFramebuffer(GLuint fbo);                            // glBindFramebuffer(GL_FRAMEBUFFER)
+	void setViewport(GLint x, GLint y, GLsizei width, GLsizei height); // glViewport
+	void setDepthTest(bool enable);                              // glEnable/glDisable(GL_DEPTH_TEST)
+	void setBlend(bool enable);                                  // glEnable/glDisable(GL_BLEND)
+
+	// オブジェクト削除時の通知（削除されたオブジェクトのバインドは0に戻る）
+	void onDeleteVertexArray(GLuint vao);
+	void onDeleteTexture(GLuint texture);
+	void onDeleteFramebuffer(GLuint fbo);
+
+	void invalidate();                                           // キャッシュを破棄（外部でGL状態を変更した場合）
+
+	// フレームごとの統計
+	void         resetFrameStats() { mIssuedCount = 0; mElidedCount = 0; }
+	unsigned int getIssuedCount() const { return mIssuedCount; }  // ドライバに発行したステート変更数
+	unsigned int getElidedCount() const { return mElidedCount; }  // 冗長として破棄したステート変更数
+
+private:
+	RenderState(); // シングルトン
+
+	bool         isCached(bool same);                           // 統計を更新しつつキャッシュヒットか判定
+
+	GLuint       mProgram;                                      // 現在のプログラム
+	GLuint       mVAO;                                          // 現在のVAO
+	GLuint       mFBO;                                          // 現在のFBO
+	GLuint       mActiveUnit;                                   // 現在のアクティブテクスチャユニット
+	GLuint       mTextures[mMaxTextureUnitNum];                 // ユニットごとのテクスチャ
+	GLenum       mTextureTargets[mMaxTextureUnitNum];           // ユニットごとのテクスチャターゲット
+	GLint        mViewport[4];                                  // ビューポート
+	int          mDepthTest;                                    // デプステスト (-1:不明 0:無効 1:有効)
+	int          mBlend;                                        // ブレンド     (-1:不明 0:無効 1:有効)
+
+	unsigned int mIssuedCount;                                  // 発行数
+	unsigned int mElidedCount;                                  // 破棄数
+};
+
+#define RENDER_STATE_INSTANCE RenderState::RenderStateInstance()
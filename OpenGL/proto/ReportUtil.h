@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 計測結果を集計・書き出す時の共通処理
+// GpuProfiler・FrameTimerの統計やベンチマークの結果JSONで使う
+///////////////////////////////////////////////////////////////////////////////////////
+namespace ReportUtil
+{
+	// ソート済み配列からパーセンタイル値を取り出す (最も近い順位の値、空なら0)
+	template <typename T>
+	T percentile(const std::vector<T>& sorted, double p)
+	{
+		if (sorted.empty())
+		{
+			return T();
+		}
+		size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+		return sorted[index < sorted.size() ? index : sorted.size() - 1];
+	}
+
+	// JSON文字列用のエスケープ (" と \ と制御文字。Windowsのパスや GL_RENDERER の文字列をそのまま書けるようにする)
+	inline std::string escapeJson(const std::string& src)
+	{
+		std::string dst;
+		dst.reserve(src.size());
+		for (char c : src)
+		{
+			switch (c)
+			{
+			case '"':  dst += "\\\""; break;
+			case '\\': dst += "\\\\"; break;
+			case '\n': dst += "\\n";  break;
+			case '\r': dst += "\\r";  break;
+			case '\t': dst += "\\t";  break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char code[8];
+					snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+					dst += code;
+				}
+				else
+				{
+					dst += c;
+				}
+				break;
+			}
+		}
+		return dst;
+	}
+}
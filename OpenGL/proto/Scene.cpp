@@ -0,0 +1,374 @@
+#include <iostream>
+#include "Scene.h"
+#include "RenderState.h"
+#include "AssetLoader.h"
+#include "TextureRegistry.h"
+#include "FrameTimer.h"
+
+Scene::Scene()
+	: mLitShader("Shader/lit.vert", "Shader/lit.frag", Shader::BuildMode_Async)
+	, mGridMaterialFeatures(ShaderFeature_Shadows | ShaderFeature_Instanced | ShaderFeature_SpecularMap)
+	, mDepthMapShader("Shader/depthmapInstanced.vert", "Shader/depthmap.frag", Shader::BuildMode_Async)
+	, mSphereShader("Shader/SphereInstanced.vert", "Shader/Sphere.frag", Shader::BuildMode_Async)
+	, mToneMapShader("Shader/screen.vert", "Shader/toneMap.frag", Shader::BuildMode_Async)
+	, mStaticArena(MeshObj::VertexFormatEnum_PackedPosNormalTex, 64 * 1024, 256 * 1024, GL_UNSIGNED_SHORT)
+	, mLightDir(0.5f, 0.5f, -0.5f)
+	, mAmbient(0.4f, 0.4f, 0.4f)
+	, mDiffuse(1.0f, 1.0f, 1.0f)
+	, mSpecular(0.8f, 0.8f, 0.8f)
+	, mLightAnim(0.0f)
+	, mExposure(1.0f)
+	, mSphereUniformsSet(false)
+{
+	mLightDir.Normalize();
+
+	// シャドウマップ
+	glGenFramebuffers(1, &mDepthMapFBO);
+	mDepthMap = TEXTURE_REGISTRY_INSTANCE.createTexture("shadow map", GL_DEPTH_COMPONENT24, mShadowWidth, mShadowHeight);
+	RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D, mDepthMap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// depthMapFBOにデプステクスチャをアタッチする
+	RENDER_STATE_INSTANCE.bindFramebuffer(mDepthMapFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, mDepthMap, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	RENDER_STATE_INSTANCE.bindFramebuffer(0);
+
+	// マテリアル (ワーカースレッドでデコードし、揃うまでは仮の色: アルベドは灰色、スペキュラは黒)
+	// 全マップの大きさと形式が同じマテリアル同士だけが同じテクスチャ配列に入り、1つのマルチドローで描ける
+	// 同梱の床と柱は同じにならない (床のスペキュラーは2048x2048で柱のマップは1024x1024、床のアルベドは無いので床は2Dテクスチャ)
+	// ため、床と柱は別のテクスチャセット・別のマルチドローになる
+	mMaterials.setSharedTexture(2, mDepthMap);
+	mFloorMaterial  = mMaterials.addMaterial("mesh/T_BrickFloor_Clean_A.png", "mesh/T_BrickFloor_Clean_S.png");
+	mPillerMaterial = mMaterials.addMaterial("mesh/T_Edge_Stones_And_Straight_Column_Texturing_Albedo.png",
+		"mesh/T_Edge_Stones_And_Straight_Column_Texturing_Specular.png");
+	mMaterials.build();
+
+	// HDR関連
+	glGenFramebuffers(1, &mHdrFBO);
+	RENDER_STATE_INSTANCE.bindFramebuffer(mHdrFBO);
+	{
+		// FBOに割り当てるためのからのテクスチャを作成
+		// RGBA併せて64bit使う
+		mFloatColorTexture = TEXTURE_REGISTRY_INSTANCE.createTexture("hdr color", GL_RGBA16F, mScreenWidth, mScreenHeight);
+		RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D, mFloatColorTexture);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// FBOにカラーテクスチャとして frameColorTexture をアタッチする
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mFloatColorTexture, 0);
+
+		// レンダーバッファの作成
+		glGenRenderbuffers(1, &mHdrDepthRBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, mHdrDepthRBO);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mScreenWidth, mScreenHeight);
+
+		// FBOにレンダーバッファーをアタッチする
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mHdrDepthRBO);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+		}
+
+		// 元のスクリーンに戻す
+		RENDER_STATE_INSTANCE.bindFramebuffer(0);
+	}
+
+	// スクリーン全体を描く四角形用頂点配列
+	float quadVertices[] = {
+		// ポジション   // テクスチャ座標
+		-1.0f,  1.0f,  0.0f, 1.0f,
+		-1.0f, -1.0f,  0.0f, 0.0f,
+		 1.0f, -1.0f,  1.0f, 0.0f,
+
+		-1.0f,  1.0f,  0.0f, 1.0f,
+		 1.0f, -1.0f,  1.0f, 0.0f,
+		 1.0f,  1.0f,  1.0f, 1.0f
+	};
+
+	// スクリーン全体を描く四角形用 VAO
+	glGenVertexArrays(1, &mQuadVAO);
+	glGenBuffers(1, &mQuadVBO);
+	RENDER_STATE_INSTANCE.bindVertexArray(mQuadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mQuadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+	// 8x8の格子配置をインスタンスバッファに登録
+	mGridBatch.addGrid(8, 8, 6.0f);
+	mGridBatch.upload();
+	mStaticArena.setInstanceBatch(&mGridBatch);
+
+	// メッシュ読み込み (アリーナに移すので頂点フォーマットをアリーナに合わせる)
+	// ワーカースレッドで読み込み、転送が終わった物から各メッシュのVAOにインスタンスバッファを接続して
+	// 静的メッシュを1つのジオメトリアリーナにまとめ、VAOを共有させる
+	const MeshObj::VertexFormat staticFormat = mStaticArena.getFormat();
+	if (MeshObj::isPackedFormat(staticFormat))
+	{
+		mGridMaterialFeatures |= ShaderFeature_PackedVertex;
+	}
+	if (mGridBatch.isRigid())
+	{
+		// 平行移動だけの配置なので法線行列は使わず、モデル行列の3x3で法線を変換する
+		mGridMaterialFeatures |= ShaderFeature_RigidModel;
+	}
+	auto moveToArena = [this](MeshObj& mesh)
+	{
+		mesh.setInstanceBatch(&mGridBatch);
+		mesh.moveToArena(mStaticArena);
+	};
+	Matrix4 scale = Matrix4::CreateScale(0.01f);
+	ASSET_LOADER_INSTANCE.requestMesh(&mFloorMesh, "mesh/SM_Floor_Internal.obj", scale, staticFormat, mStaticArena.getIndexType(), moveToArena);
+	ASSET_LOADER_INSTANCE.requestMesh(&mPillerMesh, "mesh/SM_Pillar_Internal.obj", scale, staticFormat, mStaticArena.getIndexType(), moveToArena);
+
+	// 球体だけずらして表示するために移動行列セット
+	Matrix4 mat = Matrix4::CreateTranslation(Vector3(3.0, 3.0, 3.0));
+	scale = Matrix4::CreateScale(0.1f);
+	mat = scale * mat;
+	ASSET_LOADER_INSTANCE.requestMesh(&mSphereMesh, "mesh/sphere.obj", mat, staticFormat, mStaticArena.getIndexType(), moveToArena);
+
+	// シャドウマップは描画パスより1段粗いLODで描く (影の輪郭は多少粗くても目立たない)
+	mFloorLods[RenderQueue::RenderPass_Shadow].setPolicy(1.0f, 0.25f, 1);
+	mPillerLods[RenderQueue::RenderPass_Shadow].setPolicy(1.0f, 0.25f, 1);
+
+	// サンプラーのテクスチャユニット (ビルド中のシェーダーはリンク後に反映される)
+	mLitShader.setTextureUniformString("diffuseMap", 0);
+	mLitShader.setTextureUniformString("specularMap", 1);
+	mLitShader.setTextureUniformString("depthMap", 2);
+	mLitShader.setTextureUniformString("normalMap", 3);
+
+	// 使うバリアントは起動時にビルドを始めておく (初回の描画で作ると揃うまでそのマテリアルが描かれない)
+	mLitShader.preload(mGridMaterialFeatures | mMaterials.getMaterial(mFloorMaterial).features);
+	mLitShader.preload(mGridMaterialFeatures | mMaterials.getMaterial(mPillerMaterial).features);
+
+	mToneMapShader.setTextureUniformString("hdrBuffer", 0);
+}
+
+Scene::~Scene()
+{
+	// テクスチャの解放 (マテリアルのテクスチャはmMaterialsの破棄時に解放する)
+	TEXTURE_REGISTRY_INSTANCE.release(mDepthMap);
+	TEXTURE_REGISTRY_INSTANCE.release(mFloatColorTexture);
+
+	RENDER_STATE_INSTANCE.onDeleteFramebuffer(mDepthMapFBO);
+	RENDER_STATE_INSTANCE.onDeleteFramebuffer(mHdrFBO);
+	glDeleteFramebuffers(1, &mDepthMapFBO);
+	glDeleteFramebuffers(1, &mHdrFBO);
+	glDeleteRenderbuffers(1, &mHdrDepthRBO);
+
+	RENDER_STATE_INSTANCE.onDeleteVertexArray(mQuadVAO);
+	glDeleteVertexArrays(1, &mQuadVAO);
+	glDeleteBuffers(1, &mQuadVBO);
+}
+
+/////////////////////////////////////////////////
+// ディレクショナルライトを回転させる
+// in : deltaTime  前フレームからの経過時間 (秒)
+////////////////////////////////////////////////
+void Scene::update(float deltaTime)
+{
+	mLightAnim += 0.3f * deltaTime;
+	mLightDir = Vector3(0.5f * sinf(mLightAnim), -0.3f, 0.5f * cosf(mLightAnim));
+	mLightDir.Normalize();
+}
+
+void Scene::setCamera(const Matrix4& view, const Matrix4& projection, const Vector3& viewPos)
+{
+	mViewMat = view;
+	mProjMat = projection;
+	mViewPos = viewPos;
+}
+
+/////////////////////////////////////////////////
+// 1フレーム分を描画する
+// シャドウマップ → HDRバッファへのシーン描画 → targetFBOへのトーンマップ
+// ビルドが終わっていないシェーダーの描画は飛ばす (全て揃うまでは一部のパスだけ描かれる)
+// 各パスの発行はFrameTimerの区間で計る (カリングまでは呼び出し側で開いている区間に入る)
+// in : targetFBO  最終結果の書き込み先 (ウィンドウなら0)
+////////////////////////////////////////////////
+void Scene::render(GLuint targetFBO)
+{
+	// 変化しないuniformはビルドが終わったら一度だけ設定する
+	// (カメラ・ライト・露出はフレーム共通定数ブロックで全シェーダーに共有する)
+	if (!mSphereUniformsSet && mSphereShader.isReady())
+	{
+		Vector3 lightColor(0.8, 0.5, 0.2);
+		mSphereShader.setVec3(mSphereShader.getUniformHandle("color"), lightColor);
+		mSphereShader.setFloat(mSphereShader.getUniformHandle("luminance"), 5.0);
+		mSphereUniformsSet = true;
+	}
+
+	// ディレクショナルライトのシャドウ用行列
+	Vector3 mapCenterPos(4 * 6, 0, -4 * 6);
+	Vector3 lightPos = mLightDir * -30.0f + mapCenterPos;
+	Matrix4 lightProjection, lightView, lightSpaceMatrix;
+
+	lightProjection = Matrix4::CreateOrtho(80.0f, 80.0f, 1.0f, 100.0f);
+	lightView = Matrix4::CreateLookAt(lightPos, mapCenterPos, Vector3::UnitY);
+	lightSpaceMatrix = lightView * lightProjection;
+
+	// フレーム共通定数を1回だけ転送
+	mFrameConstants.setCamera(mViewMat, mProjMat, mViewPos);
+	mFrameConstants.setLight(mLightDir, mAmbient, mDiffuse, mSpecular);
+	mFrameConstants.setLightSpaceMatrix(lightSpaceMatrix);
+	mFrameConstants.setExposure(mExposure);
+	mFrameConstants.upload();
+
+	// 視錐台カリング（シャドウパスはライトの正射影、描画パスはカメラの視錐台で判定）
+	Frustum cameraFrustum(mViewMat * mProjMat);
+	Frustum lightFrustum(lightSpaceMatrix);
+	mGridBatch.beginCulling();
+
+	// LODはどのパスもカメラから見た画面上の大きさで選ぶ (距離1で1単位が何ピクセルか)
+	const float pixelsPerUnit = mProjMat.mat[1][1] * mScreenHeight * 0.5f;
+	for (int pass = 0; pass < RenderQueue::RenderPass_Num; pass++)
+	{
+		mFloorLods[pass].setView(mViewPos, pixelsPerUnit);
+		mPillerLods[pass].setView(mViewPos, pixelsPerUnit);
+		mSphereLods[pass].setView(mViewPos, pixelsPerUnit);
+	}
+
+	// 描画アイテムを各パスのキューに積む
+	// 床と柱のマテリアルが同じテクスチャセットなら、レイヤー番号だけが違う同じシェーダー・テクスチャの描画になり1つにまとまる
+	float gridDepth = (mGridBatch.getCenter() - mViewPos).Length();
+	const MaterialLibrary::Material& floorMaterial  = mMaterials.getMaterial(mFloorMaterial);
+	const MaterialLibrary::Material& pillerMaterial = mMaterials.getMaterial(mPillerMaterial);
+	Shader* floorShader  = mLitShader.getVariant(mGridMaterialFeatures | floorMaterial.features);
+	Shader* pillerShader = mLitShader.getVariant(mGridMaterialFeatures | pillerMaterial.features);
+	mRenderQueue.clear();
+	const RenderQueue::RenderPassEnum shadow = RenderQueue::RenderPass_Shadow, opaque = RenderQueue::RenderPass_Opaque;
+	enqueueCulled(shadow, lightFrustum, { &mDepthMapShader, nullptr, &mFloorMesh, &mGridBatch, gridDepth }, mFloorLods[shadow]);
+	enqueueCulled(shadow, lightFrustum, { &mDepthMapShader, nullptr, &mPillerMesh, &mGridBatch, gridDepth }, mPillerLods[shadow]);
+	enqueueCulled(opaque, cameraFrustum, { floorShader, floorMaterial.textures, &mFloorMesh, &mGridBatch, gridDepth }, mFloorLods[opaque], floorMaterial.layer);        // 床
+	enqueueCulled(opaque, cameraFrustum, { pillerShader, pillerMaterial.textures, &mPillerMesh, &mGridBatch, gridDepth }, mPillerLods[opaque], pillerMaterial.layer);   // 柱
+	enqueueCulled(opaque, cameraFrustum, { &mSphereShader, nullptr, &mSphereMesh, &mGridBatch, gridDepth }, mSphereLods[opaque]);       // 球体
+
+	// 可視リストを転送
+	mGridBatch.upload();
+
+	mGpuProfiler.beginFrame();
+	mGpuProfiler.beginScope("Frame");
+
+	// シャドウマップパス
+	FRAME_TIMER_INSTANCE.beginPhase(FramePhase_ShadowSubmit);
+	{
+		GpuProfileScope scope(mGpuProfiler, "Shadow");
+		RENDER_STATE_INSTANCE.setDepthTest(true);
+		RENDER_STATE_INSTANCE.setViewport(0, 0, mShadowWidth, mShadowHeight);
+		RENDER_STATE_INSTANCE.bindFramebuffer(mDepthMapFBO);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		mRenderQueue.submit(RenderQueue::RenderPass_Shadow);
+	}
+
+	// 描画パス
+	FRAME_TIMER_INSTANCE.beginPhase(FramePhase_MainSubmit);
+	RENDER_STATE_INSTANCE.bindFramebuffer(mHdrFBO);
+	{
+		GpuProfileScope scope(mGpuProfiler, "HDR");
+		RENDER_STATE_INSTANCE.setDepthTest(true);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		RENDER_STATE_INSTANCE.setViewport(0, 0, mScreenWidth, mScreenHeight);
+		mRenderQueue.submit(RenderQueue::RenderPass_Opaque);
+	}
+	FRAME_TIMER_INSTANCE.beginPhase(FramePhase_Post);
+	RENDER_STATE_INSTANCE.bindFramebuffer(targetFBO);
+	{
+		GpuProfileScope scope(mGpuProfiler, "ToneMap");
+		RENDER_STATE_INSTANCE.setDepthTest(false);
+		glClear(GL_COLOR_BUFFER_BIT);
+		RENDER_STATE_INSTANCE.setViewport(0, 0, mScreenWidth, mScreenHeight);
+
+		// スクリーンいっぱいの四角形を描画 (シェーダーのビルド中はクリアのみ)
+		if (mToneMapShader.isReady())
+		{
+			RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D, mFloatColorTexture);
+
+			mToneMapShader.use();
+			RENDER_STATE_INSTANCE.bindVertexArray(mQuadVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+		}
+	}
+
+	mGpuProfiler.endScope();
+	mGpuProfiler.endFrame();
+}
+
+bool Scene::isReady() const
+{
+	if (mLitShader.isBuilding())
+	{
+		return false;
+	}
+
+	const Shader* shaders[] = { &mDepthMapShader, &mSphereShader, &mToneMapShader };
+	for (const Shader* shader : shaders)
+	{
+		if (!shader->isReady() && !shader->isFailed())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void Scene::printStats(std::ostream& os) const
+{
+	os << "uniform lookups avoided : " << Shader::getAvoidedLookupCount() << " / frame" << std::endl;
+	os << "state changes issued    : " << RENDER_STATE_INSTANCE.getIssuedCount() << " / frame" << std::endl;
+	os << "state changes elided    : " << RENDER_STATE_INSTANCE.getElidedCount() << " / frame" << std::endl;
+	os << "draw calls (shadow/opaque) : " << mRenderQueue.getDrawCount(RenderQueue::RenderPass_Shadow)
+	   << " / " << mRenderQueue.getDrawCount(RenderQueue::RenderPass_Opaque) << std::endl;
+	os << "draw commands (shadow/opaque) : " << mRenderQueue.getCommandCount(RenderQueue::RenderPass_Shadow)
+	   << " / " << mRenderQueue.getCommandCount(RenderQueue::RenderPass_Opaque) << std::endl;
+	os << "instances drawn (shadow/opaque)  : " << mRenderQueue.getInstanceCount(RenderQueue::RenderPass_Shadow)
+	   << " / " << mRenderQueue.getInstanceCount(RenderQueue::RenderPass_Opaque) << std::endl;
+	os << "instances culled (shadow/opaque) : " << mRenderQueue.getCulledCount(RenderQueue::RenderPass_Shadow)
+	   << " / " << mRenderQueue.getCulledCount(RenderQueue::RenderPass_Opaque) << std::endl;
+	os << "triangles drawn (shadow/opaque)  : " << mRenderQueue.getTriangleCount(RenderQueue::RenderPass_Shadow)
+	   << " / " << mRenderQueue.getTriangleCount(RenderQueue::RenderPass_Opaque) << std::endl;
+	const char* passNames[RenderQueue::RenderPass_Num] = { "shadow", "opaque" };
+	for (int pass = 0; pass < RenderQueue::RenderPass_Num; pass++)
+	{
+		os << "instances per LOD (" << passNames[pass] << ") :";
+		for (unsigned int lod = 0; lod < MeshObj::mLodMax; lod++)
+		{
+			os << " " << mRenderQueue.getLodInstanceCount(static_cast<RenderQueue::RenderPassEnum>(pass), lod);
+		}
+		os << std::endl;
+	}
+	mGpuProfiler.printStats(os);
+}
+
+/////////////////////////////////////////////////
+// 視錐台カリングとLOD選択をしてから描画キューに積む
+// 可視インスタンスだけをLODごとにまとめてインスタンスバッファの可視リストに追記し、
+// LODごとに描画アイテムを積む (同じVAOなので1回のマルチドローにまとまる)
+// in : pass           積むパス
+//      frustum        パスの視錐台
+//      item           描画アイテム (描画範囲とLODはここで設定する)
+//      lodSelector    メッシュ・パスごとのLOD選択
+//      materialLayer  マテリアルのテクスチャ配列のレイヤー番号 (可視リストのインスタンスに書き込む)
+////////////////////////////////////////////////
+void Scene::enqueueCulled(RenderQueue::RenderPassEnum pass, const Frustum& frustum, DrawItem item, LodSelector& lodSelector, float materialLayer)
+{
+	InstanceRange ranges[MeshObj::mLodMax];
+	unsigned int visibleCount = mGridBatch.cull(frustum, *item.mesh, lodSelector, ranges, materialLayer);
+	mRenderQueue.addCulledCount(pass, mGridBatch.getCount() - visibleCount);
+
+	for (unsigned int lod = 0; lod < MeshObj::mLodMax; lod++)
+	{
+		item.baseInstance  = ranges[lod].base;
+		item.instanceCount = ranges[lod].count;
+		item.lod           = lod;
+		mRenderQueue.enqueue(pass, item);
+	}
+}
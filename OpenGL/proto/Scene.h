@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "Math.h"
+#include "Shader.h"
+#include "ShaderPermutation.h"
+#include "MeshObj.h"
+#include "InstanceBatch.h"
+#include "GeometryArena.h"
+#include "FrameConstants.h"
+#include "RenderQueue.h"
+#include "LodSelector.h"
+#include "GpuProfiler.h"
+#include "MaterialLibrary.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 描画シーン
+// マテリアル・FBO・メッシュ・シェーダーの読み込み要求と、シャドウ → HDR → トーンマップの
+// 1フレーム分の描画をまとめたもの。ウィンドウや入力には依存しないので、
+// アプリ本体(main.cpp)とヘッドレスベンチマーク(bench)の両方から使う
+// GLコンテキストを作成してから生成すること
+///////////////////////////////////////////////////////////////////////////////////////
+class Scene
+{
+public:
+	static const int          mScreenWidth  = 1024;   // 描画解像度
+	static const int          mScreenHeight = 768;
+	static const unsigned int mShadowWidth  = 2048;   // シャドウマップ解像度
+	static const unsigned int mShadowHeight = 2048;
+
+	Scene();
+	~Scene();
+
+	void         update(float deltaTime);                                                    // ライトのアニメーション
+	void         setCamera(const Matrix4& view, const Matrix4& projection, const Vector3& viewPos); // カメラの設定
+	void         setExposure(float exposure) { mExposure = Math::Max(exposure, 0.0f); }
+	float        getExposure() const { return mExposure; }
+	void         render(GLuint targetFBO);                                                    // 1フレーム描画 (トーンマップ結果をtargetFBOに書く)
+	bool         isReady() const;                                                            // 全シェーダーのビルドが終わったか
+
+	void         printStats(std::ostream& os) const;                                         // フレーム統計の出力
+	RenderQueue& getRenderQueue() { return mRenderQueue; }
+	GpuProfiler& getGpuProfiler() { return mGpuProfiler; }
+
+private:
+	void         enqueueCulled(RenderQueue::RenderPassEnum pass, const Frustum& frustum, DrawItem item, LodSelector& lodSelector,
+	                           float materialLayer = 0.0f);                                 // カリング・LOD選択して描画キューに積む
+
+	// シェーダー
+	ShaderPermutation         mLitShader;                                  // ライティング (マテリアルの機能ごとのバリアント)
+	unsigned int              mGridMaterialFeatures;                       // 床・柱の描画に使う機能 (マテリアルの機能は別に足す)
+	Shader                    mDepthMapShader;
+	Shader                    mSphereShader;
+	Shader                    mToneMapShader;
+
+	// マテリアル・FBO
+	MaterialLibrary           mMaterials;                                  // マテリアルのテクスチャ配列
+	unsigned int              mFloorMaterial, mPillerMaterial;
+	GLuint                    mDepthMapFBO, mDepthMap;                     // シャドウマップ
+	GLuint                    mHdrFBO, mHdrDepthRBO, mFloatColorTexture;   // HDRバッファ
+	GLuint                    mQuadVAO, mQuadVBO;                          // スクリーン全体を描く四角形
+
+	// メッシュ
+	MeshObj                   mFloorMesh, mPillerMesh, mSphereMesh;
+	InstanceBatch             mGridBatch;                                  // 8x8の格子配置
+	GeometryArena             mStaticArena;                                // 静的メッシュのアリーナ
+	LodSelector               mFloorLods[RenderQueue::RenderPass_Num];     // メッシュ・パスごとのLOD選択
+	LodSelector               mPillerLods[RenderQueue::RenderPass_Num];
+	LodSelector               mSphereLods[RenderQueue::RenderPass_Num];
+
+	// フレーム
+	FrameConstantBuffer       mFrameConstants;
+	RenderQueue               mRenderQueue;
+	GpuProfiler               mGpuProfiler;
+
+	// カメラ・ライト
+	Matrix4                   mViewMat, mProjMat;
+	Vector3                   mViewPos;
+	Vector3                   mLightDir, mAmbient, mDiffuse, mSpecular;
+	float                     mLightAnim;                                  // ライト回転の角度
+	float                     mExposure;                                   // 露出
+	bool                      mSphereUniformsSet;                          // 球体シェーダーの固定uniformを設定済みか
+};
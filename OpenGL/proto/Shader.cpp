@@ -1,146 +1,313 @@
 #include "Shader.h"
+#include "FrameConstants.h"
+#include "RenderState.h"
+#include "ProgramCache.h"
+#include "ShaderBuildQueue.h"
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
+unsigned int Shader::sAvoidedLookupCount = 0;
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, BuildModeEnum buildMode, const std::vector<std::string>& defines)
+    : ID(0)
+    , mVertexPath(vertexPath)
+    , mFragmentPath(fragmentPath)
+    , mDefines(defines)
+    , mWarnMissingSampler(true)
+    , mBuildState(BuildState_Loading)
+    , mVertexShader(0)
+    , mFragmentShader(0)
+    , mCacheKey(0)
+    , mCacheHit(false)
+    , mColdMilliseconds(0.0f)
 {
-    // 1. filePath璸_/tOg̃\[XR[h擾܂
+    if (buildMode == BuildMode_Async)
+    {
+        // 読み込みからビルドキューに任せる
+        SHADER_BUILD_QUEUE_INSTANCE.enqueue(this, vertexPath, fragmentPath);
+        return;
+    }
+
+    // 1. filePathから頂点/フラグメントのソースコードを取得します
     std::string vertexCode;
     std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+    if (!ShaderBuildQueue::loadSource(vertexPath, vertexCode, mDefines) ||
+        !ShaderBuildQueue::loadSource(fragmentPath, fragmentCode, mDefines))
+    {
+        // 読み込めなかったソースはコンパイルしない (原因はloadSourceが表示済み)
+        mBuildState = BuildState_Failed;
+        return;
+    }
 
-    // ifstreamIuWFNgOX[ł邱ƂmF܂B
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    // 2. コンパイル・リンクして結果を確認
+    beginBuild(vertexCode, fragmentCode);
+    pollBuild(true);
+}
 
-    try
+Shader::~Shader()
+{
+    if (mBuildState == BuildState_Loading || mBuildState == BuildState_Compiling)
     {
-        // t@CJ
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // t@C̃obt@̓eXg[ɓǂݍ݂܂
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // t@Cnh
-        vShaderFile.close();
-        fShaderFile.close();
-        // Xg[stringɕϊ
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        SHADER_BUILD_QUEUE_INSTANCE.cancel(this);
     }
-    catch (std::ifstream::failure e)
+}
+
+/////////////////////////////////////////////////
+// プログラムのビルドを発行する
+// キャッシュにあればバイナリを読み込み、無ければコンパイル・リンクを発行する
+// 並列コンパイルを妨げないよう、ここではコンパイル・リンクの状態を問い合わせない
+////////////////////////////////////////////////
+void Shader::beginBuild(const std::string& vertexCode, const std::string& fragmentCode)
+{
+    mBuildStart = std::chrono::steady_clock::now();
+    mBuildState = BuildState_Compiling;
+    mCacheKey   = PROGRAM_CACHE_INSTANCE.makeKey(vertexCode, fragmentCode);
+
+    // プログラムバイナリのキャッシュから読み込む
+    ID = glCreateProgram();
+    mCacheHit = PROGRAM_CACHE_INSTANCE.load(mCacheKey, ID, mColdMilliseconds);
+    if (mCacheHit)
     {
-        std::cout << "ERROR::SHADER::t@Cǂݍݎs" << std::endl;
+        return;
     }
 
-    // XgOCɕϊ
+    // 拒否されたバイナリの状態を残さないようにプログラムを作り直す
+    glDeleteProgram(ID);
+    ID = glCreateProgram();
+
+    // ストリングからC文字列に変換
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
-    // 2. VF[_[̃RpC
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
+    // 頂点シェーダー
+    mVertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(mVertexShader, 1, &vShaderCode, NULL);
+    glCompileShader(mVertexShader);
 
-    // _VF[_[
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
+    // フラグメントシェーダーも同様に行います
+    mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(mFragmentShader, 1, &fShaderCode, NULL);
+    glCompileShader(mFragmentShader);
 
-    // G[oꍇ̓G[\
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR" << vertexPath << "::SHADER::_VF[_[RpCs\n" << infoLog << std::endl;
-    };
+    // シェーダープログラム (バイナリを取り出せるようにヒントを立ててからリンク)
+    glAttachShader(ID, mVertexShader);
+    glAttachShader(ID, mFragmentShader);
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(ID);
+}
 
-    // tOgVF[_[lɍs܂
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
+/////////////////////////////////////////////////
+// ビルドの完了を確認する
+// in  : wait  trueなら完了まで待つ。falseなら並列コンパイル拡張で完了を確認し、終わっていなければ戻る
+// out : 完了して結果が確定したらtrue
+////////////////////////////////////////////////
+bool Shader::pollBuild(bool wait)
+{
+    if (mBuildState != BuildState_Compiling)
+    {
+        return mBuildState != BuildState_Loading;
+    }
 
-    // G[oꍇ̓G[\
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success)
+    if (!wait && !mCacheHit && SHADER_BUILD_QUEUE_INSTANCE.isParallelSupported())
     {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cout << "ERROR" << fragmentPath << "::SHADER::tOgVF[_[s\n" << infoLog << std::endl;
+        GLint completed = GL_FALSE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+        if (!completed)
+        {
+            return false;
+        }
     }
 
-    // VF[_[vO
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
+    finishBuild();
+    return true;
+}
+
+/////////////////////////////////////////////////
+// リンク結果を確認して使える状態にする
+// 失敗したらシェーダーのコンパイルログとリンクログを表示する
+////////////////////////////////////////////////
+void Shader::finishBuild()
+{
+    int success;
+    char infoLog[512];
 
-    // NG[oG[\
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if (!success)
     {
+        // エラーが出た場合はエラー表示する
+        glGetShaderiv(mVertexShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(mVertexShader, 512, NULL, infoLog);
+            std::cout << "ERROR" << mVertexPath << "::SHADER::頂点シェーダーコンパイル失敗\n" << infoLog << std::endl;
+        }
+        glGetShaderiv(mFragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(mFragmentShader, 512, NULL, infoLog);
+            std::cout << "ERROR" << mFragmentPath << "::SHADER::フラグメントシェーダー失敗\n" << infoLog << std::endl;
+        }
+
+        // リンクエラーを表示
         glGetProgramInfoLog(ID, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VF[_[NG[\n" << infoLog << std::endl;
+        std::cout << "ERROR::SHADER::シェーダーリンクエラー : " << getName() << "\n" << infoLog << std::endl;
+        mBuildState = BuildState_Failed;
+    }
+    else
+    {
+        reflectUniforms();
+
+        // フレーム共通定数ブロックを使っていれば固定バインディングポイントに割り当てる
+        GLuint blockIndex = glGetUniformBlockIndex(ID, FrameConstantBuffer::mBlockName);
+        if (blockIndex != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(ID, blockIndex, FrameConstantBuffer::mBindingPoint);
+        }
+
+        // ビルド中に指定されたサンプラーのテクスチャユニットを反映
+        mBuildState = BuildState_Ready;
+        for (unsigned int i = 0; i < mMaxTextureUnitNum; i++)
+        {
+            if (!mTextureUniformStrings[i].empty())
+            {
+                setTextureUniformString(mTextureUniformStrings[i], i);
+            }
+        }
     }
 
-    // VF[_[͌݃vOhcɃNAsvɂȂ߃VF[_[폜܂
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mBuildStart).count();
+    if (!mCacheHit)
+    {
+        mColdMilliseconds = milliseconds;
+        if (mBuildState == BuildState_Ready)
+        {
+            PROGRAM_CACHE_INSTANCE.store(mCacheKey, ID, mColdMilliseconds);
+        }
+    }
+    PROGRAM_CACHE_INSTANCE.addRecord(getName(), mCacheHit, milliseconds, mColdMilliseconds);
 
+    // シェーダーは現在プログラムＩＤにリンクされ、不要になったためシェーダーを削除します
+    if (mVertexShader != 0)
+    {
+        glDetachShader(ID, mVertexShader);
+        glDetachShader(ID, mFragmentShader);
+        glDeleteShader(mVertexShader);
+        glDeleteShader(mFragmentShader);
+        mVertexShader   = 0;
+        mFragmentShader = 0;
+    }
+}
+
+std::string Shader::getName() const
+{
+    std::string name = mVertexPath + " + " + mFragmentPath;
+    if (!mDefines.empty())
+    {
+        name += " [";
+        for (size_t i = 0; i < mDefines.size(); i++)
+        {
+            name += (i == 0 ? "" : " ") + mDefines[i];
+        }
+        name += "]";
+    }
+    return name;
 }
 
 void Shader::use()
 {
-    if (ID != -1)
+    if (mBuildState == BuildState_Ready)
     {
-        glUseProgram(ID);
+        RENDER_STATE_INSTANCE.useProgram(ID);
     }
 }
 
 void Shader::setBool(const std::string& valiableName, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, valiableName.c_str()), (int)value);
+    glUniform1i(findUniformLocation(valiableName), (int)value);
 }
 
 void Shader::setInt(const std::string& valiableName, int value) const
 {
-    unsigned int id = glGetUniformLocation(ID, valiableName.c_str());
-    glUniform1i(id, value);
+    glUniform1i(findUniformLocation(valiableName), value);
 }
 
 void Shader::setFloat(const std::string& valiableName, float value) const
 {
-    unsigned int id = glGetUniformLocation(ID, valiableName.c_str());
-    glUniform1f(id, value);
+    glUniform1f(findUniformLocation(valiableName), value);
 }
 
 void Shader::setVec3(const std::string& valiableName, float x, float y, float z)
 {
-    unsigned int id = glGetUniformLocation(ID, valiableName.c_str());
-    glUniform3f(id, x, y, z);
+    glUniform3f(findUniformLocation(valiableName), x, y, z);
 }
 
 void Shader::setVec3(const std::string& valiableName, Vector3& vec)
 {
-    unsigned int id = glGetUniformLocation(ID, valiableName.c_str());
-    glUniform3f(id, vec.x, vec.y, vec.z);
+    glUniform3f(findUniformLocation(valiableName), vec.x, vec.y, vec.z);
 }
 
 void Shader::setVec4(const std::string& valiableName, float x, float y, float z, float w)
 {
-    unsigned int id = glGetUniformLocation(ID, valiableName.c_str());
-    glUniform4f(id, x, y, z, w);
+    glUniform4f(findUniformLocation(valiableName), x, y, z, w);
 }
 
 void Shader::setVec4(const std::string& valiableName, Vector3& vec, float w)
 {
-    unsigned int id = glGetUniformLocation(ID, valiableName.c_str());
-    glUniform4f(id, vec.x, vec.y, vec.z, w);
+    glUniform4f(findUniformLocation(valiableName), vec.x, vec.y, vec.z, w);
 }
 
 void Shader::setMatrix(const std::string& valiableName, const float* matrix)
 {
-    unsigned int id = glGetUniformLocation(ID, valiableName.c_str());
-    glUniformMatrix4fv(id, 1, GL_FALSE, matrix);
+    glUniformMatrix4fv(findUniformLocation(valiableName), 1, GL_FALSE, matrix);
+}
+
+UniformHandle Shader::getUniformHandle(const std::string& valiableName) const
+{
+    UniformHandle handle;
+    auto it = mUniformIndex.find(valiableName);
+    if (it != mUniformIndex.end())
+    {
+        handle.index = it->second;
+    }
+    return handle;
+}
+
+void Shader::setInt(UniformHandle handle, int value) const
+{
+    if (!handle.isValid())
+    {
+        return;
+    }
+    sAvoidedLookupCount++;
+    glProgramUniform1i(ID, mUniforms[handle.index].location, value);
+}
+
+void Shader::setFloat(UniformHandle handle, float value) const
+{
+    if (!handle.isValid())
+    {
+        return;
+    }
+    sAvoidedLookupCount++;
+    glProgramUniform1f(ID, mUniforms[handle.index].location, value);
+}
+
+void Shader::setVec3(UniformHandle handle, const Vector3& vec) const
+{
+    if (!handle.isValid())
+    {
+        return;
+    }
+    sAvoidedLookupCount++;
+    glProgramUniform3f(ID, mUniforms[handle.index].location, vec.x, vec.y, vec.z);
+}
+
+void Shader::setMatrix(UniformHandle handle, const float* matrix) const
+{
+    if (!handle.isValid())
+    {
+        return;
+    }
+    sAvoidedLookupCount++;
+    glProgramUniformMatrix4fv(ID, mUniforms[handle.index].location, 1, GL_FALSE, matrix);
 }
 
 void Shader::setTextureUniformString(std::string textureUniformName, unsigned int textureUnitStageNum)
@@ -150,6 +317,27 @@ void Shader::setTextureUniformString(std::string textureUniformName, unsigned in
         return;
     }
     mTextureUniformStrings[textureUnitStageNum] = textureUniformName;
+
+    // ビルド中ならリンク後に反映する
+    if (mBuildState != BuildState_Ready)
+    {
+        return;
+    }
+
+    // サンプラーのユニット番号はプログラムの状態として保持されるので、ここで一度だけ設定する
+    // リフレクション結果にサンプラーとして存在しない名前は警告しておく
+    for (int samplerIndex : mSamplers)
+    {
+        if (mUniforms[samplerIndex].name == textureUniformName)
+        {
+            glProgramUniform1i(ID, mUniforms[samplerIndex].location, textureUnitStageNum);
+            return;
+        }
+    }
+    if (mWarnMissingSampler)
+    {
+        std::cout << "WARNING::SHADER::サンプラーuniformが見つかりません : " << textureUniformName << std::endl;
+    }
 }
 
 std::string Shader::getShaderStageUniformName(unsigned int textureUnitStageNum)
@@ -160,3 +348,92 @@ std::string Shader::getShaderStageUniformName(unsigned int textureUnitStageNum)
     }
     return mTextureUniformStrings[textureUnitStageNum];
 }
+
+
+/////////////////////////////////////////////////
+// リンク済みプログラムのアクティブなuniformを列挙し、
+// 名前 → ロケーションのテーブルを作成する
+// 配列uniformは "name[0]" の他に "name" と各要素 "name[i]" も登録する
+////////////////////////////////////////////////
+void Shader::reflectUniforms()
+{
+    mUniforms.clear();
+    mSamplers.clear();
+    mUniformIndex.clear();
+
+    GLint uniformNum = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformNum);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<GLchar> nameBuf(maxNameLength + 1);
+    for (GLint i = 0; i < uniformNum; i++)
+    {
+        GLsizei length = 0;
+        GLint   size = 0;
+        GLenum  type = 0;
+        glGetActiveUniform(ID, i, static_cast<GLsizei>(nameBuf.size()), &length, &size, &type, nameBuf.data());
+
+        std::string name(nameBuf.data(), length);
+        GLint location = glGetUniformLocation(ID, name.c_str());
+
+        // uniformブロック内のメンバーはロケーションを持たない
+        if (location < 0)
+        {
+            continue;
+        }
+
+        // 配列の場合は添字を外した名前で登録する
+        std::string baseName = name;
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos && name.compare(bracket, std::string::npos, "[0]") == 0)
+        {
+            baseName = name.substr(0, bracket);
+        }
+
+        for (GLint element = 0; element < size; element++)
+        {
+            UniformInfo info;
+            info.name     = (size > 1 || baseName != name) ? baseName + "[" + std::to_string(element) + "]" : name;
+            info.location = location + element;
+            info.type     = type;
+            info.size     = (element == 0) ? size : 1;
+
+            int index = static_cast<int>(mUniforms.size());
+            mUniforms.emplace_back(info);
+            mUniformIndex[info.name] = index;
+            if (element == 0)
+            {
+                mUniformIndex[baseName] = index;
+            }
+        }
+
+        // サンプラーはテクスチャユニット設定用に別途記録しておく
+        switch (type)
+        {
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_CUBE:
+            mSamplers.emplace_back(mUniformIndex[baseName]);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/////////////////////////////////////////////////
+// uniform名からロケーションをテーブル検索する
+// 見つからない場合は-1を返す（glUniform*は-1を無視する）
+////////////////////////////////////////////////
+GLint Shader::findUniformLocation(const std::string& valiableName) const
+{
+    auto it = mUniformIndex.find(valiableName);
+    if (it == mUniformIndex.end())
+    {
+        return -1;
+    }
+    sAvoidedLookupCount++;
+    return mUniforms[it->second].location;
+}
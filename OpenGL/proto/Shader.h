@@ -6,13 +6,45 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <unordered_map>
+#include <chrono>
+
+// リンク時に解決済みのuniformハンドル（Shader内uniformテーブルのインデックス）
+struct UniformHandle
+{
+	int index = -1;
+	bool isValid() const { return index >= 0; }
+};
+
 class Shader
 {
 
 public:
-	Shader(const char* vertexPath, const char* fragmentPath);
+	// ビルド方法
+	enum BuildModeEnum
+	{
+		BuildMode_Immediate = 0,   // コンストラクタ内でコンパイル・リンクまで終える
+		BuildMode_Async,           // ShaderBuildQueueに任せる (isReady()になるまで描画に使えない)
+	};
+
+	// defines : ソースの #version の直後に挿入するマクロ ("NAME" または "NAME 値")
+	Shader(const char* vertexPath, const char* fragmentPath, BuildModeEnum buildMode = BuildMode_Immediate,
+	       const std::vector<std::string>& defines = std::vector<std::string>());
+	~Shader();
 	void use();
 
+	bool isReady() const { return mBuildState == BuildState_Ready; }    // リンク済みで使えるか
+	bool isFailed() const { return mBuildState == BuildState_Failed; }  // ビルドに失敗したか
+
+	// uniformハンドルの取得（リンク時に作成したテーブルを引くだけでドライバ問い合わせは発生しない）
+	UniformHandle getUniformHandle(const std::string& valiableName) const;
+
+	// ハンドル経由のsetter（glProgramUniform* で直接書き込むためuse()は不要）
+	void setInt(UniformHandle handle, int value) const;
+	void setFloat(UniformHandle handle, float value) const;
+	void setVec3(UniformHandle handle, const Vector3& vec) const;
+	void setMatrix(UniformHandle handle, const float* matrix) const;
+
 	// getter/setter
 	void setBool(const std::string& valiableName, bool  value) const;
 	void setInt(const std::string& valiableName, int   value) const;
@@ -27,10 +59,59 @@ public:
 
 	unsigned int GetID() { return ID; }
 	void setTextureUniformString(std::string textureUniformName, unsigned int textureUnitStageNum);
+	void setMissingSamplerWarning(bool enable) { mWarnMissingSampler = enable; } // 存在しないサンプラー名を警告するか
 	std::string getShaderStageUniformName(unsigned int textureUnitStageNum);
 
+	// フレームごとの統計（glGetUniformLocationを回避できた回数）
+	static void         resetFrameStats() { sAvoidedLookupCount = 0; }
+	static unsigned int getAvoidedLookupCount() { return sAvoidedLookupCount; }
+
 private:
+	friend class ShaderBuildQueue;
+
+	// ビルドの進行状態
+	enum BuildStateEnum
+	{
+		BuildState_Loading = 0,    // ソース読み込み待ち
+		BuildState_Compiling,      // コンパイル・リンク発行済み
+		BuildState_Ready,          // 使用可能
+		BuildState_Failed,         // 失敗
+	};
+
+	// uniform情報
+	struct UniformInfo
+	{
+		std::string name;     // uniform名
+		GLint       location; // uniformロケーション
+		GLenum      type;     // 型 (GL_FLOAT_MAT4 等)
+		GLint       size;     // 配列要素数
+	};
+
+	void  beginBuild(const std::string& vertexCode, const std::string& fragmentCode); // コンパイル・リンクの発行 (状態は問い合わせない)
+	bool  pollBuild(bool wait);                                   // 完了していれば確定してtrue (waitなら完了まで待つ)
+	void  finishBuild();                                          // リンク結果の確認とuniformテーブル作成
+	void  reflectUniforms();                                      // リンク後にアクティブなuniformを列挙してテーブル作成
+	GLint findUniformLocation(const std::string& valiableName) const;  // 名前からロケーションをテーブル検索
+	std::string getName() const;                                  // レポート用の名前 (ファイル名とマクロ)
+
 	unsigned int ID;
+	std::string                          mVertexPath;    // ソースファイル名 (エラー表示・レポート用)
+	std::string                          mFragmentPath;
+	std::vector<std::string>             mDefines;       // 挿入するマクロ
+	bool                                 mWarnMissingSampler; // 存在しないサンプラー名を警告するか
+	BuildStateEnum                       mBuildState;
+	GLuint                               mVertexShader;   // 完了待ちのシェーダーオブジェクト
+	GLuint                               mFragmentShader;
+	unsigned long long                   mCacheKey;       // プログラムバイナリキャッシュのキー
+	bool                                 mCacheHit;       // キャッシュから読み込んだか
+	float                                mColdMilliseconds; // キャッシュに記録されたコンパイル時間
+	std::chrono::steady_clock::time_point mBuildStart;    // ビルド発行時刻
+	std::vector<UniformInfo>             mUniforms;      // uniformテーブル
+	std::vector<int>                     mSamplers;      // mUniforms中のサンプラーのインデックス
+	std::unordered_map<std::string, int> mUniformIndex;  // uniform名 → mUniformsのインデックス
+
+	static unsigned int sAvoidedLookupCount;            // 回避したglGetUniformLocation呼び出し回数
+
 	const unsigned int mMaxTextureUnitNum = 8;
 	std::string mTextureUniformStrings[8];
 };
@@ -0,0 +1,21 @@
+// フレーム共通定数 (#include "FrameConstants.glsl" で読み込む)
+
+// ライト
+struct Light
+{
+        vec3  direction       ; // ライトの方向(ディレクショナルライト)
+        vec3  ambient         ; // ライトアンビエント
+        vec3  diffuse         ; // ライトディフューズ
+        vec3  specular        ; // ライトスペキュラー
+};
+
+// フレーム共通定数 (C++側 FrameConstants とstd140レイアウトを一致させる)
+layout (std140) uniform FrameConstants
+{
+        mat4  view            ; // ビュー行列
+        mat4  projection      ; // プロジェクション行列
+        mat4  lightSpaceMatrix; // ライト空間行列
+        vec3  viewPos         ; // 視点
+        float exposure        ; // 露出
+        Light light           ; // ディレクショナルライト
+};
@@ -6,7 +6,8 @@ in vec2 TexCoords;
 
 uniform sampler2D hdrBuffer;
 
-uniform float exposure;
+#include "FrameConstants.glsl"
+
 uniform float luminance;
 
 void main()
@@ -14,10 +15,10 @@ void main()
 	const float gamma = 2.2;
 	vec3 hdrColor = texture(hdrBuffer,TexCoords).rgb;
 
-	// g[}bsO
+	// トーンマッピング
 	vec3 mapped = hdrColor / (-hdrColor * exposure);
 
-	// K}RNV
+	// ガンマコレクション
 	mapped = pow(mapped,vec3(1.0 / gamma));
 
 	FragColor = vec4(hdrColor,1.0);
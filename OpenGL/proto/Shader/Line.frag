@@ -6,7 +6,7 @@
 // See LICENSE in root directory for full details.
 // ----------------------------------------------------------------
 
-// GLSL 3.3 v
+// GLSL 3.3 を要求
 #version 330
 
 uniform vec3 uColor;
@@ -14,12 +14,12 @@ out vec4 outColor;
 
 void main()
 {
-	// XN[WʒuvZĔjɂ 
+	// スクリーン座標位置から計算して破線にする 
     //uint x = uint(gl_FragCoord.x);
 	//uint y = uint(gl_FragCoord.y);
 	//if( mod(x, 2) == 0 || mod(y, 2) == 0)
 	//{
-	//   discard; //`j
+	//   discard; //描画破棄
 	//}
 	outColor = vec4(uColor.r, uColor.g, uColor.b, 1.0);
 }
@@ -6,57 +6,57 @@
 // See LICENSE in root directory for full details.
 // ----------------------------------------------------------------
 
-// GLSL 3.3 v
+// GLSL 3.3 を要求
 #version 330
 
-// _VF[_[̓
-// eNX`W
+// 頂点シェーダーからの入力
+// テクスチャ座標
 in vec2 fragTexCoord;
-// @i[hԁj
+// 法線（ワールド空間）
 in vec3 fragNormal;
-// _ʒui[hԁj
+// 頂点位置（ワールド空間）
 in vec3 fragWorldPos;
 
-// o̓J[io̓sNZJ[j
+// 出力カラー（出力ピクセルカラー）
 out vec4 outColor;
 
-// eNX`TvO
+// テクスチャサンプリング
 uniform sampler2D uTexture;
 
-// fBNViCgp\
+// ディレクショナルライト用構造体
 struct DirectionalLight
 {
-	// Cg
+	// ライト方向
 	vec3 mDirection;
-	// fBt[YF
+	// ディフューズ色
 	vec3 mDiffuseColor;
-	// XyL[F
+	// スペキュラー色
 	vec3 mSpecColor;
 };
 
-// CeBOpϐ
-// Jʒui[hԁj
+// ライティング用変数
+// カメラ位置（ワールド空間）
 uniform vec3 uCameraPos;
-// |S\ʂ̃XyL[x
+// ポリゴン表面のスペキュラー強度
 uniform float uSpecPower;
-// ArGgCgF
+// アンビエントライト色
 uniform vec3 uAmbientLight;
 
-// fBNViCg
+// ディレクショナルライト
 uniform DirectionalLight uDirLight;
 
 void main()
 {
-	// |S\ʂ̖@itOgVF[_[ŕԂĂj
+	// ポリゴン表面の法線（フラグメントシェーダー上で補間されている）
 	vec3 N = normalize(fragNormal);
-	// |S\ʂ烉Cgւ̃xNg
+	// ポリゴン表面からライト方向へのベクトル
 	vec3 L = normalize(-uDirLight.mDirection);
-	// |S\ʂJ
+	// ポリゴン表面からカメラ方向
 	vec3 V = normalize(uCameraPos - fragWorldPos);
-	// -L xNg @ N ɑ΂Ĕ˂xNgR߂
+	// -L ベクトルを 法線 N に対して反射したベクトルRを求める
 	vec3 R = normalize(reflect(-L, N));
 
-	// tHˌvZ
+	// フォン反射計算
 	vec3 Phong = uAmbientLight;
 	float NdotL = dot(N, L);
 
@@ -2,8 +2,8 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model      ; // モデル行列
-uniform mat4 view       ; // ビュー行列
-uniform mat4 projection ; // プロジェクション行列
+
+#include "FrameConstants.glsl"
 
 void main()
 {
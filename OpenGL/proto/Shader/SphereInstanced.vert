@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 4) in mat4 aModel; // インスタンスごとのモデル行列
+
+#include "FrameConstants.glsl"
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+}
\ No newline at end of file
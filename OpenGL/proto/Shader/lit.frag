@@ -0,0 +1,104 @@
+#version 330 core
+// ライティングのテクニック (ShaderPermutation で機能ごとのマクロを付けてビルドする)
+//   SHADOWS      : シャドウマップで影を付ける
+//   NORMAL_MAP   : 法線マップで法線を置き換える
+//   SPECULAR_MAP : スペキュラーマップで反射の強さを決める (無ければ一定値)
+//   TEXTURE_ARRAY: マテリアルのテクスチャ(ディフューズ・スペキュラー・法線)をテクスチャ配列のレイヤーから読む
+//                  (シャドウマップはマテリアルによらないので2Dのまま)
+
+#include "FrameConstants.glsl"
+
+#ifdef TEXTURE_ARRAY
+#define MaterialSampler     sampler2DArray
+#define sampleMaterial(map) texture(map, vec3(TexCoords, MaterialLayer))
+#else
+#define MaterialSampler     sampler2D
+#define sampleMaterial(map) texture(map, TexCoords)
+#endif
+
+uniform MaterialSampler diffuseMap  ; // ディフューズテクスチャ  (ユニット0)
+#ifdef SPECULAR_MAP
+uniform MaterialSampler specularMap ; // スペキュラーテクスチャ  (ユニット1)
+#endif
+#ifdef SHADOWS
+uniform sampler2D       depthMap    ; // （シャドウ）デプスマップ (ユニット2)
+#endif
+#ifdef NORMAL_MAP
+uniform MaterialSampler normalMap   ; // 法線マップ              (ユニット3)
+#endif
+
+in      vec3  FragPos         ; // フラグメント位置のワールド座標
+in      vec3  Normal          ; // フラグメント位置の法線ベクトル
+in      vec2  TexCoords       ; // テクスチャ座標
+#ifdef SHADOWS
+in      vec4  FragPosLightSpace;// ライト空間でのフラグメント座標
+#endif
+#ifdef NORMAL_MAP
+in      vec4  Tangent         ; // ワールド空間のタンジェント (wが従法線の向き)
+#endif
+#ifdef TEXTURE_ARRAY
+flat in float MaterialLayer   ; // マテリアルのレイヤー番号
+#endif
+
+out     vec4  FragColor       ; // このフラグメントの出力
+
+#ifndef SPECULAR_MAP
+const   float specularIntensity = 0.5; // スペキュラーマップが無い時の反射の強さ
+#endif
+
+#ifdef SHADOWS
+float ShadowCaluculation(vec4 fragPosLightSpace, vec3 norm)
+{
+   // パースペクティブ除算
+   vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+   projCoords = projCoords * 0.5 + 0.5;
+
+   // シャドウマップよりライトに最も近いフラグメントの深度値を得る
+   float closestDepth = texture(depthMap, projCoords.xy).r;
+   // 現在描画しようとしているフラグメントの深度値
+   float currentDepth = projCoords.z;
+   // シャドウ判定 (1.0:シャドウ 0.0:シャドウの外)
+   float bias = max(0.0005 * (1.0 - dot(norm, light.direction)), 0.00005);
+   float shadow = currentDepth - bias > closestDepth ? 1.0 : 0.0;
+   return shadow;
+}
+#endif
+
+void main()
+{
+    vec3  albedo     = vec3(sampleMaterial(diffuseMap));
+
+    // 法線
+    vec3  norm       = normalize(Normal);
+#ifdef NORMAL_MAP
+    vec3  tangent    = normalize(Tangent.xyz - dot(Tangent.xyz, norm) * norm);
+    vec3  bitangent  = cross(norm, tangent) * (Tangent.w < 0.0 ? -1.0 : 1.0); // UVが裏返っている面は従法線も反転
+    mat3  TBN        = mat3(tangent, bitangent, norm);
+    norm             = normalize(TBN * (sampleMaterial(normalMap).rgb * 2.0 - 1.0));
+#endif
+
+    // アンビエント
+    vec3  ambient    = light.ambient * albedo;
+
+    // ディフューズ
+    float diff       = max(dot(norm,-light.direction), 0.0);
+    vec3  diffuse    = light.diffuse * diff * albedo;
+
+    // スペキュラー
+    vec3  viewDir    = normalize(viewPos - FragPos);
+    vec3  reflectDir = reflect(light.direction, norm);
+    float spec       = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+#ifdef SPECULAR_MAP
+    vec3  specular   = light.specular * spec * vec3(sampleMaterial(specularMap));
+#else
+    vec3  specular   = light.specular * spec * specularIntensity;
+#endif
+
+#ifdef SHADOWS
+    float shadow     = ShadowCaluculation(FragPosLightSpace, norm);
+    vec3  result     = ambient + (1.0 - shadow) * (diffuse + specular);
+#else
+    vec3  result     = ambient + diffuse + specular;
+#endif
+    FragColor        = vec4(result, 1.0);
+}
@@ -0,0 +1,120 @@
+#version 330 core
+// ライティングのテクニック (ShaderPermutation で機能ごとのマクロを付けてビルドする)
+//   INSTANCED  : モデル行列・法線行列をインスタンス属性から取る (無ければ uniform model / normalMatrix)
+//   RIGID_MODEL: モデル行列が回転と平行移動だけなので、法線行列にモデル行列の3x3をそのまま使う
+//   SHADOWS    : ライト空間の位置を出力する
+//   NORMAL_MAP : タンジェントと従法線の向きから接空間の基底を出力する
+//   PACKED_VERTEX : 圧縮頂点 (法線・タンジェントが八面体エンコード、位置・UVのhalfは頂点属性の設定で展開済み)
+//   TEXTURE_ARRAY : マテリアルのレイヤー番号をフラグメントに渡す (インスタンス属性か uniform materialLayer)
+
+layout (location = 0) in vec4  aPos        ; // 頂点位置 (圧縮頂点のタンジェント付きならwが従法線の向き)
+#ifdef PACKED_VERTEX
+layout (location = 1) in vec2  aNormal     ; // 法線 (八面体エンコード)
+#else
+layout (location = 1) in vec3  aNormal     ; // 法線
+#endif
+layout (location = 2) in vec2  aTexCoords  ; // テクスチャ座標
+#ifdef NORMAL_MAP
+#ifdef PACKED_VERTEX
+layout (location = 3) in vec2  aTangent    ; // タンジェント (八面体エンコード、向きは aPos.w)
+#else
+layout (location = 3) in vec4  aTangent    ; // タンジェント (wが従法線の向き)
+#endif
+#endif
+#ifdef INSTANCED
+layout (location = 4) in mat4  aModel      ; // インスタンスごとのモデル行列
+#ifndef RIGID_MODEL
+layout (location = 8) in mat3  aNormalMatrix; // インスタンスごとの法線行列 (CPUで計算した逆転置)
+#endif
+#else
+uniform mat4 model      ; // モデル行列
+#ifndef RIGID_MODEL
+uniform mat4 normalMatrix; // 法線行列 (Matrix4::InvertTransposeBatch の結果、左上3x3を使う)
+#endif
+#endif
+#ifdef TEXTURE_ARRAY
+#ifdef INSTANCED
+layout (location = 13) in float aMaterialLayer; // インスタンスごとのマテリアルのレイヤー番号
+#else
+uniform float materialLayer; // マテリアルのレイヤー番号
+#endif
+#endif
+
+#include "FrameConstants.glsl"
+
+out     vec3 Normal     ; // フラグメントへの法線出力
+out     vec3 FragPos    ; // フラグメントの位置座標出力
+out     vec2 TexCoords  ; // テクスチャ座標
+#ifdef SHADOWS
+out     vec4 FragPosLightSpace; // ライト空間でのフラグメント位置
+#endif
+#ifdef NORMAL_MAP
+out     vec4 Tangent    ; // ワールド空間のタンジェント (wが従法線の向き)
+#endif
+#ifdef TEXTURE_ARRAY
+flat out float MaterialLayer; // マテリアルのレイヤー番号
+#endif
+
+#ifdef PACKED_VERTEX
+// 八面体エンコードの展開 (VertexPacker::decodeOctahedral と同じ)
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0)
+    {
+        vec2 signNotZero = vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+        v.xy = (1.0 - abs(v.yx)) * signNotZero;
+    }
+    return normalize(v);
+}
+#endif
+
+void main()
+{
+#ifdef INSTANCED
+    mat4 modelMat = aModel;
+#else
+    mat4 modelMat = model;
+#endif
+
+    // 法線行列 (頂点ごとに逆行列は求めない)
+#if defined(RIGID_MODEL)
+    mat3 normalMat = mat3(modelMat);
+#elif defined(INSTANCED)
+    mat3 normalMat = aNormalMatrix;
+#else
+    mat3 normalMat = mat3(normalMatrix);
+#endif
+
+    vec4 localPos    = vec4(aPos.xyz, 1.0);
+#ifdef PACKED_VERTEX
+    vec3 localNormal = decodeOctahedral(aNormal);
+#else
+    vec3 localNormal = aNormal;
+#endif
+#ifdef NORMAL_MAP
+#ifdef PACKED_VERTEX
+    vec4 localTangent = vec4(decodeOctahedral(aTangent), aPos.w);
+#else
+    vec4 localTangent = aTangent;
+#endif
+#endif
+
+    vec4 worldPos = modelMat * localPos;
+
+    gl_Position = projection * view * worldPos;
+    FragPos     = vec3(worldPos);
+    Normal      = normalMat * localNormal;
+    TexCoords   = aTexCoords;
+#ifdef SHADOWS
+    FragPosLightSpace = lightSpaceMatrix * worldPos;
+#endif
+#ifdef NORMAL_MAP
+    Tangent     = vec4(mat3(modelMat) * localTangent.xyz, localTangent.w);
+#endif
+#if defined(TEXTURE_ARRAY) && defined(INSTANCED)
+    MaterialLayer = aMaterialLayer;
+#elif defined(TEXTURE_ARRAY)
+    MaterialLayer = materialLayer;
+#endif
+}
@@ -1,4 +1,4 @@
-//ilp`̃_Op_VF[_[ framebufferScreen.vert j
+//（四角形のレンダリング用頂点シェーダー framebufferScreen.vert ）
 #version 330 core
 layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec2 aTexCoords;
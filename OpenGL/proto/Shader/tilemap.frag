@@ -9,37 +9,37 @@
 // Request GLSL 3.3
 #version 330
 
-// _VF[_[̃eNX`W͂ƂĎ󂯎
+// 頂点シェーダーからのテクスチャ座標を入力として受け取る
 in vec2 fragTexCoord;
 
-// o̓J[
+// 出力カラー
 out vec4 outColor;
 
 // uniform
-uniform sampler2D uTexture;                     // eNX`
-uniform int       uTileIndex;                   // `悵^Cio[
-uniform vec2      uTileSetSplitNum;             // eNX`c鐔
-uniform float     uAlpha;                       // x
+uniform sampler2D uTexture;                     // テクスチャ
+uniform int       uTileIndex;                   // 描画したいタイルナンバー
+uniform vec2      uTileSetSplitNum;             // テクスチャを縦横分割する数
+uniform float     uAlpha;                       // 透明度
 									            
 void main()
 {
-	ivec2 texSize  = textureSize(uTexture, 0);  // eNX`TCY
-	ivec2 splitNum = ivec2(uTileSetSplitNum);   // eNX`
+	ivec2 texSize  = textureSize(uTexture, 0);  // テクスチャサイズ
+	ivec2 splitNum = ivec2(uTileSetSplitNum);   // テクスチャ分割数
 
 	int xpos = uTileIndex % splitNum.x;
 	int ypos = uTileIndex / splitNum.x;
 
-	// uvZo
+	// 基準uvを算出
 	vec2 uv = vec2(xpos, ypos) / splitNum;
 
-	// ItZbgZo
+	// オフセット算出
 	vec2 offset = vec2(1.0f, 1.0f) / splitNum;
 	offset = offset * fragTexCoord;            
 	
-	// ŏIeNX`WZo
+	// 最終テクスチャ座標算出
 	uv += offset;
 
-	// eNX`J[TvO
+	// テクスチャからカラーをサンプリング
 	vec4 color = texture(uTexture, uv);
 	color.a = color.a * uAlpha;
     outColor = color;
@@ -6,17 +6,17 @@ in vec2 TexCoords;
 
 uniform sampler2D hdrBuffer;
 
-uniform float exposure;  //Io
+#include "FrameConstants.glsl"
 
 void main()
 {
 	const float gamma = 2.2;
 	vec3 hdrColor = texture(hdrBuffer,TexCoords).rgb;
 
-	// g[}bsO
+	// トーンマッピング
 	vec3 mapped = vec3(1.0) - exp(-hdrColor * exposure);
 
-	// K}RNV
+	// ガンマコレクション
 	mapped = pow(mapped,vec3(1.0 / gamma));
 
 	FragColor = vec4(mapped,1.0);
@@ -0,0 +1,321 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include "ShaderBuildQueue.h"
+#include "Shader.h"
+
+// #include の入れ子の上限 (循環参照の防止)
+static const int maxIncludeDepth = 8;
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// ファイルを読み込み、行頭の #include "file" を展開する (パスは読み込み元ファイルからの相対)
+static bool loadSourceRecursive(const std::string& path, std::string& destSource, int depth)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::SHADER::ファイル読み込み失敗 : " << path << std::endl;
+		return false;
+	}
+
+	const size_t slash = path.find_last_of("/\\");
+	const std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		// 改行コードをLFにそろえる
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		size_t begin = line.find_first_not_of(" \t");
+		if (begin != std::string::npos && line.compare(begin, 8, "#include") == 0)
+		{
+			size_t open  = line.find('"', begin);
+			size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+			if (close == std::string::npos || depth >= maxIncludeDepth)
+			{
+				std::cout << "ERROR::SHADER::#includeを展開できません : " << path << " : " << line << std::endl;
+				return false;
+			}
+			if (!loadSourceRecursive(directory + line.substr(open + 1, close - open - 1), destSource, depth + 1))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		destSource += line;
+		destSource += '\n';
+	}
+	return true;
+}
+
+ShaderBuildQueue::ShaderBuildQueue()
+	: mParallelSupported(false)
+	, mInFlight(nullptr)
+	, mInFlightCancelled(false)
+	, mStop(false)
+	, mBuildMilliseconds(0.0f)
+	, mBuiltNum(0)
+	, mLoadFailedNum(0)
+{
+}
+
+ShaderBuildQueue::~ShaderBuildQueue()
+{
+	if (mWorker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStop = true;
+		}
+		mCondition.notify_all();
+		mWorker.join();
+	}
+}
+
+/////////////////////////////////////////////////
+// 並列コンパイル拡張の有無を調べる
+// in : loadProc  GL関数のローダー (nullptrならスレッド数の設定は省略し、ドライバの既定値を使う)
+////////////////////////////////////////////////
+void ShaderBuildQueue::initialize(GLADloadproc loadProc)
+{
+	GLint extensionNum = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionNum);
+	const char* extensionName = nullptr;
+	for (GLint i = 0; i < extensionNum && !extensionName; i++)
+	{
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+		if (!strcmp(name, "GL_KHR_parallel_shader_compile") || !strcmp(name, "GL_ARB_parallel_shader_compile"))
+		{
+			extensionName = name;
+		}
+	}
+	mParallelSupported = extensionName != nullptr;
+
+	if (mParallelSupported && loadProc)
+	{
+		// ドライバが使える最大数のスレッドでコンパイルさせる
+		const bool isKHR = strstr(extensionName, "KHR") != nullptr;
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+			loadProc(isKHR ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+		if (maxShaderCompilerThreads)
+		{
+			maxShaderCompilerThreads(0xFFFFFFFF);
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// ソースファイルを読み込む (ワーカースレッドからも呼ぶのでGLは使わない)
+// in  : path     ファイル名
+//       defines  #version の直後に挿入するマクロ ("NAME" または "NAME 値")
+// out : destSource  #include を展開したソース
+//       読み込めたらtrue
+////////////////////////////////////////////////
+bool ShaderBuildQueue::loadSource(const std::string& path, std::string& destSource, const std::vector<std::string>& defines)
+{
+	destSource.clear();
+	if (!loadSourceRecursive(path, destSource, 0))
+	{
+		return false;
+	}
+	if (defines.empty())
+	{
+		return true;
+	}
+
+	std::string defineLines;
+	for (const std::string& define : defines)
+	{
+		defineLines += "#define " + define + "\n";
+	}
+
+	// #version より前には何も置けないので、その次の行に挿入する
+	size_t insertPoint = 0;
+	size_t version = destSource.find("#version");
+	if (version != std::string::npos)
+	{
+		size_t lineEnd = destSource.find('\n', version);
+		insertPoint = lineEnd == std::string::npos ? destSource.size() : lineEnd + 1;
+	}
+	destSource.insert(insertPoint, defineLines);
+	return true;
+}
+
+void ShaderBuildQueue::enqueue(Shader* shader, const char* vertexPath, const char* fragmentPath)
+{
+	if (isIdle())
+	{
+		mBuildStart = std::chrono::steady_clock::now();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mLoadQueue.push_back({ shader, vertexPath, fragmentPath, shader->mDefines, std::string(), std::string() });
+	}
+	mCondition.notify_all();
+
+	if (!mWorker.joinable())
+	{
+		mWorker = std::thread(&ShaderBuildQueue::workerMain, this);
+	}
+}
+
+void ShaderBuildQueue::cancel(Shader* shader)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto isTarget = [shader](const LoadJob& job) { return job.shader == shader; };
+		mLoadQueue.erase(std::remove_if(mLoadQueue.begin(), mLoadQueue.end(), isTarget), mLoadQueue.end());
+		mLoaded.erase(std::remove_if(mLoaded.begin(), mLoaded.end(), isTarget), mLoaded.end());
+		mLoadFailed.erase(std::remove(mLoadFailed.begin(), mLoadFailed.end(), shader), mLoadFailed.end());
+		if (mInFlight == shader)
+		{
+			mInFlightCancelled = true;
+		}
+	}
+	mBuilding.erase(std::remove(mBuilding.begin(), mBuilding.end(), shader), mBuilding.end());
+}
+
+void ShaderBuildQueue::workerMain()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mCondition.wait(lock, [this]() { return mStop || !mLoadQueue.empty(); });
+		if (mStop)
+		{
+			return;
+		}
+
+		LoadJob job = mLoadQueue.front();
+		mLoadQueue.pop_front();
+		mInFlight          = job.shader;
+		mInFlightCancelled = false;
+
+		// ファイルの読み込み中はロックを外す
+		lock.unlock();
+		const bool loaded = loadSource(job.vertexPath, job.vertexCode, job.defines) &&
+		                    loadSource(job.fragmentPath, job.fragmentCode, job.defines);
+		lock.lock();
+
+		// 読み込めなかったソースはコンパイルしても通らないので発行しない (状態はメインスレッドで変える)
+		if (!mInFlightCancelled)
+		{
+			if (loaded)
+			{
+				mLoaded.emplace_back(std::move(job));
+			}
+			else
+			{
+				mLoadFailed.push_back(job.shader);
+			}
+		}
+		mInFlight = nullptr;
+		mCondition.notify_all();
+	}
+}
+
+/////////////////////////////////////////////////
+// 読み込み済みのジョブのコンパイル・リンクを続けて発行する
+// 状態の問い合わせを挟まないので、ドライバは全プログラムを並行して処理できる
+// ソースを読み込めなかったShaderはここで失敗にする
+////////////////////////////////////////////////
+void ShaderBuildQueue::submitLoaded()
+{
+	std::vector<LoadJob> loaded;
+	std::vector<Shader*> failed;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		loaded.swap(mLoaded);
+		failed.swap(mLoadFailed);
+	}
+
+	for (Shader* shader : failed)
+	{
+		shader->mBuildState = Shader::BuildState_Failed;
+		mLoadFailedNum++;
+	}
+
+	for (const LoadJob& job : loaded)
+	{
+		job.shader->beginBuild(job.vertexCode, job.fragmentCode);
+		mBuilding.push_back(job.shader);
+	}
+}
+
+/////////////////////////////////////////////////
+// 発行済みのビルドの完了を確認する
+// in : wait  trueなら全て完了するまで待つ
+//            falseなら並列コンパイル拡張で終わった物だけ確定する
+//            (拡張が無ければ問い合わせで待たされるので、1回に1つだけ確定する)
+////////////////////////////////////////////////
+void ShaderBuildQueue::pollBuilding(bool wait)
+{
+	const bool blocking = wait || !mParallelSupported;
+	for (size_t i = 0; i < mBuilding.size(); )
+	{
+		if (mBuilding[i]->pollBuild(blocking))
+		{
+			mBuilding.erase(mBuilding.begin() + i);
+			mBuiltNum++;
+			if (blocking && !wait)
+			{
+				break;
+			}
+			continue;
+		}
+		i++;
+	}
+}
+
+void ShaderBuildQueue::update()
+{
+	if (isIdle())
+	{
+		return;
+	}
+
+	// 前回までに発行した分を確認してから、新しく読み込めた分を発行する (発行直後は問い合わせない)
+	pollBuilding(false);
+	submitLoaded();
+
+	if (isIdle())
+	{
+		mBuildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mBuildStart).count();
+	}
+}
+
+void ShaderBuildQueue::finish()
+{
+	while (!isIdle())
+	{
+		{
+			// ワーカーの読み込みが終わるか、発行できるジョブが出るまで待つ
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return !mLoaded.empty() || !mLoadFailed.empty() || (mLoadQueue.empty() && !mInFlight); });
+		}
+		submitLoaded();
+		pollBuilding(true);
+	}
+	mBuildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mBuildStart).count();
+}
+
+bool ShaderBuildQueue::isIdle() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mLoadQueue.empty() && !mInFlight && mLoaded.empty() && mLoadFailed.empty() && mBuilding.empty();
+}
+
+void ShaderBuildQueue::printReport(std::ostream& os) const
+{
+	os << "shader build queue : " << mBuiltNum << " programs (" << mLoadFailedNum << " failed to load), " << mBuildMilliseconds << " ms until all ready"
+	   << " (parallel compile " << (mParallelSupported ? "on" : "off") << ")" << std::endl;
+}
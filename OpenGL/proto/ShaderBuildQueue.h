@@ -0,0 +1,97 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ostream>
+
+// KHR_parallel_shader_compile (gladの生成対象外なのでここで定義する。ARB版も同じ値)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+
+class Shader;
+
+///////////////////////////////////////////////////////////////////////////////////////
+// シェーダーの非同期ビルドキュー
+// BuildMode_Async で作ったShaderを受け取り、
+//   1. ワーカースレッドでソースファイルを読み込み、#include を展開する
+//      (ファイルが無い・#includeを展開できない場合はコンパイルせずに失敗にする)
+//   2. メインスレッド(update)で読み込めた分のコンパイル・リンクを続けて発行する
+//   3. 状態の問い合わせは後回しにし、GL_COMPLETION_STATUS_KHR で終わった物から確定する
+// KHR/ARB_parallel_shader_compile が無いドライバでは、問い合わせで待たされるので
+// 1回のupdateで確定するプログラムを1つに抑え、待ちを複数フレームに分散する
+//
+// 使い方 :
+//   initialize(ローダー) → Shader(vs, fs, Shader::BuildMode_Async) … → 毎フレーム update()
+//   全て揃うまで待つ場合は finish()
+///////////////////////////////////////////////////////////////////////////////////////
+class ShaderBuildQueue
+{
+public:
+	static ShaderBuildQueue& ShaderBuildQueueInstance()  // インスタンス
+	{
+		static ShaderBuildQueue ShaderBuildQueueInstance;
+		return ShaderBuildQueueInstance;
+	}
+
+	~ShaderBuildQueue();
+
+	void         initialize(GLADloadproc loadProc);  // 並列コンパイル拡張の確認 (loadProcがあればスレッド数も設定)
+	void         enqueue(Shader* shader, const char* vertexPath, const char* fragmentPath); // ビルド待ちに追加
+	void         cancel(Shader* shader);             // ビルド待ちから外す (Shaderの破棄時)
+	void         update();                           // 読み込み済みの発行と完了の確認 (メインスレッド)
+	void         finish();                           // 全てのビルドが終わるまで待つ
+
+	bool         isIdle() const;                     // ビルド待ちが無いか
+	bool         isParallelSupported() const { return mParallelSupported; }
+	void         printReport(std::ostream& os) const;
+
+	static bool  loadSource(const std::string& path, std::string& destSource,
+	                        const std::vector<std::string>& defines = std::vector<std::string>()); // ソースの読み込みと#includeの展開
+
+private:
+	ShaderBuildQueue(); // シングルトン
+
+	// 読み込みジョブ
+	struct LoadJob
+	{
+		Shader*     shader;
+		std::string vertexPath;
+		std::string fragmentPath;
+		std::vector<std::string> defines;  // 挿入するマクロ
+		std::string vertexCode;
+		std::string fragmentCode;
+	};
+
+	void         workerMain();                       // ワーカースレッドの処理
+	void         submitLoaded();                     // 読み込み済みのジョブのコンパイル・リンクを発行
+	void         pollBuilding(bool wait);            // 発行済みの完了を確認
+
+	bool                    mParallelSupported;      // KHR/ARB_parallel_shader_compile
+	std::thread             mWorker;                 // 読み込みスレッド (最初のenqueueで起動)
+	mutable std::mutex      mMutex;                  // 以下のジョブ一覧を保護
+	std::condition_variable mCondition;
+	std::deque<LoadJob>     mLoadQueue;              // 読み込み待ち
+	std::vector<LoadJob>    mLoaded;                 // 読み込み済み (発行待ち)
+	std::vector<Shader*>    mLoadFailed;             // ソースを読み込めなかった (メインスレッドで失敗にする)
+	Shader*                 mInFlight;               // ワーカーが読み込み中のShader
+	bool                    mInFlightCancelled;      // 読み込み中にcancelされた
+	bool                    mStop;                   // ワーカーの終了要求
+
+	std::vector<Shader*>    mBuilding;               // 発行済み・完了待ち (メインスレッドのみ)
+
+	// レポート用
+	std::chrono::steady_clock::time_point mBuildStart; // アイドルから最初にenqueueした時刻
+	float                   mBuildMilliseconds;      // 最後にアイドルになるまでの時間
+	unsigned int            mBuiltNum;               // ビルドしたプログラム数
+	unsigned int            mLoadFailedNum;          // ソースを読み込めずに失敗にしたプログラム数
+};
+
+#define SHADER_BUILD_QUEUE_INSTANCE ShaderBuildQueue::ShaderBuildQueueInstance()
@@ -0,0 +1,107 @@
+#include "ShaderPermutation.h"
+
+// 機能ビットに対応するマクロ名 (ShaderFeatureEnum のビット順)
+static const char* featureNames[ShaderFeature_Num] =
+{
+	"SHADOWS",
+	"NORMAL_MAP",
+	"INSTANCED",
+	"SPECULAR_MAP",
+	"RIGID_MODEL",
+	"PACKED_VERTEX",
+	"TEXTURE_ARRAY",
+};
+
+ShaderPermutation::ShaderPermutation(const char* vertexPath, const char* fragmentPath, Shader::BuildModeEnum buildMode)
+	: mVertexPath(vertexPath)
+	, mFragmentPath(fragmentPath)
+	, mBuildMode(buildMode)
+{
+}
+
+ShaderPermutation::~ShaderPermutation()
+{
+	for (auto& variant : mVariants)
+	{
+		delete variant.second;
+	}
+}
+
+/////////////////////////////////////////////////
+// バリアントを取得する
+// 初めての組み合わせならマクロを付けてビルドを開始する (非同期ならisReady()まで描画には使えない)
+// in  : features  ShaderFeatureEnum の組み合わせ
+// out : バリアント
+////////////////////////////////////////////////
+Shader* ShaderPermutation::getVariant(unsigned int features)
+{
+	features &= ShaderFeature_All;
+
+	auto it = mVariants.find(features);
+	if (it != mVariants.end())
+	{
+		return it->second;
+	}
+
+	// 機能によって使わないサンプラーはコンパイル時に消えるので警告しない
+	Shader* shader = new Shader(mVertexPath.c_str(), mFragmentPath.c_str(), mBuildMode, getFeatureDefines(features));
+	shader->setMissingSamplerWarning(false);
+	for (const auto& sampler : mSamplers)
+	{
+		shader->setTextureUniformString(sampler.first, sampler.second);
+	}
+	mVariants[features] = shader;
+	return shader;
+}
+
+bool ShaderPermutation::isReady(unsigned int features) const
+{
+	auto it = mVariants.find(features & ShaderFeature_All);
+	return it != mVariants.end() && it->second->isReady();
+}
+
+bool ShaderPermutation::isBuilding() const
+{
+	for (const auto& variant : mVariants)
+	{
+		if (!variant.second->isReady() && !variant.second->isFailed())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ShaderPermutation::setTextureUniformString(const std::string& textureUniformName, unsigned int textureUnitStageNum)
+{
+	mSamplers.emplace_back(textureUniformName, textureUnitStageNum);
+	for (auto& variant : mVariants)
+	{
+		variant.second->setTextureUniformString(textureUniformName, textureUnitStageNum);
+	}
+}
+
+const char* ShaderPermutation::getFeatureName(unsigned int featureBit)
+{
+	for (unsigned int i = 0; i < ShaderFeature_Num; i++)
+	{
+		if (featureBit == (1u << i))
+		{
+			return featureNames[i];
+		}
+	}
+	return "";
+}
+
+std::vector<std::string> ShaderPermutation::getFeatureDefines(unsigned int features)
+{
+	std::vector<std::string> defines;
+	for (unsigned int i = 0; i < ShaderFeature_Num; i++)
+	{
+		if (features & (1u << i))
+		{
+			defines.emplace_back(featureNames[i]);
+		}
+	}
+	return defines;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Shader.h"
+
+// シェーダーの機能ビット (ソース側ではビット名のマクロで #ifdef する)
+enum ShaderFeatureEnum
+{
+	ShaderFeature_Shadows     = 1 << 0,   // SHADOWS      : シャドウマップによる影
+	ShaderFeature_NormalMap   = 1 << 1,   // NORMAL_MAP   : 法線マップ (頂点にタンジェントが必要)
+	ShaderFeature_Instanced   = 1 << 2,   // INSTANCED    : インスタンス属性のモデル行列
+	ShaderFeature_SpecularMap = 1 << 3,   // SPECULAR_MAP : スペキュラーマップ (無ければ一定の強度)
+	ShaderFeature_RigidModel  = 1 << 4,   // RIGID_MODEL  : モデル行列が剛体変換 (法線行列の代わりにモデル行列の3x3を使う)
+	ShaderFeature_PackedVertex = 1 << 5,  // PACKED_VERTEX : 圧縮頂点フォーマット (法線・タンジェントを八面体エンコードから展開)
+	ShaderFeature_TextureArray = 1 << 6,  // TEXTURE_ARRAY : マテリアルのテクスチャをテクスチャ配列のレイヤーから読む
+
+	ShaderFeature_Num         = 7,
+	ShaderFeature_All         = (1 << ShaderFeature_Num) - 1,
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// シェーダーのパーミュテーション
+// 1つのテクニックのソース(頂点/フラグメント)から、機能ビットの組み合わせごとに
+// マクロを定義したバリアントを作る。バリアントは初めて要求された時にビルドし、
+// 以降はビットマスクをキーにキャッシュしたものを返す
+// (実行時の分岐や手作業でのファイル分岐の代わりに、使う機能の分だけのコードになる)
+//
+// サンプラーのテクスチャユニットは全バリアント共通で、後から作るバリアントにも反映する
+///////////////////////////////////////////////////////////////////////////////////////
+class ShaderPermutation
+{
+public:
+	ShaderPermutation(const char* vertexPath, const char* fragmentPath, Shader::BuildModeEnum buildMode = Shader::BuildMode_Async);
+	~ShaderPermutation();
+
+	Shader*      getVariant(unsigned int features);                  // バリアントの取得 (無ければビルドを開始する)
+	void         preload(unsigned int features) { getVariant(features); } // 使う予定のバリアントを先にビルドしておく
+	bool         isReady(unsigned int features) const;               // バリアントが使える状態か
+	bool         isBuilding() const;                                 // ビルド中のバリアントがあるか
+	unsigned int getVariantNum() const { return static_cast<unsigned int>(mVariants.size()); }
+
+	void         setTextureUniformString(const std::string& textureUniformName, unsigned int textureUnitStageNum); // 全バリアントのサンプラー設定
+
+	static const char*              getFeatureName(unsigned int featureBit);    // 機能ビットのマクロ名
+	static std::vector<std::string> getFeatureDefines(unsigned int features);   // 機能ビットからマクロの一覧を作る
+
+private:
+	ShaderPermutation(const ShaderPermutation&) = delete;
+	ShaderPermutation& operator=(const ShaderPermutation&) = delete;
+
+	std::string                                mVertexPath;     // テクニックのソース
+	std::string                                mFragmentPath;
+	Shader::BuildModeEnum                      mBuildMode;      // バリアントのビルド方法
+	std::unordered_map<unsigned int, Shader*>  mVariants;       // 機能ビット → バリアント
+	std::vector<std::pair<std::string, unsigned int>> mSamplers; // サンプラー名とテクスチャユニット
+};
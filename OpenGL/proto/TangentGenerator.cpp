@@ -0,0 +1,151 @@
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "TangentGenerator.h"
+#include "Math.h"
+
+static const unsigned int srcStride     = 8;   // x,y,z, nx,ny,nz, u,v
+static const unsigned int destStride    = 12;  // x,y,z, nx,ny,nz, u,v, tx,ty,tz,w
+static const unsigned int tangentStride = 6;   // 足し込み用 tx,ty,tz, bx,by,bz
+
+/////////////////////////////////////////////////
+// 頂点にタンジェントを付ける
+// out : destVertices  タンジェント付きの頂点 (vertexCount × 12個のfloat)
+// in  : vertices      PosNormalTexの頂点 (vertexCount × 8個のfloat)
+//       vertexCount   頂点数
+//       indices       三角形リストのインデックス
+//       indexCount    インデックス数
+////////////////////////////////////////////////
+void TangentGenerator::generate(float* destVertices, const float* vertices, unsigned int vertexCount, const unsigned int* indices, size_t indexCount)
+{
+	const size_t triangleCount = indexCount / 3;
+
+	// 三角形が多ければスレッドごとに範囲を分け、それぞれ専用の足し込み先を使う
+	unsigned int threadNum = 1;
+	if (triangleCount >= mParallelTriangleNum)
+	{
+		const unsigned int hardwareNum = Math::Max(std::thread::hardware_concurrency(), 1u);
+		threadNum = static_cast<unsigned int>(Math::Min<size_t>(hardwareNum, triangleCount / (mParallelTriangleNum / 2)));
+	}
+
+	std::vector<std::vector<float>> tangents(threadNum, std::vector<float>(static_cast<size_t>(vertexCount) * tangentStride, 0.0f));
+	std::vector<const float*>       tangentPtrs(threadNum);
+	for (unsigned int i = 0; i < threadNum; i++)
+	{
+		tangentPtrs[i] = tangents[i].data();
+	}
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < threadNum; i++)
+	{
+		threads.emplace_back(&TangentGenerator::accumulate, tangents[i].data(), vertices, indices,
+			triangleCount * i / threadNum, triangleCount * (i + 1) / threadNum);
+	}
+	accumulate(tangents[0].data(), vertices, indices, 0, triangleCount / threadNum);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	threads.clear();
+
+	// 直交化も頂点の範囲で分ける
+	for (unsigned int i = 1; i < threadNum; i++)
+	{
+		threads.emplace_back(&TangentGenerator::orthogonalize, destVertices, vertices, tangentPtrs.data(), threadNum,
+			static_cast<unsigned int>(static_cast<size_t>(vertexCount) * i / threadNum),
+			static_cast<unsigned int>(static_cast<size_t>(vertexCount) * (i + 1) / threadNum));
+	}
+	orthogonalize(destVertices, vertices, tangentPtrs.data(), threadNum, 0, vertexCount / threadNum);
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+/////////////////////////////////////////////////
+// 三角形 [firstTriangle, lastTriangle) のタンジェント・従法線を頂点に足し込む
+// (Lengyel "Computing Tangent Space Basis Vectors for an Arbitrary Mesh")
+// 大きい面・UVの密度が低い面ほど大きく寄与する
+////////////////////////////////////////////////
+void TangentGenerator::accumulate(float* destTangents, const float* vertices, const unsigned int* indices, size_t firstTriangle, size_t lastTriangle)
+{
+	for (size_t t = firstTriangle; t < lastTriangle; t++)
+	{
+		const unsigned int i0 = indices[t * 3 + 0];
+		const unsigned int i1 = indices[t * 3 + 1];
+		const unsigned int i2 = indices[t * 3 + 2];
+		const float* v0 = vertices + static_cast<size_t>(i0) * srcStride;
+		const float* v1 = vertices + static_cast<size_t>(i1) * srcStride;
+		const float* v2 = vertices + static_cast<size_t>(i2) * srcStride;
+
+		const Vector3 edge1(v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]);
+		const Vector3 edge2(v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]);
+		const Vector2 deltaUV1(v1[6] - v0[6], v1[7] - v0[7]);
+		const Vector2 deltaUV2(v2[6] - v0[6], v2[7] - v0[7]);
+
+		// UVが潰れている面は向きが決まらないので寄与させない
+		const float det = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+		if (Math::Abs(det) < 1.0e-12f)
+		{
+			continue;
+		}
+		const float f = 1.0f / det;
+		const Vector3 tangent   = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * f;
+		const Vector3 bitangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * f;
+
+		const unsigned int corners[3] = { i0, i1, i2 };
+		for (unsigned int corner : corners)
+		{
+			float* dest = destTangents + static_cast<size_t>(corner) * tangentStride;
+			dest[0] += tangent.x;
+			dest[1] += tangent.y;
+			dest[2] += tangent.z;
+			dest[3] += bitangent.x;
+			dest[4] += bitangent.y;
+			dest[5] += bitangent.z;
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// 頂点 [firstVertex, lastVertex) について、各スレッドの足し込み結果を合算し、
+// 法線に直交させて正規化したタンジェントと従法線の向きを書き込む
+////////////////////////////////////////////////
+void TangentGenerator::orthogonalize(float* destVertices, const float* vertices, const float* const* tangents, unsigned int tangentsNum,
+	unsigned int firstVertex, unsigned int lastVertex)
+{
+	for (unsigned int v = firstVertex; v < lastVertex; v++)
+	{
+		const float* src  = vertices + static_cast<size_t>(v) * srcStride;
+		float*       dest = destVertices + static_cast<size_t>(v) * destStride;
+		std::copy(src, src + srcStride, dest);
+
+		Vector3 tangent(0.0f, 0.0f, 0.0f), bitangent(0.0f, 0.0f, 0.0f);
+		for (unsigned int i = 0; i < tangentsNum; i++)
+		{
+			const float* accum = tangents[i] + static_cast<size_t>(v) * tangentStride;
+			tangent   += Vector3(accum[0], accum[1], accum[2]);
+			bitangent += Vector3(accum[3], accum[4], accum[5]);
+		}
+
+		// グラム・シュミット (法線成分を取り除く)
+		const Vector3 normal(src[3], src[4], src[5]);
+		tangent -= normal * Vector3::Dot(normal, tangent);
+		if (tangent.LengthSq() < 1.0e-20f)
+		{
+			// UVから決まらない頂点は法線に直交する適当な向きにする
+			const Vector3 axis = Math::Abs(normal.x) < 0.9f ? Vector3(1.0f, 0.0f, 0.0f) : Vector3(0.0f, 1.0f, 0.0f);
+			tangent = Vector3::Cross(axis, normal);
+			if (tangent.LengthSq() < 1.0e-20f)
+			{
+				tangent = axis;
+			}
+		}
+		tangent.Normalize();
+
+		dest[8]  = tangent.x;
+		dest[9]  = tangent.y;
+		dest[10] = tangent.z;
+		dest[11] = Vector3::Dot(Vector3::Cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 接空間(タンジェント)の生成
+// 三角形ごとに位置とUVの差分からタンジェント・従法線を求めて頂点に足し込み、
+// 頂点ごとに法線に対してグラム・シュミットで直交化し、従法線の向き(handedness)を求める
+// 三角形が多い場合は三角形の範囲をスレッドに分けて足し込み、最後に合算する
+//
+// 入力はPosNormalTex (x,y,z, nx,ny,nz, u,v)、出力はPosNormalTexTangent (… tx,ty,tz,w) の並び
+// w は従法線 = cross(法線, タンジェント) * w となる符号 (UVが裏返っている面は -1)
+///////////////////////////////////////////////////////////////////////////////////////
+class TangentGenerator
+{
+public:
+	static const unsigned int mParallelTriangleNum = 32768; // これ以上の三角形数なら複数スレッドで計算
+
+	static void generate(float* destVertices, const float* vertices, unsigned int vertexCount, const unsigned int* indices, size_t indexCount);
+
+private:
+	TangentGenerator() = delete;
+
+	static void accumulate(float* destTangents, const float* vertices, const unsigned int* indices, size_t firstTriangle, size_t lastTriangle);
+	static void orthogonalize(float* destVertices, const float* vertices, const float* const* tangents, unsigned int tangentsNum,
+	                          unsigned int firstVertex, unsigned int lastVertex);
+};
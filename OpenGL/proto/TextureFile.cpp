@@ -0,0 +1,564 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+#include "TextureFile.h"
+#include "MappedFile.h"
+#include "Math.h"
+
+// DDSファイルの構造 (先頭に "DDS " の4文字)
+struct DdsPixelFormat
+{
+	unsigned int size;          // 32
+	unsigned int flags;         // DDPF_*
+	unsigned int fourCC;
+	unsigned int rgbBitCount;
+	unsigned int rMask;
+	unsigned int gMask;
+	unsigned int bMask;
+	unsigned int aMask;
+};
+
+struct DdsHeader
+{
+	unsigned int   size;        // 124
+	unsigned int   flags;       // DDSD_*
+	unsigned int   height;
+	unsigned int   width;
+	unsigned int   pitchOrLinearSize;
+	unsigned int   depth;
+	unsigned int   mipMapCount;
+	unsigned int   reserved1[11];
+	DdsPixelFormat pixelFormat;
+	unsigned int   caps;
+	unsigned int   caps2;
+	unsigned int   caps3;
+	unsigned int   caps4;
+	unsigned int   reserved2;
+};
+static_assert(sizeof(DdsHeader) == 124, "DdsHeader must match the DDS file layout");
+
+// fourCCが "DX10" の時にヘッダーの後に続く
+struct DdsHeaderDX10
+{
+	unsigned int dxgiFormat;
+	unsigned int resourceDimension;
+	unsigned int miscFlag;
+	unsigned int arraySize;
+	unsigned int miscFlags2;
+};
+
+static const unsigned int ddsdCaps        = 0x1;
+static const unsigned int ddsdHeight      = 0x2;
+static const unsigned int ddsdWidth       = 0x4;
+static const unsigned int ddsdPitch       = 0x8;
+static const unsigned int ddsdPixelFormat = 0x1000;
+static const unsigned int ddsdMipMapCount = 0x20000;
+static const unsigned int ddsdLinearSize  = 0x80000;
+static const unsigned int ddpfAlphaPixels = 0x1;
+static const unsigned int ddpfFourCC      = 0x4;
+static const unsigned int ddpfRGB         = 0x40;
+static const unsigned int ddsCapsComplex  = 0x8;
+static const unsigned int ddsCapsTexture  = 0x1000;
+static const unsigned int ddsCapsMipMap   = 0x400000;
+static const unsigned int dxgiResourceTexture2D = 3;
+
+// 予約領域に元の画像のハッシュ・大きさ・更新時刻を入れる印
+// reserved1[1..2] : ハッシュ、[3..4] : バイト数、[5..6] : 更新時刻 (大きさと時刻が無い古いファイルは0)
+static const unsigned int sourceHashTag = 0x48435253; // "SRCH"
+
+static unsigned int makeFourCC(const char* text)
+{
+	return static_cast<unsigned int>(static_cast<unsigned char>(text[0])) |
+		(static_cast<unsigned int>(static_cast<unsigned char>(text[1])) << 8) |
+		(static_cast<unsigned int>(static_cast<unsigned char>(text[2])) << 16) |
+		(static_cast<unsigned int>(static_cast<unsigned char>(text[3])) << 24);
+}
+
+// DXGI_FORMAT からの変換 (sRGB・TYPELESSも同じブロック形式として読む)
+static TextureFile::Format formatFromDxgi(unsigned int dxgiFormat)
+{
+	switch (dxgiFormat)
+	{
+	case 27: case 28: case 29: return TextureFile::Format_RGBA8;   // R8G8B8A8
+	case 70: case 71: case 72: return TextureFile::Format_BC1;
+	case 76: case 77: case 78: return TextureFile::Format_BC3;
+	case 79: case 80:          return TextureFile::Format_BC4;
+	case 82: case 83:          return TextureFile::Format_BC5;
+	case 97: case 98: case 99: return TextureFile::Format_BC7;
+	}
+	return TextureFile::Format_None;
+}
+
+// DDSのピクセルフォーマットからの変換
+static TextureFile::Format formatFromPixelFormat(const DdsPixelFormat& pixelFormat)
+{
+	if (pixelFormat.flags & ddpfFourCC)
+	{
+		const unsigned int fourCC = pixelFormat.fourCC;
+		if (fourCC == makeFourCC("DXT1"))                                     return TextureFile::Format_BC1;
+		if (fourCC == makeFourCC("DXT5"))                                     return TextureFile::Format_BC3;
+		if (fourCC == makeFourCC("ATI1") || fourCC == makeFourCC("BC4U"))    return TextureFile::Format_BC4;
+		if (fourCC == makeFourCC("ATI2") || fourCC == makeFourCC("BC5U"))    return TextureFile::Format_BC5;
+		return TextureFile::Format_None;
+	}
+	if ((pixelFormat.flags & ddpfRGB) && pixelFormat.rMask == 0x000000ff && pixelFormat.gMask == 0x0000ff00 && pixelFormat.bMask == 0x00ff0000)
+	{
+		if (pixelFormat.rgbBitCount == 32 && pixelFormat.aMask == 0xff000000)
+		{
+			return TextureFile::Format_RGBA8;
+		}
+		if (pixelFormat.rgbBitCount == 24)
+		{
+			return TextureFile::Format_RGB8;
+		}
+	}
+	return TextureFile::Format_None;
+}
+
+// FNV-1a 64bit (8バイト単位で混ぜ、端数は1バイトずつ)
+static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		unsigned long long word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash ^= word;
+		hash *= 1099511628211ull;
+	}
+	for (; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+TextureFile::TextureFile()
+	: mFormat(Format_None)
+	, mSourceHash(0)
+{
+}
+
+/////////////////////////////////////////////////
+// 全ミップレベルの領域を確保する
+// in : format    ピクセルフォーマット
+//      width     レベル0の幅
+//      height    レベル0の高さ
+//      levelNum  ミップレベル数 (1x1までの数を超えた分は作らない)
+////////////////////////////////////////////////
+void TextureFile::create(Format format, int width, int height, unsigned int levelNum)
+{
+	clear();
+	mFormat = format;
+	levelNum = Math::Min(Math::Max(levelNum, 1u), getFullLevelNum(width, height));
+
+	size_t offset = 0;
+	for (unsigned int i = 0; i < levelNum; i++)
+	{
+		TextureLevel level;
+		level.width  = Math::Max(width >> i, 1);
+		level.height = Math::Max(height >> i, 1);
+		level.offset = offset;
+		level.size   = getLevelSize(format, level.width, level.height);
+		mLevels.push_back(level);
+		offset += level.size;
+	}
+	mData.assign(offset, 0);
+}
+
+void TextureFile::clear()
+{
+	mFormat = Format_None;
+	mLevels.clear();
+	mData.clear();
+	mSourceHash = 0;
+}
+
+/////////////////////////////////////////////////
+// DDSファイルを読み込む
+// in  : path  ファイル名
+// out : 読み込めたらtrue (無い・対応していない形式・壊れている場合はfalse)
+////////////////////////////////////////////////
+bool TextureFile::loadDDS(const std::string& path)
+{
+	clear();
+
+	MappedFile file;
+	if (!file.open(path))
+	{
+		return false;
+	}
+
+	Info   info;
+	size_t dataOffset;
+	if (!parseDDSHeader(file.getData(), file.getSize(), info, dataOffset))
+	{
+		if (info.format == Format_None && dataOffset > 0)
+		{
+			std::cout << "対応していないDDSの形式 : " << path << std::endl;
+		}
+		return false;
+	}
+
+	create(info.format, info.width, info.height, info.levelNum);
+	if (file.getSize() < dataOffset + mData.size())
+	{
+		// 書き込み途中のファイル
+		clear();
+		return false;
+	}
+	memcpy(mData.data(), file.getData() + dataOffset, mData.size());
+	mSourceHash = info.sourceHash;
+	return true;
+}
+
+/////////////////////////////////////////////////
+// DDS・PNGのヘッダーだけを読み、大きさと形式を調べる
+// in  : path  ファイル名 (拡張子ではなく先頭のシグネチャで判別する)
+// out : dest  大きさと形式
+//       分かればtrue
+////////////////////////////////////////////////
+bool TextureFile::readInfo(const std::string& path, Info& dest)
+{
+	// DDSのヘッダー (DX10拡張を含む) が収まる分だけ読む
+	unsigned char head[4 + sizeof(DdsHeader) + sizeof(DdsHeaderDX10)];
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	file.read(reinterpret_cast<char*>(head), sizeof(head));
+	const size_t size = static_cast<size_t>(file.gcount());
+
+	// PNG : シグネチャ(8) + IHDRチャンク (長さ4 + "IHDR" + 幅4 + 高さ4 + ビット深度1 + カラータイプ1)
+	static const unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	if (size >= 26 && memcmp(head, pngSignature, sizeof(pngSignature)) == 0 && memcmp(head + 12, "IHDR", 4) == 0)
+	{
+		dest.width      = static_cast<int>((head[16] << 24) | (head[17] << 16) | (head[18] << 8) | head[19]);
+		dest.height     = static_cast<int>((head[20] << 24) | (head[21] << 16) | (head[22] << 8) | head[23]);
+		dest.format     = head[25] == 2 ? Format_RGB8 : Format_RGBA8; // 2 : トゥルーカラー (アルファ無し)
+		dest.levelNum   = 1;
+		dest.sourceHash = 0;
+		dest.sourceSize = 0;
+		dest.sourceTime = 0;
+		return dest.width > 0 && dest.height > 0;
+	}
+
+	size_t dataOffset;
+	return parseDDSHeader(head, size, dest, dataOffset);
+}
+
+/////////////////////////////////////////////////
+// DDSのヘッダーを解釈する
+// in  : data, size  ファイルの先頭
+// out : dest        大きさと形式 (形式が分からなければFormat_None)
+//       dataOffset  ピクセルデータの位置 (DDSでなければ0)
+//       対応している形式ならtrue
+////////////////////////////////////////////////
+bool TextureFile::parseDDSHeader(const unsigned char* data, size_t size, Info& dest, size_t& dataOffset)
+{
+	dest.format = Format_None;
+	dataOffset  = 0;
+	if (size < 4 + sizeof(DdsHeader) || memcmp(data, "DDS ", 4) != 0)
+	{
+		return false;
+	}
+
+	DdsHeader header;
+	memcpy(&header, data + 4, sizeof(header));
+	if (header.size != sizeof(DdsHeader) || header.width == 0 || header.height == 0)
+	{
+		return false;
+	}
+	dataOffset = 4 + sizeof(DdsHeader);
+
+	if ((header.pixelFormat.flags & ddpfFourCC) && header.pixelFormat.fourCC == makeFourCC("DX10"))
+	{
+		DdsHeaderDX10 headerDX10;
+		if (size < dataOffset + sizeof(headerDX10))
+		{
+			return false;
+		}
+		memcpy(&headerDX10, data + dataOffset, sizeof(headerDX10));
+		dataOffset += sizeof(headerDX10);
+		if (headerDX10.resourceDimension != dxgiResourceTexture2D || headerDX10.arraySize > 1)
+		{
+			return false;
+		}
+		dest.format = formatFromDxgi(headerDX10.dxgiFormat);
+	}
+	else
+	{
+		dest.format = formatFromPixelFormat(header.pixelFormat);
+	}
+
+	dest.width      = static_cast<int>(header.width);
+	dest.height     = static_cast<int>(header.height);
+	dest.levelNum   = Math::Min((header.flags & ddsdMipMapCount) ? Math::Max(header.mipMapCount, 1u) : 1u, getFullLevelNum(dest.width, dest.height));
+	dest.sourceHash = 0;
+	dest.sourceSize = 0;
+	dest.sourceTime = 0;
+	if (header.reserved1[0] == sourceHashTag)
+	{
+		dest.sourceHash = static_cast<unsigned long long>(header.reserved1[1]) | (static_cast<unsigned long long>(header.reserved1[2]) << 32);
+		dest.sourceSize = static_cast<unsigned long long>(header.reserved1[3]) | (static_cast<unsigned long long>(header.reserved1[4]) << 32);
+		dest.sourceTime = static_cast<long long>(static_cast<unsigned long long>(header.reserved1[5]) | (static_cast<unsigned long long>(header.reserved1[6]) << 32));
+	}
+	return dest.format != Format_None;
+}
+
+/////////////////////////////////////////////////
+// DDSファイルを書き出す
+// in  : path        ファイル名
+//       sourcePath  元の画像ファイル名 (内容のハッシュと大きさ・更新時刻を予約領域に入れる、空なら入れない)
+// out : 書き出せたらtrue
+////////////////////////////////////////////////
+bool TextureFile::saveDDS(const std::string& path, const std::string& sourcePath) const
+{
+	if (mLevels.empty())
+	{
+		return false;
+	}
+
+	DdsHeader header;
+	memset(&header, 0, sizeof(header));
+	header.size              = sizeof(DdsHeader);
+	header.flags             = ddsdCaps | ddsdHeight | ddsdWidth | ddsdPixelFormat | ddsdMipMapCount;
+	header.height            = static_cast<unsigned int>(mLevels[0].height);
+	header.width             = static_cast<unsigned int>(mLevels[0].width);
+	header.mipMapCount       = getLevelNum();
+	header.pixelFormat.size  = sizeof(DdsPixelFormat);
+	header.caps              = ddsCapsTexture | (getLevelNum() > 1 ? ddsCapsComplex | ddsCapsMipMap : 0);
+
+	DdsHeaderDX10 headerDX10;
+	memset(&headerDX10, 0, sizeof(headerDX10));
+	bool useDX10 = false;
+
+	if (isCompressed(mFormat))
+	{
+		header.flags                |= ddsdLinearSize;
+		header.pitchOrLinearSize     = static_cast<unsigned int>(mLevels[0].size);
+		header.pixelFormat.flags     = ddpfFourCC;
+		switch (mFormat)
+		{
+		case Format_BC1: header.pixelFormat.fourCC = makeFourCC("DXT1"); break;
+		case Format_BC3: header.pixelFormat.fourCC = makeFourCC("DXT5"); break;
+		case Format_BC4: header.pixelFormat.fourCC = makeFourCC("ATI1"); break;
+		case Format_BC5: header.pixelFormat.fourCC = makeFourCC("ATI2"); break;
+		default:
+			// BC7は旧来のfourCCが無いのでDX10拡張ヘッダーを使う
+			header.pixelFormat.fourCC    = makeFourCC("DX10");
+			headerDX10.dxgiFormat        = 98; // DXGI_FORMAT_BC7_UNORM
+			headerDX10.resourceDimension = dxgiResourceTexture2D;
+			headerDX10.arraySize         = 1;
+			useDX10 = true;
+			break;
+		}
+	}
+	else
+	{
+		header.flags                  |= ddsdPitch;
+		header.pitchOrLinearSize       = static_cast<unsigned int>(mLevels[0].width * getBlockBytes(mFormat));
+		header.pixelFormat.flags       = ddpfRGB | (mFormat == Format_RGBA8 ? ddpfAlphaPixels : 0);
+		header.pixelFormat.rgbBitCount = getBlockBytes(mFormat) * 8;
+		header.pixelFormat.rMask       = 0x000000ff;
+		header.pixelFormat.gMask       = 0x0000ff00;
+		header.pixelFormat.bMask       = 0x00ff0000;
+		header.pixelFormat.aMask       = mFormat == Format_RGBA8 ? 0xff000000 : 0;
+	}
+
+	if (!sourcePath.empty())
+	{
+		bool found;
+		const unsigned long long sourceHash = hashFile(sourcePath, found);
+		if (found)
+		{
+			header.reserved1[0] = sourceHashTag;
+			header.reserved1[1] = static_cast<unsigned int>(sourceHash);
+			header.reserved1[2] = static_cast<unsigned int>(sourceHash >> 32);
+
+			unsigned long long sourceSize;
+			long long          sourceTime;
+			if (getFileStamp(sourcePath, sourceSize, sourceTime))
+			{
+				header.reserved1[3] = static_cast<unsigned int>(sourceSize);
+				header.reserved1[4] = static_cast<unsigned int>(sourceSize >> 32);
+				header.reserved1[5] = static_cast<unsigned int>(static_cast<unsigned long long>(sourceTime));
+				header.reserved1[6] = static_cast<unsigned int>(static_cast<unsigned long long>(sourceTime) >> 32);
+			}
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ファイル書き込み失敗 : " << path << std::endl;
+		return false;
+	}
+	file.write("DDS ", 4);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (useDX10)
+	{
+		file.write(reinterpret_cast<const char*>(&headerDX10), sizeof(headerDX10));
+	}
+	file.write(reinterpret_cast<const char*>(mData.data()), static_cast<std::streamsize>(mData.size()));
+	return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////
+// 元の画像ファイルから変わっていないか
+// in  : sourceHash  DDSに埋め込まれていたハッシュ
+//       sourcePath  元の画像ファイル名
+// out : ハッシュが一致するか、比べられない (ハッシュが無い・元の画像が無い) 場合はtrue
+////////////////////////////////////////////////
+bool TextureFile::isSourceCurrent(unsigned long long sourceHash, const std::string& sourcePath)
+{
+	if (sourceHash == 0)
+	{
+		return true;
+	}
+	bool found;
+	const unsigned long long currentHash = hashFile(sourcePath, found);
+	return !found || currentHash == sourceHash;
+}
+
+/////////////////////////////////////////////////
+// 元の画像ファイルの大きさと更新時刻が、DDSに埋め込まれた値と同じか
+// 中身は読まないのでメインスレッドでの選択に使い、ハッシュはワーカーで isSourceCurrent() で確かめる
+// in  : info        readInfoで読んだDDSのヘッダーの情報
+//       sourcePath  元の画像ファイル名
+// out : 同じか、比べられない (ハッシュ・時刻が無い、元の画像が無い) 場合はtrue
+////////////////////////////////////////////////
+bool TextureFile::isSourceStampCurrent(const Info& info, const std::string& sourcePath)
+{
+	if (info.sourceHash == 0 || info.sourceTime == 0)
+	{
+		return true;
+	}
+	unsigned long long size;
+	long long          time;
+	if (!getFileStamp(sourcePath, size, time))
+	{
+		return true;
+	}
+	return size == info.sourceSize && time == info.sourceTime;
+}
+
+bool TextureFile::isCompressed(Format format)
+{
+	return format == Format_BC1 || format == Format_BC3 || format == Format_BC4 || format == Format_BC5 || format == Format_BC7;
+}
+
+unsigned int TextureFile::getBlockBytes(Format format)
+{
+	switch (format)
+	{
+	case Format_RGB8:  return 3;
+	case Format_RGBA8: return 4;
+	case Format_BC1:
+	case Format_BC4:   return 8;
+	case Format_BC3:
+	case Format_BC5:
+	case Format_BC7:   return 16;
+	default:           return 0;
+	}
+}
+
+size_t TextureFile::getLevelSize(Format format, int width, int height)
+{
+	if (isCompressed(format))
+	{
+		const size_t blocksX = static_cast<size_t>(Math::Max((width + 3) / 4, 1));
+		const size_t blocksY = static_cast<size_t>(Math::Max((height + 3) / 4, 1));
+		return blocksX * blocksY * getBlockBytes(format);
+	}
+	return static_cast<size_t>(width) * height * getBlockBytes(format);
+}
+
+unsigned int TextureFile::getFullLevelNum(int width, int height)
+{
+	unsigned int levelNum = 1;
+	for (int size = Math::Max(width, height); size > 1; size >>= 1)
+	{
+		levelNum++;
+	}
+	return levelNum;
+}
+
+GLenum TextureFile::getInternalFormat(Format format)
+{
+	switch (format)
+	{
+	case Format_RGB8:  return GL_RGB8;
+	case Format_RGBA8: return GL_RGBA8;
+	case Format_BC1:   return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case Format_BC3:   return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case Format_BC4:   return GL_COMPRESSED_RED_RGTC1;
+	case Format_BC5:   return GL_COMPRESSED_RG_RGTC2;
+	case Format_BC7:   return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default:           return GL_NONE;
+	}
+}
+
+GLenum TextureFile::getPixelFormat(Format format)
+{
+	return format == Format_RGB8 ? GL_RGB : GL_RGBA;
+}
+
+const char* TextureFile::getFormatName(Format format)
+{
+	switch (format)
+	{
+	case Format_RGB8:  return "RGB8";
+	case Format_RGBA8: return "RGBA8";
+	case Format_BC1:   return "BC1";
+	case Format_BC3:   return "BC3";
+	case Format_BC4:   return "BC4";
+	case Format_BC5:   return "BC5";
+	case Format_BC7:   return "BC7";
+	default:           return "none";
+	}
+}
+
+std::string TextureFile::getCompressedPath(const std::string& imagePath)
+{
+	const size_t dot   = imagePath.find_last_of('.');
+	const size_t slash = imagePath.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+	{
+		return imagePath + ".dds";
+	}
+	return imagePath.substr(0, dot) + ".dds";
+}
+
+std::string TextureFile::getMipCachePath(const std::string& imagePath)
+{
+	const std::string compressedPath = getCompressedPath(imagePath);
+	return compressedPath.substr(0, compressedPath.size() - 4) + ".mip.dds";
+}
+
+unsigned long long TextureFile::hashFile(const std::string& path, bool& found)
+{
+	MappedFile file;
+	found = file.open(path);
+	if (!found)
+	{
+		return 0;
+	}
+	return hashBytes(14695981039346656037ull, file.getData(), file.getSize());
+}
+
+bool TextureFile::getFileStamp(const std::string& path, unsigned long long& size, long long& time)
+{
+	std::error_code error;
+	size = static_cast<unsigned long long>(std::filesystem::file_size(path, error));
+	if (error)
+	{
+		return false;
+	}
+	time = static_cast<long long>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+	return !error;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// S3TC (BC1/BC3) はGL4.2のコアに無いので拡張の定数を定義しておく (GL_EXT_texture_compression_s3tc)
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// ミップレベル1枚分の位置
+struct TextureLevel
+{
+	int    width;
+	int    height;
+	size_t offset;   // getData() の先頭から
+	size_t size;     // バイト数
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// テクスチャのピクセルデータ (全ミップレベル) とDDSファイルの読み書き
+// 非圧縮のRGB8/RGBA8と、ブロック圧縮(BC1/BC3/BC4/BC5/BC7)を扱う
+// GLは使わないので、ワーカースレッドでの読み込みや変換ツールでも使える
+//
+// 変換ツールが書き出すDDSは元の画像ファイルのハッシュと大きさ・更新時刻を予約領域に持ち、
+// 元の画像が書き換えられていたら isSourceCurrent() (中身を読む) がfalseを返す
+// isSourceStampCurrent() はファイルの大きさと更新時刻だけを比べる軽い確認で、メインスレッドで使う
+// readInfo() はファイルの先頭だけを読み、中身を読む前にテクスチャの大きさと形式を知るのに使う
+///////////////////////////////////////////////////////////////////////////////////////
+class TextureFile
+{
+public:
+	enum Format
+	{
+		Format_None,
+		Format_RGB8,
+		Format_RGBA8,
+		Format_BC1,      // RGB 4bpp
+		Format_BC3,      // RGBA 8bpp (アルファはBC4と同じ形式)
+		Format_BC4,      // R 4bpp
+		Format_BC5,      // RG 8bpp
+		Format_BC7,      // RGBA 8bpp (読み込みのみ)
+	};
+
+	// ファイルの先頭から分かる情報
+	struct Info
+	{
+		Format             format;       // PNGはRGB8 / RGBA8 (パレット・グレースケールはRGBA8に変換して読む)
+		int                width;
+		int                height;
+		unsigned int       levelNum;     // PNGは1
+		unsigned long long sourceHash;   // DDSに埋め込まれた元の画像のハッシュ (無ければ0)
+		unsigned long long sourceSize;   // 同じく元の画像のバイト数 (無ければ0)
+		long long          sourceTime;   // 同じく元の画像の更新時刻 (std::filesystemの時刻の値、無ければ0)
+	};
+
+	TextureFile();
+
+	void                 create(Format format, int width, int height, unsigned int levelNum); // 全レベルの領域を確保する (内容は0)
+	void                 clear();
+	bool                 loadDDS(const std::string& path);                          // DDSを読み込む (対応していない形式は失敗)
+	bool                 saveDDS(const std::string& path, const std::string& sourcePath = "") const; // DDSを書き出す (sourcePathのハッシュを埋め込む)
+	bool                 isSourceCurrent(const std::string& sourcePath) const { return isSourceCurrent(mSourceHash, sourcePath); }
+
+	Format               getFormat() const { return mFormat; }
+	int                  getWidth() const { return mLevels.empty() ? 0 : mLevels[0].width; }
+	int                  getHeight() const { return mLevels.empty() ? 0 : mLevels[0].height; }
+	unsigned int         getLevelNum() const { return static_cast<unsigned int>(mLevels.size()); }
+	const TextureLevel&  getLevel(unsigned int level) const { return mLevels[level]; }
+	unsigned char*       getLevelData(unsigned int level) { return mData.data() + mLevels[level].offset; }
+	const unsigned char* getLevelData(unsigned int level) const { return mData.data() + mLevels[level].offset; }
+	const std::vector<unsigned char>& getData() const { return mData; }
+
+	static bool          readInfo(const std::string& path, Info& dest);             // DDS・PNGのヘッダーだけを読む
+	static bool          isSourceCurrent(unsigned long long sourceHash, const std::string& sourcePath); // 元の画像から変わっていないか (比べられなければtrue)
+	static bool          isSourceStampCurrent(const Info& info, const std::string& sourcePath); // 元の画像の大きさと更新時刻が同じか (比べられなければtrue)
+	static bool          isCompressed(Format format);                           // ブロック圧縮か
+	static unsigned int  getBlockBytes(Format format);                          // 4x4ブロック1つのバイト数 (非圧縮なら1画素のバイト数)
+	static size_t        getLevelSize(Format format, int width, int height);    // 1レベルのバイト数
+	static unsigned int  getFullLevelNum(int width, int height);                // 1x1までのミップレベル数
+	static GLenum        getInternalFormat(Format format);                      // glCompressedTexImage2D / glTexImage2D の内部フォーマット
+	static GLenum        getPixelFormat(Format format);                         // 非圧縮の glTexImage2D の format
+	static const char*   getFormatName(Format format);
+	static std::string   getCompressedPath(const std::string& imagePath);       // 変換後のファイル名 (拡張子を.ddsにする)
+	static std::string   getMipCachePath(const std::string& imagePath);         // 実行時に作ったミップ付きRGB8/RGBA8の保存先 (拡張子を.mip.ddsにする)
+
+private:
+	static bool          parseDDSHeader(const unsigned char* data, size_t size, Info& dest, size_t& dataOffset); // DDSのヘッダーを解釈する
+	static unsigned long long hashFile(const std::string& path, bool& found);  // ファイル内容のハッシュ
+	static bool          getFileStamp(const std::string& path, unsigned long long& size, long long& time); // ファイルの大きさと更新時刻
+
+	Format                    mFormat;
+	std::vector<TextureLevel> mLevels;
+	std::vector<unsigned char> mData;
+	unsigned long long        mSourceHash;    // DDSに埋め込まれていた元の画像のハッシュ (無ければ0)
+};
@@ -0,0 +1,473 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include "TextureRegistry.h"
+#include "AssetLoader.h"
+#include "BlockEncoder.h"
+#include "RenderState.h"
+
+// 読み込み中のテクスチャの既定の仮の色 (灰色)
+static const unsigned char defaultPlaceholder[4] = { 128, 128, 128, 255 };
+
+// 内部フォーマットから仮の色を圧縮する時の形式 (圧縮でなければFormat_None)
+static TextureFile::Format getBlockFormat(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return TextureFile::Format_BC1;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return TextureFile::Format_BC3;
+	case GL_COMPRESSED_RED_RGTC1:          return TextureFile::Format_BC4;
+	case GL_COMPRESSED_RG_RGTC2:           return TextureFile::Format_BC5;
+	default:                               return TextureFile::Format_None;
+	}
+}
+
+TextureRegistry::TextureRegistry()
+	: mTotalBytes(0)
+	, mRequestNum(0)
+	, mSharedNum(0)
+{
+}
+
+/////////////////////////////////////////////////
+// 画像ファイルのテクスチャを得る
+// 登録済みなら参照数を増やして同じテクスチャ名を返し、無ければ読み込みを要求する
+// in  : path         画像ファイル名
+//       placeholder  読み込み中の色 (RGBA、nullptrなら灰色。登録済みなら使わない)
+// out : テクスチャ名
+////////////////////////////////////////////////
+GLuint TextureRegistry::acquire(const std::string& path, const unsigned char* placeholder)
+{
+	mRequestNum++;
+	const std::string key = getCanonicalPath(path);
+	auto found = mPaths.find(key);
+	if (found != mPaths.end())
+	{
+		found->second->refCount++;
+		mSharedNum++;
+		return found->second->texture;
+	}
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D, texture);
+
+	// テクスチャラッピング＆フィルタリング設定 (縮小は読み込んだ・作ったミップレベルを使う)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	Entry* entry = createEntry(path, texture, GL_TEXTURE_2D);
+	entry->key      = key;
+	entry->fromFile = true;
+	mPaths[key] = entry;
+
+	// ヘッダーから大きさと形式が分かれば先に確保し、最小のミップレベルの仮の色から描く
+	// (BC7は仮の色を圧縮できないので、読み込みが終わるまで確保しない)
+	TextureFile::Info info;
+	const std::string file = ASSET_LOADER_INSTANCE.selectTextureFile(path, info);
+	GLenum       internalFormat;
+	unsigned int levelNum;
+	if (info.format != TextureFile::Format_BC7 && getStorageFormat(info, internalFormat, levelNum))
+	{
+		allocateStorage(texture, internalFormat, info.width, info.height, levelNum);
+		fillPlaceholder(texture, placeholder ? placeholder : defaultPlaceholder);
+	}
+
+	ASSET_LOADER_INSTANCE.requestTexture(texture, path, file);
+	return texture;
+}
+
+/////////////////////////////////////////////////
+// 描画先などの空のテクスチャを作る (パスの表には載せない)
+// in  : name            レポートに出す名前
+//       internalFormat  内部フォーマット
+//       width, height   大きさ
+//       levelNum        ミップレベル数
+// out : テクスチャ名 (パラメーターは呼び出し側で設定する)
+////////////////////////////////////////////////
+GLuint TextureRegistry::createTexture(const std::string& name, GLenum internalFormat, int width, int height, unsigned int levelNum)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	createEntry(name, texture, GL_TEXTURE_2D);
+	allocateStorage(texture, internalFormat, width, height, levelNum);
+	return texture;
+}
+
+/////////////////////////////////////////////////
+// 空のテクスチャ配列を作る (パスの表には載せない)
+// 不変ストレージなので、レイヤー数は作る時に決めておく
+// in  : name            レポートに出す名前
+//       internalFormat  内部フォーマット (全レイヤー共通)
+//       width, height   レベル0の大きさ (全レイヤー共通)
+//       levelNum        ミップレベル数
+//       layerNum        レイヤー数
+// out : テクスチャ名 (パラメーターは呼び出し側で設定する)
+////////////////////////////////////////////////
+GLuint TextureRegistry::createTextureArray(const std::string& name, GLenum internalFormat, int width, int height, unsigned int levelNum,
+	unsigned int layerNum)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	Entry* entry = createEntry(name, texture, GL_TEXTURE_2D_ARRAY);
+
+	RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLsizei>(levelNum), internalFormat, width, height, static_cast<GLsizei>(layerNum));
+
+	entry->internalFormat = internalFormat;
+	entry->width          = width;
+	entry->height         = height;
+	entry->levelNum       = levelNum;
+	entry->layerNum       = layerNum;
+	for (unsigned int i = 0; i < levelNum; i++)
+	{
+		entry->bytes += getLevelBytes(internalFormat, std::max(width >> i, 1), std::max(height >> i, 1)) * layerNum;
+	}
+	mTotalBytes += entry->bytes;
+	return texture;
+}
+
+TextureRegistry::Entry* TextureRegistry::createEntry(const std::string& name, GLuint texture, GLenum target)
+{
+	Entry* entry = new Entry;
+	entry->name           = name;
+	entry->texture        = texture;
+	entry->target         = target;
+	entry->refCount       = 1;
+	entry->fromFile       = false;
+	entry->internalFormat = GL_NONE;
+	entry->width          = 0;
+	entry->height         = 0;
+	entry->levelNum       = 0;
+	entry->layerNum       = 1;
+	entry->bytes          = 0;
+	mTextures[texture] = entry;
+	return entry;
+}
+
+void TextureRegistry::addRef(GLuint texture)
+{
+	auto found = mTextures.find(texture);
+	if (found != mTextures.end())
+	{
+		found->second->refCount++;
+	}
+}
+
+void TextureRegistry::release(GLuint texture)
+{
+	auto found = mTextures.find(texture);
+	if (found == mTextures.end())
+	{
+		return;
+	}
+	if (--found->second->refCount == 0)
+	{
+		destroy(found->second);
+	}
+}
+
+/////////////////////////////////////////////////
+// 残っているテクスチャを全て削除する (GLコンテキストの破棄前)
+// 解放し忘れたテクスチャは名前を出力する
+////////////////////////////////////////////////
+void TextureRegistry::releaseAll()
+{
+	std::vector<Entry*> entries;
+	for (const auto& pair : mTextures)
+	{
+		entries.push_back(pair.second);
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) { return a->texture < b->texture; });
+	for (Entry* entry : entries)
+	{
+		std::cout << "解放されていないテクスチャ : " << entry->name << std::endl;
+		destroy(entry);
+	}
+}
+
+void TextureRegistry::destroy(Entry* entry)
+{
+	ASSET_LOADER_INSTANCE.cancel(entry->texture);
+	RENDER_STATE_INSTANCE.onDeleteTexture(entry->texture);
+	glDeleteTextures(1, &entry->texture);
+
+	mTotalBytes -= entry->bytes;
+	if (entry->fromFile)
+	{
+		mPaths.erase(entry->key);
+	}
+	mTextures.erase(entry->texture);
+	delete entry;
+}
+
+/////////////////////////////////////////////////
+// 不変ストレージを確保する
+// 確保済みなら作り直せないので、同じ大きさ・形式かどうかだけを返す
+// in  : texture         テクスチャ名
+//       internalFormat  内部フォーマット
+//       width, height   レベル0の大きさ
+//       levelNum        ミップレベル数
+// out : 要求どおりのストレージがあればtrue
+////////////////////////////////////////////////
+bool TextureRegistry::allocateStorage(GLuint texture, GLenum internalFormat, int width, int height, unsigned int levelNum)
+{
+	auto found = mTextures.find(texture);
+	if (found == mTextures.end())
+	{
+		return false;
+	}
+	Entry* entry = found->second;
+	if (entry->internalFormat != GL_NONE)
+	{
+		return entry->internalFormat == internalFormat && entry->width == width && entry->height == height && entry->levelNum == levelNum;
+	}
+
+	RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(levelNum), internalFormat, width, height);
+
+	entry->internalFormat = internalFormat;
+	entry->width          = width;
+	entry->height         = height;
+	entry->levelNum       = levelNum;
+	entry->bytes          = 0;
+	for (unsigned int i = 0; i < levelNum; i++)
+	{
+		entry->bytes += getLevelBytes(internalFormat, std::max(width >> i, 1), std::max(height >> i, 1));
+	}
+	mTotalBytes += entry->bytes;
+	return true;
+}
+
+/////////////////////////////////////////////////
+// 最小のミップレベルを1色で埋め、BASE_LEVELをそこに合わせて描けるようにする
+// in : texture  テクスチャ名
+//      color    RGBA
+////////////////////////////////////////////////
+void TextureRegistry::fillPlaceholder(GLuint texture, const unsigned char* color)
+{
+	auto found = mTextures.find(texture);
+	if (found == mTextures.end() || found->second->internalFormat == GL_NONE || found->second->target != GL_TEXTURE_2D)
+	{
+		return;
+	}
+	const Entry* entry = found->second;
+
+	const GLint level  = static_cast<GLint>(entry->levelNum - 1);
+	const int   width  = std::max(entry->width >> level, 1);
+	const int   height = std::max(entry->height >> level, 1);
+	std::vector<unsigned char> pixels;
+	makeSolidLevel(pixels, entry->internalFormat, width, height, color);
+
+	RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (getBlockFormat(entry->internalFormat) != TextureFile::Format_None)
+	{
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, entry->internalFormat, static_cast<GLsizei>(pixels.size()), pixels.data());
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+}
+
+/////////////////////////////////////////////////
+// テクスチャ配列の1レイヤーを全ミップレベル1色で埋める
+// (BASE_LEVELは全レイヤー共通なので、2Dのように最小のレベルだけ埋めて済ませることはできない)
+// in : texture  テクスチャ配列の名前
+//      layer    レイヤー番号
+//      color    RGBA
+////////////////////////////////////////////////
+void TextureRegistry::fillLayer(GLuint texture, unsigned int layer, const unsigned char* color)
+{
+	auto found = mTextures.find(texture);
+	if (found == mTextures.end() || found->second->target != GL_TEXTURE_2D_ARRAY || layer >= found->second->layerNum)
+	{
+		return;
+	}
+	const Entry* entry      = found->second;
+	const bool   compressed = getBlockFormat(entry->internalFormat) != TextureFile::Format_None;
+
+	RENDER_STATE_INSTANCE.bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	std::vector<unsigned char> pixels;
+	for (unsigned int i = 0; i < entry->levelNum; i++)
+	{
+		const int width  = std::max(entry->width >> i, 1);
+		const int height = std::max(entry->height >> i, 1);
+		makeSolidLevel(pixels, entry->internalFormat, width, height, color);
+		if (compressed)
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, width, height, 1, entry->internalFormat,
+				static_cast<GLsizei>(pixels.size()), pixels.data());
+		}
+		else
+		{
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/////////////////////////////////////////////////
+// 1色で埋めたレベルの転送データを作る
+// 圧縮形式は1色ならどのブロックも同じなので、4x4を1つ圧縮して並べる
+// in  : internalFormat  内部フォーマット
+//       width, height   レベルの大きさ
+//       color           RGBA
+// out : dest            圧縮形式はブロックの並び、それ以外はRGBA8の画素
+////////////////////////////////////////////////
+void TextureRegistry::makeSolidLevel(std::vector<unsigned char>& dest, GLenum internalFormat, int width, int height, const unsigned char* color)
+{
+	const TextureFile::Format blockFormat = getBlockFormat(internalFormat);
+	if (blockFormat != TextureFile::Format_None)
+	{
+		unsigned char pixels[4 * 4 * 4];
+		unsigned char block[16];
+		for (int i = 0; i < 4 * 4; i++)
+		{
+			std::copy(color, color + 4, pixels + i * 4);
+		}
+		BlockEncoder::encode(block, pixels, 4, 4, blockFormat, 1);
+
+		const size_t blockBytes = TextureFile::getBlockBytes(blockFormat);
+		dest.resize(TextureFile::getLevelSize(blockFormat, width, height));
+		for (size_t i = 0; i < dest.size(); i += blockBytes)
+		{
+			std::copy(block, block + blockBytes, dest.begin() + i);
+		}
+	}
+	else
+	{
+		dest.resize(static_cast<size_t>(width) * height * 4);
+		for (size_t i = 0; i < dest.size(); i += 4)
+		{
+			std::copy(color, color + 4, dest.begin() + i);
+		}
+	}
+}
+
+GLenum TextureRegistry::getTarget(GLuint texture) const
+{
+	auto found = mTextures.find(texture);
+	return found != mTextures.end() ? found->second->target : GL_TEXTURE_2D;
+}
+
+size_t TextureRegistry::getMemoryBytes(GLuint texture) const
+{
+	auto found = mTextures.find(texture);
+	return found != mTextures.end() ? found->second->bytes : 0;
+}
+
+void TextureRegistry::printReport(std::ostream& os) const
+{
+	std::vector<const Entry*> entries;
+	for (const auto& pair : mTextures)
+	{
+		entries.push_back(pair.second);
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) { return a->texture < b->texture; });
+
+	os << "texture registry : " << entries.size() << " textures, " << mRequestNum << " requests (" << mSharedNum << " shared), "
+	   << std::fixed << std::setprecision(2) << mTotalBytes / (1024.0 * 1024.0) << " MB" << std::endl;
+	for (const Entry* entry : entries)
+	{
+		os << "  " << std::left << std::setw(56) << entry->name << std::right
+		   << std::setw(6) << entry->width << "x" << std::left << std::setw(6) << entry->height << std::right
+		   << std::setw(8) << getFormatName(entry->internalFormat) << std::setw(4) << entry->levelNum << " levels"
+		   << std::setw(9) << entry->bytes / (1024.0 * 1024.0) << " MB  refs " << entry->refCount;
+		if (entry->target == GL_TEXTURE_2D_ARRAY)
+		{
+			os << "  layers " << entry->layerNum;
+		}
+		os << std::endl;
+	}
+	os.unsetf(std::ios::fixed);
+	os << std::setprecision(6);
+}
+
+std::string TextureRegistry::getCanonicalPath(const std::string& path)
+{
+	std::error_code error;
+	std::filesystem::path absolute = std::filesystem::absolute(path, error);
+	std::string canonical = (error ? std::filesystem::path(path) : absolute).lexically_normal().generic_string();
+#ifdef _WIN32
+	// Windowsのファイル名は大文字・小文字を区別しない
+	std::transform(canonical.begin(), canonical.end(), canonical.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+#endif
+	return canonical;
+}
+
+/////////////////////////////////////////////////
+// ファイルの内容を入れる不変ストレージの形式
+// ミップレベルを持つファイルはそのレベル数、1レベルだけの非圧縮の画像は読み込み時にMipBuilderで作るレベルも含めて1x1まで確保する
+// 非圧縮はRGBA8に揃える (RGB8もドライバー内では4バイトで持つことが多く、揃えればアルファの有無が違う
+// 画像も同じテクスチャ配列に入れられる。RGBの画素はアルファ1として転送される)
+// in  : info            ファイルの先頭から読んだ情報
+// out : internalFormat  内部フォーマット
+//       levelNum        ミップレベル数
+//       形式が分からなければfalse
+////////////////////////////////////////////////
+bool TextureRegistry::getStorageFormat(const TextureFile::Info& info, GLenum& internalFormat, unsigned int& levelNum)
+{
+	internalFormat = info.format == TextureFile::Format_RGB8 ? GL_RGBA8 : TextureFile::getInternalFormat(info.format);
+	if (internalFormat == GL_NONE || info.width <= 0 || info.height <= 0)
+	{
+		return false;
+	}
+	if (info.levelNum > 1)
+	{
+		levelNum = info.levelNum;
+	}
+	else
+	{
+		levelNum = TextureFile::isCompressed(info.format) ? 1 : TextureFile::getFullLevelNum(info.width, info.height);
+	}
+	return true;
+}
+
+size_t TextureRegistry::getLevelBytes(GLenum internalFormat, int width, int height)
+{
+	const size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+	const size_t pixels = static_cast<size_t>(width) * height;
+	switch (internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RED_RGTC1:          return blocks * 8;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:    return blocks * 16;
+	case GL_RGB8:                          return pixels * 3;
+	case GL_RGBA16F:                       return pixels * 8;
+	default:                               return pixels * 4;   // RGBA8・デプス
+	}
+}
+
+const char* TextureRegistry::getFormatName(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return "BC1";
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return "BC3";
+	case GL_COMPRESSED_RED_RGTC1:          return "BC4";
+	case GL_COMPRESSED_RG_RGTC2:           return "BC5";
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:    return "BC7";
+	case GL_RGB8:                          return "RGB8";
+	case GL_RGBA8:                         return "RGBA8";
+	case GL_RGBA16F:                       return "RGBA16F";
+	case GL_DEPTH_COMPONENT24:             return "D24";
+	case GL_DEPTH_COMPONENT32F:            return "D32F";
+	case GL_NONE:                          return "-";
+	default:                               return "?";
+	}
+}
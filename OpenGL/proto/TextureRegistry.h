@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ostream>
+#include "TextureFile.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// テクスチャの登録簿
+// 画像ファイルのテクスチャを正規化したパスで1つにまとめ、参照数で寿命を管理する
+// (同じファイルを2回要求してもデコードせず、同じテクスチャ名の参照数を増やすだけ)
+//
+// ストレージはglTexStorage2Dの不変ストレージで確保する
+//   ・要求した時にファイルの先頭だけを読み、大きさと形式が分かれば全ミップレベルを確保して、
+//     最小のレベルにだけ仮の色を入れてそこから描く (BASE_LEVEL = 最小のレベル)
+//   ・読み込みが終わるとAssetLoaderが全レベルを書き込み、BASE_LEVELを0に戻す
+//   ・先頭から分からない形式は読み込みが終わった時に確保する (それまでは黒)
+// 描画先のテクスチャ(シャドウマップ・HDRバッファ)とマテリアルのテクスチャ配列も登録し、
+// テクスチャごとのメモリ使用量を記録する
+//
+// 使い方 :
+//   acquire / createTexture → 使い終わったら release (参照数が0になったら削除)
+//   GLコンテキストの破棄前に releaseAll (解放し忘れを報告して全て削除)
+///////////////////////////////////////////////////////////////////////////////////////
+class TextureRegistry
+{
+public:
+	static TextureRegistry& TextureRegistryInstance()    // インスタンス
+	{
+		static TextureRegistry TextureRegistryInstance;
+		return TextureRegistryInstance;
+	}
+
+	~TextureRegistry() {};
+
+	GLuint       acquire(const std::string& path, const unsigned char* placeholder = nullptr); // 画像ファイルのテクスチャ (読み込み中の色はRGBA、nullptrなら灰色)
+	GLuint       createTexture(const std::string& name, GLenum internalFormat, int width, int height, unsigned int levelNum = 1); // 描画先などの空のテクスチャ
+	GLuint       createTextureArray(const std::string& name, GLenum internalFormat, int width, int height, unsigned int levelNum,
+	                                unsigned int layerNum);       // 空のテクスチャ配列 (GL_TEXTURE_2D_ARRAY)
+	void         addRef(GLuint texture);                          // 参照数を増やす
+	void         release(GLuint texture);                         // 参照数を減らし、0になったら削除する
+	void         releaseAll();                                    // 残っているテクスチャを全て削除する
+
+	bool         allocateStorage(GLuint texture, GLenum internalFormat, int width, int height, unsigned int levelNum); // 不変ストレージの確保 (確保済みなら同じ大きさ・形式か調べる)
+	void         fillPlaceholder(GLuint texture, const unsigned char* color); // 最小のミップレベルを1色で埋めてそこから描く (確保前なら何もしない)
+	void         fillLayer(GLuint texture, unsigned int layer, const unsigned char* color); // テクスチャ配列の1レイヤーの全レベルを1色で埋める
+
+	GLenum       getTarget(GLuint texture) const;                 // バインドするターゲット (GL_TEXTURE_2D / GL_TEXTURE_2D_ARRAY)
+
+	size_t       getMemoryBytes(GLuint texture) const;            // テクスチャのメモリ使用量 (確保前は0)
+	size_t       getTotalMemoryBytes() const { return mTotalBytes; }
+	void         printReport(std::ostream& os) const;
+
+	static std::string getCanonicalPath(const std::string& path); // 重複を見分けるためのパス (絶対パス、区切りは'/'、"."と".."を除く)
+	static bool  getStorageFormat(const TextureFile::Info& info, GLenum& internalFormat, unsigned int& levelNum); // ファイルの内容を入れる不変ストレージの形式
+
+private:
+	TextureRegistry(); // シングルトン
+
+	struct Entry
+	{
+		std::string  key;             // 正規化したパス (描画先は空)
+		std::string  name;            // 最初に要求した時のパス / 描画先の名前 (レポート用)
+		GLuint       texture;
+		GLenum       target;          // GL_TEXTURE_2D / GL_TEXTURE_2D_ARRAY
+		unsigned int refCount;
+		bool         fromFile;        // 画像ファイルから読んだか (パスの表に載っているか)
+		GLenum       internalFormat;  // 確保前はGL_NONE
+		int          width;
+		int          height;
+		unsigned int levelNum;
+		unsigned int layerNum;        // テクスチャ配列のレイヤー数 (2Dは1)
+		size_t       bytes;           // 全ミップレベル・全レイヤーの合計
+	};
+
+	Entry*       createEntry(const std::string& name, GLuint texture, GLenum target); // 参照数1の登録 (パスの表には載せない)
+	void         destroy(Entry* entry);
+	static void  makeSolidLevel(std::vector<unsigned char>& dest, GLenum internalFormat, int width, int height, const unsigned char* color); // 1色のレベルの転送データ
+	static size_t getLevelBytes(GLenum internalFormat, int width, int height); // 1レベルのバイト数 (ドライバーの詰め物は含まない)
+	static const char* getFormatName(GLenum internalFormat);
+
+	std::unordered_map<std::string, Entry*> mPaths;               // 正規化したパス → 画像ファイルのテクスチャ
+	std::unordered_map<GLuint, Entry*>      mTextures;            // テクスチャ名 → 全てのテクスチャ
+	size_t       mTotalBytes;                                     // 確保済みのメモリ使用量の合計
+	unsigned int mRequestNum;                                     // acquireの回数
+	unsigned int mSharedNum;                                      // そのうち登録済みのテクスチャを返した回数
+};
+
+#define TEXTURE_REGISTRY_INSTANCE TextureRegistry::TextureRegistryInstance()
@@ -0,0 +1,211 @@
+#include <cstring>
+#include "VertexPacker.h"
+
+// 0を正として符号を返す (八面体の折り返しで0の成分が消えないように)
+static float signNotZero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+static short toSnorm16(float value)
+{
+	value = Math::Clamp(value, -1.0f, 1.0f);
+	return static_cast<short>(value >= 0.0f ? value * 32767.0f + 0.5f : value * 32767.0f - 0.5f);
+}
+
+unsigned short VertexPacker::packHalf(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const unsigned int sign     = (bits >> 16) & 0x8000;
+	const unsigned int exponent = (bits >> 23) & 0xff;
+	unsigned int       mantissa = bits & 0x7fffff;
+
+	// 無限大・NaN
+	if (exponent == 0xff)
+	{
+		return static_cast<unsigned short>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+
+	const int halfExponent = static_cast<int>(exponent) - 127 + 15;
+	if (halfExponent >= 31)
+	{
+		return static_cast<unsigned short>(sign | 0x7c00); // 範囲外は無限大
+	}
+
+	// 非正規化数 (小さすぎるものは0)
+	if (halfExponent <= 0)
+	{
+		if (halfExponent < -10)
+		{
+			return static_cast<unsigned short>(sign);
+		}
+		mantissa |= 0x800000;
+		const unsigned int shift     = static_cast<unsigned int>(14 - halfExponent);
+		const unsigned int remainder = mantissa & ((1u << shift) - 1);
+		const unsigned int halfway   = 1u << (shift - 1);
+		unsigned int       half      = mantissa >> shift;
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+		{
+			half++;
+		}
+		return static_cast<unsigned short>(sign | half);
+	}
+
+	// 正規化数 (仮数の繰り上がりはそのまま指数に伝わる)
+	unsigned int half = (static_cast<unsigned int>(halfExponent) << 10) | (mantissa >> 13);
+	const unsigned int remainder = mantissa & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+	{
+		half++;
+	}
+	return static_cast<unsigned short>(sign | half);
+}
+
+float VertexPacker::unpackHalf(unsigned short value)
+{
+	const unsigned int sign     = static_cast<unsigned int>(value & 0x8000) << 16;
+	const unsigned int exponent = (value >> 10) & 0x1f;
+	const unsigned int mantissa = value & 0x3ff;
+
+	unsigned int bits;
+	if (exponent == 0)
+	{
+		// 0と非正規化数
+		float result = mantissa * (1.0f / 16777216.0f);
+		return sign ? -result : result;
+	}
+	else if (exponent == 31)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+/////////////////////////////////////////////////
+// 単位ベクトルを八面体に投影して正方形に開き、2成分のsnorm16にする
+// (Cigolle et al. "A Survey of Efficient Representations for Independent Unit Vectors")
+// out : dest  エンコード結果
+// in  : vec   単位ベクトル (長さ0なら(0,0,1)扱い)
+////////////////////////////////////////////////
+void VertexPacker::encodeOctahedral(short dest[2], const Vector3& vec)
+{
+	const float length = Math::Abs(vec.x) + Math::Abs(vec.y) + Math::Abs(vec.z);
+	if (length <= 0.0f)
+	{
+		dest[0] = 0;
+		dest[1] = 0;
+		return;
+	}
+
+	float x = vec.x / length;
+	float y = vec.y / length;
+	if (vec.z < 0.0f)
+	{
+		// 下半球は四隅に折り返す
+		const float foldX = (1.0f - Math::Abs(y)) * signNotZero(x);
+		const float foldY = (1.0f - Math::Abs(x)) * signNotZero(y);
+		x = foldX;
+		y = foldY;
+	}
+	dest[0] = toSnorm16(x);
+	dest[1] = toSnorm16(y);
+}
+
+Vector3 VertexPacker::decodeOctahedral(const short src[2])
+{
+	// GLの正規化snormと同じ変換 (-32768も-1.0)
+	const float x = Math::Max(src[0] / 32767.0f, -1.0f);
+	const float y = Math::Max(src[1] / 32767.0f, -1.0f);
+
+	Vector3 vec(x, y, 1.0f - Math::Abs(x) - Math::Abs(y));
+	if (vec.z < 0.0f)
+	{
+		vec.x = (1.0f - Math::Abs(y)) * signNotZero(x);
+		vec.y = (1.0f - Math::Abs(x)) * signNotZero(y);
+	}
+	return Vector3::Normalize(vec);
+}
+
+/////////////////////////////////////////////////
+// float版の頂点を圧縮する
+// out : dest          圧縮した頂点 (vertexCount × MeshObj::getVertexSize(packedFormat) バイト)
+// in  : packedFormat  VertexFormatEnum_PackedPosNormalTex or VertexFormatEnum_PackedPosNormalTexTangent
+//       src           対応するfloat版の頂点 (x,y,z, nx,ny,nz, u,v [, tx,ty,tz,w])
+//       vertexCount   頂点数
+////////////////////////////////////////////////
+void VertexPacker::packVertices(void* dest, MeshObj::VertexFormat packedFormat, const float* src, unsigned int vertexCount)
+{
+	const bool         hasTangent  = packedFormat == MeshObj::VertexFormatEnum_PackedPosNormalTexTangent;
+	const unsigned int srcStride   = hasTangent ? 12 : 8;
+	const unsigned int destSize    = MeshObj::getVertexSize(packedFormat);
+	unsigned char*     destBytes   = static_cast<unsigned char*>(dest);
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		const float*        v = src + static_cast<size_t>(i) * srcStride;
+		PackedTangentVertex packed;
+		packed.position[0] = packHalf(v[0]);
+		packed.position[1] = packHalf(v[1]);
+		packed.position[2] = packHalf(v[2]);
+		packed.position[3] = packHalf(hasTangent ? v[11] : 1.0f); // タンジェント付きなら従法線の向き
+		encodeOctahedral(packed.normal, Vector3(v[3], v[4], v[5]));
+		packed.texCoord[0] = packHalf(v[6]);
+		packed.texCoord[1] = packHalf(v[7]);
+		if (hasTangent)
+		{
+			encodeOctahedral(packed.tangent, Vector3(v[8], v[9], v[10]));
+		}
+
+		// PackedVertex は PackedTangentVertex の先頭と同じ並び
+		memcpy(destBytes + static_cast<size_t>(i) * destSize, &packed, destSize);
+	}
+}
+
+/////////////////////////////////////////////////
+// 圧縮した頂点をfloat版に戻す (GPUが読む値と同じになる)
+// out : dest          float版の頂点 (x,y,z, nx,ny,nz, u,v [, tx,ty,tz,w])
+// in  : packedFormat  srcの頂点フォーマット
+//       src           圧縮した頂点
+//       vertexCount   頂点数
+////////////////////////////////////////////////
+void VertexPacker::unpackVertices(float* dest, MeshObj::VertexFormat packedFormat, const void* src, unsigned int vertexCount)
+{
+	const bool           hasTangent = packedFormat == MeshObj::VertexFormatEnum_PackedPosNormalTexTangent;
+	const unsigned int   destStride = hasTangent ? 12 : 8;
+	const unsigned int   srcSize    = MeshObj::getVertexSize(packedFormat);
+	const unsigned char* srcBytes   = static_cast<const unsigned char*>(src);
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		PackedTangentVertex packed = {};
+		memcpy(&packed, srcBytes + static_cast<size_t>(i) * srcSize, srcSize);
+
+		float*  v      = dest + static_cast<size_t>(i) * destStride;
+		Vector3 normal = decodeOctahedral(packed.normal);
+		v[0] = unpackHalf(packed.position[0]);
+		v[1] = unpackHalf(packed.position[1]);
+		v[2] = unpackHalf(packed.position[2]);
+		v[3] = normal.x;
+		v[4] = normal.y;
+		v[5] = normal.z;
+		v[6] = unpackHalf(packed.texCoord[0]);
+		v[7] = unpackHalf(packed.texCoord[1]);
+		if (hasTangent)
+		{
+			Vector3 tangent = decodeOctahedral(packed.tangent);
+			v[8]  = tangent.x;
+			v[9]  = tangent.y;
+			v[10] = tangent.z;
+			v[11] = unpackHalf(packed.position[3]);
+		}
+	}
+}
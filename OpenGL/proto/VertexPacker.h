@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Math.h"
+#include "MeshObj.h"
+
+// VertexFormatEnum_PackedPosNormalTex の1頂点 (16byte, float版は32byte)
+struct PackedVertex
+{
+	unsigned short position[4];  // 位置 (half x,y,z と 1.0)
+	short          normal[2];    // 法線 (八面体エンコード, snorm16)
+	unsigned short texCoord[2];  // UV (half)
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must be 16 bytes");
+
+// VertexFormatEnum_PackedPosNormalTexTangent の1頂点 (20byte, float版は48byte)
+struct PackedTangentVertex
+{
+	unsigned short position[4];  // 位置 (half x,y,z と 従法線の向き ±1.0)
+	short          normal[2];    // 法線 (八面体エンコード, snorm16)
+	unsigned short texCoord[2];  // UV (half)
+	short          tangent[2];   // タンジェント (八面体エンコード, snorm16)
+};
+static_assert(sizeof(PackedTangentVertex) == 20, "PackedTangentVertex must be 20 bytes");
+
+///////////////////////////////////////////////////////////////////////////////////////
+// 頂点の圧縮・展開
+// 位置とUVは半精度浮動小数、法線とタンジェントは単位ベクトルを八面体に写して2成分のsnorm16にする
+// 位置・UVはGL_HALF_FLOATの頂点属性としてそのまま読め、法線・タンジェントはシェーダーで展開する
+// (Shader/lit.vert の PACKED_VERTEX)
+///////////////////////////////////////////////////////////////////////////////////////
+class VertexPacker
+{
+public:
+	static unsigned short packHalf(float value);                                // float → half (最近接偶数丸め)
+	static float          unpackHalf(unsigned short value);                     // half → float
+	static void           encodeOctahedral(short dest[2], const Vector3& vec);  // 単位ベクトル → 八面体エンコード
+	static Vector3        decodeOctahedral(const short src[2]);                 // 八面体エンコード → 単位ベクトル
+
+	static void           packVertices(void* dest, MeshObj::VertexFormat packedFormat, const float* src, unsigned int vertexCount);
+	static void           unpackVertices(float* dest, MeshObj::VertexFormat packedFormat, const void* src, unsigned int vertexCount);
+
+private:
+	VertexPacker() = delete;
+};
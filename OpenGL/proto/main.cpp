@@ -1,23 +1,28 @@
 #include <iostream>
 #include <SDL/SDL.h>
-#include <SDL/SDL_image.h>
 #include "glad/glad.h"
 #include <stdlib.h>
 #include "Math.h"
 #include "Shader.h"
 #include "FlyCamera.h"
 #include "MeshObj.h"
+#include "RenderState.h"
+#include "Scene.h"
+#include "FrameTimer.h"
+#include "FrameTimeOverlay.h"
+#include "ProgramCache.h"
+#include "MeshCache.h"
+#include "ShaderBuildQueue.h"
+#include "AssetLoader.h"
+#include "TextureRegistry.h"
 
 SDL_Window* SDLWindow;
 SDL_GLContext context;
 SDL_Renderer* renderer;
 
-// ֐vg^Cv錾
+// 関数プロトタイプ宣言
 bool initGL();
 void destroyGL();
-GLuint loadTexture(std::string textureFileName);
-void drawMeshsInScene(Shader* shader, MeshObj& mesh);
-void setTextureUnit(Shader* shader, std::vector<unsigned int>& textures);
 void screenVAOSetting(unsigned int& vao);
 
 void drawModelInScene(Shader* shader, MeshObj& mesh);
@@ -26,168 +31,43 @@ int main(int argc, char** argv)
 {
 	initGL();
 
-	// Jݒ
+	// カメラ設定
 	Vector3 camerapos(18, 5, 5);
 	FlyCamera flyCamera(camerapos);
 
-	unsigned int depthMapFBO;
-	glGenFramebuffers(1, &depthMapFBO);
-	const unsigned int SHADOW_WIDTH = 2048, SHADOW_HEIGHT = 2048;
-
-	unsigned int depthMap;
-	glGenTextures(1, &depthMap);
-	glBindTexture(GL_TEXTURE_2D, depthMap);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-		SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// depthMapFBOɃfvXeNX`A^b`
-	glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// eNX`ǂݍ
-	unsigned int floorTex, floorTexN, floorTexS, pillerTex, pillerTexN, pillerTexS;
-	floorTex = loadTexture("mesh/T_BrickFloor_Clean_A.png");
-	floorTexS = loadTexture("mesh/T_BrickFloor_Clean_S.png");
-	pillerTex = loadTexture("mesh/T_Edge_Stones_And_Straight_Column_Texturing_Albedo.png");
-	pillerTexS = loadTexture("mesh/T_Edge_Stones_And_Straight_Column_Texturing_Specular.png");
-
-	// HDR֘A
-	unsigned int hdrFBO, rbo, floatColorTexture;
-	glGenFramebuffers(1, &hdrFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-	{
-		// FBOɊ蓖Ă邽߂̂̃eNX`쐬
-		glGenTextures(1, &floatColorTexture);
-		glBindTexture(GL_TEXTURE_2D, floatColorTexture);
-
-		// RGBA64bitg
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1024, 768, 0, GL_RGBA, GL_FLOAT, NULL);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// FBOɃJ[eNX`Ƃ frameColorTexture A^b`
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, floatColorTexture, 0);
-
-		// _[obt@̍쐬
-		glGenRenderbuffers(1, &rbo);
-		glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1024, 768);
-
-		// FBOɃ_[obt@[A^b`
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		{
-			std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-		}
-
-		// ̃XN[ɖ߂
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
+	// スクリーン全体を覆う頂点バッファオブジェクト
+	unsigned int screenVAO;
+	screenVAOSetting(screenVAO);
 
-	// XN[Ŝ`lp`p_z
-	float quadVertices[] = {
-		// |WV   // eNX`W
-		-1.0f,  1.0f,  0.0f, 1.0f,
-		-1.0f, -1.0f,  0.0f, 0.0f,
-		 1.0f, -1.0f,  1.0f, 0.0f,
-
-		-1.0f,  1.0f,  0.0f, 1.0f,
-		 1.0f, -1.0f,  1.0f, 0.0f,
-		 1.0f,  1.0f,  1.0f, 1.0f
-	};
+	// シェーダーは非同期にビルドし、揃うまでの間も描画ループを回す
+	SHADER_BUILD_QUEUE_INSTANCE.initialize((GLADloadproc)SDL_GL_GetProcAddress);
 
-	// XN[Ŝ`lp`p VAO
-	unsigned int quadVAO, quadVBO;
-	glGenVertexArrays(1, &quadVAO);
-	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+	// テクスチャ・メッシュも非同期に読み込み、揃った物から描画する
+	ASSET_LOADER_INSTANCE.initialize();
 
-	// XN[Ŝ𕢂_obt@IuWFNg
-	unsigned int screenVAO;
-	screenVAOSetting(screenVAO);
+	// シーン（テクスチャ・メッシュの読み込み要求とシェーダーのビルド開始）
+	Scene* scene = new Scene;
 
-	// bVǂݍ
-	Matrix4 scale = Matrix4::CreateScale(0.01f);
-	MeshObj floorMesh, pillerMesh, sphereMesh;
-	floorMesh.loadMesh("mesh/SM_Floor_Internal.obj", scale);
-	pillerMesh.loadMesh("mesh/SM_Pillar_Internal.obj", scale);
-
-	// ̂炵ĕ\邽߂ɈړsZbg
-	Matrix4 mat = Matrix4::CreateTranslation(Vector3(3.0, 3.0, 3.0));
-	scale = Matrix4::CreateScale(0.1f);
-	mat = scale * mat;
-	sphereMesh.loadMesh("mesh/sphere.obj", mat);
-
-	// bVɃeNX`o^
-	floorMesh.setTexture(floorTex, 0);
-	floorMesh.setTexture(floorTexS, 1);
-	floorMesh.setTexture(depthMap, 2);
-	pillerMesh.setTexture(pillerTex, 0);
-	pillerMesh.setTexture(pillerTexS, 1);
-	pillerMesh.setTexture(depthMap, 2);
-
-	// eNX`zɓo^
-	std::vector<unsigned int>floorTextures;
-	std::vector<unsigned int>pillerTextures;
-
-	floorTextures.emplace_back(floorTex);
-	floorTextures.emplace_back(floorTexS);
-	floorTextures.emplace_back(depthMap);
-	pillerTextures.emplace_back(pillerTex);
-	pillerTextures.emplace_back(pillerTexS);
-	pillerTextures.emplace_back(depthMap);
-
-	// VF[_[
-	Shader phongShader("shader/speculer.vert", "shader/speculer.frag");
-	Shader depthMapShader("shader/depthmap.vert", "shader/depthmap.frag");
-	Shader debugShader("shader/Debugdepthmap.vert", "shader/Debugdepthmap.frag");
-	Shader shadowMapShader("shader/shadowmap.vert", "shader/shadowmap.frag");
-	Shader HDRShader("shader/speculer.vert", "shader/HDR.frag");
-	Shader sphereShader("shader/Sphere.vert", "shader/Sphere.frag");
-	Shader toneMapShader("shader/screen.vert", "shader/tonemap.frag");
-	Shader screenShader("shader/screen.vert", "shader/screen.frag");
-
-	phongShader.setTextureUniformString("diffuseMap", 0);
-	phongShader.setTextureUniformString("SpecluarMap", 1);
-
-	// VF[_p[^
-	Vector3 LightDir(0.5f, 0.5f, -0.5f);
-	Vector3 ambient(0.4f, 0.4f, 0.4f);
-	Vector3 specular(0.8f, 0.8f, 0.8f);
-	Vector3 diffuse(1.0f, 1.0f, 1.0f);
-	LightDir.Normalize();
+	// フレーム時間グラフ
+	FrameTimeOverlay* frameTimeOverlay = new FrameTimeOverlay;
+	bool   showOverlay = true;
+	Uint32 titleUpdateTime = 0;
+	bool   shaderReported = false;
 
 	bool renderLoop = true;
-	Uint32 lastTime = 0;
 	float  deltaTime = 0;
 	MOUSE_INSTANCE.SetRelativeMouseMode(true);
-	float anim = 0.0f;
-
-	float exposure = 1.0f;
 
 	while (renderLoop)
 	{
+		deltaTime = FRAME_TIMER_INSTANCE.beginFrame();
+		FRAME_TIMER_INSTANCE.beginPhase(FramePhase_Input);
 		INPUT_INSTANCE.Update();
-		MOUSE_INSTANCE.Update(); // _[[v̏߂1񂾂Ă
-		deltaTime = (SDL_GetTicks() - lastTime) / 1000.0f;
-		lastTime = SDL_GetTicks();
+		MOUSE_INSTANCE.Update(); // レンダーループの初めに1回だけ呼ぶ
+		Shader::resetFrameStats();
+		RENDER_STATE_INSTANCE.resetFrameStats();
 
-		// ICxg̃Lb`
+		// 終了イベントのキャッチ
 		SDL_Event event;
 		while (SDL_PollEvent(&event))
 		{
@@ -203,117 +83,125 @@ int main(int argc, char** argv)
 			}
 		}
 
+		// フライカメラ
+		FRAME_TIMER_INSTANCE.beginPhase(FramePhase_Camera);
+		SHADER_BUILD_QUEUE_INSTANCE.update();
+		ASSET_LOADER_INSTANCE.update();
+
+		// シェーダーとアセットが揃ったら読み込み時間を表示 (メッシュ・プログラムバイナリキャッシュのヒット/ミス)
+		if (!shaderReported && SHADER_BUILD_QUEUE_INSTANCE.isIdle() && ASSET_LOADER_INSTANCE.isIdle())
+		{
+			MESH_CACHE_INSTANCE.printReport(std::cout);
+			PROGRAM_CACHE_INSTANCE.printReport(std::cout);
+			SHADER_BUILD_QUEUE_INSTANCE.printReport(std::cout);
+			ASSET_LOADER_INSTANCE.printReport(std::cout);
+			TEXTURE_REGISTRY_INSTANCE.printReport(std::cout);
+			shaderReported = true;
+		}
+
 		flyCamera.UpdateCamera(deltaTime);
-		// tCJ
-		Matrix4 viewMat, projMat;
-		viewMat = flyCamera.GetViewMatrix();
-		projMat = flyCamera.GetProjectionMatrix();
-		Vector3 viewPos;
-		viewPos = flyCamera.GetPositionVec();
-
-		// fBNViCg
-		anim += 0.3f * deltaTime;
-		LightDir = Vector3(0.5f * sinf(anim), -0.3f, 0.5f * cosf(anim));
-		LightDir.Normalize();
-		Vector3 forwardVec = flyCamera.GetFrontVec();
-		Vector3 camPosVec = flyCamera.GetPositionVec();
-		Vector3 LightPos;
-		Vector3 mapCenterPos(4 * 6, 0, -4 * 6);
-		LightPos = LightDir * -30.0f + mapCenterPos;
-		Matrix4 lightProjection, lightView, lightSpaceMatrix;
-
-		lightProjection = Matrix4::CreateOrtho(80.0f, 80.0f, 1.0f, 100.0f);
-		lightView = Matrix4::CreateLookAt(LightPos, mapCenterPos, Vector3::UnitY);
-		lightSpaceMatrix = lightView * lightProjection;
+		scene->setCamera(flyCamera.GetViewMatrix(), flyCamera.GetProjectionMatrix(), flyCamera.GetPositionVec());
+
+		// ディレクショナルライト
+		scene->update(deltaTime);
 
 		if (INPUT_INSTANCE.IsKeyPressed(SDL_SCANCODE_UP))
 		{
-			exposure += 0.01f;
+			scene->setExposure(scene->getExposure() + 0.01f);
 		}
 		if (INPUT_INSTANCE.IsKeyPressed(SDL_SCANCODE_DOWN))
 		{
-			exposure -= 0.01f;
-			if (exposure < 0.0f)
+			scene->setExposure(scene->getExposure() - 0.01f);
+		}
+
+		scene->render(0);
+
+		if (showOverlay)
+		{
+			frameTimeOverlay->draw(FRAME_TIMER_INSTANCE, Scene::mScreenWidth, Scene::mScreenHeight);
+		}
+
+		FRAME_TIMER_INSTANCE.beginPhase(FramePhase_Swap);
+		SDL_GL_SwapWindow(SDLWindow);
+		FRAME_TIMER_INSTANCE.endFrame();
+
+		// フレーム時間の統計を0.5秒ごとにウィンドウタイトルに表示
+		if (SDL_GetTicks() - titleUpdateTime > 500)
+		{
+			FrameTimeStats stats;
+			if (FRAME_TIMER_INSTANCE.getFrameStats(stats))
 			{
-				exposure = 0.0f;
+				char title[128];
+				snprintf(title, sizeof(title), "SDL & GL Window  %.1f fps | p50 %.2f / p95 %.2f / p99 %.2f ms | hitches %u",
+					1000.0f / stats.average, stats.p50, stats.p95, stats.p99, FRAME_TIMER_INSTANCE.getRecentHitchCount());
+				SDL_SetWindowTitle(SDLWindow, title);
 			}
+			titleUpdateTime = SDL_GetTicks();
 		}
 
-		// VhE}bvpX
-		glEnable(GL_DEPTH_TEST);
-		glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-		glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-		glClear(GL_DEPTH_BUFFER_BIT);
-		depthMapShader.use();
-		depthMapShader.setMatrix("lightSpaceMatrix", lightSpaceMatrix.GetAsFloatPtr());
-		drawMeshsInScene(&depthMapShader, floorMesh);
-		drawMeshsInScene(&depthMapShader, pillerMesh);
-
-		// `pX
-		glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+		// F1キーでフレーム統計をコンソールに出力
+		if (INPUT_INSTANCE.IsKeyPullup(SDL_SCANCODE_F1))
 		{
-			glEnable(GL_DEPTH_TEST);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			glViewport(0, 0, 1024, 768);
-
-			// VF[_[uniformϐZbg
-			phongShader.use();
-			phongShader.setVec3("light.direction", LightDir);
-			phongShader.setVec3("light.ambient", ambient);
-			phongShader.setVec3("light.diffuse", diffuse);
-			phongShader.setVec3("light.specular", specular);
-			phongShader.setVec3("viewPos", viewPos);
-			phongShader.setMatrix("view", viewMat.GetAsFloatPtr());
-			phongShader.setMatrix("projection", projMat.GetAsFloatPtr());
-
-			// bVɃeNX`ݒ肵ĕ`
-			setTextureUnit(&phongShader, floorTextures); // 
-			drawMeshsInScene(&phongShader, floorMesh);
-
-			setTextureUnit(&phongShader, pillerTextures); // 
-			drawMeshsInScene(&phongShader, pillerMesh);
-
-			Vector3 lightColor(0.8, 0.5, 0.2);
-			sphereShader.use();
-			sphereShader.setMatrix("view", viewMat.GetAsFloatPtr());
-			sphereShader.setMatrix("projection", projMat.GetAsFloatPtr());
-
-			sphereShader.setVec3("color", lightColor);
-			sphereShader.setFloat("luminance", 5.0);
-
-			drawMeshsInScene(&sphereShader, sphereMesh);
+			scene->printStats(std::cout);
+			FRAME_TIMER_INSTANCE.printStats(std::cout);
 		}
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// F2キーでGPU区間のキャプチャ開始/終了 (終了時にCSVとChromeトレースを書き出す)
+		if (INPUT_INSTANCE.IsKeyPullup(SDL_SCANCODE_F2))
 		{
-			glDisable(GL_DEPTH_TEST);
-			glClear(GL_COLOR_BUFFER_BIT);
-			glViewport(0, 0, 1024, 768);
-
-			// XN[ς̎lp``
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, floatColorTexture);
-
-			toneMapShader.use();
-			toneMapShader.setInt("screenTexture", 0);
-			toneMapShader.setFloat("exposure", exposure);
-			glBindVertexArray(quadVAO);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+			GpuProfiler& gpuProfiler = scene->getGpuProfiler();
+			if (gpuProfiler.isCapturing())
+			{
+				gpuProfiler.stopCapture();
+				gpuProfiler.writeCSV("gpu_profile.csv");
+				gpuProfiler.writeChromeTrace("gpu_trace.json");
+				std::cout << "GPU capture saved : gpu_profile.csv / gpu_trace.json" << std::endl;
+			}
+			else
+			{
+				gpuProfiler.startCapture();
+				std::cout << "GPU capture started" << std::endl;
+			}
 		}
 
-		SDL_GL_SwapWindow(SDLWindow);
+		// F3キーでフレーム時間グラフの表示切り替え
+		if (INPUT_INSTANCE.IsKeyPullup(SDL_SCANCODE_F3))
+		{
+			showOverlay = !showOverlay;
+		}
+
+		// F4キーでフレーム時間の履歴をCSVに書き出す
+		if (INPUT_INSTANCE.IsKeyPullup(SDL_SCANCODE_F4))
+		{
+			if (FRAME_TIMER_INSTANCE.writeCSV("frame_times.csv"))
+			{
+				std::cout << "frame times saved : frame_times.csv" << std::endl;
+			}
+		}
 
-		// EscL[ŏI
+		// F5キーでフレームリミッタの切り替え (なし → 60fps → 30fps)
+		if (INPUT_INSTANCE.IsKeyPullup(SDL_SCANCODE_F5))
+		{
+			unsigned int fps = FRAME_TIMER_INSTANCE.getTargetFrameRate();
+			fps = fps == 0 ? 60 : (fps == 60 ? 30 : 0);
+			FRAME_TIMER_INSTANCE.setTargetFrameRate(fps);
+			std::cout << "frame limiter : " << (fps ? std::to_string(fps) + " fps" : std::string("off")) << std::endl;
+		}
+
+		// Escキーで終了
 		if (INPUT_INSTANCE.IsKeyPullup(SDL_SCANCODE_ESCAPE))
 		{
 			exit(0);
 		}
+
+		FRAME_TIMER_INSTANCE.waitForNextFrame();
 	}
 
-	// eNX`̍폜
-	glDeleteTextures(1, &floorTex);
-	glDeleteTextures(1, &floorTexS);
-	glDeleteTextures(1, &pillerTex);
-	glDeleteTextures(1, &pillerTexS);
+	// シーンの削除 (GLコンテキストを破棄する前に行う)
+	delete frameTimeOverlay;
+	delete scene;
+	TEXTURE_REGISTRY_INSTANCE.releaseAll();
+	ASSET_LOADER_INSTANCE.shutdown();
 
 	destroyGL();
 
@@ -321,63 +209,63 @@ int main(int argc, char** argv)
 }
 
 /// <summary>
-/// SDLGL̏
+/// SDLとGLの初期化
 /// </summary>
 /// <returns></returns>
 bool initGL()
 {
-	// SDL̏
+	// SDLの初期化
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0)
 	{
-		printf("SDLs : %s\n", SDL_GetError());
+		printf("SDL初期化失敗 : %s\n", SDL_GetError());
 		return false;
 	}
 
-	// OpenGL Agr[g̃Zbg
+	// OpenGL アトリビュートのセット
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
 	// GL version 3.1
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
 
-	// 8Bit RGBA `l
+	// 8Bit RGBA チャンネル
 	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
 
-	// _uobt@O
+	// ダブルバッファリング
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 
-	// n[hEFAANZ[V
+	// ハードウェアアクセラレーションを強制
 	SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
 
-	// Window̍쐬
+	// Windowの作成
 	SDLWindow = SDL_CreateWindow("SDL & GL Window",
 		100, 80,
 		1024, 768, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
 	if (!SDLWindow)
 	{
-		printf("Window̍쐬Ɏs: %s", SDL_GetError());
+		printf("Windowの作成に失敗: %s", SDL_GetError());
 		return false;
 	}
 
-	// SDL Renderer̍쐬
+	// SDL Rendererの作成
 	renderer = SDL_CreateRenderer(SDLWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 	if (!renderer)
 	{
-		printf("SDLRenderer̍쐬Ɏs %s", SDL_GetError());
+		printf("SDLRendererの作成に失敗 %s", SDL_GetError());
 		return false;
 	}
 
 	context = SDL_GL_CreateContext(SDLWindow);
 
-	// GLAD̏
+	// GLADの初期化
 	const int version = gladLoadGL();
 	if (version == 0)
 	{
-		printf("gladsI\n");
+		printf("glad初期化失敗！\n");
 		return false;
 	}
 
@@ -385,7 +273,7 @@ bool initGL()
 }
 
 /// <summary>
-/// SDLGĽn
+/// SDLとGLの後始末
 /// </summary>
 void destroyGL()
 {
@@ -395,76 +283,7 @@ void destroyGL()
 
 
 /// <summary>
-/// eNX`[̓ǂݍ
-/// </summary>
-/// <param name="textureFileName"> eNX`[̃t@C </param>
-/// <returns> textureID </returns>
-GLuint loadTexture(std::string textureFileName)
-{
-	// 摜SDLT[tFXɓǂݍ
-	SDL_Surface* surf = IMG_Load(textureFileName.c_str());
-	if (!surf)
-	{
-		std::cout << "t@Cǂݍ݂Ɏs : " << textureFileName << std::endl;
-		return -1;
-	}
-
-	// 摜̕E擾
-	int width = surf->w;
-	int	height = surf->h;
-	int channels = surf->format->BytesPerPixel;
-
-	// 摜tH[}bg̔
-	int format = GL_RGB;
-	if (channels == 4)
-	{
-		format = GL_RGBA;
-	}
-
-	// SDLT[tFXfkeNX`쐬ep[^Zbg
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
-
-	// eNX`bsOtB^Oݒ
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// SDLf[^GL̃eNX`f[^ƂăRs[
-	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-		GL_UNSIGNED_BYTE, surf->pixels);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	// SDLT[tFX͗pς݂Ȃ̂ŉ
-	SDL_FreeSurface(surf);
-
-	return textureID;
-}
-
-/// <summary>
-/// bV8x8ɕׂăV[`悷
-/// </summary>
-/// <param name="shader"> VF[_[ </param>
-/// <param name="mesh"> bV </param>
-void drawMeshsInScene(Shader* shader, MeshObj& mesh)
-{
-	// bV̕`iȑOshadermodelsȑÕf[^͓nĂO)
-	for (int i = 0; i < 8; i++)
-	{
-		for (int j = 0; j < 8; j++)
-		{
-			Vector3 pos(i * 6.0f, 0.0f, -j * 6.0f);
-			Matrix4 modelMat = Matrix4::CreateTranslation(pos);
-			shader->setMatrix("model", modelMat.GetAsFloatPtr());
-			mesh.draw();
-		}
-	}
-}
-
-/// <summary>
-/// ǉf̕`
+/// 追加モデルの描画
 /// </summary>
 /// <param name="shader"></param>
 /// <param name="mesh"></param>
@@ -477,26 +296,12 @@ void drawModelInScene(Shader* shader, MeshObj& mesh)
 }
 
 /// <summary>
-/// eNX`Xe[WƃeNX`̐ݒ
-/// </summary>
-/// <param name="textures"> eNX`[ </param>
-void setTextureUnit(Shader* shader, std::vector<unsigned int>& textures)
-{
-	for (unsigned int i = 0; i < textures.size(); i++)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]);
-		shader->setInt(shader->getShaderStageUniformName(i), i);
-	}
-}
-
-/// <summary>
-/// ʑŜ𕢂_`
+/// 画面全体を覆う頂点定義
 /// </summary>
-/// <param name="vao"> _zIuWFNg(Vertex Array Object) </param>
+/// <param name="vao"> 頂点配列オブジェクト(Vertex Array Object) </param>
 void screenVAOSetting(unsigned int& vao)
 {
-	unsigned int vbo;	// _obt@IuWFNg(Vertex Buffer Object)
+	unsigned int vbo;	// 頂点バッファオブジェクト(Vertex Buffer Object)
 	float quadVertices[] = {
 		// positions        // texture Coords
 		-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
@@ -508,7 +313,7 @@ void screenVAOSetting(unsigned int& vao)
 	// setup plane VAO
 	glGenVertexArrays(1, &vao);
 	glGenBuffers(1, &vbo);
-	glBindVertexArray(vao);
+	RENDER_STATE_INSTANCE.bindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
@@ -13,7 +13,7 @@ public:
 		MOUSE_BUTTON_PULLUP
 	}MouseButtonState;
 
-	// CX^X
+	// インスタンス
 	static Mouse& MouseInstance()
 	{
 		static Mouse MouseInstance;
@@ -31,16 +31,16 @@ public:
 	void             Update();
 
 private:
-	Mouse(); //VOg
+	Mouse(); //シングルトン
 
 	Vector2 mMousePos;
 	Vector2 mMouseWheel;
 
-	//{^̃f[^
+	//ボタンのデータ
 	Uint32 mCurrentButtons;
 	Uint32 mPrevButtons;
 
-	// ΃[h
+	// 相対モード
 	bool   mIsRelative;
 };
 
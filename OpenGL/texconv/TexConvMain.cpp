@@ -0,0 +1,215 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cstdlib>
+#include <cstring>
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include "TextureFile.h"
+#include "BlockEncoder.h"
+#include "MipBuilder.h"
+
+///////////////////////////////////////////////////////////////////////////////////////
+// テクスチャ変換ツール
+// PNGなどの画像をミップマップ付きのブロック圧縮テクスチャ(DDS)に変換し、元の画像と同じ場所に.ddsで書き出す
+// 実行時はAssetLoaderが同じ名前の.ddsを見つけてそのまま転送する (デコードとglGenerateMipmapを省く)
+//
+// 使い方 :
+//   texconv [--format auto|bc1|bc3|bc4|bc5] [--mip auto|color|linear|normal] [--threads N] [--force] 画像ファイルかディレクトリ…
+//     --format   圧縮形式 (既定 : auto = アルファがあればBC3、無ければBC1)
+//     --mip      ミップの作り方 (既定 : auto = ファイル名から決める、MipBuilder::getDefaultMode)
+//     --threads  ミップ生成と圧縮のスレッド数 (既定 : コア数)
+//     --force    元の画像が変わっていなくても変換し直す
+//   ディレクトリを指定するとその中の .png を全て変換する
+///////////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////
+// 画像1枚を変換する
+// in  : imagePath  元の画像ファイル名
+//       format     圧縮形式 (Format_Noneならアルファの有無で決める)
+//       mipMode    ミップの作り方 (nullptrならファイル名から決める)
+//       threadNum  ミップ生成と圧縮のスレッド数 (0ならコア数)
+//       force      変わっていなくても変換し直す
+// out : 変換できた (か変換済みだった) らtrue
+////////////////////////////////////////////////
+static bool convertImage(const std::string& imagePath, TextureFile::Format format, const MipBuilder::Mode* mipMode, unsigned int threadNum, bool force)
+{
+	const std::string outPath = TextureFile::getCompressedPath(imagePath);
+	if (!force)
+	{
+		TextureFile current;
+		if (current.loadDDS(outPath) && current.isSourceCurrent(imagePath))
+		{
+			std::cout << "  " << imagePath << " : up to date" << std::endl;
+			return true;
+		}
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	// 画素の並びをRGBA (リトルエンディアンのABGR8888) に揃える
+	SDL_Surface* loaded = IMG_Load(imagePath.c_str());
+	if (!loaded)
+	{
+		std::cout << "ファイル読み込み失敗 : " << imagePath << std::endl;
+		return false;
+	}
+	SDL_Surface* surf = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ABGR8888, 0);
+	SDL_FreeSurface(loaded);
+	if (!surf)
+	{
+		std::cout << "画素形式の変換失敗 : " << imagePath << std::endl;
+		return false;
+	}
+
+	const int width  = surf->w;
+	const int height = surf->h;
+	TextureFile source;
+	source.create(TextureFile::Format_RGBA8, width, height, 1);
+	for (int y = 0; y < height; y++)
+	{
+		memcpy(source.getLevelData(0) + static_cast<size_t>(width) * 4 * y, static_cast<const unsigned char*>(surf->pixels) + static_cast<size_t>(surf->pitch) * y,
+			static_cast<size_t>(width) * 4);
+	}
+	SDL_FreeSurface(surf);
+
+	if (format == TextureFile::Format_None)
+	{
+		const std::vector<unsigned char>& pixels = source.getData();
+		bool hasAlpha = false;
+		for (size_t i = 3; i < pixels.size() && !hasAlpha; i += 4)
+		{
+			hasAlpha = pixels[i] != 255;
+		}
+		format = hasAlpha ? TextureFile::Format_BC3 : TextureFile::Format_BC1;
+	}
+
+	// 1x1までのミップを作ってから各レベルを圧縮する
+	const MipBuilder::Mode mode = mipMode ? *mipMode : MipBuilder::getDefaultMode(imagePath);
+	TextureFile mips;
+	MipBuilder::build(mips, source, mode, threadNum);
+	TextureFile texture;
+	texture.create(format, width, height, mips.getLevelNum());
+	for (unsigned int i = 0; i < texture.getLevelNum(); i++)
+	{
+		const TextureLevel& dest = texture.getLevel(i);
+		BlockEncoder::encode(texture.getLevelData(i), mips.getLevelData(i), dest.width, dest.height, format, threadNum);
+	}
+
+	if (!texture.saveDDS(outPath, imagePath))
+	{
+		return false;
+	}
+
+	const float  milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	const size_t rawBytes     = static_cast<size_t>(width) * height * 4;
+	std::cout << "  " << imagePath << " -> " << outPath << " : " << width << "x" << height << " " << TextureFile::getFormatName(format)
+	          << ", " << texture.getLevelNum() << " levels (" << MipBuilder::getModeName(mode) << "), " << std::fixed << std::setprecision(2)
+	          << rawBytes / (1024.0 * 1024.0) << " MB -> " << texture.getData().size() / (1024.0 * 1024.0) << " MB, "
+	          << milliseconds << " ms" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	TextureFile::Format      format    = TextureFile::Format_None;
+	MipBuilder::Mode         mipMode   = MipBuilder::Mode_Color;
+	bool                     mipAuto   = true;
+	unsigned int             threadNum = 0;
+	bool                     force     = false;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--format") && hasValue)
+		{
+			const char* name = argv[++i];
+			if (!strcmp(name, "auto"))     { format = TextureFile::Format_None; }
+			else if (!strcmp(name, "bc1")) { format = TextureFile::Format_BC1; }
+			else if (!strcmp(name, "bc3")) { format = TextureFile::Format_BC3; }
+			else if (!strcmp(name, "bc4")) { format = TextureFile::Format_BC4; }
+			else if (!strcmp(name, "bc5")) { format = TextureFile::Format_BC5; }
+			else
+			{
+				std::cout << "対応していない形式 : " << name << std::endl;
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--mip") && hasValue)
+		{
+			const char* name = argv[++i];
+			mipAuto = false;
+			if (!strcmp(name, "auto"))        { mipAuto = true; }
+			else if (!strcmp(name, "color"))  { mipMode = MipBuilder::Mode_Color; }
+			else if (!strcmp(name, "linear")) { mipMode = MipBuilder::Mode_Linear; }
+			else if (!strcmp(name, "normal")) { mipMode = MipBuilder::Mode_Normal; }
+			else
+			{
+				std::cout << "対応していないミップの作り方 : " << name << std::endl;
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "--threads") && hasValue) { threadNum = static_cast<unsigned int>(atoi(argv[++i])); }
+		else if (!strcmp(argv[i], "--force"))                { force = true; }
+		else if (argv[i][0] != '-')                          { inputs.push_back(argv[i]); }
+		else
+		{
+			inputs.clear();
+			break;
+		}
+	}
+	if (inputs.empty())
+	{
+		std::cout << "usage : texconv [--format auto|bc1|bc3|bc4|bc5] [--mip auto|color|linear|normal] [--threads N] [--force] image-or-directory..." << std::endl;
+		return 1;
+	}
+
+	// ディレクトリは中の .png に展開する
+	std::vector<std::string> images;
+	for (const std::string& input : inputs)
+	{
+		std::error_code error;
+		if (std::filesystem::is_directory(input, error))
+		{
+			std::vector<std::string> found;
+			for (const auto& entry : std::filesystem::directory_iterator(input, error))
+			{
+				std::string extension = entry.path().extension().string();
+				std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+				if (entry.is_regular_file() && extension == ".png")
+				{
+					found.push_back(entry.path().generic_string());
+				}
+			}
+			std::sort(found.begin(), found.end());
+			images.insert(images.end(), found.begin(), found.end());
+		}
+		else
+		{
+			images.push_back(input);
+		}
+	}
+
+	IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+
+	const auto   start     = std::chrono::steady_clock::now();
+	unsigned int failedNum = 0;
+	for (const std::string& image : images)
+	{
+		if (!convertImage(image, format, mipAuto ? nullptr : &mipMode, threadNum, force))
+		{
+			failedNum++;
+		}
+	}
+	const float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "texconv : " << images.size() << " images (" << failedNum << " failed), " << std::fixed << std::setprecision(2)
+	          << milliseconds << " ms" << std::endl;
+
+	IMG_Quit();
+	return failedNum == 0 ? 0 : 1;
+}